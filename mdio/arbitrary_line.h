@@ -0,0 +1,677 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MDIO_ARBITRARY_LINE_H_
+#define MDIO_ARBITRARY_LINE_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mdio/dataset.h"
+#include "mdio/impl.h"
+#include "mdio/variable.h"
+#include "tensorstore/array.h"
+#include "tensorstore/index_space/index_domain_builder.h"
+#include "tensorstore/util/division.h"
+#include "tensorstore/util/future.h"
+
+namespace mdio {
+
+/// A point of a line, as an (inline, crossline) pair.
+using LinePoint = std::array<double, 2>;
+
+/**
+ * @brief How the points of a line are given.
+ */
+enum class LineCoordinates {
+  /// Fractional indices of the inline and crossline dimensions.
+  kIndex,
+  /// Values of the inline and crossline coordinates, e.g. line numbers.
+  kLine,
+  /// Surface positions, matched against the CDP coordinates.
+  kCdp,
+};
+
+/**
+ * @brief Options for `ExtractLine` and `ExtractHorizon`.
+ */
+struct ArbitraryLineOptions {
+  /// The distance between the traces of a line, in grid traces.
+  double spacing = 1.0;
+  /// The dimensions the line is drawn over, the leading dimensions of the
+  /// Variable.
+  std::string inline_dimension = "inline";
+  std::string crossline_dimension = "crossline";
+  /// How the points of a line through a Dataset are given.
+  LineCoordinates coordinates = LineCoordinates::kIndex;
+  /// The CDP coordinates, used with `LineCoordinates::kCdp`.
+  std::string cdp_x = "cdp_x";
+  std::string cdp_y = "cdp_y";
+  /// The maximum number of chunks read at once. 0 means unbounded.
+  std::size_t max_in_flight = 64;
+};
+
+namespace internal {
+
+/// Interpolated samples keep double precision, everything else is float.
+template <typename T>
+using InterpolatedType =
+    std::conditional_t<std::is_same_v<T, double>, double, float>;
+
+/**
+ * @brief Places points along a polyline at a fixed spacing.
+ * Every vertex is kept, so the line passes through its corners.
+ * @param distances Receives the distance of every point from the first one.
+ */
+inline std::vector<LinePoint> DensifyLine(
+    const std::vector<LinePoint>& vertices, double spacing,
+    std::vector<double>& distances) {  // NOLINT (non-const)
+  std::vector<LinePoint> points;
+  distances.clear();
+  if (vertices.empty()) {
+    return points;
+  }
+  points.push_back(vertices[0]);
+  distances.push_back(0);
+  for (std::size_t v = 1; v < vertices.size(); ++v) {
+    const auto& from = vertices[v - 1];
+    const auto& to = vertices[v];
+    const double length = std::hypot(to[0] - from[0], to[1] - from[1]);
+    const auto steps =
+        std::max<Index>(1, static_cast<Index>(std::ceil(length / spacing)));
+    for (Index s = 1; s <= steps; ++s) {
+      const double f = static_cast<double>(s) / steps;
+      points.push_back({from[0] + f * (to[0] - from[0]),
+                        from[1] + f * (to[1] - from[1])});
+      distances.push_back(distances.back() + length / steps);
+    }
+  }
+  return points;
+}
+
+/**
+ * @brief The four traces around a point and their bilinear weights.
+ */
+struct BilinearStencil {
+  Index x0;
+  Index y0;
+  Index x1;
+  Index y1;
+  double fx;
+  double fy;
+};
+
+/**
+ * @brief Gets the stencil of a point, clamped to [origin, origin + shape).
+ */
+inline BilinearStencil MakeStencil(const LinePoint& point,
+                                   tensorstore::span<const Index> origin,
+                                   tensorstore::span<const Index> shape) {
+  const auto axis = [&](int d, Index& i0, Index& i1, double& f) {
+    const double lo = origin[d];
+    const double hi = origin[d] + shape[d] - 1;
+    const double x = std::clamp(point[d], lo, hi);
+    i0 = static_cast<Index>(std::floor(x));
+    i1 = std::min<Index>(i0 + 1, origin[d] + shape[d] - 1);
+    f = x - i0;
+  };
+  BilinearStencil stencil;
+  axis(0, stencil.x0, stencil.x1, stencil.fx);
+  axis(1, stencil.y0, stencil.y1, stencil.fy);
+  return stencil;
+}
+
+/**
+ * @brief Bilinearly interpolates four traces, sample by sample.
+ * The loop runs along the samples with the weights fixed, so it vectorizes.
+ */
+template <typename T, typename U>
+void InterpolateTraces(const T* c00, const T* c10, const T* c01, const T* c11,
+                       double fx, double fy, Index n_samples, U* out) {
+  const U w00 = static_cast<U>((1 - fx) * (1 - fy));
+  const U w10 = static_cast<U>(fx * (1 - fy));
+  const U w01 = static_cast<U>((1 - fx) * fy);
+  const U w11 = static_cast<U>(fx * fy);
+  for (Index t = 0; t < n_samples; ++t) {
+    out[t] = w00 * static_cast<U>(c00[t]) + w10 * static_cast<U>(c10[t]) +
+             w01 * static_cast<U>(c01[t]) + w11 * static_cast<U>(c11[t]);
+  }
+}
+
+/**
+ * @brief Gets the fractional index of a value in monotonic coordinates.
+ * Values beyond the coordinates are clamped to the ends.
+ */
+inline double FractionalIndex(const std::vector<double>& coords,
+                              double value) {
+  if (coords.size() < 2) {
+    return 0;
+  }
+  const bool rising = coords.back() >= coords.front();
+  const auto before = [rising](double a, double b) {
+    return rising ? a < b : a > b;
+  };
+  auto upper = std::upper_bound(coords.begin(), coords.end(), value, before);
+  if (upper == coords.begin()) {
+    return 0;
+  }
+  if (upper == coords.end()) {
+    return coords.size() - 1;
+  }
+  const std::size_t i = (upper - coords.begin()) - 1;
+  const double span = coords[i + 1] - coords[i];
+  return i + (span == 0 ? 0 : (value - coords[i]) / span);
+}
+
+template <typename T>
+Future<std::vector<double>> ReadTypedAsDouble(
+    Dataset& dataset,  // NOLINT (non-const)
+    const std::string& name, const std::vector<RangeDescriptor<Index>>& desc) {
+  MDIO_ASSIGN_OR_RETURN(auto var, dataset.variables.get<T>(name))
+  if (!desc.empty()) {
+    MDIO_ASSIGN_OR_RETURN(var, var.slice(desc))
+  }
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [](VariableData<T>& data) {
+        const T* values =
+            data.get_data_accessor().data() + data.get_flattened_offset();
+        return std::vector<double>(values, values + data.num_samples());
+      },
+      var.Read());
+}
+
+/**
+ * @brief Reads a numeric coordinate as doubles, in C order.
+ */
+inline Future<std::vector<double>> ReadAsDouble(
+    Dataset& dataset,  // NOLINT (non-const)
+    const std::string& name,
+    const std::vector<RangeDescriptor<Index>>& desc = {}) {
+  MDIO_ASSIGN_OR_RETURN(auto var, dataset.variables.at(name))
+  const auto dtype = var.dtype();
+  if (dtype == tensorstore::dtype_v<double>) {
+    return ReadTypedAsDouble<double>(dataset, name, desc);
+  } else if (dtype == tensorstore::dtype_v<float>) {
+    return ReadTypedAsDouble<float>(dataset, name, desc);
+  } else if (dtype == tensorstore::dtype_v<int32_t>) {
+    return ReadTypedAsDouble<int32_t>(dataset, name, desc);
+  } else if (dtype == tensorstore::dtype_v<uint32_t>) {
+    return ReadTypedAsDouble<uint32_t>(dataset, name, desc);
+  } else if (dtype == tensorstore::dtype_v<int64_t>) {
+    return ReadTypedAsDouble<int64_t>(dataset, name, desc);
+  } else if (dtype == tensorstore::dtype_v<uint64_t>) {
+    return ReadTypedAsDouble<uint64_t>(dataset, name, desc);
+  } else if (dtype == tensorstore::dtype_v<int16_t>) {
+    return ReadTypedAsDouble<int16_t>(dataset, name, desc);
+  }
+  return absl::InvalidArgumentError("The coordinate '" + name +
+                                    "' is not numeric.");
+}
+
+/**
+ * @brief Checks that the line dimensions lead the dimensions of a Variable.
+ */
+inline absl::Status CheckLineDimensions(IndexDomainView<> domain,
+                                        const std::string& name,
+                                        const ArbitraryLineOptions& options) {
+  if (domain.rank() < 2 || domain.labels()[0] != options.inline_dimension ||
+      domain.labels()[1] != options.crossline_dimension) {
+    return absl::InvalidArgumentError(
+        "The dimensions of '" + name + "' must start with '" +
+        options.inline_dimension + "' and '" + options.crossline_dimension +
+        "'.");
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace internal
+
+/**
+ * @brief The traces interpolated along a line.
+ * @tparam T The element type of the Variable.
+ */
+template <typename T>
+struct LineSection {
+  using value_type = internal::InterpolatedType<T>;
+
+  /// The fractional (inline, crossline) index of every trace.
+  std::vector<LinePoint> positions;
+  /// The distance of every trace from the start of the line, in grid traces.
+  std::vector<double> distances;
+  /// The domain of one trace, the dimensions after inline and crossline.
+  IndexDomain<> sample_domain;
+  /// The samples of the traces, one trace after the other.
+  std::vector<value_type> data;
+  /// The chunks that were read.
+  std::size_t chunks_read = 0;
+
+  std::size_t num_traces() const { return positions.size(); }
+
+  Index samples_per_trace() const {
+    return sample_domain.valid() ? sample_domain.box().num_elements() : 0;
+  }
+
+  /// The samples of the i'th trace, in C order.
+  const value_type* trace(std::size_t i) const {
+    return data.data() + i * samples_per_trace();
+  }
+};
+
+/**
+ * @brief Extracts the traces along a polyline.
+ * The line is sampled every `spacing` grid traces, and every trace is
+ * bilinearly interpolated from the four grid traces around it. Only the
+ * chunks holding those traces are read, concurrently, and only the parts of
+ * them the line needs. Slice the Variable first to limit the samples.
+ * @details \b Usage
+ * @code
+ * MDIO_ASSIGN_OR_RETURN(auto seismic, ds.variables.get<float>("seismic"));
+ * std::vector<mdio::LinePoint> line = {{10.0, 20.0}, {250.5, 80.0}};
+ * MDIO_ASSIGN_OR_RETURN(auto section,
+ *                       mdio::ExtractLine(seismic, line).result());
+ * @endcode
+ * @param var The Variable, whose leading dimensions are inline and crossline.
+ * @param vertices The corners of the line, as fractional indices. Points off
+ * the grid are clamped to it.
+ * @param options The spacing of the traces and the dimension labels.
+ * @return A future of the interpolated traces.
+ */
+template <typename T>
+Future<LineSection<T>> ExtractLine(const Variable<T>& var,
+                                   const std::vector<LinePoint>& vertices,
+                                   const ArbitraryLineOptions& options = {}) {
+  static_assert(std::is_arithmetic_v<T>,
+                "ExtractLine requires a real numeric Variable.");
+  const auto domain = var.dimensions();
+  auto checked =
+      internal::CheckLineDimensions(domain, var.get_variable_name(), options);
+  if (!checked.ok()) {
+    return checked;
+  }
+  if (vertices.empty() || !(options.spacing > 0)) {
+    return absl::InvalidArgumentError(
+        "A line needs at least one point and a positive spacing.");
+  }
+  const DimensionIndex rank = domain.rank();
+
+  struct State {
+    Variable<T> var;
+    LineSection<T> section;
+    std::vector<internal::BilinearStencil> stencils;
+    /// The grid traces the line needs, and where they are in `traces`.
+    std::unordered_map<Index, std::size_t> slots;
+    std::vector<T> traces;
+    /// The boxes read, each within one chunk column, and their traces.
+    std::vector<std::array<Index, 4>> reads;
+    std::vector<std::vector<std::pair<Index, Index>>> read_traces;
+    Index n_samples = 0;
+  };
+  auto state = std::make_shared<State>();
+  state->var = var;
+  auto& section = state->section;
+  section.positions =
+      internal::DensifyLine(vertices, options.spacing, section.distances);
+
+  tensorstore::IndexDomainBuilder<> builder(rank - 2);
+  for (DimensionIndex d = 2; d < rank; ++d) {
+    builder.origin()[d - 2] = domain.origin()[d];
+    builder.shape()[d - 2] = domain.shape()[d];
+    builder.labels()[d - 2] = domain.labels()[d];
+  }
+  MDIO_ASSIGN_OR_RETURN(section.sample_domain, builder.Finalize())
+  state->n_samples = section.samples_per_trace();
+
+  // The grid traces around every point, grouped by chunk column.
+  auto chunk_res = var.get_chunk_shape();
+  Index chunks[2];
+  for (DimensionIndex d = 0; d < 2; ++d) {
+    const bool chunked = chunk_res.ok() && chunk_res->size() == rank &&
+                         (*chunk_res)[d] > 0;
+    chunks[d] =
+        chunked ? (*chunk_res)[d] : std::max<Index>(domain.shape()[d], 1);
+  }
+  const Index ny = domain.shape()[1];
+  std::map<std::pair<Index, Index>, std::vector<std::pair<Index, Index>>>
+      columns;
+  for (const auto& point : section.positions) {
+    const auto stencil =
+        internal::MakeStencil(point, domain.origin(), domain.shape());
+    state->stencils.push_back(stencil);
+    for (Index x : {stencil.x0, stencil.x1}) {
+      for (Index y : {stencil.y0, stencil.y1}) {
+        const Index key =
+            (x - domain.origin()[0]) * ny + (y - domain.origin()[1]);
+        if (state->slots.emplace(key, state->slots.size()).second) {
+          columns[{tensorstore::FloorOfRatio(x, chunks[0]),
+                   tensorstore::FloorOfRatio(y, chunks[1])}]
+              .push_back({x, y});
+        }
+      }
+    }
+  }
+  state->traces.resize(state->slots.size() * state->n_samples);
+  for (auto& [cell, traces] : columns) {
+    std::array<Index, 4> box = {std::numeric_limits<Index>::max(),
+                                std::numeric_limits<Index>::min(),
+                                std::numeric_limits<Index>::max(),
+                                std::numeric_limits<Index>::min()};
+    for (const auto& [x, y] : traces) {
+      box[0] = std::min(box[0], x);
+      box[1] = std::max(box[1], x + 1);
+      box[2] = std::min(box[2], y);
+      box[3] = std::max(box[3], y + 1);
+    }
+    state->reads.push_back(box);
+    state->read_traces.push_back(std::move(traces));
+  }
+  section.chunks_read = state->reads.size();
+
+  const auto origin_x = domain.origin()[0];
+  const auto origin_y = domain.origin()[1];
+  auto all_read = internal::ForEachBounded(
+      state->reads.size(), options.max_in_flight,
+      [state, options, ny, origin_x, origin_y](std::size_t i) -> Future<void> {
+        const auto& box = state->reads[i];
+        MDIO_ASSIGN_OR_RETURN(
+            auto region,
+            state->var.slice(
+                RangeDescriptor<Index>{options.inline_dimension, box[0],
+                                       box[1], 1},
+                RangeDescriptor<Index>{options.crossline_dimension, box[2],
+                                       box[3], 1}))
+        return tensorstore::MapFutureValue(
+            tensorstore::InlineExecutor{},
+            [state, i, ny, origin_x, origin_y](VariableData<T>& data) {
+              const T* src =
+                  data.get_data_accessor().data() + data.get_flattened_offset();
+              const auto& box = state->reads[i];
+              const Index width = box[3] - box[2];
+              const Index n = state->n_samples;
+              for (const auto& [x, y] : state->read_traces[i]) {
+                const auto slot =
+                    state->slots.at((x - origin_x) * ny + (y - origin_y));
+                const T* from = src + ((x - box[0]) * width + y - box[2]) * n;
+                std::copy(from, from + n, state->traces.data() + slot * n);
+              }
+            },
+            region.Read());
+      });
+
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [state, ny, origin_x, origin_y]() {
+        auto& section = state->section;
+        const Index n = state->n_samples;
+        section.data.resize(section.positions.size() * n);
+        const auto trace = [&](Index x, Index y) {
+          return state->traces.data() +
+                 state->slots.at((x - origin_x) * ny + (y - origin_y)) * n;
+        };
+        for (std::size_t p = 0; p < state->stencils.size(); ++p) {
+          const auto& s = state->stencils[p];
+          internal::InterpolateTraces(trace(s.x0, s.y0), trace(s.x1, s.y0),
+                                      trace(s.x0, s.y1), trace(s.x1, s.y1),
+                                      s.fx, s.fy, n,
+                                      section.data.data() + p * n);
+        }
+        return std::move(section);
+      },
+      std::move(all_read));
+}
+
+/**
+ * @brief Extracts the traces along a polyline through a Dataset.
+ * The points are converted to fractional indices as `options.coordinates`
+ * says. Line numbers are looked up in the 1-D coordinates named after the
+ * inline and crossline dimensions. CDP positions are inverted through the
+ * affine map of the `cdp_x` and `cdp_y` coordinates of a regular grid, which
+ * only needs the corner of the grid.
+ * @param dataset The Dataset holding the Variable and its coordinates.
+ * @param name The name of the Variable.
+ * @param vertices The corners of the line.
+ */
+template <typename T>
+Future<LineSection<T>> ExtractLine(Dataset& dataset,  // NOLINT (non-const)
+                                   const std::string& name,
+                                   const std::vector<LinePoint>& vertices,
+                                   const ArbitraryLineOptions& options = {}) {
+  MDIO_ASSIGN_OR_RETURN(auto var, dataset.variables.get<T>(name))
+  const auto domain = var.dimensions();
+  auto checked = internal::CheckLineDimensions(domain, name, options);
+  if (!checked.ok()) {
+    return checked;
+  }
+  const Index origin_x = domain.origin()[0];
+  const Index origin_y = domain.origin()[1];
+
+  if (options.coordinates == LineCoordinates::kIndex) {
+    return ExtractLine(var, vertices, options);
+  }
+  if (options.coordinates == LineCoordinates::kLine) {
+    auto inlines = internal::ReadAsDouble(dataset, options.inline_dimension);
+    auto crosslines =
+        internal::ReadAsDouble(dataset, options.crossline_dimension);
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [var, vertices, options, origin_x, origin_y](
+            std::vector<double>& il, std::vector<double>& xl) {
+          std::vector<LinePoint> indices;
+          for (const auto& point : vertices) {
+            indices.push_back(
+                {origin_x + internal::FractionalIndex(il, point[0]),
+                 origin_y + internal::FractionalIndex(xl, point[1])});
+          }
+          return ExtractLine(var, indices, options);
+        },
+        std::move(inlines), std::move(crosslines));
+  }
+
+  if (domain.shape()[0] < 2 || domain.shape()[1] < 2) {
+    return absl::InvalidArgumentError(
+        "CDP positions need a grid of at least 2 by 2 traces.");
+  }
+  const std::vector<RangeDescriptor<Index>> corner = {
+      {options.inline_dimension, origin_x, origin_x + 2, 1},
+      {options.crossline_dimension, origin_y, origin_y + 2, 1}};
+  auto xs = internal::ReadAsDouble(dataset, options.cdp_x, corner);
+  auto ys = internal::ReadAsDouble(dataset, options.cdp_y, corner);
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [var, vertices, options, origin_x, origin_y](
+          std::vector<double>& x,
+          std::vector<double>& y) -> Future<LineSection<T>> {
+        if (x.size() != 4 || y.size() != 4) {
+          return absl::InvalidArgumentError(
+              "The CDP coordinates must be over inline and crossline.");
+        }
+        // C order of the 2 by 2 corner: (0, 0), (0, 1), (1, 0), (1, 1).
+        const double ax = x[2] - x[0], ay = y[2] - y[0];
+        const double bx = x[1] - x[0], by = y[1] - y[0];
+        const double det = ax * by - ay * bx;
+        if (det == 0) {
+          return absl::InvalidArgumentError(
+              "The CDP coordinates are not a regular grid.");
+        }
+        std::vector<LinePoint> indices;
+        for (const auto& point : vertices) {
+          const double dx = point[0] - x[0];
+          const double dy = point[1] - y[0];
+          indices.push_back({origin_x + (dx * by - dy * bx) / det,
+                             origin_y + (ax * dy - ay * dx) / det});
+        }
+        return ExtractLine(var, indices, options);
+      },
+      std::move(xs), std::move(ys));
+}
+
+/**
+ * @brief Extracts the amplitudes along a horizon.
+ * Every trace of the horizon is linearly interpolated at its fractional
+ * sample index. Each chunk column is only read over the samples the horizon
+ * spans in it, so a flat horizon touches one chunk per column.
+ * @param var The Variable, of dimensions inline, crossline and samples.
+ * @param horizon The fractional sample index of every trace, NaN where the
+ * horizon is not defined. Its dimensions are inline and crossline, within
+ * the Variable.
+ * @param options The dimension labels and the reads in flight.
+ * @return A future of the amplitudes over the domain of the horizon, NaN
+ * where the horizon is not defined or outside of the samples.
+ */
+template <typename T>
+Future<VariableData<internal::InterpolatedType<T>>> ExtractHorizon(
+    const Variable<T>& var, const VariableData<float>& horizon,
+    const ArbitraryLineOptions& options = {}) {
+  static_assert(std::is_arithmetic_v<T>,
+                "ExtractHorizon requires a real numeric Variable.");
+  using U = internal::InterpolatedType<T>;
+  const auto domain = var.dimensions();
+  auto checked =
+      internal::CheckLineDimensions(domain, var.get_variable_name(), options);
+  if (!checked.ok()) {
+    return checked;
+  }
+  const auto surface = horizon.dimensions();
+  if (domain.rank() != 3 || surface.rank() != 2 ||
+      surface.labels()[0] != options.inline_dimension ||
+      surface.labels()[1] != options.crossline_dimension) {
+    return absl::InvalidArgumentError(
+        "A horizon is a 2-D surface over a 3-D Variable.");
+  }
+  for (DimensionIndex d = 0; d < 2; ++d) {
+    if (!tensorstore::Contains(domain[d].interval(), surface[d].interval())) {
+      return absl::OutOfRangeError("The horizon is outside of '" +
+                                   var.get_variable_name() + "'.");
+    }
+  }
+
+  auto array = tensorstore::AllocateArray<U>(
+      surface.box(), tensorstore::c_order, tensorstore::default_init);
+  LabeledArray<U, dynamic_rank, offset_origin> labeled{surface, array};
+  auto out = std::make_shared<VariableData<U>>(
+      var.get_variable_name(), var.get_long_name(), var.getMetadata(),
+      labeled);
+  U* amplitudes =
+      out->get_data_accessor().data() + out->get_flattened_offset();
+  auto picks = std::make_shared<VariableData<float>>(horizon);
+  const float* times =
+      picks->get_data_accessor().data() + picks->get_flattened_offset();
+  const Index nx = surface.shape()[0];
+  const Index ny = surface.shape()[1];
+  const Index sx = surface.origin()[0];
+  const Index sy = surface.origin()[1];
+  const Index t_min = domain.origin()[2];
+  const Index t_max = domain.origin()[2] + domain.shape()[2] - 1;
+  std::fill(amplitudes, amplitudes + nx * ny,
+            std::numeric_limits<U>::quiet_NaN());
+
+  // The samples the horizon spans in every chunk column.
+  auto chunk_res = var.get_chunk_shape();
+  Index chunks[2];
+  for (DimensionIndex d = 0; d < 2; ++d) {
+    const bool chunked = chunk_res.ok() && chunk_res->size() == 3 &&
+                         (*chunk_res)[d] > 0;
+    chunks[d] =
+        chunked ? (*chunk_res)[d] : std::max<Index>(surface.shape()[d], 1);
+  }
+  std::vector<std::array<Index, 6>> reads;
+  for (Index cx = tensorstore::FloorOfRatio(sx, chunks[0]);
+       cx * chunks[0] < sx + nx; ++cx) {
+    for (Index cy = tensorstore::FloorOfRatio(sy, chunks[1]);
+         cy * chunks[1] < sy + ny; ++cy) {
+      const Index x0 = std::max(sx, cx * chunks[0]);
+      const Index x1 = std::min(sx + nx, (cx + 1) * chunks[0]);
+      const Index y0 = std::max(sy, cy * chunks[1]);
+      const Index y1 = std::min(sy + ny, (cy + 1) * chunks[1]);
+      double lo = std::numeric_limits<double>::infinity();
+      double hi = -lo;
+      for (Index x = x0; x < x1; ++x) {
+        for (Index y = y0; y < y1; ++y) {
+          const double t = times[(x - sx) * ny + (y - sy)];
+          if (t >= t_min && t <= t_max) {
+            lo = std::min(lo, t);
+            hi = std::max(hi, t);
+          }
+        }
+      }
+      if (lo > hi) {
+        continue;
+      }
+      const Index first = static_cast<Index>(std::floor(lo));
+      const Index last = std::min<Index>(static_cast<Index>(std::floor(hi)) + 1,
+                                         t_max);
+      reads.push_back({x0, x1, y0, y1, first, last + 1});
+    }
+  }
+
+  auto all_read = internal::ForEachBounded(
+      reads.size(), options.max_in_flight,
+      [var, reads, options, picks, times, out, amplitudes, sx, sy, ny,
+       t_max](std::size_t i) -> Future<void> {
+        const auto& box = reads[i];
+        MDIO_ASSIGN_OR_RETURN(
+            auto region,
+            var.slice(RangeDescriptor<Index>{options.inline_dimension, box[0],
+                                             box[1], 1},
+                      RangeDescriptor<Index>{options.crossline_dimension,
+                                             box[2], box[3], 1},
+                      RangeDescriptor<Index>{DimensionIdentifier(2), box[4],
+                                             box[5], 1}))
+        return tensorstore::MapFutureValue(
+            tensorstore::InlineExecutor{},
+            [box, picks, times, out, amplitudes, sx, sy, ny,
+             t_max](VariableData<T>& data) {
+              const T* src =
+                  data.get_data_accessor().data() + data.get_flattened_offset();
+              const Index width = box[3] - box[2];
+              const Index depth = box[5] - box[4];
+              for (Index x = box[0]; x < box[1]; ++x) {
+                for (Index y = box[2]; y < box[3]; ++y) {
+                  const Index at = (x - sx) * ny + (y - sy);
+                  const double t = times[at];
+                  if (!(t >= box[4] && t <= t_max)) {
+                    continue;
+                  }
+                  const T* trace =
+                      src + ((x - box[0]) * width + (y - box[2])) * depth;
+                  const Index i0 = static_cast<Index>(std::floor(t));
+                  const Index i1 = std::min(i0 + 1, t_max);
+                  const U f = static_cast<U>(t - i0);
+                  amplitudes[at] =
+                      static_cast<U>(trace[i0 - box[4]]) * (1 - f) +
+                      static_cast<U>(trace[i1 - box[4]]) * f;
+                }
+              }
+            },
+            region.Read());
+      });
+
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [out]() -> VariableData<U> { return *out; }, std::move(all_read));
+}
+
+}  // namespace mdio
+
+#endif  // MDIO_ARBITRARY_LINE_H_
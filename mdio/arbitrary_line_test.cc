@@ -0,0 +1,146 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mdio/arbitrary_line.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <filesystem>
+#include <vector>
+
+#include "mdio/utils/test_fixtures.h"
+
+namespace {
+
+// Sample (x, y, t) is 100 * x + 10 * y + t, so interpolation is exact.
+mdio::Result<mdio::Variable<float>> MakeVariable() {
+  return mdio::testing::MakeVariable<float>(
+      mdio::testing::VariableSpec("line_variable",
+                                  {"inline", "crossline", "time"}, {8, 10, 6},
+                                  {4, 4, 6}),
+      [](const std::vector<mdio::Index>& p) {
+        return 100 * p[0] + 10 * p[1] + p[2];
+      });
+}
+
+TEST(ArbitraryLine, extractLine) {
+  auto var = MakeVariable();
+  ASSERT_TRUE(var.ok()) << var.status();
+
+  // A dog-leg crossing chunk columns, sampled every half trace.
+  std::vector<mdio::LinePoint> line = {{0.5, 1.0}, {6.5, 7.0}, {6.5, 9.0}};
+  mdio::ArbitraryLineOptions options;
+  options.spacing = 0.5;
+  auto section = mdio::ExtractLine(var.value(), line, options).result();
+  ASSERT_TRUE(section.ok()) << section.status();
+  EXPECT_EQ(section->samples_per_trace(), 6);
+  ASSERT_GT(section->num_traces(), 2);
+  EXPECT_EQ(section->positions.front(), line.front());
+  EXPECT_EQ(section->positions.back(), line.back());
+  EXPECT_NEAR(section->distances.back(), 6 * std::sqrt(2.0) + 2, 1e-9);
+  EXPECT_LE(section->chunks_read, 6);
+  for (std::size_t i = 0; i < section->num_traces(); ++i) {
+    const auto& p = section->positions[i];
+    for (int t = 0; t < 6; ++t) {
+      EXPECT_NEAR(section->trace(i)[t], 100 * p[0] + 10 * p[1] + t, 1e-3)
+          << i << ", " << t;
+    }
+  }
+  std::filesystem::remove_all("line_variable");
+}
+
+TEST(ArbitraryLine, clampsToGrid) {
+  auto var = MakeVariable();
+  ASSERT_TRUE(var.ok()) << var.status();
+
+  std::vector<mdio::LinePoint> line = {{-3.0, 2.0}, {20.0, 2.0}};
+  mdio::ArbitraryLineOptions options;
+  options.spacing = 23;
+  auto section = mdio::ExtractLine(var.value(), line, options).result();
+  ASSERT_TRUE(section.ok()) << section.status();
+  ASSERT_EQ(section->num_traces(), 2);
+  EXPECT_FLOAT_EQ(section->trace(0)[0], 20);
+  EXPECT_FLOAT_EQ(section->trace(1)[0], 720);
+
+  options.inline_dimension = "crossline";
+  EXPECT_FALSE(mdio::ExtractLine(var.value(), line, options).status().ok());
+  std::filesystem::remove_all("line_variable");
+}
+
+TEST(ArbitraryLine, extractHorizon) {
+  auto var = MakeVariable();
+  ASSERT_TRUE(var.ok()) << var.status();
+
+  auto domain = tensorstore::IndexDomainBuilder<>(2)
+                    .labels({"inline", "crossline"})
+                    .origin({2, 3})
+                    .shape({4, 5})
+                    .Finalize();
+  ASSERT_TRUE(domain.ok()) << domain.status();
+  auto picks = tensorstore::AllocateArray<float>(
+      domain->box(), tensorstore::c_order, tensorstore::default_init);
+  mdio::VariableData<float> horizon{
+      "horizon", "", ::nlohmann::json::object(),
+      mdio::LabeledArray<float, mdio::dynamic_rank, mdio::offset_origin>{
+          domain.value(), picks}};
+  float* times =
+      horizon.get_data_accessor().data() + horizon.get_flattened_offset();
+  for (int i = 0; i < 20; ++i) {
+    times[i] = 0.25f * i;
+  }
+  times[7] = std::nanf("");
+
+  auto amplitudes = mdio::ExtractHorizon(var.value(), horizon).result();
+  ASSERT_TRUE(amplitudes.ok()) << amplitudes.status();
+  EXPECT_EQ(amplitudes->dimensions().origin()[0], 2);
+  EXPECT_EQ(amplitudes->dimensions().shape()[1], 5);
+  const float* out = amplitudes->get_data_accessor().data() +
+                     amplitudes->get_flattened_offset();
+  for (int i = 0; i < 20; ++i) {
+    const int x = 2 + i / 5;
+    const int y = 3 + i % 5;
+    if (i == 7 || times[i] > 5) {
+      EXPECT_TRUE(std::isnan(out[i])) << i;
+    } else {
+      EXPECT_NEAR(out[i], 100 * x + 10 * y + times[i], 1e-3) << i;
+    }
+  }
+  std::filesystem::remove_all("line_variable");
+}
+
+TEST(ArbitraryLine, fractionalIndex) {
+  const std::vector<double> rising = {100, 102, 104, 108};
+  EXPECT_DOUBLE_EQ(mdio::internal::FractionalIndex(rising, 103), 1.5);
+  EXPECT_DOUBLE_EQ(mdio::internal::FractionalIndex(rising, 106), 2.5);
+  EXPECT_DOUBLE_EQ(mdio::internal::FractionalIndex(rising, 50), 0);
+  EXPECT_DOUBLE_EQ(mdio::internal::FractionalIndex(rising, 200), 3);
+
+  const std::vector<double> falling = {40, 30, 20};
+  EXPECT_DOUBLE_EQ(mdio::internal::FractionalIndex(falling, 25), 1.5);
+}
+
+TEST(ArbitraryLine, interpolateTraces) {
+  const std::vector<float> a = {0, 1, 2}, b = {10, 11, 12};
+  const std::vector<float> c = {20, 21, 22}, d = {30, 31, 32};
+  std::vector<float> out(3);
+  mdio::internal::InterpolateTraces(a.data(), b.data(), c.data(), d.data(),
+                                    0.5, 0.25, 3, out.data());
+  for (int t = 0; t < 3; ++t) {
+    EXPECT_FLOAT_EQ(out[t], 5 + 5 + t);
+  }
+}
+
+}  // namespace
@@ -0,0 +1,559 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the MDIO hot paths.
+//
+// Every benchmark runs against a local file store, Variables also against an
+// in-memory store. Setting MDIO_BENCHMARK_S3 to "bucket/prefix" adds runs
+// against S3. Use `--benchmark_format=json` or `--benchmark_out=<file>` to
+// keep the results for comparison.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mdio/coordinate_selector.h"
+#include "mdio/dataset.h"
+#include "mdio/variable.h"
+
+// clang-format off
+#include <nlohmann/json.hpp>  // NOLINT
+// clang-format on
+
+namespace {
+
+constexpr char kLocalRoot[] = "benchmark_data";
+
+// The dimensions of the benchmark Dataset.
+constexpr mdio::Index kInlines = 256;
+constexpr mdio::Index kCrosslines = 64;
+constexpr mdio::Index kSamples = 256;
+
+enum class Store { kMemory, kFile, kS3 };
+
+const char* StoreName(Store store) {
+  switch (store) {
+    case Store::kMemory:
+      return "memory";
+    case Store::kFile:
+      return "file";
+    default:
+      return "s3";
+  }
+}
+
+// The "bucket/prefix" of the S3 runs, empty if they are disabled.
+std::string S3Root() {
+  const char* root = std::getenv("MDIO_BENCHMARK_S3");
+  return root ? root : "";
+}
+
+::nlohmann::json KvStore(Store store, const std::string& name) {
+  if (store == Store::kMemory) {
+    return {{"driver", "memory"}, {"path", name}};
+  }
+  if (store == Store::kFile) {
+    return {{"driver", "file"}, {"path", std::string(kLocalRoot) + "/" + name}};
+  }
+  const auto root = S3Root();
+  const auto slash = root.find('/');
+  const auto prefix =
+      slash == std::string::npos ? "" : root.substr(slash + 1) + "/";
+  return {{"driver", "s3"},
+          {"bucket", root.substr(0, slash)},
+          {"path", prefix + name}};
+}
+
+std::string DatasetPath(Store store, const std::string& name) {
+  if (store == Store::kS3) {
+    return "s3://" + S3Root() + "/" + name;
+  }
+  return std::string(kLocalRoot) + "/" + name;
+}
+
+// The compressors of the Variable benchmarks, by index.
+::nlohmann::json Compressor(int64_t index) {
+  if (index == 1) {
+    return {{"id", "blosc"}, {"cname", "lz4"}, {"clevel", 5}, {"shuffle", 1}};
+  }
+  if (index == 2) {
+    return {{"id", "zstd"}, {"level", 3}};
+  }
+  return nullptr;
+}
+
+::nlohmann::json VariableSpec(Store store, const std::string& name,
+                              mdio::Index chunk, int64_t compressor) {
+  return {
+      {"driver", "zarr"},
+      {"kvstore", KvStore(store, name)},
+      {"attributes",
+       {{"long_name", "benchmark"},
+        {"dimension_names", {"inline", "crossline", "sample"}}}},
+      {"metadata",
+       {{"dtype", "<f4"},
+        {"shape", {kInlines / 2, kCrosslines * 2, kSamples}},
+        {"chunks", {chunk, chunk, kSamples}},
+        {"compressor", Compressor(compressor)},
+        {"fill_value", 0.0},
+        {"dimension_separator", "/"}}},
+  };
+}
+
+// Fills the samples with a smooth signal, so compression has work to do.
+void FillSignal(mdio::VariableData<float>& data) {
+  auto ptr = data.get_data_accessor().data() + data.get_flattened_offset();
+  for (mdio::Index i = 0; i < data.num_samples(); ++i) {
+    ptr[i] = std::sin(static_cast<float>(i % kSamples) * 0.05f) *
+             static_cast<float>(i / kSamples % 17);
+  }
+}
+
+void BM_VariableWrite(benchmark::State& state, Store store) {
+  const auto name = "write_" + std::to_string(state.range(0)) + "_" +
+                    std::to_string(state.range(1));
+  auto var = mdio::Variable<float>::Open(
+                 VariableSpec(store, name, state.range(0), state.range(1)),
+                 mdio::constants::kCreateClean)
+                 .result();
+  if (!var.ok()) {
+    state.SkipWithError(var.status().ToString().c_str());
+    return;
+  }
+  auto data = mdio::from_variable<float>(var.value());
+  if (!data.ok()) {
+    state.SkipWithError(data.status().ToString().c_str());
+    return;
+  }
+  FillSignal(data.value());
+  for (auto _ : state) {
+    auto written = var->Write(data.value()).commit_future.result();
+    if (!written.ok()) {
+      state.SkipWithError(written.status().ToString().c_str());
+      break;
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * data->num_samples() *
+                          sizeof(float));
+}
+
+void BM_VariableRead(benchmark::State& state, Store store) {
+  const auto name = "read_" + std::to_string(state.range(0)) + "_" +
+                    std::to_string(state.range(1));
+  auto var = mdio::Variable<float>::Open(
+                 VariableSpec(store, name, state.range(0), state.range(1)),
+                 mdio::constants::kCreateClean)
+                 .result();
+  if (!var.ok()) {
+    state.SkipWithError(var.status().ToString().c_str());
+    return;
+  }
+  auto data = mdio::from_variable<float>(var.value());
+  if (!data.ok()) {
+    state.SkipWithError(data.status().ToString().c_str());
+    return;
+  }
+  FillSignal(data.value());
+  auto written = var->Write(data.value()).commit_future.result();
+  if (!written.ok()) {
+    state.SkipWithError(written.status().ToString().c_str());
+    return;
+  }
+  for (auto _ : state) {
+    auto read = var->Read().result();
+    if (!read.ok()) {
+      state.SkipWithError(read.status().ToString().c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(read->get_data_accessor().data());
+  }
+  state.SetBytesProcessed(state.iterations() * data->num_samples() *
+                          sizeof(float));
+}
+
+// A seismic Dataset with a live mask and `num_headers` trace headers.
+::nlohmann::json DatasetSchema(int64_t num_headers) {
+  auto chunks = [](std::vector<mdio::Index> shape) {
+    return ::nlohmann::json{
+        {"chunkGrid",
+         {{"name", "regular"}, {"configuration", {{"chunkShape", shape}}}}}};
+  };
+  auto variables = ::nlohmann::json::array();
+  variables.push_back({{"name", "seismic"},
+                       {"dataType", "float32"},
+                       {"dimensions",
+                        {{{"name", "inline"}, {"size", kInlines}},
+                         {{"name", "crossline"}, {"size", kCrosslines}},
+                         {{"name", "sample"}, {"size", kSamples}}}},
+                       {"metadata", chunks({16, 16, kSamples})},
+                       {"coordinates", {"live_mask"}}});
+  variables.push_back({{"name", "live_mask"},
+                       {"dataType", "bool"},
+                       {"dimensions", {"inline", "crossline"}},
+                       {"metadata", chunks({64, kCrosslines})}});
+  for (int64_t i = 0; i < num_headers; ++i) {
+    variables.push_back({{"name", "header_" + std::to_string(i)},
+                         {"dataType", "int32"},
+                         {"dimensions", {"inline", "crossline"}},
+                         {"metadata", chunks({64, kCrosslines})}});
+  }
+  for (const auto& [dim, size] :
+       std::vector<std::pair<std::string, mdio::Index>>{
+           {"inline", kInlines},
+           {"crossline", kCrosslines},
+           {"sample", kSamples}}) {
+    variables.push_back({{"name", dim},
+                         {"dataType", "uint32"},
+                         {"dimensions", {{{"name", dim}, {"size", size}}}}});
+  }
+  return {{"metadata",
+           {{"name", "benchmark"},
+            {"apiVersion", "1.0.0"},
+            {"createdOn", "2025-01-01T00:00:00.000000-06:00"}}},
+          {"variables", variables}};
+}
+
+// Writes `value(i)` to every flattened index `i` of a Variable.
+template <typename T, typename F>
+mdio::Result<void> Fill(mdio::Dataset& dataset, const std::string& name,
+                        F&& value) {
+  MDIO_ASSIGN_OR_RETURN(auto var, dataset.variables.get<T>(name))
+  MDIO_ASSIGN_OR_RETURN(auto data, mdio::from_variable<T>(var))
+  auto ptr = data.get_data_accessor().data() + data.get_flattened_offset();
+  for (mdio::Index i = 0; i < data.num_samples(); ++i) {
+    ptr[i] = value(i);
+  }
+  auto written = var.Write(data).commit_future.result();
+  if (!written.ok()) {
+    return written.status();
+  }
+  return absl::OkStatus();
+}
+
+mdio::Result<void> Populate(mdio::Dataset& dataset, int64_t num_headers) {
+  auto status = Fill<float>(dataset, "seismic", [](mdio::Index i) {
+    return std::sin(static_cast<float>(i % kSamples) * 0.05f);
+  });
+  // Every fourth trace is dead, so a filter keeps many short runs.
+  if (status.ok()) {
+    status = Fill<bool>(dataset, "live_mask",
+                        [](mdio::Index i) { return i % 4 != 3; });
+  }
+  // Sorting by the first header reverses the traces.
+  const mdio::Index traces = kInlines * kCrosslines;
+  for (int64_t h = 0; status.ok() && h < num_headers; ++h) {
+    status = Fill<int32_t>(dataset, "header_" + std::to_string(h),
+                           [traces](mdio::Index i) {
+                             return static_cast<int32_t>(traces - i);
+                           });
+  }
+  for (const auto& dim : {"inline", "crossline", "sample"}) {
+    if (status.ok()) {
+      status = Fill<uint32_t>(dataset, dim, [](mdio::Index i) {
+        return static_cast<uint32_t>(i);
+      });
+    }
+  }
+  return status;
+}
+
+// Creates the Dataset of a store and number of headers once per process.
+mdio::Result<mdio::Dataset> GetDataset(Store store, int64_t num_headers,
+                                       bool populate = true) {
+  static std::mutex mutex;
+  static std::map<std::string, mdio::Dataset> datasets;
+  std::lock_guard<std::mutex> lock(mutex);
+  const auto path = DatasetPath(
+      store, "dataset_" + std::to_string(num_headers) +
+                 (populate ? "" : "_empty") + ".mdio");
+  auto found = datasets.find(path);
+  if (found != datasets.end()) {
+    return found->second;
+  }
+  auto schema = DatasetSchema(num_headers);
+  MDIO_ASSIGN_OR_RETURN(auto dataset,
+                        mdio::Dataset::from_json(schema, path,
+                                                 mdio::constants::kCreateClean)
+                            .result())
+  if (populate) {
+    auto populated = Populate(dataset, num_headers);
+    if (!populated.ok()) {
+      return populated.status();
+    }
+  }
+  datasets.emplace(path, dataset);
+  return dataset;
+}
+
+void BM_DatasetOpen(benchmark::State& state, Store store) {
+  const bool memoized = state.range(1);
+  auto dataset = GetDataset(store, state.range(0), /*populate=*/false);
+  if (!dataset.ok()) {
+    state.SkipWithError(dataset.status().ToString().c_str());
+    return;
+  }
+  const auto path =
+      DatasetPath(store, "dataset_" + std::to_string(state.range(0)) +
+                             "_empty.mdio");
+  for (auto _ : state) {
+    if (!memoized) {
+      state.PauseTiming();
+      auto& memo = mdio::internal::ProcessConsolidatedMemo();
+      {
+        std::lock_guard<std::mutex> lock(memo.mutex);
+        memo.entries.clear();
+      }
+      state.ResumeTiming();
+    }
+    auto opened = mdio::Dataset::Open(path, mdio::constants::kOpen).result();
+    if (!opened.ok()) {
+      state.SkipWithError(opened.status().ToString().c_str());
+      break;
+    }
+  }
+  state.counters["variables"] = state.range(0) + 5;
+}
+
+// Slices `num_slices` single inlines, spread over the Dataset.
+std::vector<mdio::RangeDescriptor<mdio::Index>> InlineSlices(
+    int64_t num_slices) {
+  std::vector<mdio::RangeDescriptor<mdio::Index>> slices;
+  const mdio::Index spacing = std::max<mdio::Index>(kInlines / num_slices, 1);
+  for (mdio::Index il = 0; il < kInlines &&
+                         static_cast<int64_t>(slices.size()) < num_slices;
+       il += spacing) {
+    slices.push_back({"inline", il, il + 1, 1});
+  }
+  return slices;
+}
+
+void BM_DatasetIsel(benchmark::State& state, Store store) {
+  auto dataset = GetDataset(store, 1);
+  if (!dataset.ok()) {
+    state.SkipWithError(dataset.status().ToString().c_str());
+    return;
+  }
+  const auto slices = InlineSlices(state.range(0));
+  for (auto _ : state) {
+    auto slice = dataset->isel(slices);
+    if (!slice.ok()) {
+      state.SkipWithError(slice.status().ToString().c_str());
+      break;
+    }
+    // Variables are sliced on access.
+    auto seismic = slice->variables.at("seismic");
+    benchmark::DoNotOptimize(seismic);
+  }
+}
+
+void BM_DatasetIselRead(benchmark::State& state, Store store) {
+  auto dataset = GetDataset(store, 1);
+  if (!dataset.ok()) {
+    state.SkipWithError(dataset.status().ToString().c_str());
+    return;
+  }
+  const auto slices = InlineSlices(state.range(0));
+  for (auto _ : state) {
+    auto slice = dataset->isel(slices);
+    if (!slice.ok()) {
+      state.SkipWithError(slice.status().ToString().c_str());
+      break;
+    }
+    auto seismic = slice->variables.get<float>("seismic");
+    if (!seismic.ok()) {
+      state.SkipWithError(seismic.status().ToString().c_str());
+      break;
+    }
+    auto read = seismic->Read().result();
+    if (!read.ok()) {
+      state.SkipWithError(read.status().ToString().c_str());
+      break;
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) * kCrosslines *
+                          kSamples * sizeof(float));
+}
+
+void BM_DatasetSel(benchmark::State& state, Store store) {
+  auto dataset = GetDataset(store, 1);
+  if (!dataset.ok()) {
+    state.SkipWithError(dataset.status().ToString().c_str());
+    return;
+  }
+  std::vector<uint32_t> values;
+  for (const auto& slice : InlineSlices(state.range(0))) {
+    values.push_back(static_cast<uint32_t>(slice.start));
+  }
+  mdio::ListDescriptor<uint32_t> inlines = {"inline", values};
+  for (auto _ : state) {
+    auto slice = dataset->sel(inlines);
+    if (!slice.ok()) {
+      state.SkipWithError(slice.status().ToString().c_str());
+      break;
+    }
+  }
+}
+
+// The stages of a CoordinateSelector, each timed with the ones before it.
+enum class Selection { kFilter, kSort, kRead };
+
+void BM_CoordinateSelector(benchmark::State& state, Store store,
+                           Selection stage) {
+  auto dataset = GetDataset(store, 1);
+  if (!dataset.ok()) {
+    state.SkipWithError(dataset.status().ToString().c_str());
+    return;
+  }
+  mdio::ValueDescriptor<bool> live = {"live_mask", true};
+  for (auto _ : state) {
+    mdio::CoordinateSelector selector(dataset.value());
+    auto status = selector.filterByCoordinate(live).status();
+    if (status.ok() && stage != Selection::kFilter) {
+      status = selector.sortSelectionByKey<int32_t>("header_0").status();
+    }
+    if (status.ok() && stage == Selection::kRead) {
+      status = selector.readSelection<float>("seismic").status();
+    }
+    if (!status.ok()) {
+      state.SkipWithError(status.ToString().c_str());
+      break;
+    }
+  }
+}
+
+void BM_CommitMetadata(benchmark::State& state, Store store) {
+  auto created = GetDataset(store, state.range(0), /*populate=*/false);
+  if (!created.ok()) {
+    state.SkipWithError(created.status().ToString().c_str());
+    return;
+  }
+  // A Dataset of its own, so the commits don't race other benchmarks' reads.
+  const auto path =
+      DatasetPath(store, "dataset_" + std::to_string(state.range(0)) +
+                             "_empty.mdio");
+  auto dataset = mdio::Dataset::Open(path, mdio::constants::kOpen).result();
+  if (!dataset.ok()) {
+    state.SkipWithError(dataset.status().ToString().c_str());
+    return;
+  }
+  int64_t revision = 0;
+  for (auto _ : state) {
+    auto seismic = dataset->variables.at("seismic");
+    if (!seismic.ok()) {
+      state.SkipWithError(seismic.status().ToString().c_str());
+      break;
+    }
+    auto attrs = seismic->GetAttributes();
+    attrs["attributes"]["revision"] = ++revision;
+    auto updated = seismic->UpdateAttributes<float>(attrs);
+    if (!updated.status().ok()) {
+      state.SkipWithError(updated.status().ToString().c_str());
+      break;
+    }
+    auto committed = dataset->CommitMetadata().result();
+    if (!committed.ok()) {
+      state.SkipWithError(committed.status().ToString().c_str());
+      break;
+    }
+  }
+  state.counters["variables"] = state.range(0) + 5;
+}
+
+void RegisterBenchmarks(Store store) {
+  const std::string suffix = std::string("/") + StoreName(store);
+  for (auto [name, fn] :
+       std::vector<std::pair<std::string, void (*)(benchmark::State&, Store)>>{
+           {"Variable/Write", BM_VariableWrite},
+           {"Variable/Read", BM_VariableRead}}) {
+    benchmark::RegisterBenchmark((name + suffix).c_str(), fn, store)
+        ->ArgsProduct({{16, 32, 64}, {0, 1, 2}})
+        ->ArgNames({"chunk", "compressor"})
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+  }
+  // Datasets are only addressed by file and cloud paths.
+  if (store == Store::kMemory) {
+    return;
+  }
+  benchmark::RegisterBenchmark(("Dataset/Open" + suffix).c_str(),
+                               BM_DatasetOpen, store)
+      ->ArgsProduct({{1, 32, 256}, {0, 1}})
+      ->ArgNames({"headers", "memoized"})
+      ->Unit(benchmark::kMicrosecond)
+      ->UseRealTime();
+  benchmark::RegisterBenchmark(("Dataset/isel" + suffix).c_str(),
+                               BM_DatasetIsel, store)
+      ->RangeMultiplier(8)
+      ->Range(1, kInlines)
+      ->ArgName("slices")
+      ->Unit(benchmark::kMicrosecond);
+  benchmark::RegisterBenchmark(("Dataset/iselRead" + suffix).c_str(),
+                               BM_DatasetIselRead, store)
+      ->RangeMultiplier(8)
+      ->Range(1, kInlines)
+      ->ArgName("slices")
+      ->Unit(benchmark::kMillisecond)
+      ->UseRealTime();
+  benchmark::RegisterBenchmark(("Dataset/sel" + suffix).c_str(),
+                               BM_DatasetSel, store)
+      ->RangeMultiplier(8)
+      ->Range(1, kInlines)
+      ->ArgName("values")
+      ->Unit(benchmark::kMillisecond)
+      ->UseRealTime();
+  for (auto [name, stage] : std::vector<std::pair<std::string, Selection>>{
+           {"CoordinateSelector/filter", Selection::kFilter},
+           {"CoordinateSelector/filterSort", Selection::kSort},
+           {"CoordinateSelector/filterSortRead", Selection::kRead}}) {
+    benchmark::RegisterBenchmark((name + suffix).c_str(),
+                                 BM_CoordinateSelector, store, stage)
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+  }
+  benchmark::RegisterBenchmark(("Dataset/CommitMetadata" + suffix).c_str(),
+                               BM_CommitMetadata, store)
+      ->Arg(1)
+      ->Arg(32)
+      ->Arg(256)
+      ->ArgName("headers")
+      ->Unit(benchmark::kMillisecond)
+      ->UseRealTime();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  RegisterBenchmarks(Store::kMemory);
+  RegisterBenchmarks(Store::kFile);
+  if (!S3Root().empty()) {
+    RegisterBenchmarks(Store::kS3);
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  std::filesystem::remove_all(kLocalRoot);
+  return 0;
+}
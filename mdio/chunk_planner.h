@@ -0,0 +1,217 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MDIO_CHUNK_PLANNER_H_
+#define MDIO_CHUNK_PLANNER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace mdio {
+
+/**
+ * @brief The dominant way a Variable will be read, used to plan its chunks.
+ * The last dimension is taken to be the sample (time or depth) axis and the
+ * first to be the slowest spatial axis (inline).
+ */
+enum class AccessHint {
+  /// Whole traces, chunks are long along the last dimension.
+  kTrace,
+  /// Slices of a fixed first index, chunks are thin along the first dimension.
+  kInline,
+  /// Slices of a fixed sample, chunks are thin along the last dimension.
+  kTime,
+  /// No preferred direction, chunks are as close to cubes as the shape allows.
+  kBalanced,
+};
+
+/**
+ * @brief Options for `PlanChunkShape` and `CheckChunkShape`.
+ */
+struct ChunkPlanOptions {
+  /// The size a planned chunk aims for, before compression.
+  uint64_t target_bytes = 4 * 1024 * 1024;
+  /// Chunks smaller than this are reported as tiny.
+  uint64_t min_bytes = 64 * 1024;
+  /// Chunks larger than this are reported as oversized.
+  uint64_t max_bytes = 1024 * 1024 * 1024;
+  AccessHint hint = AccessHint::kBalanced;
+};
+
+namespace internal {
+
+/**
+ * @brief Gives `budget` elements to the dimensions in `dims` as evenly as
+ * their extents allow. Dimensions smaller than their share get their full
+ * extent and the remainder goes to the larger ones.
+ * @return The budget left over, at least 1.
+ */
+inline uint64_t FillChunkDimensions(const std::vector<uint64_t>& shape,
+                                    std::vector<std::size_t> dims,
+                                    uint64_t budget,
+                                    std::vector<uint64_t>& chunks) {
+  std::stable_sort(dims.begin(), dims.end(),
+                   [&shape](std::size_t a, std::size_t b) {
+                     return shape[a] < shape[b];
+                   });
+  for (std::size_t i = 0; i < dims.size(); ++i) {
+    const double share =
+        std::pow(static_cast<double>(budget), 1.0 / (dims.size() - i));
+    // Guard the floor against the root landing just below an integer.
+    const auto side = static_cast<uint64_t>(std::floor(share + 1e-9));
+    const uint64_t chunk = std::clamp<uint64_t>(side, 1, shape[dims[i]]);
+    chunks[dims[i]] = chunk;
+    budget = std::max<uint64_t>(budget / chunk, 1);
+  }
+  return budget;
+}
+
+}  // namespace internal
+
+/**
+ * @brief Parses the `accessPattern` of a MDIO chunk hint.
+ * @param name One of "trace", "inline", "time" or "balanced".
+ * @return The hint or `std::nullopt` if the name is unknown.
+ */
+inline std::optional<AccessHint> AccessHintFromString(const std::string& name) {
+  if (name == "trace") {
+    return AccessHint::kTrace;
+  } else if (name == "inline") {
+    return AccessHint::kInline;
+  } else if (name == "time") {
+    return AccessHint::kTime;
+  } else if (name == "balanced") {
+    return AccessHint::kBalanced;
+  }
+  return std::nullopt;
+}
+
+/**
+ * @brief Chooses a chunk shape for an array.
+ * The preferred dimensions of the hint are filled first, then what is left of
+ * the `target_bytes` is spread over the others. An array that fits the target
+ * is a single chunk.
+ * @param shape The shape of the array.
+ * @param item_bytes The size of one element.
+ * @param options The target size and access hint.
+ * @details \b Usage
+ * @code
+ * mdio::ChunkPlanOptions options;
+ * options.hint = mdio::AccessHint::kTrace;
+ * // {26, 26, 1500} for float32
+ * auto chunks = mdio::PlanChunkShape({2000, 2000, 1500}, 4, options);
+ * @endcode
+ * @return The chunk shape, of the same rank as `shape`.
+ */
+inline std::vector<uint64_t> PlanChunkShape(
+    const std::vector<uint64_t>& shape, uint64_t item_bytes,
+    const ChunkPlanOptions& options = {}) {
+  const std::size_t rank = shape.size();
+  const uint64_t item = std::max<uint64_t>(item_bytes, 1);
+  const uint64_t budget = std::max<uint64_t>(options.target_bytes / item, 1);
+  bool fits = true;
+  uint64_t total = 1;
+  for (auto extent : shape) {
+    extent = std::max<uint64_t>(extent, 1);
+    if (extent > budget / total) {
+      fits = false;
+      break;
+    }
+    total *= extent;
+  }
+  if (rank == 0 || fits) {
+    return shape;
+  }
+
+  std::vector<std::size_t> preferred;
+  std::vector<std::size_t> others;
+  for (std::size_t d = 0; d < rank; ++d) {
+    bool is_preferred = true;
+    if (rank > 1) {
+      switch (options.hint) {
+        case AccessHint::kTrace:
+          is_preferred = d == rank - 1;
+          break;
+        case AccessHint::kInline:
+          is_preferred = d != 0;
+          break;
+        case AccessHint::kTime:
+          is_preferred = d != rank - 1;
+          break;
+        case AccessHint::kBalanced:
+          break;
+      }
+    }
+    (is_preferred ? preferred : others).push_back(d);
+  }
+
+  std::vector<uint64_t> extents(rank);
+  for (std::size_t d = 0; d < rank; ++d) {
+    extents[d] = std::max<uint64_t>(shape[d], 1);
+  }
+  std::vector<uint64_t> chunks(rank, 1);
+  const uint64_t left =
+      internal::FillChunkDimensions(extents, preferred, budget, chunks);
+  internal::FillChunkDimensions(extents, others, left, chunks);
+  return chunks;
+}
+
+/**
+ * @brief Checks an explicit chunk shape against the planner's size bounds.
+ * A chunk covering the whole array is never reported as tiny.
+ * @param shape The shape of the array.
+ * @param chunks The chunk shape.
+ * @param item_bytes The size of one element.
+ * @param options The size bounds.
+ * @return A description of the problem, or `std::nullopt` if the chunks are
+ * reasonably sized.
+ */
+inline std::optional<std::string> CheckChunkShape(
+    const std::vector<uint64_t>& shape, const std::vector<uint64_t>& chunks,
+    uint64_t item_bytes, const ChunkPlanOptions& options = {}) {
+  if (chunks.size() != shape.size()) {
+    return std::nullopt;
+  }
+  uint64_t chunk_bytes = std::max<uint64_t>(item_bytes, 1);
+  bool whole_array = true;
+  for (std::size_t d = 0; d < chunks.size(); ++d) {
+    const uint64_t extent =
+        std::max<uint64_t>(std::min(chunks[d], shape[d]), 1);
+    // Saturate rather than wrap for very large chunks.
+    chunk_bytes = extent > std::numeric_limits<uint64_t>::max() / chunk_bytes
+                      ? std::numeric_limits<uint64_t>::max()
+                      : chunk_bytes * extent;
+    whole_array = whole_array && chunks[d] >= shape[d];
+  }
+  if (chunk_bytes > options.max_bytes) {
+    return "chunks of " + std::to_string(chunk_bytes) +
+           " bytes exceed the recommended maximum of " +
+           std::to_string(options.max_bytes) + " bytes";
+  }
+  if (chunk_bytes < options.min_bytes && !whole_array) {
+    return "chunks of " + std::to_string(chunk_bytes) +
+           " bytes are below the recommended minimum of " +
+           std::to_string(options.min_bytes) + " bytes";
+  }
+  return std::nullopt;
+}
+
+}  // namespace mdio
+
+#endif  // MDIO_CHUNK_PLANNER_H_
@@ -0,0 +1,94 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mdio/chunk_planner.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+const std::vector<uint64_t> kCube = {2000, 2000, 1500};
+
+uint64_t ChunkBytes(const std::vector<uint64_t>& chunks, uint64_t item_bytes) {
+  uint64_t bytes = item_bytes;
+  for (auto chunk : chunks) {
+    bytes *= chunk;
+  }
+  return bytes;
+}
+
+TEST(ChunkPlanner, smallArrayIsOneChunk) {
+  std::vector<uint64_t> shape = {10, 20, 30};
+  EXPECT_EQ(mdio::PlanChunkShape(shape, 4), shape);
+}
+
+TEST(ChunkPlanner, hints) {
+  mdio::ChunkPlanOptions options;
+
+  options.hint = mdio::AccessHint::kBalanced;
+  EXPECT_EQ(mdio::PlanChunkShape(kCube, 4, options),
+            (std::vector<uint64_t>{101, 102, 101}));
+
+  options.hint = mdio::AccessHint::kTrace;
+  EXPECT_EQ(mdio::PlanChunkShape(kCube, 4, options),
+            (std::vector<uint64_t>{26, 26, 1500}));
+
+  options.hint = mdio::AccessHint::kInline;
+  EXPECT_EQ(mdio::PlanChunkShape(kCube, 4, options),
+            (std::vector<uint64_t>{1, 1024, 1024}));
+
+  options.hint = mdio::AccessHint::kTime;
+  EXPECT_EQ(mdio::PlanChunkShape(kCube, 4, options),
+            (std::vector<uint64_t>{1024, 1024, 1}));
+
+  // Every plan stays within the target.
+  for (auto hint : {mdio::AccessHint::kBalanced, mdio::AccessHint::kTrace,
+                    mdio::AccessHint::kInline, mdio::AccessHint::kTime}) {
+    options.hint = hint;
+    EXPECT_LE(ChunkBytes(mdio::PlanChunkShape(kCube, 4, options), 4),
+              options.target_bytes);
+  }
+}
+
+TEST(ChunkPlanner, shortDimensionsGiveWayToLongOnes) {
+  // The 8 samples take their full extent and the rest goes to the others.
+  auto chunks = mdio::PlanChunkShape({5000, 5000, 8}, 4);
+  EXPECT_EQ(chunks, (std::vector<uint64_t>{362, 362, 8}));
+}
+
+TEST(ChunkPlanner, hugeShapeDoesNotOverflow) {
+  const uint64_t huge = 4611686018427387903;
+  auto chunks = mdio::PlanChunkShape({huge, huge}, 8);
+  EXPECT_EQ(chunks, (std::vector<uint64_t>{724, 724}));
+}
+
+TEST(ChunkPlanner, accessHintFromString) {
+  EXPECT_EQ(mdio::AccessHintFromString("trace"), mdio::AccessHint::kTrace);
+  EXPECT_EQ(mdio::AccessHintFromString("time"), mdio::AccessHint::kTime);
+  EXPECT_FALSE(mdio::AccessHintFromString("diagonal").has_value());
+}
+
+TEST(ChunkPlanner, check) {
+  EXPECT_FALSE(mdio::CheckChunkShape(kCube, {128, 128, 128}, 4).has_value());
+  EXPECT_TRUE(mdio::CheckChunkShape(kCube, {4, 4, 4}, 4).has_value());
+  EXPECT_TRUE(mdio::CheckChunkShape(kCube, kCube, 4).has_value());
+  // A small array in a single chunk is fine.
+  EXPECT_FALSE(mdio::CheckChunkShape({10}, {10}, 4).has_value());
+}
+
+}  // namespace
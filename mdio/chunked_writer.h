@@ -0,0 +1,513 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MDIO_CHUNKED_WRITER_H_
+#define MDIO_CHUNKED_WRITER_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mdio/dataset.h"
+#include "mdio/impl.h"
+#include "mdio/variable.h"
+#include "tensorstore/array.h"
+#include "tensorstore/box.h"
+#include "tensorstore/index_space/dim_expression.h"
+#include "tensorstore/transaction.h"
+#include "tensorstore/util/division.h"
+#include "tensorstore/util/future.h"
+
+namespace mdio {
+
+/**
+ * @brief Options for a `ChunkedWriter` or `ChunkedWriterGroup`.
+ */
+struct ChunkedWriterOptions {
+  /// The memory for buffered chunks, including the chunks being written.
+  std::size_t max_buffered_bytes = 512 * 1024 * 1024;
+  /// The number of chunk writes in flight.
+  std::size_t max_in_flight = 16;
+};
+
+namespace internal {
+
+/**
+ * @brief The memory and write budget of one or more ChunkedWriters.
+ * Writes are released in the order they were started.
+ */
+struct ChunkWritePool {
+  /// A chunk being written and the buffer it holds on to.
+  struct Pending {
+    Future<void> done;
+    std::size_t bytes;
+  };
+
+  explicit ChunkWritePool(const ChunkedWriterOptions& options)
+      : options(options) {}
+
+  /**
+   * @brief Releases the finished writes, waiting for the oldest ones while
+   * more than `keep` are in flight.
+   */
+  void Release(std::size_t keep) {
+    while (!in_flight.empty() &&
+           (in_flight.size() > keep || in_flight.front().done.ready())) {
+      auto result = in_flight.front().done.result();
+      if (!result.ok() && status.ok()) {
+        status = result.status();
+      }
+      buffered_bytes -= in_flight.front().bytes;
+      in_flight.pop_front();
+    }
+  }
+
+  /**
+   * @brief Waits for every write in flight.
+   * @return The first error of any write of the pool.
+   */
+  Future<void> Drain() {
+    std::vector<tensorstore::AnyFuture> futures;
+    for (const auto& pending : in_flight) {
+      futures.push_back(pending.done);
+    }
+    in_flight.clear();
+    buffered_bytes = 0;
+    if (!status.ok()) {
+      return status;
+    }
+    return tensorstore::WaitAllFuture(futures);
+  }
+
+  ChunkedWriterOptions options;
+  std::size_t buffered_bytes = 0;
+  std::deque<Pending> in_flight;
+  absl::Status status;
+};
+
+}  // namespace internal
+
+/**
+ * @brief Buffers writes to a Variable into whole chunks.
+ * Incoming blocks, such as single traces, are copied into a buffer per chunk.
+ * A chunk is written as soon as every one of its samples has arrived, so it is
+ * compressed once and never read back. Up to `max_in_flight` chunks are
+ * written concurrently. When the buffers would exceed `max_buffered_bytes` the
+ * fullest partial chunk is written early, and the remaining partial chunks are
+ * written by `Close`.
+ * @pre Every sample is written once. A sample written twice counts twice
+ * towards filling its chunk.
+ * @note A ChunkedWriter is not thread safe, it is driven by one producer.
+ * @details \b Usage
+ * @code
+ * MDIO_ASSIGN_OR_RETURN(auto seismic, ds.variables.get<float>("seismic"));
+ * MDIO_ASSIGN_OR_RETURN(auto writer,
+ *                       mdio::ChunkedWriter<float>::Make(seismic));
+ * for (const auto& trace : traces) {
+ *   // A VariableData of one trace, in the Variable's index space
+ *   MDIO_ASSIGN_OR_RETURN(auto data, MakeTrace(seismic, trace));
+ *   auto written = writer.Write(data);
+ *   if (!written.ok()) {
+ *     return written.status();
+ *   }
+ * }
+ * return writer.Close();
+ * @endcode
+ */
+template <typename T = void>
+class ChunkedWriter {
+ public:
+  /**
+   * @brief Makes a writer with its own memory and write budget.
+   * @param var The Variable, or region of one, to write.
+   * @param options The memory and write budget.
+   */
+  static Result<ChunkedWriter> Make(const Variable<T>& var,
+                                    const ChunkedWriterOptions& options = {}) {
+    return Make(var, std::make_shared<internal::ChunkWritePool>(options));
+  }
+
+  /**
+   * @brief Makes a writer sharing the budget of other writers.
+   * Intended for internal use, see `ChunkedWriterGroup`.
+   */
+  static Result<ChunkedWriter> Make(
+      const Variable<T>& var, std::shared_ptr<internal::ChunkWritePool> pool) {
+    const auto domain = var.dimensions();
+    const DimensionIndex rank = domain.rank();
+    // Dimensions the metadata doesn't chunk, e.g. the bytes of a structured
+    // dtype, are whole.
+    auto chunk_res = var.get_chunk_shape();
+    std::vector<Index> chunk_shape(rank);
+    for (DimensionIndex d = 0; d < rank; ++d) {
+      const bool chunked = chunk_res.ok() &&
+                           d < static_cast<DimensionIndex>(chunk_res->size()) &&
+                           (*chunk_res)[d] > 0;
+      chunk_shape[d] = chunked
+                           ? (*chunk_res)[d]
+                           : std::max<Index>(domain[d].exclusive_max(), 1);
+    }
+    return ChunkedWriter(var, std::move(chunk_shape), std::move(pool));
+  }
+
+  /**
+   * @brief Buffers a block of samples.
+   * Chunks the block completes are written, which may wait for earlier writes
+   * to free their memory.
+   * @param data The samples, in the index space of the Variable.
+   * @return An error if the block is outside the Variable, or the error of an
+   * earlier chunk write.
+   */
+  Result<void> Write(const VariableData<T>& data) {
+    if (closed) {
+      return absl::FailedPreconditionError("The ChunkedWriter is closed.");
+    }
+    if (!pool->status.ok()) {
+      return pool->status;
+    }
+    if (data.dtype() != var.dtype()) {
+      return absl::InvalidArgumentError(
+          "The source and target dtypes do not match.");
+    }
+    const auto& source = data.data.data;
+    const auto domain = var.dimensions();
+    const DimensionIndex rank = domain.rank();
+    if (source.rank() != rank ||
+        !tensorstore::Contains(domain.box(), source.domain())) {
+      return absl::OutOfRangeError(
+          "The block is not inside Variable '" + var.get_variable_name() +
+          "'.");
+    }
+    if (source.num_elements() == 0) {
+      return absl::OkStatus();
+    }
+
+    // Visit every chunk the block overlaps.
+    std::vector<Index> first(rank), last(rank), cell(rank);
+    for (DimensionIndex d = 0; d < rank; ++d) {
+      first[d] = tensorstore::FloorOfRatio(source.origin()[d], chunk_shape[d]);
+      last[d] = tensorstore::FloorOfRatio(
+          source.origin()[d] + source.shape()[d] - 1, chunk_shape[d]);
+    }
+    cell = first;
+    while (true) {
+      MDIO_ASSIGN_OR_RETURN(auto buffer, GetBuffer(cell))
+      tensorstore::Box<> region(rank);
+      tensorstore::Intersect(buffer->array.domain(), source.domain(),
+                             tensorstore::MutableBoxView<>(region));
+      MDIO_ASSIGN_OR_RETURN(auto from,
+                            source | tensorstore::AllDims().BoxSlice(region))
+      MDIO_ASSIGN_OR_RETURN(
+          auto to, buffer->array | tensorstore::AllDims().BoxSlice(region))
+      tensorstore::CopyArray(from, to);
+      buffer->filled += region.num_elements();
+      buffer->regions.push_back(region);
+      if (buffer->filled >= buffer->array.num_elements()) {
+        auto flushed = FlushChunk(cell);
+        if (!flushed.ok()) {
+          return flushed.status();
+        }
+      }
+
+      DimensionIndex d = rank - 1;
+      for (; d >= 0; --d) {
+        if (++cell[d] <= last[d]) {
+          break;
+        }
+        cell[d] = first[d];
+      }
+      if (d < 0) {
+        break;
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  /**
+   * @brief Writes every partial chunk without waiting for it.
+   * @return The error of an earlier chunk write, if any.
+   */
+  Result<void> Flush() {
+    while (!buffers.empty()) {
+      auto flushed = FlushChunk(buffers.begin()->first);
+      if (!flushed.ok()) {
+        return flushed.status();
+      }
+    }
+    return pool->status;
+  }
+
+  /**
+   * @brief Writes the partial chunks and waits for every write.
+   * The writer can't be written to afterwards.
+   * @return A future that is ready once every chunk is committed.
+   */
+  Future<void> Close() {
+    closed = true;
+    auto flushed = Flush();
+    if (!flushed.ok()) {
+      return flushed.status();
+    }
+    return pool->Drain();
+  }
+
+  /**
+   * @brief Gets the number of chunks that are waiting for more samples.
+   */
+  std::size_t num_partial_chunks() const { return buffers.size(); }
+
+  /**
+   * @brief Gets the shape of the chunks the writer fills.
+   */
+  const std::vector<Index>& get_chunk_shape() const { return chunk_shape; }
+
+ private:
+  /// The samples of one chunk received so far.
+  struct Buffer {
+    SharedArray<T, dynamic_rank, offset_origin> array;
+    Index filled = 0;
+    /// The received blocks, written on their own if the chunk isn't complete.
+    std::vector<tensorstore::Box<>> regions;
+  };
+
+  ChunkedWriter(const Variable<T>& var, std::vector<Index> chunk_shape,
+                std::shared_ptr<internal::ChunkWritePool> pool)
+      : var(var), chunk_shape(std::move(chunk_shape)), pool(std::move(pool)) {}
+
+  /**
+   * @brief Gets the buffer of a chunk, allocating it once there is room.
+   */
+  Result<Buffer*> GetBuffer(const std::vector<Index>& cell) {
+    auto found = buffers.find(cell);
+    if (found != buffers.end()) {
+      return &found->second;
+    }
+
+    // The chunk clamped to the Variable.
+    const auto domain = var.dimensions();
+    const DimensionIndex rank = domain.rank();
+    tensorstore::Box<> chunk(rank);
+    for (DimensionIndex d = 0; d < rank; ++d) {
+      chunk[d] = tensorstore::IndexInterval::UncheckedHalfOpen(
+          cell[d] * chunk_shape[d], (cell[d] + 1) * chunk_shape[d]);
+    }
+    tensorstore::Intersect(chunk, domain.box(),
+                           tensorstore::MutableBoxView<>(chunk));
+    const std::size_t bytes = chunk.num_elements() * var.dtype().size();
+
+    // Make room, first by waiting for writes then by writing partial chunks.
+    auto* pool = this->pool.get();
+    pool->Release(pool->options.max_in_flight);
+    while (pool->buffered_bytes + bytes > pool->options.max_buffered_bytes) {
+      if (!pool->in_flight.empty()) {
+        pool->Release(pool->in_flight.size() - 1);
+      } else if (!buffers.empty()) {
+        auto fullest = std::max_element(
+            buffers.begin(), buffers.end(), [](const auto& a, const auto& b) {
+              return a.second.filled < b.second.filled;
+            });
+        auto flushed = FlushChunk(fullest->first);
+        if (!flushed.ok()) {
+          return flushed.status();
+        }
+      } else {
+        // A single chunk larger than the budget is still written.
+        break;
+      }
+    }
+    if (!pool->status.ok()) {
+      return pool->status;
+    }
+
+    auto array = tensorstore::AllocateArray(chunk, tensorstore::c_order,
+                                            tensorstore::default_init,
+                                            var.dtype());
+    pool->buffered_bytes += bytes;
+    Buffer buffer;
+    buffer.array = tensorstore::StaticDataTypeCast<T, tensorstore::unchecked>(
+        std::move(array));
+    return &buffers.emplace(cell, std::move(buffer)).first->second;
+  }
+
+  /**
+   * @brief Starts writing the buffer of a chunk, waiting for a free slot.
+   * The cell is taken by value as it may be the key that is erased.
+   */
+  Result<void> FlushChunk(std::vector<Index> cell) {
+    auto found = buffers.find(cell);
+    if (found == buffers.end()) {
+      return absl::OkStatus();
+    }
+    Buffer buffer = std::move(found->second);
+    buffers.erase(found);
+    const std::size_t bytes = buffer.array.num_elements() * var.dtype().size();
+
+    pool->Release(pool->options.max_in_flight > 0
+                      ? pool->options.max_in_flight - 1
+                      : 0);
+    auto written = pool->status.ok() ? WriteBuffer(buffer)
+                                     : Result<Future<void>>(pool->status);
+    if (!written.ok()) {
+      pool->buffered_bytes -= bytes;
+      if (pool->status.ok()) {
+        pool->status = written.status();
+      }
+      return written.status();
+    }
+    pool->in_flight.push_back({std::move(written).value(), bytes});
+    return absl::OkStatus();
+  }
+
+  /**
+   * @brief Writes the received samples of a chunk.
+   * A complete chunk is written whole. Otherwise only the received regions
+   * are written, in one transaction so the chunk is read and written once.
+   */
+  Result<Future<void>> WriteBuffer(const Buffer& buffer) {
+    const bool whole = buffer.filled >= buffer.array.num_elements();
+    tensorstore::Transaction transaction(tensorstore::isolated);
+    std::vector<tensorstore::AnyFuture> futures;
+    for (std::size_t i = 0; i < (whole ? 1 : buffer.regions.size()); ++i) {
+      const tensorstore::BoxView<> region =
+          whole ? buffer.array.domain() : buffer.regions[i];
+      MDIO_ASSIGN_OR_RETURN(
+          auto array, buffer.array | tensorstore::AllDims().BoxSlice(region))
+      auto store = var.get_store();
+      if (!whole) {
+        MDIO_ASSIGN_OR_RETURN(store, store | transaction)
+      }
+      MDIO_ASSIGN_OR_RETURN(store,
+                            store | tensorstore::AllDims().BoxSlice(region))
+      // Written through the Variable, which quantizes and tracks statistics.
+      Variable<T> target = var;
+      target.set_store(store);
+      LabeledArray<T, dynamic_rank, offset_origin> labeled{target.dimensions(),
+                                                           array};
+      VariableData<T> data{var.get_variable_name(), var.get_long_name(),
+                           var.getMetadata(), labeled};
+      auto write = target.Write(data);
+      if (whole) {
+        return write.commit_future;
+      }
+      futures.push_back(write.copy_future);
+    }
+    futures.push_back(transaction.CommitAsync());
+    return tensorstore::WaitAllFuture(futures);
+  }
+
+  Variable<T> var;
+  std::vector<Index> chunk_shape;
+  std::shared_ptr<internal::ChunkWritePool> pool;
+  /// The partial chunks, by their position in the chunk grid.
+  std::map<std::vector<Index>, Buffer> buffers;
+  bool closed = false;
+};
+
+/**
+ * @brief Writes several Variables of a Dataset in lockstep.
+ * Each Variable gets a `ChunkedWriter`, and all of them share one memory and
+ * write budget. This suits ingest that writes the samples and the headers of
+ * each trace together.
+ * @details \b Usage
+ * @code
+ * MDIO_ASSIGN_OR_RETURN(auto writers, mdio::ChunkedWriterGroup::Make(
+ *     ds, {"seismic", "cdp-x", "cdp-y"}));
+ * for (const auto& [name, block] : {std::pair{"seismic", traces},
+ *                                   std::pair{"cdp-x", cdpX},
+ *                                   std::pair{"cdp-y", cdpY}}) {
+ *   auto written = writers.Write(name, block);
+ *   if (!written.ok()) {
+ *     return written.status();
+ *   }
+ * }
+ * return writers.Close();
+ * @endcode
+ */
+class ChunkedWriterGroup {
+ public:
+  /**
+   * @brief Makes a writer for each of the named Variables.
+   * @param dataset The Dataset holding the Variables.
+   * @param names The Variables to write.
+   * @param options The memory and write budget shared by the writers.
+   */
+  static Result<ChunkedWriterGroup> Make(
+      Dataset& dataset, const std::vector<std::string>& names,
+      const ChunkedWriterOptions& options = {}) {
+    ChunkedWriterGroup group;
+    group.pool = std::make_shared<internal::ChunkWritePool>(options);
+    for (const auto& name : names) {
+      MDIO_ASSIGN_OR_RETURN(auto var, dataset.variables.at(name))
+      MDIO_ASSIGN_OR_RETURN(auto writer,
+                            ChunkedWriter<>::Make(var, group.pool))
+      group.writers.emplace(name, std::move(writer));
+    }
+    return group;
+  }
+
+  /**
+   * @brief Buffers a block of samples of one of the Variables.
+   * @see ChunkedWriter::Write
+   */
+  Result<void> Write(const std::string& name, const VariableData<>& data) {
+    auto writer = writers.find(name);
+    if (writer == writers.end()) {
+      return absl::InvalidArgumentError("Variable '" + name +
+                                        "' is not written by this group.");
+    }
+    return writer->second.Write(data);
+  }
+
+  /**
+   * @brief Writes the partial chunks of every Variable and waits for every
+   * write.
+   * @return A future that is ready once every chunk is committed.
+   */
+  Future<void> Close() {
+    for (auto& [name, writer] : writers) {
+      auto flushed = writer.Flush();
+      if (!flushed.ok()) {
+        return flushed.status();
+      }
+    }
+    return pool->Drain();
+  }
+
+  /**
+   * @brief Gets the writer of one of the Variables.
+   */
+  Result<ChunkedWriter<>*> get(const std::string& name) {
+    auto writer = writers.find(name);
+    if (writer == writers.end()) {
+      return absl::InvalidArgumentError("Variable '" + name +
+                                        "' is not written by this group.");
+    }
+    return &writer->second;
+  }
+
+ private:
+  ChunkedWriterGroup() = default;
+
+  std::shared_ptr<internal::ChunkWritePool> pool;
+  std::map<std::string, ChunkedWriter<>> writers;
+};
+
+}  // namespace mdio
+
+#endif  // MDIO_CHUNKED_WRITER_H_
@@ -0,0 +1,257 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mdio/chunked_writer.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+
+// clang-format off
+::nlohmann::json json_chunked = ::nlohmann::json::object({
+    {"driver", "zarr"},
+    {"kvstore",
+        {
+            {"driver", "file"},
+            {"path", "chunked_variable"}
+        }
+    },
+    {"attributes",
+        {
+            {"long_name", "chunked writer test"},
+            {"dimension_names", {"x", "y"} },
+        }
+    },
+    {"metadata",
+        {
+            {"dtype", "<f4"},
+            {"shape", {20, 30}},
+            {"chunks", {8, 16}},
+            {"fill_value", -1.0},
+            {"dimension_separator", "/"},
+        }
+    }
+});
+// clang-format on
+
+// Writes row `x` of the Variable, trace by trace, with the value x * 100 + y.
+mdio::Result<void> WriteRow(mdio::ChunkedWriter<float>& writer,
+                            const mdio::Variable<float>& var, mdio::Index x) {
+  mdio::RangeDescriptor<mdio::Index> desc = {"x", x, x + 1, 1};
+  MDIO_ASSIGN_OR_RETURN(auto row, var.slice(desc))
+  MDIO_ASSIGN_OR_RETURN(auto data, mdio::from_variable<float>(row))
+  auto ptr = data.get_data_accessor().data() + data.get_flattened_offset();
+  for (mdio::Index y = 0; y < 30; ++y) {
+    ptr[y] = static_cast<float>(x * 100 + y);
+  }
+  return writer.Write(data);
+}
+
+TEST(ChunkedWriter, fullChunks) {
+  auto var = mdio::Variable<float>::Open(json_chunked,
+                                         mdio::constants::kCreateClean)
+                 .result();
+  ASSERT_TRUE(var.ok()) << var.status();
+
+  auto writer = mdio::ChunkedWriter<float>::Make(var.value());
+  ASSERT_TRUE(writer.ok()) << writer.status();
+  EXPECT_EQ(writer->get_chunk_shape(), (std::vector<mdio::Index>{8, 16}));
+
+  for (mdio::Index x = 0; x < 8; ++x) {
+    ASSERT_TRUE(WriteRow(writer.value(), var.value(), x).ok());
+  }
+  // The first row of chunks is complete and no longer buffered.
+  EXPECT_EQ(writer->num_partial_chunks(), 0);
+  ASSERT_TRUE(WriteRow(writer.value(), var.value(), 8).ok());
+  EXPECT_EQ(writer->num_partial_chunks(), 2);
+  for (mdio::Index x = 9; x < 20; ++x) {
+    ASSERT_TRUE(WriteRow(writer.value(), var.value(), x).ok());
+  }
+  // The last row of chunks is cut short by the shape and completes early.
+  EXPECT_EQ(writer->num_partial_chunks(), 0);
+  ASSERT_TRUE(writer->Close().result().ok());
+  EXPECT_FALSE(WriteRow(writer.value(), var.value(), 0).ok());
+
+  auto data = var->Read().result();
+  ASSERT_TRUE(data.ok()) << data.status();
+  auto ptr = data->get_data_accessor().data() + data->get_flattened_offset();
+  EXPECT_EQ(ptr[0], 0);
+  EXPECT_EQ(ptr[8 * 30 + 17], 817);
+  EXPECT_EQ(ptr[19 * 30 + 29], 1929);
+
+  std::filesystem::remove_all("chunked_variable");
+}
+
+TEST(ChunkedWriter, boundedMemory) {
+  auto json = json_chunked;
+  json["kvstore"]["path"] = "bounded_variable";
+  auto var =
+      mdio::Variable<float>::Open(json, mdio::constants::kCreateClean).result();
+  ASSERT_TRUE(var.ok()) << var.status();
+
+  // Room for a single chunk, partial chunks are written early.
+  mdio::ChunkedWriterOptions options;
+  options.max_buffered_bytes = 8 * 16 * sizeof(float);
+  options.max_in_flight = 1;
+  auto writer = mdio::ChunkedWriter<float>::Make(var.value(), options);
+  ASSERT_TRUE(writer.ok()) << writer.status();
+  for (mdio::Index x = 0; x < 20; ++x) {
+    ASSERT_TRUE(WriteRow(writer.value(), var.value(), x).ok());
+    EXPECT_LE(writer->num_partial_chunks(), 1);
+  }
+  ASSERT_TRUE(writer->Close().result().ok());
+
+  auto data = var->Read().result();
+  ASSERT_TRUE(data.ok()) << data.status();
+  auto ptr = data->get_data_accessor().data() + data->get_flattened_offset();
+  for (mdio::Index i = 0; i < 600; ++i) {
+    ASSERT_EQ(ptr[i], (i / 30) * 100 + i % 30) << i;
+  }
+
+  // Blocks outside the Variable are rejected.
+  auto other = mdio::from_variable<float>(var.value());
+  ASSERT_TRUE(other.ok()) << other.status();
+  auto small = mdio::Variable<float>::Open(json, mdio::constants::kOpen)
+                   .result();
+  ASSERT_TRUE(small.ok()) << small.status();
+  mdio::RangeDescriptor<mdio::Index> desc = {"x", 0, 10, 1};
+  auto half = small->slice(desc);
+  ASSERT_TRUE(half.ok()) << half.status();
+  auto half_writer = mdio::ChunkedWriter<float>::Make(half.value());
+  ASSERT_TRUE(half_writer.ok()) << half_writer.status();
+  EXPECT_FALSE(half_writer->Write(other.value()).ok());
+
+  std::filesystem::remove_all("bounded_variable");
+}
+
+TEST(ChunkedWriterGroup, lockstep) {
+  const std::string schema = R"(
+{
+  "metadata": {
+    "name": "chunked",
+    "apiVersion": "1.0.0",
+    "createdOn": "2023-12-12T15:02:06.413469-06:00"
+  },
+  "variables": [
+    {
+      "name": "seismic",
+      "dataType": "float32",
+      "dimensions": [
+        {"name": "inline", "size": 8},
+        {"name": "crossline", "size": 8},
+        {"name": "depth", "size": 16}
+      ],
+      "metadata": {
+        "chunkGrid": {
+          "name": "regular",
+          "configuration": {"chunkShape": [4, 4, 16]}
+        }
+      },
+      "coordinates": ["cdp-x"]
+    },
+    {
+      "name": "cdp-x",
+      "dataType": "float64",
+      "dimensions": ["inline", "crossline"],
+      "metadata": {
+        "chunkGrid": {
+          "name": "regular",
+          "configuration": {"chunkShape": [8, 8]}
+        }
+      }
+    },
+    {
+      "name": "inline",
+      "dataType": "uint32",
+      "dimensions": [{"name": "inline", "size": 8}]
+    },
+    {
+      "name": "crossline",
+      "dataType": "uint32",
+      "dimensions": [{"name": "crossline", "size": 8}]
+    },
+    {
+      "name": "depth",
+      "dataType": "uint32",
+      "dimensions": [{"name": "depth", "size": 16}]
+    }
+  ]
+}
+  )";
+  auto dataset =
+      mdio::Dataset::from_json(::nlohmann::json::parse(schema),
+                               "zarrs/chunked", mdio::constants::kCreateClean)
+          .result();
+  ASSERT_TRUE(dataset.ok()) << dataset.status();
+  auto writers =
+      mdio::ChunkedWriterGroup::Make(dataset.value(), {"seismic", "cdp-x"});
+  ASSERT_TRUE(writers.ok()) << writers.status();
+  EXPECT_FALSE(writers->get("depth").ok());
+
+  // One trace and its header at a time.
+  for (mdio::Index il = 0; il < 8; ++il) {
+    for (mdio::Index xl = 0; xl < 8; ++xl) {
+      mdio::RangeDescriptor<mdio::Index> il_desc = {"inline", il, il + 1, 1};
+      mdio::RangeDescriptor<mdio::Index> xl_desc = {"crossline", xl, xl + 1,
+                                                    1};
+      auto trace = dataset->isel(il_desc, xl_desc);
+      ASSERT_TRUE(trace.ok()) << trace.status();
+
+      auto seismic = trace->variables.get<float>("seismic");
+      ASSERT_TRUE(seismic.ok()) << seismic.status();
+      auto samples = mdio::from_variable<float>(seismic.value());
+      ASSERT_TRUE(samples.ok()) << samples.status();
+      auto ptr =
+          samples->get_data_accessor().data() + samples->get_flattened_offset();
+      for (mdio::Index z = 0; z < 16; ++z) {
+        ptr[z] = static_cast<float>(il * 8 + xl);
+      }
+      ASSERT_TRUE(writers->Write("seismic", samples.value()).ok());
+
+      auto cdp = trace->variables.get<double>("cdp-x");
+      ASSERT_TRUE(cdp.ok()) << cdp.status();
+      auto header = mdio::from_variable<double>(cdp.value());
+      ASSERT_TRUE(header.ok()) << header.status();
+      header->get_data_accessor()
+          .data()[header->get_flattened_offset()] = il * 1000.0 + xl;
+      ASSERT_TRUE(writers->Write("cdp-x", header.value()).ok());
+    }
+    // The seismic chunks fill every 4 inlines, cdp-x only at the end.
+    auto seismic_writer = writers->get("seismic");
+    ASSERT_TRUE(seismic_writer.ok()) << seismic_writer.status();
+    EXPECT_EQ((*seismic_writer)->num_partial_chunks(), il % 4 == 3 ? 0 : 2);
+  }
+  ASSERT_TRUE(writers->Close().result().ok());
+
+  auto cdp = dataset->variables.get<double>("cdp-x");
+  ASSERT_TRUE(cdp.ok()) << cdp.status();
+  auto cdp_data = cdp->Read().result();
+  ASSERT_TRUE(cdp_data.ok()) << cdp_data.status();
+  EXPECT_EQ(cdp_data->get_data_accessor().data()[8 * 5 + 3], 5003.0);
+  auto seismic = dataset->variables.get<float>("seismic");
+  ASSERT_TRUE(seismic.ok()) << seismic.status();
+  auto seismic_data = seismic->Read().result();
+  ASSERT_TRUE(seismic_data.ok()) << seismic_data.status();
+  EXPECT_EQ(seismic_data->get_data_accessor().data()[(6 * 8 + 7) * 16 + 9],
+            55.0f);
+
+  std::filesystem::remove_all("zarrs/chunked");
+}
+
+}  // namespace
@@ -0,0 +1,678 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MDIO_COMPUTE_H_
+#define MDIO_COMPUTE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mdio/compute_stats.h"
+#include "mdio/impl.h"
+#include "mdio/variable.h"
+#include "tensorstore/array.h"
+#include "tensorstore/box.h"
+#include "tensorstore/index_space/index_domain_builder.h"
+#include "tensorstore/util/future.h"
+
+// clang-format off
+#include <nlohmann/json.hpp>  // NOLINT
+// clang-format on
+
+namespace mdio {
+
+/**
+ * @brief The reductions of an `Expression`.
+ */
+enum class ReduceOp {
+  kSum,
+  kMean,
+  kMin,
+  kMax,
+  /// The root mean square, e.g. the RMS amplitude of a trace.
+  kRms,
+  /// The number of samples that were kept.
+  kCount,
+};
+
+/**
+ * @brief Options for evaluating an `Expression`.
+ */
+struct ComputeOptions {
+  /// The maximum number of chunks read at once. 0 means unbounded.
+  std::size_t max_in_flight = 64;
+};
+
+namespace internal {
+
+struct IdentityMap {
+  template <typename V>
+  V operator()(const V& value) const {
+    return value;
+  }
+};
+
+template <typename F, typename G>
+struct ComposedMap {
+  F first;
+  G second;
+
+  template <typename V>
+  auto operator()(const V& value) const {
+    return second(first(value));
+  }
+};
+
+/**
+ * @brief Partial reductions of a block of output elements.
+ * Each moment is its own array, so updating neighboring elements vectorizes.
+ */
+struct ReduceBuffer {
+  explicit ReduceBuffer(std::size_t n)
+      : count(n),
+        sum(n),
+        sum_squares(n),
+        min(n, std::numeric_limits<double>::infinity()),
+        max(n, -std::numeric_limits<double>::infinity()) {}
+
+  /// Adds element `from` of `other` to element `to`.
+  void Merge(std::size_t to, const ReduceBuffer& other, std::size_t from) {
+    count[to] += other.count[from];
+    sum[to] += other.sum[from];
+    sum_squares[to] += other.sum_squares[from];
+    min[to] = std::min(min[to], other.min[from]);
+    max[to] = std::max(max[to], other.max[from]);
+  }
+
+  /// The reduction of an element, NaN if it has no samples.
+  double Finish(std::size_t i, ReduceOp op) const {
+    const double n = static_cast<double>(count[i]);
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    switch (op) {
+      case ReduceOp::kSum:
+        return sum[i];
+      case ReduceOp::kCount:
+        return n;
+      case ReduceOp::kMean:
+        return count[i] ? sum[i] / n : nan;
+      case ReduceOp::kMin:
+        return count[i] ? min[i] : nan;
+      case ReduceOp::kMax:
+        return count[i] ? max[i] : nan;
+      default:
+        return count[i] ? std::sqrt(sum_squares[i] / n) : nan;
+    }
+  }
+
+  std::vector<int64_t> count;
+  std::vector<double> sum;
+  std::vector<double> sum_squares;
+  std::vector<double> min;
+  std::vector<double> max;
+};
+
+/**
+ * @brief Calls `visit(index)` with the index of the first element of every
+ * row, along the last dimension, of an array of the given shape.
+ * A rank 0 or 1 array is a single row.
+ */
+template <typename Visit>
+void ForEachRow(tensorstore::span<const Index> shape, Visit visit) {
+  for (auto extent : shape) {
+    if (extent == 0) {
+      return;
+    }
+  }
+  const DimensionIndex rank = shape.size();
+  std::vector<Index> index(rank, 0);
+  while (true) {
+    visit(index);
+    DimensionIndex d = rank - 2;
+    for (; d >= 0; --d) {
+      if (++index[d] < shape[d]) {
+        break;
+      }
+      index[d] = 0;
+    }
+    if (d < 0) {
+      return;
+    }
+  }
+}
+
+/**
+ * @brief Reduces a C-order block of samples along one dimension.
+ * The block is seen as [outer, extent, inner], the middle dimension being
+ * reduced. With `inner` of 1, e.g. traces reduced along samples, each row is
+ * reduced in independent lanes, otherwise the `inner` neighboring outputs are
+ * updated together. NaNs and samples that are not kept are skipped.
+ * @param keep Invoked as `keep(i)` for the i'th sample of the block.
+ * @param out The `outer * inner` partial reductions, in C order.
+ */
+template <typename T, typename Fn, typename Keep>
+void ReduceBlock(const T* data, Index outer, Index extent, Index inner,
+                 const Fn& fn, const Keep& keep,
+                 ReduceBuffer& out) {  // NOLINT (non-const)
+  if (inner == 1) {
+    constexpr Index kLanes = 8;
+    constexpr double kInf = std::numeric_limits<double>::infinity();
+    for (Index a = 0; a < outer; ++a) {
+      const Index row = a * extent;
+      int64_t count[kLanes] = {};
+      double sum[kLanes] = {};
+      double sum_squares[kLanes] = {};
+      double min[kLanes];
+      double max[kLanes];
+      std::fill(min, min + kLanes, kInf);
+      std::fill(max, max + kLanes, -kInf);
+
+      const auto lane = [&](Index l, Index i) {
+        const double v = static_cast<double>(fn(data[i]));
+        const bool kept = (v == v) & keep(i);
+        count[l] += kept;
+        sum[l] += kept ? v : 0.0;
+        sum_squares[l] += kept ? v * v : 0.0;
+        min[l] = kept && v < min[l] ? v : min[l];
+        max[l] = kept && v > max[l] ? v : max[l];
+      };
+      Index k = 0;
+      for (; k + kLanes <= extent; k += kLanes) {
+        for (Index l = 0; l < kLanes; ++l) {
+          lane(l, row + k + l);
+        }
+      }
+      for (; k < extent; ++k) {
+        lane(0, row + k);
+      }
+
+      for (Index l = 0; l < kLanes; ++l) {
+        out.count[a] += count[l];
+        out.sum[a] += sum[l];
+        out.sum_squares[a] += sum_squares[l];
+        out.min[a] = std::min(out.min[a], min[l]);
+        out.max[a] = std::max(out.max[a], max[l]);
+      }
+    }
+    return;
+  }
+
+  for (Index a = 0; a < outer; ++a) {
+    int64_t* count = out.count.data() + a * inner;
+    double* sum = out.sum.data() + a * inner;
+    double* sum_squares = out.sum_squares.data() + a * inner;
+    double* min = out.min.data() + a * inner;
+    double* max = out.max.data() + a * inner;
+    for (Index k = 0; k < extent; ++k) {
+      const Index row = (a * extent + k) * inner;
+      for (Index b = 0; b < inner; ++b) {
+        const double v = static_cast<double>(fn(data[row + b]));
+        const bool kept = (v == v) & keep(row + b);
+        count[b] += kept;
+        sum[b] += kept ? v : 0.0;
+        sum_squares[b] += kept ? v * v : 0.0;
+        min[b] = kept && v < min[b] ? v : min[b];
+        max[b] = kept && v > max[b] ? v : max[b];
+      }
+    }
+  }
+}
+
+/**
+ * @brief Expands a mask over a block of samples.
+ * The mask is matched to the block by dimension label and broadcast along the
+ * dimensions it doesn't have, e.g. a trace mask over a block of traces.
+ * @param mask The mask, covering the block along its dimensions.
+ * @param block The dimensions of the block.
+ * @return One flag per sample of the block, in C order.
+ */
+inline Result<std::vector<char>> ExpandMask(
+    VariableData<bool>& mask,  // NOLINT (non-const)
+    IndexDomainView<> block) {
+  const auto mask_domain = mask.dimensions();
+  const DimensionIndex rank = block.rank();
+  std::vector<Index> stride(rank, 0);
+  Index base = 0;
+  Index mask_stride = 1;
+  for (DimensionIndex m = mask_domain.rank() - 1; m >= 0; --m) {
+    const auto& label = mask_domain.labels()[m];
+    DimensionIndex d = 0;
+    while (d < rank && (label.empty() || block.labels()[d] != label)) {
+      ++d;
+    }
+    if (d == rank) {
+      return absl::InvalidArgumentError(
+          "The mask '" + mask.variableName + "' has dimension '" + label +
+          "', which the data doesn't have.");
+    }
+    if (!tensorstore::Contains(mask_domain[m].interval(),
+                               block[d].interval())) {
+      return absl::OutOfRangeError("The mask '" + mask.variableName +
+                                   "' doesn't cover dimension '" + label +
+                                   "' of the data.");
+    }
+    stride[d] = mask_stride;
+    base += (block.origin()[d] - mask_domain.origin()[m]) * mask_stride;
+    mask_stride *= mask_domain.shape()[m];
+  }
+
+  const bool* flags =
+      mask.get_data_accessor().data() + mask.get_flattened_offset();
+  std::vector<char> keep(block.box().num_elements());
+  const Index last = rank ? block.shape()[rank - 1] : 1;
+  const Index last_stride = rank ? stride[rank - 1] : 0;
+  std::size_t out = 0;
+  ForEachRow(block.shape(), [&](const std::vector<Index>& index) {
+    Index offset = base;
+    for (DimensionIndex d = 0; d + 1 < rank; ++d) {
+      offset += index[d] * stride[d];
+    }
+    for (Index k = 0; k < last; ++k) {
+      keep[out++] = flags[offset + k * last_stride];
+    }
+  });
+  return keep;
+}
+
+/**
+ * @brief What an `Expression` is evaluated over.
+ */
+template <typename T>
+struct ComputeSource {
+  using Visit = std::function<Future<void>(VariableData<T>&)>;
+
+  IndexDomain<> domain;
+  std::string name;
+  std::string long_name;
+  ::nlohmann::json metadata;
+  /// Calls the visitor with every chunk, at most `max_in_flight` at once.
+  std::function<Future<void>(std::size_t max_in_flight, Visit visit)>
+      for_each_chunk;
+};
+
+/// Gets the mask of a block of samples.
+using ComputeMask =
+    std::function<Future<VariableData<bool>>(IndexDomainView<> block)>;
+
+/**
+ * @brief The C-order strides of an array of the given shape.
+ */
+inline std::vector<Index> ContiguousStrides(
+    tensorstore::span<const Index> shape) {
+  std::vector<Index> strides(shape.size());
+  Index stride = 1;
+  for (DimensionIndex d = shape.size() - 1; d >= 0; --d) {
+    strides[d] = stride;
+    stride *= shape[d];
+  }
+  return strides;
+}
+
+}  // namespace internal
+
+/**
+ * @brief A lazy elementwise expression over a Variable or a VariableData.
+ * Nothing is read until the expression is reduced or evaluated. Then the
+ * source is visited chunk by chunk in parallel, the mapped samples are reduced
+ * on the thread completing each read, and only `max_in_flight` chunks are
+ * resident at once. Create one with `mdio::Lazy`.
+ * @tparam T The element type of the source.
+ * @tparam Fn The elementwise map applied to the samples.
+ */
+template <typename T, typename Fn = internal::IdentityMap>
+class Expression {
+ public:
+  /// The type of the mapped samples.
+  using value_type = std::decay_t<std::invoke_result_t<const Fn&, const T&>>;
+
+  Expression(std::shared_ptr<const internal::ComputeSource<T>> source, Fn fn,
+             internal::ComputeMask mask, ComputeOptions options)
+      : source(std::move(source)),
+        fn(std::move(fn)),
+        mask(std::move(mask)),
+        options(options) {}
+
+  /**
+   * @brief Applies a function to every sample, after the existing map.
+   * @param map Invoked as `map(value_type)`, it must be thread safe.
+   */
+  template <typename G>
+  Expression<T, internal::ComposedMap<Fn, G>> Map(G map) const {
+    return {source, internal::ComposedMap<Fn, G>{fn, std::move(map)}, mask,
+            options};
+  }
+
+  /**
+   * @brief Keeps only the samples where a mask is true.
+   * The mask is matched by dimension label and broadcast along the dimensions
+   * it doesn't have, so a `trace_mask` selects the live traces of a volume.
+   * Only the parts of the mask under each chunk are read.
+   * @param mask A boolean Variable whose dimensions are a subset of the
+   * source's.
+   */
+  Expression Where(const Variable<bool>& mask) const {
+    return {source, fn,
+            [mask](IndexDomainView<> block) -> Future<VariableData<bool>> {
+              std::vector<RangeDescriptor<Index>> desc;
+              for (DimensionIndex d = 0; d < block.rank(); ++d) {
+                // Slicing ignores the dimensions the mask doesn't have.
+                if (!block.labels()[d].empty()) {
+                  desc.push_back({DimensionIdentifier(block.labels()[d]),
+                                  block.origin()[d],
+                                  block.origin()[d] + block.shape()[d], 1});
+                }
+              }
+              MDIO_ASSIGN_OR_RETURN(auto block_mask, mask.slice(desc));
+              return block_mask.Read();
+            },
+            options};
+  }
+
+  /**
+   * @brief Keeps only the samples where an in-memory mask is true.
+   */
+  Expression Where(const VariableData<bool>& mask) const {
+    return {source, fn,
+            [mask](IndexDomainView<>) {
+              return tensorstore::MakeReadyFuture<VariableData<bool>>(mask);
+            },
+            options};
+  }
+
+  /**
+   * @brief Reduces the mapped samples along a dimension.
+   * @details \b Usage
+   * @code
+   * // The RMS amplitude of every live trace
+   * auto rms = mdio::Lazy(seismic)
+   *                .Where(trace_mask)
+   *                .Reduce("time", mdio::ReduceOp::kRms)
+   *                .result();
+   * @endcode
+   * @param dimension The label of the dimension to reduce.
+   * @param op The reduction.
+   * @return A future of the reductions, over the other dimensions of the
+   * source. Elements without kept samples are NaN, or 0 for `kSum` and
+   * `kCount`.
+   */
+  Future<VariableData<double>> Reduce(const std::string& dimension,
+                                      ReduceOp op) const {
+    static_assert(std::is_arithmetic_v<value_type>,
+                  "Reductions require a real numeric expression.");
+    const auto& domain = source->domain;
+    const DimensionIndex rank = domain.rank();
+    DimensionIndex reduced = -1;
+    for (DimensionIndex d = 0; d < rank; ++d) {
+      if (domain.labels()[d] == dimension) {
+        reduced = d;
+      }
+    }
+    if (reduced < 0) {
+      return absl::InvalidArgumentError("'" + source->name +
+                                        "' has no dimension '" + dimension +
+                                        "'.");
+    }
+
+    tensorstore::IndexDomainBuilder<> builder(rank - 1);
+    for (DimensionIndex d = 0, o = 0; d < rank; ++d) {
+      if (d != reduced) {
+        builder.origin()[o] = domain.origin()[d];
+        builder.shape()[o] = domain.shape()[d];
+        builder.labels()[o] = domain.labels()[d];
+        ++o;
+      }
+    }
+    MDIO_ASSIGN_OR_RETURN(auto out_domain, builder.Finalize())
+
+    struct State {
+      explicit State(std::size_t n) : total(n) {}
+      std::mutex mutex;
+      internal::ReduceBuffer total;
+    };
+    auto state = std::make_shared<State>(out_domain.box().num_elements());
+    const auto out_box = tensorstore::Box<>(out_domain.box());
+    const auto out_strides = internal::ContiguousStrides(out_box.shape());
+
+    auto reduce_chunk = [fn = fn, state, reduced, out_box, out_strides](
+                            const T* data, tensorstore::BoxView<> box,
+                            const auto& keep) {
+      Index outer = 1;
+      Index inner = 1;
+      std::vector<Index> chunk_origin;
+      std::vector<Index> chunk_shape;
+      for (DimensionIndex d = 0; d < box.rank(); ++d) {
+        if (d < reduced) {
+          outer *= box.shape()[d];
+        } else if (d > reduced) {
+          inner *= box.shape()[d];
+        }
+        if (d != reduced) {
+          chunk_origin.push_back(box.origin()[d]);
+          chunk_shape.push_back(box.shape()[d]);
+        }
+      }
+      internal::ReduceBuffer partial(outer * inner);
+      internal::ReduceBlock(data, outer, box.shape()[reduced], inner, fn, keep,
+                            partial);
+
+      const DimensionIndex out_rank = chunk_shape.size();
+      const Index last = out_rank ? chunk_shape.back() : 1;
+      std::size_t from = 0;
+      std::lock_guard<std::mutex> lock(state->mutex);
+      internal::ForEachRow(chunk_shape, [&](const std::vector<Index>& index) {
+        Index to = 0;
+        for (DimensionIndex d = 0; d < out_rank; ++d) {
+          to += (chunk_origin[d] + index[d] - out_box.origin()[d]) *
+                out_strides[d];
+        }
+        for (Index k = 0; k < last; ++k) {
+          state->total.Merge(to + k, partial, from++);
+        }
+      });
+    };
+
+    auto done = ForEachChunk(std::move(reduce_chunk));
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [source = source, state, op,
+         out_domain]() -> Result<VariableData<double>> {
+          auto array = tensorstore::AllocateArray<double>(
+              out_domain.box(), tensorstore::c_order,
+              tensorstore::default_init);
+          LabeledArray<double, dynamic_rank, offset_origin> labeled{out_domain,
+                                                                    array};
+          VariableData<double> reduced{source->name, source->long_name,
+                                       source->metadata, labeled};
+          double* out = reduced.get_data_accessor().data() +
+                        reduced.get_flattened_offset();
+          for (std::size_t i = 0; i < state->total.count.size(); ++i) {
+            out[i] = state->total.Finish(i, op);
+          }
+          return reduced;
+        },
+        std::move(done));
+  }
+
+  /**
+   * @brief Reduces every mapped sample to a single number.
+   * @return A future of the reduction, NaN if no sample was kept, or 0 for
+   * `kSum` and `kCount`.
+   */
+  Future<double> ReduceAll(ReduceOp op) const {
+    static_assert(std::is_arithmetic_v<value_type>,
+                  "Reductions require a real numeric expression.");
+    struct State {
+      std::mutex mutex;
+      internal::ReduceBuffer total{1};
+    };
+    auto state = std::make_shared<State>();
+    auto reduce_chunk = [fn = fn, state](const T* data,
+                                         tensorstore::BoxView<> box,
+                                         const auto& keep) {
+      internal::ReduceBuffer partial(1);
+      internal::ReduceBlock(data, 1, box.num_elements(), 1, fn, keep, partial);
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->total.Merge(0, partial, 0);
+    };
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [state, op]() { return state->total.Finish(0, op); },
+        ForEachChunk(std::move(reduce_chunk)));
+  }
+
+  /**
+   * @brief Materializes the mapped samples.
+   * @param otherwise The value of the samples that are not kept by the mask.
+   * @return A future of the mapped samples, in the index space of the source.
+   */
+  Future<VariableData<value_type>> Evaluate(
+      value_type otherwise = value_type{}) const {
+    const auto& domain = source->domain;
+    auto array = tensorstore::AllocateArray<value_type>(
+        domain.box(), tensorstore::c_order, tensorstore::default_init);
+    LabeledArray<value_type, dynamic_rank, offset_origin> labeled{domain,
+                                                                  array};
+    auto out = std::make_shared<VariableData<value_type>>(
+        source->name, source->long_name, source->metadata, labeled);
+    value_type* base =
+        out->get_data_accessor().data() + out->get_flattened_offset();
+    const auto out_box = tensorstore::Box<>(domain.box());
+    const auto out_strides = internal::ContiguousStrides(out_box.shape());
+
+    // Chunks are disjoint, so they are written without locking.
+    auto map_chunk = [fn = fn, base, out_box, out_strides, otherwise](
+                         const T* data, tensorstore::BoxView<> box,
+                         const auto& keep) {
+      const DimensionIndex rank = box.rank();
+      const Index last = rank ? box.shape()[rank - 1] : 1;
+      Index from = 0;
+      internal::ForEachRow(box.shape(), [&](const std::vector<Index>& index) {
+        Index to = 0;
+        for (DimensionIndex d = 0; d < rank; ++d) {
+          to += (box.origin()[d] + index[d] - out_box.origin()[d]) *
+                out_strides[d];
+        }
+        for (Index k = 0; k < last; ++k, ++from) {
+          base[to + k] = keep(from) ? fn(data[from]) : otherwise;
+        }
+      });
+    };
+
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [out]() -> VariableData<value_type> { return *out; },
+        ForEachChunk(std::move(map_chunk)));
+  }
+
+ private:
+  /**
+   * @brief Visits the chunks of the source with their mask.
+   * @param visit Invoked as `visit(const T* data, BoxView<> box, keep)`, where
+   * `keep(i)` tells if the i'th sample of the chunk is kept.
+   */
+  template <typename Visit>
+  Future<void> ForEachChunk(Visit visit) const {
+    auto mask_of = mask;
+    return source->for_each_chunk(
+        options.max_in_flight,
+        [visit = std::move(visit),
+         mask_of](VariableData<T>& chunk) -> Future<void> {
+          const T* data =
+              chunk.get_data_accessor().data() + chunk.get_flattened_offset();
+          const auto box = tensorstore::Box<>(chunk.dimensions().box());
+          if (!mask_of) {
+            visit(data, box, [](Index) { return true; });
+            return absl::OkStatus();
+          }
+          return tensorstore::MapFutureValue(
+              tensorstore::InlineExecutor{},
+              [visit, chunk, data, box](
+                  VariableData<bool>& block_mask) -> Result<void> {
+                MDIO_ASSIGN_OR_RETURN(
+                    auto keep,
+                    internal::ExpandMask(block_mask, chunk.dimensions()))
+                const char* flags = keep.data();
+                visit(data, box, [flags](Index i) { return flags[i] != 0; });
+                return absl::OkStatus();
+              },
+              mask_of(chunk.dimensions()));
+        });
+  }
+
+  std::shared_ptr<const internal::ComputeSource<T>> source;
+  Fn fn;
+  internal::ComputeMask mask;
+  ComputeOptions options;
+};
+
+/**
+ * @brief Starts a lazy expression over a Variable.
+ * @details \b Usage
+ * @code
+ * MDIO_ASSIGN_OR_RETURN(auto seismic, ds.variables.get<float>("seismic"));
+ * MDIO_ASSIGN_OR_RETURN(auto mask, ds.variables.get<bool>("trace_mask"));
+ * // The largest absolute amplitude of every live trace
+ * auto peaks = mdio::Lazy(seismic)
+ *                  .Map([](float v) { return std::abs(v); })
+ *                  .Where(mask)
+ *                  .Reduce("time", mdio::ReduceOp::kMax);
+ * @endcode
+ */
+template <typename T>
+Expression<T> Lazy(const Variable<T>& var, ComputeOptions options = {}) {
+  static_assert(!std::is_void_v<T>, "Lazy requires a typed Variable.");
+  auto source = std::make_shared<internal::ComputeSource<T>>();
+  source->domain = var.dimensions();
+  source->name = var.get_variable_name();
+  source->long_name = var.get_long_name();
+  source->metadata = var.getMetadata();
+  source->for_each_chunk =
+      [var](std::size_t max_in_flight,
+            typename internal::ComputeSource<T>::Visit visit) {
+        return internal::ForEachChunkData(var, max_in_flight, visit);
+      };
+  return {std::move(source), internal::IdentityMap{}, nullptr, options};
+}
+
+/**
+ * @brief Starts a lazy expression over samples already in memory.
+ * The samples are processed as a single chunk.
+ */
+template <typename T>
+Expression<T> Lazy(const VariableData<T>& data, ComputeOptions options = {}) {
+  static_assert(!std::is_void_v<T>, "Lazy requires a typed VariableData.");
+  auto source = std::make_shared<internal::ComputeSource<T>>();
+  source->domain = data.dimensions();
+  source->name = data.variableName;
+  source->long_name = data.longName;
+  source->metadata = data.metadata;
+  source->for_each_chunk =
+      [data](std::size_t, typename internal::ComputeSource<T>::Visit visit) {
+        auto chunk = data;
+        return visit(chunk);
+      };
+  return {std::move(source), internal::IdentityMap{}, nullptr, options};
+}
+
+}  // namespace mdio
+
+#endif  // MDIO_COMPUTE_H_
@@ -0,0 +1,323 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MDIO_COMPUTE_STATS_H_
+#define MDIO_COMPUTE_STATS_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mdio/dataset.h"
+#include "mdio/impl.h"
+#include "mdio/variable.h"
+#include "tensorstore/util/division.h"
+
+// clang-format off
+#include <nlohmann/json.hpp>  // NOLINT
+// clang-format on
+
+namespace mdio {
+namespace internal {
+
+/**
+ * @brief Gets the numeric fill value of a Variable.
+ * @return The fill value, or `std::nullopt` if the Variable has none or it is
+ * not representable as a number (e.g. "NaN", which is always skipped).
+ */
+template <typename T, DimensionIndex R, ReadWriteMode M>
+std::optional<T> GetFillValue(const Variable<T, R, M>& var) {
+  auto spec = var.get_spec();
+  if (!spec.ok()) {
+    return std::nullopt;
+  }
+  auto fill = FillValueFromSpec(spec.value());
+  if (!fill.has_value()) {
+    return std::nullopt;
+  }
+  return static_cast<T>(*fill);
+}
+
+/**
+ * @brief Reads a Variable one chunk at a time and hands each chunk to `visit`.
+ * The chunks are read concurrently, bounded by `max_in_flight`, and `visit`
+ * runs on the thread that completes the read. A store without a chunk shape
+ * is visited as a single piece.
+ * @param visit Invoked as `visit(VariableData<T>& chunk)`, it may return
+ * `void`, `Result<void>` or a `Future<void>` that holds the chunk in flight.
+ */
+template <typename T, DimensionIndex R, ReadWriteMode M, typename Visit>
+Future<void> ForEachChunkData(const Variable<T, R, M>& var,
+                              std::size_t max_in_flight, Visit visit) {
+  const auto domain = var.dimensions();
+  const DimensionIndex rank = domain.rank();
+  auto chunk_res = var.get_chunk_shape();
+  std::vector<Index> chunk_shape(rank);
+  for (DimensionIndex d = 0; d < rank; ++d) {
+    const bool chunked = chunk_res.ok() && chunk_res->size() == rank &&
+                         (*chunk_res)[d] > 0;
+    chunk_shape[d] =
+        chunked ? (*chunk_res)[d] : std::max<Index>(domain.shape()[d], 1);
+  }
+
+  // The chunk grid is anchored at 0.
+  std::vector<Index> first_cell(rank);
+  std::vector<Index> num_cells(rank);
+  std::size_t total = 1;
+  for (DimensionIndex d = 0; d < rank; ++d) {
+    const auto interval = domain[d].interval();
+    if (interval.empty()) {
+      return absl::OkStatus();
+    }
+    first_cell[d] =
+        tensorstore::FloorOfRatio(interval.inclusive_min(), chunk_shape[d]);
+    num_cells[d] = tensorstore::FloorOfRatio(interval.inclusive_max(),
+                                             chunk_shape[d]) -
+                   first_cell[d] + 1;
+    total *= num_cells[d];
+  }
+
+  std::vector<DimensionIdentifier> labels;
+  for (DimensionIndex d = 0; d < rank; ++d) {
+    const auto& label = domain.labels()[d];
+    labels.push_back(label.empty() ? DimensionIdentifier(d)
+                                   : DimensionIdentifier(label));
+  }
+
+  return ForEachBounded(
+      total, max_in_flight,
+      [var, labels, chunk_shape, first_cell, num_cells,
+       visit = std::move(visit)](std::size_t i) -> Future<void> {
+        std::vector<RangeDescriptor<Index>> desc(labels.size());
+        std::size_t rest = i;
+        for (DimensionIndex d = labels.size() - 1; d >= 0; --d) {
+          const Index cell = first_cell[d] + rest % num_cells[d];
+          rest /= num_cells[d];
+          desc[d] = {labels[d], cell * chunk_shape[d],
+                     (cell + 1) * chunk_shape[d], 1};
+        }
+        // Sliced to the chunk, the Variable clamps the edge chunks.
+        auto chunk = desc.empty() ? Result<Variable<T, R, M>>(var)
+                                  : var.slice(desc);
+        if (!chunk.ok()) {
+          return chunk.status();
+        }
+        return tensorstore::MapFutureValue(
+            tensorstore::InlineExecutor{},
+            [visit](auto& data) { return visit(data); }, chunk->Read());
+      });
+}
+
+/**
+ * @brief Reads a Variable one chunk at a time and hands each chunk to `visit`.
+ * @param visit Invoked as `visit(const T* data, Index n_samples)` with the
+ * C-order samples of one chunk.
+ */
+template <typename T, DimensionIndex R, ReadWriteMode M, typename Visit>
+Future<void> ForEachChunk(const Variable<T, R, M>& var,
+                          std::size_t max_in_flight, Visit visit) {
+  return ForEachChunkData(
+      var, max_in_flight, [visit = std::move(visit)](auto& data) {
+        visit(data.get_data_accessor().data() + data.get_flattened_offset(),
+              data.num_samples());
+      });
+}
+
+}  // namespace internal
+
+/**
+ * @brief Options for `ComputeStats`.
+ */
+struct StatsOptions {
+  /// The number of equal width histogram bins.
+  std::size_t num_bins = 256;
+  /// The range covered by the histogram. If not given it is the [min, max] of
+  /// the data, which costs a second pass over the Variable.
+  std::optional<std::pair<double, double>> histogram_range;
+  /// Whether to skip samples equal to the Variable's fill value.
+  bool skip_fill_value = true;
+  /// The maximum number of chunks read at once. 0 means unbounded.
+  std::size_t max_in_flight = 64;
+  /// Whether to write the result to the Variable's statsV1 attributes.
+  bool update_attributes = true;
+};
+
+/**
+ * @brief Summary statistics and histogram computed from a Variable.
+ */
+struct ComputedStats {
+  int64_t count = 0;
+  double sum = 0;
+  double sumSquares = 0;
+  double min = 0;
+  double max = 0;
+  /// The left edge of every histogram bin.
+  std::vector<double> binEdges;
+  std::vector<double> binWidths;
+  std::vector<int64_t> counts;
+
+  /**
+   * @brief Gets the MDIO statsV1 representation with an edge defined
+   * histogram.
+   */
+  nlohmann::json ToJson() const {
+    nlohmann::json stats;
+    stats["count"] = count;
+    stats["sum"] = sum;
+    stats["sumSquares"] = sumSquares;
+    stats["min"] = min;
+    stats["max"] = max;
+    stats["histogram"]["binEdges"] = binEdges;
+    stats["histogram"]["binWidths"] = binWidths;
+    stats["histogram"]["counts"] = counts;
+    return stats;
+  }
+};
+
+/**
+ * @brief Computes the summary statistics and histogram of a Variable.
+ * The Variable is read chunk by chunk in parallel. Every chunk is reduced on
+ * the thread completing its read and the partial result is merged into the
+ * total, so only `max_in_flight` chunks are resident at once. NaNs and the
+ * fill value are skipped.
+ * @param var The Variable to compute the statistics of.
+ * @param options The options controlling the computation.
+ * @details \b Usage
+ * @code
+ * MDIO_ASSIGN_OR_RETURN(auto var, dataset.variables.get<float>("seismic"));
+ * auto stats = mdio::ComputeStats(var).result();
+ * // The statsV1 attributes are updated, commit them
+ * auto commit = dataset.CommitMetadata();
+ * @endcode
+ * @return A future of the statistics. If `update_attributes` is set, the
+ * Variable's statsV1 attributes are replaced once the future is ready. This
+ * does not commit them to durable media.
+ */
+template <typename T, DimensionIndex R, ReadWriteMode M>
+Future<ComputedStats> ComputeStats(const Variable<T, R, M>& var,
+                                   const StatsOptions& options = {}) {
+  static_assert(std::is_arithmetic_v<T>,
+                "ComputeStats requires a real numeric Variable.");
+  if (options.num_bins == 0) {
+    return absl::InvalidArgumentError("num_bins must be at least 1.");
+  }
+
+  struct State {
+    std::mutex mutex;
+    internal::StatsMoments moments;
+    std::vector<int64_t> counts;
+    double lo = 0;
+    double hi = 0;
+  };
+  auto state = std::make_shared<State>();
+  state->counts.assign(options.num_bins, 0);
+  std::optional<T> fill;
+  if (options.skip_fill_value) {
+    fill = internal::GetFillValue(var);
+  }
+
+  const auto histogram_pass = [var, options, state, fill]() {
+    return internal::ForEachChunk(
+        var, options.max_in_flight,
+        [state, fill](const T* data, Index n_samples) {
+          std::vector<int64_t> counts(state->counts.size());
+          internal::AccumulateHistogram(data, n_samples, fill, state->lo,
+                                        state->hi, counts);
+          std::lock_guard<std::mutex> lock(state->mutex);
+          for (std::size_t b = 0; b < counts.size(); ++b) {
+            state->counts[b] += counts[b];
+          }
+        });
+  };
+
+  Future<void> done;
+  if (options.histogram_range.has_value()) {
+    state->lo = options.histogram_range->first;
+    state->hi = options.histogram_range->second;
+    done = internal::ForEachChunk(
+        var, options.max_in_flight,
+        [state, fill](const T* data, Index n_samples) {
+          internal::StatsMoments moments;
+          internal::AccumulateMoments(data, n_samples, fill, moments);
+          std::vector<int64_t> counts(state->counts.size());
+          internal::AccumulateHistogram(data, n_samples, fill, state->lo,
+                                        state->hi, counts);
+          std::lock_guard<std::mutex> lock(state->mutex);
+          state->moments.Merge(moments);
+          for (std::size_t b = 0; b < counts.size(); ++b) {
+            state->counts[b] += counts[b];
+          }
+        });
+  } else {
+    auto moments_pass = internal::ForEachChunk(
+        var, options.max_in_flight,
+        [state, fill](const T* data, Index n_samples) {
+          internal::StatsMoments moments;
+          internal::AccumulateMoments(data, n_samples, fill, moments);
+          std::lock_guard<std::mutex> lock(state->mutex);
+          state->moments.Merge(moments);
+        });
+    done = tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [state, histogram_pass]() -> Future<void> {
+          if (state->moments.count == 0) {
+            return absl::OkStatus();
+          }
+          state->lo = state->moments.min;
+          state->hi = state->moments.max;
+          return histogram_pass();
+        },
+        std::move(moments_pass));
+  }
+
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [var, options, state]() mutable -> Result<ComputedStats> {
+        ComputedStats stats;
+        const auto& moments = state->moments;
+        stats.count = moments.count;
+        stats.sum = moments.sum;
+        stats.sumSquares = moments.sum_squares;
+        stats.min = moments.count ? moments.min : 0;
+        stats.max = moments.count ? moments.max : 0;
+        const double width =
+            (state->hi - state->lo) / static_cast<double>(options.num_bins);
+        for (std::size_t b = 0; b < options.num_bins; ++b) {
+          stats.binEdges.push_back(state->lo + b * width);
+          stats.binWidths.push_back(width);
+        }
+        stats.counts = std::move(state->counts);
+
+        if (options.update_attributes) {
+          auto attrs = var.GetAttributes();
+          attrs["statsV1"] = stats.ToJson();
+          auto updated = var.template UpdateAttributes<float>(attrs);
+          if (!updated.ok()) {
+            return updated.status();
+          }
+        }
+        return stats;
+      },
+      std::move(done));
+}
+
+}  // namespace mdio
+
+#endif  // MDIO_COMPUTE_STATS_H_
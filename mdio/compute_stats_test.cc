@@ -0,0 +1,342 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mdio/compute_stats.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <vector>
+
+#include "mdio/chunked_writer.h"
+#include "mdio/dataset.h"
+
+namespace {
+
+// clang-format off
+::nlohmann::json json_stats = ::nlohmann::json::object({
+    {"driver", "zarr"},
+    {"kvstore",
+        {
+            {"driver", "file"},
+            {"path", "stats_variable"}
+        }
+    },
+    {"attributes",
+        {
+            {"long_name", "stats test"},
+            {"dimension_names", {"x", "y"} },
+        }
+    },
+    {"metadata",
+        {
+            {"dtype", "<f4"},
+            {"shape", {20, 30}},
+            {"chunks", {8, 16}},
+            {"fill_value", -1.0},
+            {"dimension_separator", "/"},
+        }
+    }
+});
+// clang-format on
+
+TEST(ComputeStats, moments) {
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  std::vector<float> data(21);
+  std::iota(data.begin(), data.end(), 0.0f);  // 0 ... 20
+  data[3] = nan;
+  data[7] = -1.0f;
+
+  mdio::internal::StatsMoments moments;
+  mdio::internal::AccumulateMoments(data.data(), data.size(),
+                                    std::optional<float>(-1.0f), moments);
+  EXPECT_EQ(moments.count, 19);
+  EXPECT_DOUBLE_EQ(moments.sum, 210 - 3 - 7);
+  EXPECT_DOUBLE_EQ(moments.min, 0);
+  EXPECT_DOUBLE_EQ(moments.max, 20);
+
+  // Partials merge to the same result.
+  mdio::internal::StatsMoments first, second;
+  mdio::internal::AccumulateMoments(data.data(), 10,
+                                    std::optional<float>(-1.0f), first);
+  mdio::internal::AccumulateMoments(data.data() + 10, 11,
+                                    std::optional<float>(-1.0f), second);
+  first.Merge(second);
+  EXPECT_EQ(first.count, moments.count);
+  EXPECT_DOUBLE_EQ(first.sum_squares, moments.sum_squares);
+}
+
+TEST(ComputeStats, histogram) {
+  std::vector<int32_t> data = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 42};
+  std::vector<int64_t> counts(5);
+  mdio::internal::AccumulateHistogram(data.data(), data.size(),
+                                      std::optional<int32_t>(), 0, 10, counts);
+  // The max lands in the last bin, out of range samples are dropped.
+  EXPECT_EQ(counts, (std::vector<int64_t>{2, 2, 2, 2, 3}));
+}
+
+TEST(ComputeStats, variable) {
+  auto var = mdio::Variable<float>::Open(json_stats,
+                                         mdio::constants::kCreateClean)
+                 .result();
+  ASSERT_TRUE(var.ok()) << var.status();
+
+  auto data = mdio::from_variable<float>(var.value());
+  ASSERT_TRUE(data.ok()) << data.status();
+  auto ptr = data->get_data_accessor().data() + data->get_flattened_offset();
+  for (mdio::Index i = 0; i < 600; ++i) {
+    ptr[i] = static_cast<float>(i % 10);
+  }
+  ptr[0] = -1.0f;  // The fill value is skipped.
+  ASSERT_TRUE(var->Write(data.value()).status().ok());
+
+  mdio::StatsOptions options;
+  options.num_bins = 10;
+  options.max_in_flight = 2;
+  auto stats = mdio::ComputeStats(var.value(), options).result();
+  ASSERT_TRUE(stats.ok()) << stats.status();
+  EXPECT_EQ(stats->count, 599);
+  EXPECT_DOUBLE_EQ(stats->min, 0);
+  EXPECT_DOUBLE_EQ(stats->max, 9);
+  EXPECT_DOUBLE_EQ(stats->sum, 60 * 45);
+  EXPECT_EQ(std::accumulate(stats->counts.begin(), stats->counts.end(),
+                            int64_t{0}),
+            599);
+
+  // A fixed range takes a single pass and gives the same moments.
+  options.histogram_range = std::make_pair(0.0, 10.0);
+  options.update_attributes = false;
+  auto single = mdio::ComputeStats(var.value(), options).result();
+  ASSERT_TRUE(single.ok()) << single.status();
+  EXPECT_EQ(single->count, stats->count);
+  EXPECT_DOUBLE_EQ(single->sumSquares, stats->sumSquares);
+  EXPECT_EQ(single->counts[9], 60);
+
+  // The first result was written to the attributes.
+  auto attrs = var->GetAttributes();
+  ASSERT_TRUE(attrs.contains("statsV1"));
+  EXPECT_EQ(attrs["statsV1"]["count"], 599);
+  EXPECT_TRUE(attrs["statsV1"]["histogram"].contains("binEdges"));
+
+  std::filesystem::remove_all("stats_variable");
+}
+
+TEST(TrackStats, write) {
+  auto json = json_stats;
+  json["kvstore"]["path"] = "tracked_variable";
+  auto var =
+      mdio::Variable<float>::Open(json, mdio::constants::kCreateClean).result();
+  ASSERT_TRUE(var.ok()) << var.status();
+
+  // Without statsV1 a range is required.
+  EXPECT_FALSE(var->TrackStats().ok());
+  mdio::StatsTrackingOptions options;
+  options.num_bins = 10;
+  options.histogram_range = std::make_pair(0.0, 10.0);
+  ASSERT_TRUE(var->TrackStats(options).ok());
+
+  auto data = mdio::from_variable<float>(var.value());
+  ASSERT_TRUE(data.ok()) << data.status();
+  auto ptr = data->get_data_accessor().data() + data->get_flattened_offset();
+  for (mdio::Index i = 0; i < 600; ++i) {
+    ptr[i] = static_cast<float>(i % 10);
+  }
+  ptr[0] = -1.0f;  // The fill value is skipped.
+  ASSERT_TRUE(var->Write(data.value()).commit_future.result().ok());
+
+  ASSERT_TRUE(var->PublishTrackedStats().ok());
+  EXPECT_TRUE(var->was_updated());
+  auto stats = var->GetAttributes()["statsV1"];
+  EXPECT_EQ(stats["count"], 599);
+  EXPECT_DOUBLE_EQ(stats["sum"].get<double>(), 60 * 45);
+  EXPECT_EQ(stats["histogram"]["counts"][5], 60);
+
+  // Overwrite the first 10 rows through a slice, which shares the tracking.
+  mdio::RangeDescriptor<mdio::Index> desc = {"x", 0, 10, 1};
+  auto slice = var->slice(desc);
+  ASSERT_TRUE(slice.ok()) << slice.status();
+  auto block = mdio::from_variable<float>(slice.value());
+  ASSERT_TRUE(block.ok()) << block.status();
+  auto block_ptr =
+      block->get_data_accessor().data() + block->get_flattened_offset();
+  std::fill_n(block_ptr, 300, 5.0f);
+  ASSERT_TRUE(slice->Write(block.value()).commit_future.result().ok());
+
+  ASSERT_TRUE(var->PublishTrackedStats().ok());
+  auto attrs = var->GetAttributes();
+  EXPECT_EQ(attrs["statsV1"]["count"], 600);
+  EXPECT_DOUBLE_EQ(attrs["statsV1"]["sum"].get<double>(),
+                   60 * 45 - 30 * 45 + 300 * 5);
+  EXPECT_EQ(attrs["statsV1"]["histogram"]["counts"][5], 60 - 30 + 300);
+  // The old min and max can't be retracted.
+  EXPECT_TRUE(attrs["attributes"]["statsV1Approximate"].get<bool>());
+
+  // Tracking resumes from the published statistics.
+  EXPECT_TRUE(var->TrackStats().ok());
+
+  std::filesystem::remove_all("tracked_variable");
+}
+
+TEST(TrackStats, stridedSource) {
+  auto json = json_stats;
+  json["kvstore"]["path"] = "tracked_strided";
+  auto var =
+      mdio::Variable<float>::Open(json, mdio::constants::kCreateClean).result();
+  ASSERT_TRUE(var.ok()) << var.status();
+  mdio::StatsTrackingOptions options;
+  options.num_bins = 10;
+  options.histogram_range = std::make_pair(0.0, 10.0);
+  ASSERT_TRUE(var->TrackStats(options).ok());
+
+  // A Fortran order source isn't laid out like the samples of the Variable.
+  mdio::IndexDomain<> domain(var->dimensions());
+  auto array = tensorstore::AllocateArray<float>(
+      domain.box(), tensorstore::fortran_order, tensorstore::value_init);
+  double sum = 0;
+  for (mdio::Index i = 0; i < 20; ++i) {
+    for (mdio::Index j = 0; j < 30; ++j) {
+      array(i, j) = static_cast<float>((i + 2 * j) % 10);
+      sum += array(i, j);
+    }
+  }
+  mdio::VariableData<float> data{"strided", "", ::nlohmann::json::object(),
+                                 {domain, array}};
+  ASSERT_TRUE(var->Write(data).commit_future.result().ok());
+
+  // The statistics include the write as soon as it has committed.
+  ASSERT_TRUE(var->PublishTrackedStats().ok());
+  auto stats = var->GetAttributes()["statsV1"];
+  EXPECT_EQ(stats["count"], 600);
+  EXPECT_DOUBLE_EQ(stats["sum"].get<double>(), sum);
+
+  std::filesystem::remove_all("tracked_strided");
+}
+
+// Writes i % 10 to every sample of a tracked Variable, the first sample as
+// the fill value.
+mdio::Result<void> WriteTracked(mdio::Variable<float> var) {
+  mdio::StatsTrackingOptions options;
+  options.num_bins = 10;
+  options.histogram_range = std::make_pair(0.0, 10.0);
+  auto tracking = var.TrackStats(options);
+  if (!tracking.ok()) {
+    return tracking;
+  }
+  MDIO_ASSIGN_OR_RETURN(auto data, mdio::from_variable<float>(var))
+  auto ptr = data.get_data_accessor().data() + data.get_flattened_offset();
+  for (mdio::Index i = 0; i < data.num_samples(); ++i) {
+    ptr[i] = static_cast<float>(i % 10);
+  }
+  ptr[0] = -1.0f;
+  return var.Write(data).commit_future.result();
+}
+
+TEST(TrackStats, chunkedWriterOverwrite) {
+  auto json = json_stats;
+  json["kvstore"]["path"] = "tracked_chunked";
+  auto var =
+      mdio::Variable<float>::Open(json, mdio::constants::kCreateClean).result();
+  ASSERT_TRUE(var.ok()) << var.status();
+  ASSERT_TRUE(WriteTracked(var.value()).ok());
+
+  // Rows 8 and 9 only partly fill their chunks, which are written in a
+  // transaction that commits right after the writes.
+  auto writer = mdio::ChunkedWriter<float>::Make(var.value());
+  ASSERT_TRUE(writer.ok()) << writer.status();
+  for (mdio::Index x = 0; x < 10; ++x) {
+    mdio::RangeDescriptor<mdio::Index> desc = {"x", x, x + 1, 1};
+    auto row = var->slice(desc);
+    ASSERT_TRUE(row.ok()) << row.status();
+    auto data = mdio::from_variable<float>(row.value());
+    ASSERT_TRUE(data.ok()) << data.status();
+    std::fill_n(data->get_data_accessor().data() + data->get_flattened_offset(),
+                30, 5.0f);
+    ASSERT_TRUE(writer->Write(data.value()).ok());
+  }
+  ASSERT_TRUE(writer->Close().result().ok());
+
+  ASSERT_TRUE(var->PublishTrackedStats().ok());
+  auto stats = var->GetAttributes()["statsV1"];
+  EXPECT_EQ(stats["count"], 600);
+  EXPECT_DOUBLE_EQ(stats["sum"].get<double>(), 60 * 45 - 30 * 45 + 300 * 5);
+  EXPECT_EQ(stats["histogram"]["counts"][5], 60 - 30 + 300);
+
+  auto stored = var->Read().result();
+  ASSERT_TRUE(stored.ok()) << stored.status();
+  EXPECT_EQ(stored->get_data_accessor().data()[stored->get_flattened_offset() +
+                                                9 * 30 + 29],
+            5.0f);
+
+  std::filesystem::remove_all("tracked_chunked");
+}
+
+TEST(TrackStats, transactionOverwrite) {
+  const std::string path = "tracked_transaction.mdio";
+  auto schema = ::nlohmann::json::parse(R"(
+{
+  "metadata": {
+    "name": "tracked",
+    "apiVersion": "1.0.0",
+    "createdOn": "2023-12-12T15:02:06.413469-06:00"
+  },
+  "variables": [
+    {
+      "name": "seismic",
+      "dataType": "float32",
+      "dimensions": [
+        {"name": "inline", "size": 20},
+        {"name": "depth", "size": 30}
+      ],
+      "metadata": {
+        "chunkGrid": {
+          "name": "regular",
+          "configuration": {"chunkShape": [8, 16]}
+        }
+      }
+    }
+  ]
+}
+)");
+  auto dataset =
+      mdio::Dataset::from_json(schema, path, mdio::constants::kCreateClean)
+          .result();
+  ASSERT_TRUE(dataset.ok()) << dataset.status();
+  auto var = dataset->variables.get<float>("seismic");
+  ASSERT_TRUE(var.ok()) << var.status();
+  ASSERT_TRUE(WriteTracked(var.value()).ok());
+
+  auto transaction = dataset->StartTransaction();
+  auto data = mdio::from_variable<float>(var.value());
+  ASSERT_TRUE(data.ok()) << data.status();
+  std::fill_n(data->get_data_accessor().data() + data->get_flattened_offset(),
+              600, 5.0f);
+  ASSERT_TRUE(transaction.Write(data.value()).ok());
+  auto committed = transaction.Commit().result();
+  ASSERT_TRUE(committed.ok()) << committed.status();
+
+  ASSERT_TRUE(var->PublishTrackedStats().ok());
+  auto stats = var->GetAttributes()["statsV1"];
+  EXPECT_EQ(stats["count"], 600);
+  EXPECT_DOUBLE_EQ(stats["sum"].get<double>(), 600 * 5);
+  EXPECT_EQ(stats["histogram"]["counts"][5], 600);
+
+  std::filesystem::remove_all(path);
+}
+
+}  // namespace
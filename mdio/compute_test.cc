@@ -0,0 +1,190 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mdio/compute.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <filesystem>
+#include <vector>
+
+#include "mdio/utils/test_fixtures.h"
+
+namespace {
+
+// Sample (x, y) is x * 30 + y.
+mdio::Result<mdio::Variable<float>> MakeVariable() {
+  return mdio::testing::MakeVariable<float>(
+      mdio::testing::VariableSpec("compute_variable", {"x", "y"}, {20, 30},
+                                  {8, 16}),
+      [](const std::vector<mdio::Index>& p) { return p[0] * 30 + p[1]; });
+}
+
+// Every third row of x is live.
+mdio::Result<mdio::Variable<bool>> MakeMask() {
+  return mdio::testing::MakeVariable<bool>(
+      mdio::testing::VariableSpec("compute_mask", {"x"}, {20}, {8}, "|b1",
+                                  false),
+      [](const std::vector<mdio::Index>& p) { return p[0] % 3 == 0; });
+}
+
+TEST(Compute, reduceLastDimension) {
+  auto var = MakeVariable();
+  ASSERT_TRUE(var.ok()) << var.status();
+
+  auto rms = mdio::Lazy(var.value()).Reduce("y", mdio::ReduceOp::kRms).result();
+  ASSERT_TRUE(rms.ok()) << rms.status();
+  EXPECT_EQ(rms->dimensions().shape()[0], 20);
+  EXPECT_EQ(rms->dimensions().labels()[0], "x");
+  const double* out =
+      rms->get_data_accessor().data() + rms->get_flattened_offset();
+  for (int x = 0; x < 20; ++x) {
+    double sum_squares = 0;
+    for (int y = 0; y < 30; ++y) {
+      sum_squares += double(x * 30 + y) * (x * 30 + y);
+    }
+    EXPECT_NEAR(out[x], std::sqrt(sum_squares / 30), 1e-6) << x;
+  }
+  std::filesystem::remove_all("compute_variable");
+}
+
+TEST(Compute, reduceFirstDimension) {
+  auto var = MakeVariable();
+  ASSERT_TRUE(var.ok()) << var.status();
+
+  // Chunks of 8 rows are merged along the reduced dimension.
+  auto sums = mdio::Lazy(var.value()).Reduce("x", mdio::ReduceOp::kSum);
+  auto maxes = mdio::Lazy(var.value()).Reduce("x", mdio::ReduceOp::kMax);
+  ASSERT_TRUE(sums.result().ok()) << sums.status();
+  ASSERT_TRUE(maxes.result().ok()) << maxes.status();
+  auto sum_data = sums.value();
+  auto max_data = maxes.value();
+  const double* sum =
+      sum_data.get_data_accessor().data() + sum_data.get_flattened_offset();
+  const double* max =
+      max_data.get_data_accessor().data() + max_data.get_flattened_offset();
+  for (int y = 0; y < 30; ++y) {
+    // sum over x of (x * 30 + y)
+    EXPECT_DOUBLE_EQ(sum[y], 30 * 190 + 20 * y) << y;
+    EXPECT_DOUBLE_EQ(max[y], 19 * 30 + y) << y;
+  }
+  std::filesystem::remove_all("compute_variable");
+}
+
+TEST(Compute, mapAndWhere) {
+  auto var = MakeVariable();
+  ASSERT_TRUE(var.ok()) << var.status();
+  auto mask = MakeMask();
+  ASSERT_TRUE(mask.ok()) << mask.status();
+
+  auto live = mdio::Lazy(var.value())
+                  .Map([](float v) { return v * 2; })
+                  .Where(mask.value());
+  auto count = live.ReduceAll(mdio::ReduceOp::kCount).result();
+  ASSERT_TRUE(count.ok()) << count.status();
+  EXPECT_DOUBLE_EQ(count.value(), 7 * 30);
+
+  auto means = live.Reduce("y", mdio::ReduceOp::kMean).result();
+  ASSERT_TRUE(means.ok()) << means.status();
+  const double* mean =
+      means->get_data_accessor().data() + means->get_flattened_offset();
+  for (int x = 0; x < 20; ++x) {
+    if (x % 3 == 0) {
+      EXPECT_DOUBLE_EQ(mean[x], 2 * (x * 30 + 14.5)) << x;
+    } else {
+      EXPECT_TRUE(std::isnan(mean[x])) << x;
+    }
+  }
+
+  auto evaluated = live.Evaluate(-1.0f).result();
+  ASSERT_TRUE(evaluated.ok()) << evaluated.status();
+  const float* samples = evaluated->get_data_accessor().data() +
+                         evaluated->get_flattened_offset();
+  for (int x = 0; x < 20; ++x) {
+    for (int y = 0; y < 30; ++y) {
+      const float expected = x % 3 == 0 ? 2.0f * (x * 30 + y) : -1.0f;
+      EXPECT_EQ(samples[x * 30 + y], expected) << x << ", " << y;
+    }
+  }
+  std::filesystem::remove_all("compute_variable");
+  std::filesystem::remove_all("compute_mask");
+}
+
+TEST(Compute, inMemory) {
+  auto var = MakeVariable();
+  ASSERT_TRUE(var.ok()) << var.status();
+  auto data = var->Read().result();
+  ASSERT_TRUE(data.ok()) << data.status();
+  auto mask = MakeMask();
+  ASSERT_TRUE(mask.ok()) << mask.status();
+  auto mask_data = mask->Read().result();
+  ASSERT_TRUE(mask_data.ok()) << mask_data.status();
+
+  auto lazy = mdio::Lazy(var.value()).Where(mask.value());
+  auto eager = mdio::Lazy(data.value()).Where(mask_data.value());
+  auto expected = lazy.ReduceAll(mdio::ReduceOp::kRms).result();
+  auto actual = eager.ReduceAll(mdio::ReduceOp::kRms).result();
+  ASSERT_TRUE(expected.ok()) << expected.status();
+  ASSERT_TRUE(actual.ok()) << actual.status();
+  EXPECT_NEAR(actual.value(), expected.value(), 1e-6);
+  std::filesystem::remove_all("compute_variable");
+  std::filesystem::remove_all("compute_mask");
+}
+
+TEST(Compute, errors) {
+  auto var = MakeVariable();
+  ASSERT_TRUE(var.ok()) << var.status();
+  EXPECT_FALSE(mdio::Lazy(var.value())
+                   .Reduce("z", mdio::ReduceOp::kSum)
+                   .status()
+                   .ok());
+
+  // A mask over a dimension the data doesn't have.
+  auto domain =
+      tensorstore::IndexDomainBuilder<>(1).labels({"z"}).shape({4}).Finalize();
+  ASSERT_TRUE(domain.ok()) << domain.status();
+  auto flags = tensorstore::AllocateArray<bool>(
+      domain->box(), tensorstore::c_order, tensorstore::value_init);
+  mdio::VariableData<bool> mask{
+      "z_mask", "", ::nlohmann::json::object(),
+      mdio::LabeledArray<bool, mdio::dynamic_rank, mdio::offset_origin>{
+          domain.value(), flags}};
+  EXPECT_FALSE(mdio::Lazy(var.value())
+                   .Where(mask)
+                   .ReduceAll(mdio::ReduceOp::kSum)
+                   .status()
+                   .ok());
+  std::filesystem::remove_all("compute_variable");
+}
+
+TEST(Compute, reduceBlockLanes) {
+  // More samples than lanes, with a NaN that is skipped.
+  std::vector<float> data(19);
+  for (int i = 0; i < 19; ++i) {
+    data[i] = i;
+  }
+  data[4] = std::nanf("");
+  mdio::internal::ReduceBuffer out(1);
+  mdio::internal::ReduceBlock(
+      data.data(), 1, 19, 1, mdio::internal::IdentityMap{},
+      [](mdio::Index i) { return i != 7; }, out);
+  EXPECT_EQ(out.count[0], 17);
+  EXPECT_DOUBLE_EQ(out.sum[0], 171 - 4 - 7);
+  EXPECT_DOUBLE_EQ(out.Finish(0, mdio::ReduceOp::kMin), 0);
+  EXPECT_DOUBLE_EQ(out.Finish(0, mdio::ReduceOp::kMax), 18);
+}
+
+}  // namespace
@@ -0,0 +1,275 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MDIO_CONVERT_H_
+#define MDIO_CONVERT_H_
+
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "mdio/impl.h"
+#include "mdio/stats.h"
+#include "mdio/variable.h"
+#include "tensorstore/array.h"
+#include "tensorstore/cast.h"
+#include "tensorstore/strided_layout.h"
+#include "tensorstore/util/future.h"
+
+// clang-format off
+#include <nlohmann/json.hpp>  // NOLINT
+// clang-format on
+
+namespace mdio {
+namespace internal {
+
+/**
+ * @brief The linear encoding of a Variable that stores floating point samples
+ * as integers, recorded as ["metadata"]["scaleOffsetV1"].
+ * A stored sample `q` is the value `q * scale + offset`.
+ */
+struct ScaleOffset {
+  double scale = 1;
+  double offset = 0;
+};
+
+/**
+ * @brief Gets the scaled integer encoding from the metadata of a Variable.
+ * @return The encoding, or `std::nullopt` if the samples are stored as is.
+ */
+inline std::optional<ScaleOffset> GetScaleOffset(
+    const nlohmann::json& metadata) {
+  if (!metadata.contains("metadata") ||
+      !metadata["metadata"].contains("scaleOffsetV1")) {
+    return std::nullopt;
+  }
+  const auto& encoding = metadata["metadata"]["scaleOffsetV1"];
+  return ScaleOffset{encoding.value("scale", 1.0),
+                     encoding.value("offset", 0.0)};
+}
+
+/**
+ * @brief Decodes stored integers to floating point samples.
+ * The loop is branch free so the compiler vectorizes it. Stored samples equal
+ * to `fill` are NaN.
+ */
+template <typename S, typename U>
+void DecodeScaled(const S* stored, U* samples, Index n_samples,
+                  const ScaleOffset& encoding, std::optional<S> fill) {
+  const U scale = static_cast<U>(encoding.scale);
+  const U offset = static_cast<U>(encoding.offset);
+  if (!fill.has_value()) {
+    for (Index i = 0; i < n_samples; ++i) {
+      samples[i] = static_cast<U>(stored[i]) * scale + offset;
+    }
+    return;
+  }
+  const S missing = *fill;
+  const U nan = std::numeric_limits<U>::quiet_NaN();
+  for (Index i = 0; i < n_samples; ++i) {
+    const U value = static_cast<U>(stored[i]) * scale + offset;
+    samples[i] = stored[i] == missing ? nan : value;
+  }
+}
+
+/**
+ * @brief Encodes floating point samples as stored integers, the nearest level
+ * clamped to the range of `S`.
+ * NaNs are stored as `fill`.
+ */
+template <typename U, typename S>
+void EncodeScaled(const U* samples, S* stored, Index n_samples,
+                  const ScaleOffset& encoding, S fill) {
+  const double inverse = 1 / encoding.scale;
+  const double offset = encoding.offset;
+  constexpr double lowest = std::numeric_limits<S>::lowest();
+  constexpr double highest = std::numeric_limits<S>::max();
+  for (Index i = 0; i < n_samples; ++i) {
+    double level = std::nearbyint((samples[i] - offset) * inverse);
+    level = level < lowest ? lowest : level;
+    level = level > highest ? highest : level;
+    stored[i] = std::isnan(level) ? fill : static_cast<S>(level);
+  }
+}
+
+/**
+ * @brief Gets the fill value of a Variable as a stored integer.
+ */
+template <typename S, typename T, DimensionIndex R, ReadWriteMode M>
+std::optional<S> ScaledFillValue(const Variable<T, R, M>& var) {
+  auto spec = var.get_spec();
+  if (!spec.ok()) {
+    return std::nullopt;
+  }
+  auto fill = FillValueFromSpec(spec.value());
+  if (!fill.has_value()) {
+    return std::nullopt;
+  }
+  return static_cast<S>(*fill);
+}
+}  // namespace internal
+
+/**
+ * @brief Reads a Variable as another element type.
+ * A Variable stored as scaled integers (see "scaleOffsetV1") is decoded to
+ * `q * scale + offset`, samples equal to the fill value are NaN. Any other
+ * Variable is converted by tensorstore chunk by chunk as it is decoded, e.g.
+ * a `float16` Variable read as `float`.
+ *
+ * @details \b Usage
+ * @code
+ * MDIO_ASSIGN_OR_RETURN(auto amplitude, dataset.variables.at("seismic"));
+ * MDIO_ASSIGN_OR_RETURN(auto data, mdio::ReadAs<float>(amplitude).result());
+ * @endcode
+ * @tparam U The element type to read as.
+ * @return A future of the converted VariableData, or an error if the stored
+ * type can't be converted to `U`.
+ */
+template <typename U, typename T, DimensionIndex R, ReadWriteMode M>
+Future<VariableData<U, R, offset_origin>> ReadAs(
+    const Variable<T, R, M>& var) {
+  using Data = VariableData<U, R, offset_origin>;
+  auto encoding = internal::GetScaleOffset(var.getMetadata());
+  tensorstore::IndexDomain<R> domain = var.dimensions();
+  auto label = [name = var.get_variable_name(),
+                long_name = var.get_long_name(), metadata = var.getMetadata(),
+                domain](SharedArray<U, R, offset_origin> array) {
+    return Data{name, long_name, metadata,
+                LabeledArray<U, R, offset_origin>{domain, std::move(array)}};
+  };
+
+  if (!encoding.has_value()) {
+    MDIO_ASSIGN_OR_RETURN(auto converted, tensorstore::Cast<U>(var.get_store()))
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [label](const SharedArray<U, R, offset_origin>& array) {
+          return label(array);
+        },
+        tensorstore::Read(converted));
+  }
+
+  if constexpr (!std::is_floating_point_v<U>) {
+    return absl::InvalidArgumentError(
+        "A scaled integer Variable can only be read as floating point.");
+  } else {
+    const DataType dtype = var.dtype();
+    std::optional<double> fill;
+    if (auto spec = var.get_spec(); spec.ok()) {
+      fill = internal::FillValueFromSpec(spec.value());
+    }
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [label, encoding = *encoding, dtype,
+         fill](const SharedArray<T, R, offset_origin>& stored) -> Result<Data> {
+          auto samples = tensorstore::AllocateArray<U>(
+              stored.domain(), ContiguousLayoutOrder::c,
+              tensorstore::default_init);
+          const void* ptr = stored.byte_strided_origin_pointer().get();
+          bool decoded = false;
+          internal::DispatchNumericType<T>(dtype, [&](auto tag) {
+            using S = decltype(tag);
+            if constexpr (std::is_integral_v<S>) {
+              std::optional<S> missing;
+              if (fill.has_value()) {
+                missing = static_cast<S>(*fill);
+              }
+              internal::DecodeScaled(
+                  static_cast<const S*>(ptr),
+                  samples.byte_strided_origin_pointer().get(),
+                  samples.num_elements(), encoding, missing);
+              decoded = true;
+            }
+          });
+          if (!decoded) {
+            return absl::InvalidArgumentError(
+                "scaleOffsetV1 requires an integer Variable.");
+          }
+          return label(std::move(samples));
+        },
+        tensorstore::Read(var.get_store()));
+  }
+}
+
+/**
+ * @brief Writes data of another element type to a Variable.
+ * To a Variable stored as scaled integers (see "scaleOffsetV1") the samples
+ * are written as the nearest integer level, clamped to the stored type, NaNs
+ * as the fill value. Any other Variable gets a converted copy, e.g. `float`
+ * data written to a `float16` Variable.
+ *
+ * @details \b Usage
+ * @code
+ * MDIO_ASSIGN_OR_RETURN(auto amplitude, dataset.variables.at("seismic"));
+ * MDIO_ASSIGN_OR_RETURN(auto data, mdio::ReadAs<float>(amplitude).result());
+ * // Process `data` here
+ * auto written = mdio::WriteAs(amplitude, data);
+ * @endcode
+ * @return The futures of the write, see `Variable::Write`, or an error if
+ * `U` can't be converted to the stored type.
+ */
+template <typename T, DimensionIndex R, ReadWriteMode M, typename U,
+          ArrayOriginKind OriginKind>
+WriteFutures WriteAs(const Variable<T, R, M>& var,
+                     const VariableData<U, R, OriginKind>& source) {
+  const auto& array = source.data.data;
+  auto stored = tensorstore::AllocateArray(
+      array.domain(), ContiguousLayoutOrder::c, tensorstore::default_init,
+      var.dtype());
+  auto encoding = internal::GetScaleOffset(var.getMetadata());
+  if (!encoding.has_value()) {
+    auto copied = tensorstore::CopyConvertedArray(array, stored);
+    if (!copied.ok()) {
+      return copied;
+    }
+  } else if constexpr (!std::is_floating_point_v<U>) {
+    return absl::InvalidArgumentError(
+        "A scaled integer Variable can only be written from floating point.");
+  } else {
+    SharedArray<const U, R, offset_origin> samples = array;
+    if (!tensorstore::IsContiguousLayout(samples.layout(),
+                                         ContiguousLayoutOrder::c, sizeof(U))) {
+      samples = tensorstore::MakeCopy(array);
+    }
+    bool encoded = false;
+    internal::DispatchNumericType<T>(var.dtype(), [&](auto tag) {
+      using S = decltype(tag);
+      if constexpr (std::is_integral_v<S>) {
+        internal::EncodeScaled(
+            samples.byte_strided_origin_pointer().get(),
+            static_cast<S*>(stored.byte_strided_origin_pointer().get()),
+            samples.num_elements(), *encoding,
+            internal::ScaledFillValue<S>(var).value_or(S{}));
+        encoded = true;
+      }
+    });
+    if (!encoded) {
+      return absl::InvalidArgumentError(
+          "scaleOffsetV1 requires an integer Variable.");
+    }
+  }
+
+  MDIO_ASSIGN_OR_RETURN(auto typed,
+                        tensorstore::StaticDataTypeCast<T>(std::move(stored)))
+  VariableData<T, R, offset_origin> data{
+      source.variableName, source.longName, source.metadata,
+      LabeledArray<T, R, offset_origin>{source.data.domain, std::move(typed)}};
+  return var.Write(data);
+}
+
+}  // namespace mdio
+
+#endif  // MDIO_CONVERT_H_
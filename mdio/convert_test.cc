@@ -0,0 +1,193 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mdio/convert.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <string>
+
+#include "mdio/dataset.h"
+
+namespace {
+
+/*NOLINT*/ const std::string kPath = "zarrs/converted.mdio";
+
+const char kSchema[] = R"(
+{
+  "metadata": {
+    "name": "converted",
+    "apiVersion": "1.0.0",
+    "createdOn": "2023-12-12T15:02:06.413469-06:00"
+  },
+  "variables": [
+    {
+      "name": "scaled",
+      "dataType": "int16",
+      "dimensions": [
+        {"name": "inline", "size": 4},
+        {"name": "depth", "size": 5}
+      ],
+      "metadata": {
+        "chunkGrid": {
+          "name": "regular",
+          "configuration": {"chunkShape": [2, 5]}
+        },
+        "scaleOffsetV1": {"scale": 0.5, "offset": 10}
+      },
+      "coordinates": ["inline"]
+    },
+    {
+      "name": "half",
+      "dataType": "float16",
+      "dimensions": ["inline", "depth"],
+      "metadata": {
+        "chunkGrid": {
+          "name": "regular",
+          "configuration": {"chunkShape": [4, 5]}
+        }
+      },
+      "coordinates": ["inline"]
+    },
+    {
+      "name": "inline",
+      "dataType": "uint32",
+      "dimensions": [{"name": "inline", "size": 4}]
+    },
+    {
+      "name": "depth",
+      "dataType": "uint32",
+      "dimensions": [{"name": "depth", "size": 5}]
+    }
+  ]
+}
+)";
+
+mdio::Result<mdio::Dataset> MakeDataset(const ::nlohmann::json& schema) {
+  return mdio::Dataset::from_json(schema, kPath, mdio::constants::kCreateClean)
+      .result();
+}
+
+float* Samples(mdio::VariableData<float>& data) {  // NOLINT (non-const)
+  return data.get_data_accessor().data() + data.get_flattened_offset();
+}
+
+TEST(Convert, scaledRoundTrip) {
+  auto dataset = MakeDataset(::nlohmann::json::parse(kSchema));
+  ASSERT_TRUE(dataset.ok()) << dataset.status();
+  auto scaled = dataset->variables.at("scaled");
+  ASSERT_TRUE(scaled.ok()) << scaled.status();
+
+  auto data = mdio::ReadAs<float>(scaled.value()).result();
+  ASSERT_TRUE(data.ok()) << data.status();
+  float* samples = Samples(data.value());
+  for (int i = 0; i < 4 * 5; ++i) {
+    samples[i] = 0.25f * i;
+  }
+  samples[1] = std::numeric_limits<float>::quiet_NaN();
+  samples[2] = 1e9f;
+  auto written = mdio::WriteAs(scaled.value(), data.value());
+  ASSERT_TRUE(written.commit_future.result().ok()) << written.status();
+
+  // The stored levels, rounded to the nearest and clamped to int16.
+  auto levels = dataset->variables.get<mdio::dtypes::int16_t>("scaled");
+  ASSERT_TRUE(levels.ok()) << levels.status();
+  auto stored = levels->Read().result();
+  ASSERT_TRUE(stored.ok()) << stored.status();
+  const int16_t* raw =
+      stored->get_data_accessor().data() + stored->get_flattened_offset();
+  EXPECT_EQ(raw[0], -20);
+  EXPECT_EQ(raw[1], 0);
+  EXPECT_EQ(raw[2], std::numeric_limits<int16_t>::max());
+  EXPECT_EQ(raw[8], -16);
+
+  auto read = mdio::ReadAs<float>(scaled.value()).result();
+  ASSERT_TRUE(read.ok()) << read.status();
+  const float* decoded = Samples(read.value());
+  EXPECT_EQ(decoded[0], 0.0f);
+  EXPECT_EQ(decoded[2], 10 + 0.5f * std::numeric_limits<int16_t>::max());
+  for (int i = 3; i < 4 * 5; ++i) {
+    EXPECT_NEAR(decoded[i], 0.25f * i, 0.25f) << i;
+  }
+  std::filesystem::remove_all(kPath);
+}
+
+TEST(Convert, scaleOffsetRoundTrips) {
+  ASSERT_TRUE(MakeDataset(::nlohmann::json::parse(kSchema)).ok());
+  auto dataset = mdio::Dataset::Open(kPath, mdio::constants::kOpen).result();
+  ASSERT_TRUE(dataset.ok()) << dataset.status();
+  auto scaled = dataset->variables.at("scaled");
+  ASSERT_TRUE(scaled.ok()) << scaled.status();
+  auto encoding = mdio::internal::GetScaleOffset(scaled->getMetadata());
+  ASSERT_TRUE(encoding.has_value());
+  EXPECT_EQ(encoding->scale, 0.5);
+  EXPECT_EQ(encoding->offset, 10);
+  EXPECT_EQ(scaled->getMetadata()["metadata"]["scaleOffsetV1"],
+            ::nlohmann::json({{"scale", 0.5}, {"offset", 10}}));
+
+  // Only floating point data goes in and out of scaled integers.
+  EXPECT_FALSE(mdio::ReadAs<int32_t>(scaled.value()).result().ok());
+  std::filesystem::remove_all(kPath);
+}
+
+TEST(Convert, float16) {
+  auto dataset = MakeDataset(::nlohmann::json::parse(kSchema));
+  ASSERT_TRUE(dataset.ok()) << dataset.status();
+  auto half = dataset->variables.at("half");
+  ASSERT_TRUE(half.ok()) << half.status();
+
+  auto data = mdio::ReadAs<float>(half.value()).result();
+  ASSERT_TRUE(data.ok()) << data.status();
+  float* samples = Samples(data.value());
+  // Nothing is written yet, the fill value converts to NaN.
+  EXPECT_TRUE(std::isnan(samples[0]));
+  for (int i = 0; i < 4 * 5; ++i) {
+    samples[i] = 0.25f * i - 1;
+  }
+  // The stored dtype still has to match for a plain write.
+  auto rejected = half->Write(data.value());
+  EXPECT_FALSE(rejected.status().ok());
+  auto written = mdio::WriteAs(half.value(), data.value());
+  ASSERT_TRUE(written.commit_future.result().ok()) << written.status();
+
+  auto read = mdio::ReadAs<float>(half.value()).result();
+  ASSERT_TRUE(read.ok()) << read.status();
+  const float* converted = Samples(read.value());
+  for (int i = 0; i < 4 * 5; ++i) {
+    EXPECT_EQ(converted[i], 0.25f * i - 1) << i;
+  }
+  std::filesystem::remove_all(kPath);
+}
+
+TEST(Convert, invalidScaleOffset) {
+  auto schema = ::nlohmann::json::parse(kSchema);
+  schema["variables"][0]["dataType"] = "float32";
+  EXPECT_EQ(MakeDataset(schema).status().code(),
+            absl::StatusCode::kInvalidArgument);
+  schema["variables"][0]["dataType"] = "int64";
+  EXPECT_EQ(MakeDataset(schema).status().code(),
+            absl::StatusCode::kInvalidArgument);
+  schema["variables"][0]["dataType"] = "int8";
+  schema["variables"][0]["metadata"]["scaleOffsetV1"]["scale"] = 0;
+  EXPECT_EQ(MakeDataset(schema).status().code(),
+            absl::StatusCode::kInvalidArgument);
+  std::filesystem::remove_all(kPath);
+}
+
+}  // namespace
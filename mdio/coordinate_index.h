@@ -0,0 +1,351 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MDIO_COORDINATE_INDEX_H_
+#define MDIO_COORDINATE_INDEX_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/cord.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "mdio/impl.h"
+#include "tensorstore/kvstore/kvstore.h"
+#include "tensorstore/kvstore/operations.h"
+#include "tensorstore/util/endian.h"
+#include "tensorstore/util/future.h"
+#include "tensorstore/util/span.h"
+
+namespace mdio {
+namespace internal {
+
+/// A half-open run [start, stop) of flat offsets.
+struct FlatRun {
+  Index start;
+  Index stop;
+};
+
+/// The key of the index sidecar, relative to the Variable's directory.
+constexpr char kCoordinateIndexKey[] = ".zindex";
+/// The key of the spatial index sidecar of the CDP coordinates, see
+/// spatial_index.h.
+constexpr char kSpatialIndexKey[] = ".zspatial";
+/// Leading bytes of a serialized index, also acts as the format version.
+constexpr std::string_view kCoordinateIndexMagic = "MDIOIDX1";
+
+/**
+ * @brief Swaps `count` elements of `size` bytes between host and little
+ * endian byte order, which is what the serialized index is in.
+ */
+inline void SwapLittleEndian(char* data, std::size_t size, std::size_t count) {
+  if (tensorstore::endian::native == tensorstore::endian::little) {
+    return;
+  }
+  for (std::size_t i = 0; i < count; ++i) {
+    std::reverse(data + i * size, data + (i + 1) * size);
+  }
+}
+
+template <typename T>
+void AppendBytes(std::string& out, const T* data,  // NOLINT (non-const)
+                 std::size_t count, std::size_t element_size = sizeof(T)) {
+  const std::size_t start = out.size();
+  out.append(reinterpret_cast<const char*>(data), count * sizeof(T));
+  SwapLittleEndian(out.data() + start, element_size,
+                   count * sizeof(T) / element_size);
+}
+
+template <typename T>
+bool ConsumeBytes(std::string_view& in, T* data,  // NOLINT (non-const)
+                  std::size_t count, std::size_t element_size = sizeof(T)) {
+  const std::size_t num_bytes = count * sizeof(T);
+  if (count != 0 && num_bytes / count != sizeof(T)) {
+    return false;
+  }
+  if (in.size() < num_bytes) {
+    return false;
+  }
+  std::memcpy(data, in.data(), num_bytes);
+  SwapLittleEndian(reinterpret_cast<char*>(data), element_size,
+                   num_bytes / element_size);
+  in.remove_prefix(num_bytes);
+  return true;
+}
+
+// Runs are serialized as pairs of offsets.
+static_assert(sizeof(FlatRun) == 2 * sizeof(Index));
+
+}  // namespace internal
+
+/**
+ * @brief A sorted value to run table for a coordinate Variable.
+ * Every distinct value maps to the runs of flat, C-order offsets at which the
+ * value occurs. A lookup is a binary search over the distinct values and never
+ * touches the coordinate data itself.
+ *
+ * The index is persisted as a sidecar key in the Variable's directory. It
+ * describes the full, unsliced Variable. The first write to the coordinate
+ * through a Variable deletes it, so it has to be rebuilt after the coordinate
+ * is modified. NaN values are never indexed because they never compare equal.
+ * @tparam T The element type of the coordinate.
+ */
+template <typename T>
+class CoordinateIndex {
+  // std::vector<bool> is bit packed, so bools are stored as bytes.
+  using stored_type = std::conditional_t<std::is_same_v<T, bool>, uint8_t, T>;
+
+ public:
+  /**
+   * @brief Builds the index from a contiguous C-order buffer.
+   * @param data Pointer to the first element of the coordinate.
+   * @param num_samples The number of elements in the coordinate.
+   */
+  static CoordinateIndex Build(const T* data, Index num_samples) {
+    struct Entry {
+      stored_type value;
+      internal::FlatRun run;
+    };
+    std::vector<Entry> entries;
+    for (Index i = 0; i < num_samples;) {
+      const T value = data[i];
+      Index stop = i + 1;
+      while (stop < num_samples && data[stop] == value) {
+        ++stop;
+      }
+      if (value == value) {  // Skip NaN
+        entries.push_back({static_cast<stored_type>(value), {i, stop}});
+      }
+      i = stop;
+    }
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const Entry& a, const Entry& b) {
+                       return a.value < b.value;
+                     });
+
+    CoordinateIndex index;
+    index.num_samples_ = num_samples;
+    index.runs_.reserve(entries.size());
+    for (const auto& entry : entries) {
+      if (index.values_.empty() || index.values_.back() != entry.value) {
+        index.values_.push_back(entry.value);
+        index.offsets_.push_back(index.runs_.size());
+      }
+      index.runs_.push_back(entry.run);
+    }
+    index.offsets_.push_back(index.runs_.size());
+    return index;
+  }
+
+  /**
+   * @brief Serializes the index for storage.
+   * The layout is the magic, the length of the dtype name, the sample, value
+   * and run counts, the dtype name, and then the values, run offsets, and
+   * runs. Numbers are little endian.
+   * @param dtype The dtype of the coordinate, checked on deserialization.
+   */
+  absl::Cord Serialize(DataType dtype) const {
+    std::string out(internal::kCoordinateIndexMagic);
+    const std::string_view name = dtype.name();
+    const uint64_t header[] = {name.size(),
+                               static_cast<uint64_t>(num_samples_),
+                               values_.size(), runs_.size()};
+    internal::AppendBytes(out, header, 4);
+    out.append(name);
+    internal::AppendBytes(out, values_.data(), values_.size());
+    internal::AppendBytes(out, offsets_.data(), offsets_.size());
+    internal::AppendBytes(out, runs_.data(), runs_.size(), sizeof(Index));
+    return absl::Cord(std::move(out));
+  }
+
+  /**
+   * @brief Reconstructs an index written by `Serialize`.
+   * @param bytes The serialized index.
+   * @param dtype The dtype of the coordinate the index is expected to describe.
+   * @return The index, or a DataLossError if the bytes are malformed or
+   * describe a different dtype.
+   */
+  static Result<CoordinateIndex> Deserialize(const absl::Cord& bytes,
+                                             DataType dtype) {
+    const std::string flat(bytes);
+    std::string_view in(flat);
+    const auto corrupt = [] {
+      return absl::DataLossError("Corrupt coordinate index.");
+    };
+    if (!absl::StartsWith(in, internal::kCoordinateIndexMagic)) {
+      return corrupt();
+    }
+    in.remove_prefix(internal::kCoordinateIndexMagic.size());
+
+    uint64_t header[4];
+    if (!internal::ConsumeBytes(in, header, 4) || in.size() < header[0]) {
+      return corrupt();
+    }
+    if (in.substr(0, header[0]) != dtype.name()) {
+      return absl::DataLossError(absl::StrCat(
+          "Coordinate index was built for dtype '", in.substr(0, header[0]),
+          "' but the Variable is '", dtype.name(), "'."));
+    }
+    in.remove_prefix(header[0]);
+
+    CoordinateIndex index;
+    index.num_samples_ = static_cast<Index>(header[1]);
+    const uint64_t num_values = header[2];
+    const uint64_t num_runs = header[3];
+    // Guard the allocations against sizes the payload can't hold.
+    if (num_values > in.size() || num_runs > in.size()) {
+      return corrupt();
+    }
+    index.values_.resize(num_values);
+    index.offsets_.resize(num_values + 1);
+    index.runs_.resize(num_runs);
+    if (!internal::ConsumeBytes(in, index.values_.data(), num_values) ||
+        !internal::ConsumeBytes(in, index.offsets_.data(), num_values + 1) ||
+        !internal::ConsumeBytes(in, index.runs_.data(), num_runs,
+                                sizeof(Index)) ||
+        !in.empty() || index.offsets_.front() != 0 ||
+        index.offsets_.back() != num_runs ||
+        !std::is_sorted(index.offsets_.begin(), index.offsets_.end())) {
+      return corrupt();
+    }
+    return index;
+  }
+
+  /**
+   * @brief Finds every occurrence of `value`.
+   * @return The runs of flat offsets holding `value`, in ascending order. The
+   * span is empty if the value does not occur.
+   */
+  tensorstore::span<const internal::FlatRun> find(const T& value) const {
+    const stored_type key = static_cast<stored_type>(value);
+    auto it = std::lower_bound(values_.begin(), values_.end(), key);
+    if (it == values_.end() || *it != key) {
+      return {};
+    }
+    const auto pos = it - values_.begin();
+    return {runs_.data() + offsets_[pos],
+            static_cast<std::ptrdiff_t>(offsets_[pos + 1] - offsets_[pos])};
+  }
+
+  /**
+   * @brief Counts the occurrences of `value`.
+   */
+  Index count(const T& value) const {
+    Index total = 0;
+    for (const auto& run : find(value)) {
+      total += run.stop - run.start;
+    }
+    return total;
+  }
+
+  /// The number of samples of the coordinate the index was built from.
+  Index num_samples() const { return num_samples_; }
+
+  /// The number of distinct values in the index.
+  std::size_t num_values() const { return values_.size(); }
+
+ private:
+  CoordinateIndex() = default;
+
+  Index num_samples_ = 0;
+  std::vector<stored_type> values_;
+  std::vector<uint64_t> offsets_;
+  std::vector<internal::FlatRun> runs_;
+};
+
+namespace internal {
+
+/**
+ * @brief Reads the persisted index of a coordinate Variable if there is one.
+ * The index is only used for a Variable that covers its full stored domain,
+ * because the flat offsets refer to the unsliced coordinate. An index that
+ * can't be decoded, or was built for another dtype, is treated as absent.
+ * @return A future of the index, or of `std::nullopt` if the Variable has no
+ * usable index.
+ */
+template <typename T, typename VariableType>
+Future<std::optional<CoordinateIndex<T>>> ReadCoordinateIndex(
+    const VariableType& var) {
+  using OptionalIndex = std::optional<CoordinateIndex<T>>;
+  auto origin = var.dimensions().origin();
+  if (std::any_of(origin.begin(), origin.end(),
+                  [](Index i) { return i != 0; })) {
+    return OptionalIndex{};
+  }
+  auto kvs = var.get_store().kvstore();
+  if (!kvs.valid()) {
+    return OptionalIndex{};
+  }
+  const Index num_samples = var.num_samples();
+  const DataType dtype = var.dtype();
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [num_samples, dtype](const tensorstore::kvstore::ReadResult& read)
+          -> Result<OptionalIndex> {
+        if (!read.has_value()) {
+          return OptionalIndex{};
+        }
+        auto index = CoordinateIndex<T>::Deserialize(read.value, dtype);
+        // A sliced Variable with a zero origin has fewer samples.
+        if (!index.ok() || index->num_samples() != num_samples) {
+          return OptionalIndex{};
+        }
+        return OptionalIndex{std::move(index).value()};
+      },
+      tensorstore::kvstore::Read(kvs, kCoordinateIndexKey));
+}
+
+/**
+ * @brief Deletes the indexes of a coordinate Variable, if it has any.
+ * The spatial index of the CDP coordinates goes too, as it describes them.
+ * @param kvs The kvstore of the Variable's data.
+ */
+inline Future<void> DeleteCoordinateIndex(const tensorstore::KvStore& kvs) {
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [](const tensorstore::TimestampedStorageGeneration&,
+         const tensorstore::TimestampedStorageGeneration&) {},
+      tensorstore::kvstore::Delete(kvs, kCoordinateIndexKey),
+      tensorstore::kvstore::Delete(kvs, kSpatialIndexKey));
+}
+
+/**
+ * @brief Writes the index of a coordinate Variable next to its data.
+ */
+template <typename T, typename VariableType>
+Future<void> WriteCoordinateIndex(const VariableType& var,
+                                  const CoordinateIndex<T>& index) {
+  auto kvs = var.get_store().kvstore();
+  if (!kvs.valid()) {
+    return absl::UnimplementedError(
+        "The Variable's store does not support a coordinate index.");
+  }
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [](const tensorstore::TimestampedStorageGeneration&) {},
+      tensorstore::kvstore::Write(kvs, kCoordinateIndexKey,
+                                  index.Serialize(var.dtype())));
+}
+
+}  // namespace internal
+}  // namespace mdio
+
+#endif  // MDIO_COORDINATE_INDEX_H_
@@ -0,0 +1,132 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mdio/coordinate_index.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+TEST(CoordinateIndex, build) {
+  std::vector<int32_t> data = {1, 2, 3, 4, 3, 5, 6, 7, 8, 8};
+  auto index =
+      mdio::CoordinateIndex<int32_t>::Build(data.data(), data.size());
+  EXPECT_EQ(index.num_samples(), 10);
+  EXPECT_EQ(index.num_values(), 8);
+
+  auto runs = index.find(3);
+  ASSERT_EQ(runs.size(), 2);
+  EXPECT_EQ(runs[0].start, 2);
+  EXPECT_EQ(runs[0].stop, 3);
+  EXPECT_EQ(runs[1].start, 4);
+  EXPECT_EQ(runs[1].stop, 5);
+
+  runs = index.find(8);
+  ASSERT_EQ(runs.size(), 1);
+  EXPECT_EQ(runs[0].start, 8);
+  EXPECT_EQ(runs[0].stop, 10);
+  EXPECT_EQ(index.count(8), 2);
+
+  EXPECT_TRUE(index.find(9).empty());
+  EXPECT_EQ(index.count(9), 0);
+}
+
+TEST(CoordinateIndex, roundTrip) {
+  std::vector<int32_t> data = {5, 5, 1, 1, 1, 5, 2};
+  auto index =
+      mdio::CoordinateIndex<int32_t>::Build(data.data(), data.size());
+  auto bytes = index.Serialize(mdio::constants::kInt32);
+
+  auto decoded = mdio::CoordinateIndex<int32_t>::Deserialize(
+      bytes, mdio::constants::kInt32);
+  ASSERT_TRUE(decoded.ok()) << decoded.status();
+  EXPECT_EQ(decoded->num_samples(), 7);
+  EXPECT_EQ(decoded->num_values(), 3);
+  auto runs = decoded->find(5);
+  ASSERT_EQ(runs.size(), 2);
+  EXPECT_EQ(runs[0].start, 0);
+  EXPECT_EQ(runs[0].stop, 2);
+  EXPECT_EQ(runs[1].start, 5);
+  EXPECT_EQ(runs[1].stop, 6);
+}
+
+TEST(CoordinateIndex, littleEndian) {
+  std::vector<int32_t> data = {0x01020304};
+  const std::string bytes(mdio::CoordinateIndex<int32_t>::Build(
+                              data.data(), data.size())
+                              .Serialize(mdio::constants::kInt32));
+  // The header starts with the length of the dtype name.
+  const std::string name(mdio::constants::kInt32.name());
+  std::size_t at = mdio::internal::kCoordinateIndexMagic.size();
+  EXPECT_EQ(bytes[at], static_cast<char>(name.size()));
+  EXPECT_EQ(bytes.substr(at + 1, 7), std::string(7, '\0'));
+  // The single value follows the header and the name.
+  at += 4 * sizeof(uint64_t) + name.size();
+  EXPECT_EQ(bytes.substr(at, 4), std::string("\x04\x03\x02\x01"));
+}
+
+TEST(CoordinateIndex, dtypeMismatch) {
+  std::vector<int32_t> data = {1, 2, 3};
+  auto bytes = mdio::CoordinateIndex<int32_t>::Build(data.data(), data.size())
+                   .Serialize(mdio::constants::kInt32);
+  auto decoded = mdio::CoordinateIndex<int32_t>::Deserialize(
+      bytes, mdio::constants::kUint32);
+  EXPECT_FALSE(decoded.ok());
+}
+
+TEST(CoordinateIndex, corrupt) {
+  std::vector<int32_t> data = {1, 2, 3};
+  std::string bytes(
+      mdio::CoordinateIndex<int32_t>::Build(data.data(), data.size())
+          .Serialize(mdio::constants::kInt32));
+
+  // Truncated
+  auto decoded = mdio::CoordinateIndex<int32_t>::Deserialize(
+      absl::Cord(bytes.substr(0, bytes.size() - 1)), mdio::constants::kInt32);
+  EXPECT_FALSE(decoded.ok());
+
+  // Not an index at all
+  decoded = mdio::CoordinateIndex<int32_t>::Deserialize(
+      absl::Cord("{\"foo\": \"bar\"}"), mdio::constants::kInt32);
+  EXPECT_FALSE(decoded.ok());
+}
+
+TEST(CoordinateIndex, boolean) {
+  bool data[] = {true, true, false, true, false, false};
+  auto index = mdio::CoordinateIndex<bool>::Build(data, 6);
+  auto bytes = index.Serialize(mdio::constants::kBool);
+  auto decoded = mdio::CoordinateIndex<bool>::Deserialize(
+      bytes, mdio::constants::kBool);
+  ASSERT_TRUE(decoded.ok()) << decoded.status();
+  EXPECT_EQ(decoded->count(true), 3);
+  EXPECT_EQ(decoded->count(false), 3);
+  EXPECT_EQ(decoded->find(true).size(), 2);
+}
+
+TEST(CoordinateIndex, nanIsNotIndexed) {
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  std::vector<float> data = {nan, 1.5f, nan, nan, 2.5f};
+  auto index = mdio::CoordinateIndex<float>::Build(data.data(), data.size());
+  EXPECT_EQ(index.num_values(), 2);
+  EXPECT_TRUE(index.find(nan).empty());
+  EXPECT_EQ(index.count(2.5f), 1);
+}
+
+}  // namespace
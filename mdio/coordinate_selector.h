@@ -15,12 +15,26 @@
 #ifndef MDIO_COORDINATE_SELECTOR_H_
 #define MDIO_COORDINATE_SELECTOR_H_
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
 #include <map>
+#include <memory>
+#include <numeric>
+#include <optional>
 #include <string>
+#include <thread>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "absl/numeric/bits.h"
+#include "absl/synchronization/mutex.h"
+#include "mdio/coordinate_index.h"
 #include "mdio/dataset.h"
 #include "mdio/impl.h"
 #include "mdio/variable.h"
@@ -31,23 +45,12 @@
 #include "tensorstore/index_space/index_domain_builder.h"
 #include "tensorstore/index_space/index_transform.h"
 #include "tensorstore/index_space/index_transform_builder.h"
+#include "tensorstore/internal/thread/thread_pool.h"
+#include "tensorstore/util/division.h"
 #include "tensorstore/util/span.h"
 
-// #define MDIO_INTERNAL_PROFILING 0  // TODO(BrianMichell): Remove simple
-// profiling code once we approach a more mature API access.
-
 namespace mdio {
 
-#ifdef MDIO_INTERNAL_PROFILING
-void timer(std::chrono::high_resolution_clock::time_point start) {
-  auto end = std::chrono::high_resolution_clock::now();
-  auto duration =
-      std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-  std::cout << "Time taken: " << duration.count() << " microseconds"
-            << std::endl;
-}
-#endif
-
 // — helper to tag multi-key sorts ——
 template <typename T>
 struct SortKey {
@@ -72,6 +75,691 @@ struct is_sort_key<SortKey<T>> : std::true_type {};
 template <typename D>
 inline constexpr bool is_sort_key_v = is_sort_key<std::decay_t<D>>::value;
 
+namespace internal {
+
+/**
+ * @brief Finds the maximal runs of elements equal to `value`.
+ * The data is scanned in blocks of 64 elements. Each block is reduced to a bit
+ * mask with a branch-free compare loop, which the compiler turns into SIMD
+ * compares, and run boundaries are then located with count-trailing-zeros
+ * instead of testing every element. Blocks that are all matches or all misses
+ * cost a single mask test.
+ * @param data Pointer to the first element to scan.
+ * @param n_samples The number of elements to scan.
+ * @param value The value to match.
+ * @param runs The runs found, relative to `data`, are appended here.
+ */
+template <typename T>
+void FindMatchingRuns(const T* data, Index n_samples, const T& value,
+                      std::vector<FlatRun>& runs) {  // NOLINT (non-const)
+  constexpr Index kBlock = 64;
+  bool in_run = false;
+  Index run_start = 0;
+
+  for (Index base = 0; base < n_samples; base += kBlock) {
+    const Index width = std::min(kBlock, n_samples - base);
+    const T* block = data + base;
+    uint64_t mask = 0;
+    if (width == kBlock) {
+      for (Index b = 0; b < kBlock; ++b) {
+        mask |= static_cast<uint64_t>(block[b] == value) << b;
+      }
+    } else {
+      for (Index b = 0; b < width; ++b) {
+        mask |= static_cast<uint64_t>(block[b] == value) << b;
+      }
+    }
+    const uint64_t valid =
+        width == kBlock ? ~uint64_t{0} : (uint64_t{1} << width) - 1;
+
+    // Fast paths for blocks that can't change the run state.
+    if ((in_run && mask == valid) || (!in_run && mask == 0)) {
+      continue;
+    }
+
+    int consumed = 0;
+    while (consumed < width) {
+      const uint64_t remaining = valid & (~uint64_t{0} << consumed);
+      if (in_run) {
+        const uint64_t misses = ~mask & remaining;
+        if (misses == 0) break;
+        consumed = absl::countr_zero(misses);
+        runs.push_back({run_start, base + consumed});
+        in_run = false;
+      } else {
+        const uint64_t hits = mask & remaining;
+        if (hits == 0) break;
+        consumed = absl::countr_zero(hits);
+        run_start = base + consumed;
+        in_run = true;
+      }
+    }
+  }
+  if (in_run) {
+    runs.push_back({run_start, n_samples});
+  }
+}
+
+/**
+ * @brief A single read that covers a group of selected runs.
+ * @param box The bounding box of the runs, in the Variable's index space.
+ * @param runs The positions of the runs in the selection.
+ */
+struct CoalescedRead {
+  tensorstore::Box<> box;
+  std::vector<std::size_t> runs;
+};
+
+/**
+ * @brief Groups runs that fall in the same chunks into a single read.
+ * Runs are grouped by the span of chunk cells they touch in every dimension,
+ * so a group's bounding box never reaches into a chunk that one of its runs
+ * doesn't already need. Without a chunk shape every run is read on its own.
+ * @param boxes The box of each run.
+ * @param chunk_shape The chunk shape of the Variable, the grid is anchored at
+ * 0. May be empty.
+ * @return The reads, in order of their first run.
+ */
+inline std::vector<CoalescedRead> PlanCoalescedReads(
+    const std::vector<tensorstore::Box<>>& boxes,
+    const std::vector<DimensionIndex>& chunk_shape) {
+  std::vector<CoalescedRead> reads;
+  std::map<std::vector<Index>, std::size_t> read_of;
+  for (std::size_t i = 0; i < boxes.size(); ++i) {
+    const auto& box = boxes[i];
+    const DimensionIndex rank = box.rank();
+    std::vector<Index> key;
+    if (static_cast<DimensionIndex>(chunk_shape.size()) == rank) {
+      key.reserve(2 * rank);
+      for (DimensionIndex d = 0; d < rank; ++d) {
+        const Index chunk = std::max<Index>(chunk_shape[d], 1);
+        key.push_back(tensorstore::FloorOfRatio(box.origin()[d], chunk));
+        key.push_back(tensorstore::FloorOfRatio(
+            box.origin()[d] + std::max<Index>(box.shape()[d] - 1, 0), chunk));
+      }
+    } else {
+      key.push_back(static_cast<Index>(i));
+    }
+    auto [it, inserted] = read_of.emplace(std::move(key), reads.size());
+    if (inserted) {
+      reads.push_back({box, {i}});
+      continue;
+    }
+    auto& read = reads[it->second];
+    for (DimensionIndex d = 0; d < rank; ++d) {
+      const Index lo = std::min(read.box.origin()[d], box.origin()[d]);
+      const Index hi = std::max(read.box.origin()[d] + read.box.shape()[d],
+                                box.origin()[d] + box.shape()[d]);
+      read.box.origin()[d] = lo;
+      read.box.shape()[d] = hi - lo;
+    }
+    read.runs.push_back(i);
+  }
+  return reads;
+}
+
+/**
+ * @brief Copies a box out of a larger C-order buffer into a contiguous C-order
+ * destination.
+ * @param src The buffer holding `src_box`.
+ * @param src_box The box covered by `src`.
+ * @param box The box to copy, contained in `src_box`.
+ * @param out The destination, with room for `box.num_elements()` elements.
+ */
+template <typename T>
+void CopyBoxToContiguous(const T* src, tensorstore::BoxView<> src_box,
+                         tensorstore::BoxView<> box, T* out) {
+  const DimensionIndex rank = box.rank();
+  if (rank == 0) {
+    *out = *src;
+    return;
+  }
+  if (box.num_elements() == 0) {
+    return;
+  }
+  std::vector<Index> strides(rank, 1);
+  for (DimensionIndex d = rank - 1; d > 0; --d) {
+    strides[d - 1] = strides[d] * src_box.shape()[d];
+  }
+  const Index row = box.shape()[rank - 1];
+  std::vector<Index> pos(box.origin().begin(), box.origin().end());
+  while (true) {
+    Index offset = 0;
+    for (DimensionIndex d = 0; d < rank; ++d) {
+      offset += (pos[d] - src_box.origin()[d]) * strides[d];
+    }
+    std::memcpy(out, src + offset, row * sizeof(T));
+    out += row;
+    // Advance the outer dimensions like an odometer.
+    DimensionIndex d = rank - 2;
+    for (; d >= 0; --d) {
+      if (++pos[d] < box.origin()[d] + box.shape()[d]) {
+        break;
+      }
+      pos[d] = box.origin()[d];
+    }
+    if (d < 0) {
+      return;
+    }
+  }
+}
+
+/**
+ * @brief The number of runs of a selection that a Variable yields.
+ * A 1-D Variable only yields the first run.
+ */
+template <typename Runs>
+std::size_t NumReadableRuns(const Variable<>& var, const Runs& runs) {
+  return var.rank() == 1 ? std::min<std::size_t>(runs.size(), 1) : runs.size();
+}
+
+/**
+ * @brief Reads runs [first, last) of a selection into one contiguous vector.
+ * Runs that fall in the same chunks are served by a single read, and each run
+ * is copied straight to its final offset as its read resolves.
+ */
+template <typename T>
+Future<std::vector<T>> ReadRuns(
+    const Variable<>& var,
+    const std::vector<std::vector<RangeDescriptor<Index>>>& runs,
+    std::size_t first, std::size_t last) {
+  // The chunk shape is only a hint, stores without one read run by run.
+  auto chunk_shape = var.get_chunk_shape();
+
+  std::vector<tensorstore::Box<>> boxes;
+  std::vector<Index> offsets;
+  boxes.reserve(last - first);
+  offsets.reserve(last - first);
+  Index total = 0;
+  for (std::size_t i = first; i < last; ++i) {
+    MDIO_ASSIGN_OR_RETURN(auto run, var.slice(runs[i]));
+    boxes.emplace_back(run.dimensions().box());
+    offsets.push_back(total);
+    total += boxes.back().num_elements();
+  }
+
+  auto reads = PlanCoalescedReads(
+      boxes, chunk_shape.ok() ? chunk_shape.value()
+                              : std::vector<DimensionIndex>{});
+  auto labels = var.dimensions().labels();
+  std::vector<Variable<>> pieces;
+  pieces.reserve(reads.size());
+  for (const auto& read : reads) {
+    std::vector<RangeDescriptor<Index>> desc;
+    desc.reserve(read.box.rank());
+    for (DimensionIndex d = 0; d < read.box.rank(); ++d) {
+      desc.push_back({labels[d].empty() ? DimensionIdentifier(d)
+                                        : DimensionIdentifier(labels[d]),
+                      read.box.origin()[d],
+                      read.box.origin()[d] + read.box.shape()[d], 1});
+    }
+    MDIO_ASSIGN_OR_RETURN(auto piece, var.slice(desc));
+    pieces.push_back(std::move(piece));
+  }
+
+  struct ReadState {
+    std::vector<T> out;
+    std::vector<tensorstore::Box<>> boxes;
+    std::vector<Index> offsets;
+    std::vector<CoalescedRead> reads;
+    std::vector<Variable<>> pieces;
+  };
+  auto state = std::make_shared<ReadState>();
+  state->out.resize(total);
+  state->boxes = std::move(boxes);
+  state->offsets = std::move(offsets);
+  state->reads = std::move(reads);
+  state->pieces = std::move(pieces);
+
+  auto all_read = ForEachBounded(
+      state->reads.size(), 0, [state](std::size_t i) {
+        return tensorstore::MapFutureValue(
+            tensorstore::InlineExecutor{},
+            [state, i](VariableData<void>& data) {
+              const auto& read = state->reads[i];
+              const T* src =
+                  static_cast<const T*>(data.get_data_accessor().data()) +
+                  data.get_flattened_offset();
+              for (auto run : read.runs) {
+                CopyBoxToContiguous(src, read.box, state->boxes[run],
+                                    state->out.data() + state->offsets[run]);
+              }
+            },
+            state->pieces[i].Read());
+      });
+
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [state]() { return std::move(state->out); }, std::move(all_read));
+}
+
+/**
+ * @brief Maps a key to an unsigned integer with the same order.
+ * Signed integers have their sign bit flipped, floating point numbers are
+ * ordered by their bits with negative numbers inverted.
+ */
+template <typename T>
+std::uint64_t OrderedBits(T value) {
+  static_assert(std::is_arithmetic_v<T> && sizeof(T) <= 8,
+                "Sort keys must be numbers of at most 64 bits.");
+  if constexpr (std::is_same_v<T, bool>) {
+    return value;
+  } else if constexpr (std::is_integral_v<T>) {
+    using U = std::make_unsigned_t<T>;
+    U bits = static_cast<U>(value);
+    if constexpr (std::is_signed_v<T>) {
+      bits ^= U(1) << (sizeof(T) * 8 - 1);
+    }
+    return bits;
+  } else {
+    using U = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+    U bits;
+    std::memcpy(&bits, &value, sizeof(T));
+    constexpr U kSign = U(1) << (sizeof(U) * 8 - 1);
+    return (bits & kSign) ? ~bits : (bits | kSign);
+  }
+}
+
+/**
+ * @brief Reads the first sample of every run of a selection.
+ * The first samples that fall in the same chunks are served by a single read.
+ * @return A future of the keys, as `OrderedBits`, in the order of the runs.
+ */
+template <typename T>
+Future<std::vector<std::uint64_t>> ReadOrderedRunKeys(
+    const Variable<>& var,
+    const std::vector<std::vector<RangeDescriptor<Index>>>& runs) {
+  if (var.dtype() != tensorstore::dtype_v<T>) {
+    return absl::InvalidArgumentError(
+        "Sort key '" + var.get_variable_name() + "' is not of type " +
+        std::string(tensorstore::dtype_v<T>.name()) + ".");
+  }
+  const auto domain = var.dimensions();
+  const DimensionIndex rank = domain.rank();
+
+  // The first sample of a run, computed without slicing the Variable.
+  std::vector<tensorstore::Box<>> points;
+  points.reserve(runs.size());
+  for (const auto& run : runs) {
+    tensorstore::Box<> point(rank);
+    for (DimensionIndex d = 0; d < rank; ++d) {
+      point.origin()[d] = domain.origin()[d];
+      point.shape()[d] = 1;
+    }
+    for (const auto& desc : run) {
+      DimensionIndex d = -1;
+      const auto label = desc.label.label();
+      if (label.data() == nullptr) {
+        d = desc.label.index();
+      } else {
+        for (DimensionIndex i = 0; i < rank; ++i) {
+          if (domain.labels()[i] == label) {
+            d = i;
+          }
+        }
+      }
+      // Like slicing, descriptors of other dimensions are skipped.
+      if (d < 0 || d >= rank) {
+        continue;
+      }
+      const Index start = std::max(desc.start, domain.origin()[d]);
+      if (start >= std::min(desc.stop, domain[d].exclusive_max())) {
+        return absl::InvalidArgumentError(
+            "A run of the selection is outside of sort key '" +
+            var.get_variable_name() + "'.");
+      }
+      point.origin()[d] = start;
+    }
+    points.push_back(std::move(point));
+  }
+
+  auto chunk_shape = var.get_chunk_shape();
+  auto reads = PlanCoalescedReads(
+      points, chunk_shape.ok() ? chunk_shape.value()
+                               : std::vector<DimensionIndex>{});
+  const auto labels = domain.labels();
+  std::vector<Variable<>> pieces;
+  pieces.reserve(reads.size());
+  for (const auto& read : reads) {
+    std::vector<RangeDescriptor<Index>> desc;
+    desc.reserve(rank);
+    for (DimensionIndex d = 0; d < rank; ++d) {
+      desc.push_back({labels[d].empty() ? DimensionIdentifier(d)
+                                        : DimensionIdentifier(labels[d]),
+                      read.box.origin()[d],
+                      read.box.origin()[d] + read.box.shape()[d], 1});
+    }
+    MDIO_ASSIGN_OR_RETURN(auto piece, var.slice(desc));
+    pieces.push_back(std::move(piece));
+  }
+
+  struct KeyState {
+    std::vector<std::uint64_t> keys;
+    std::vector<tensorstore::Box<>> points;
+    std::vector<CoalescedRead> reads;
+    std::vector<Variable<>> pieces;
+  };
+  auto state = std::make_shared<KeyState>();
+  state->keys.resize(runs.size());
+  state->points = std::move(points);
+  state->reads = std::move(reads);
+  state->pieces = std::move(pieces);
+
+  auto all_read = ForEachBounded(
+      state->reads.size(), 0, [state](std::size_t i) {
+        return tensorstore::MapFutureValue(
+            tensorstore::InlineExecutor{},
+            [state, i](VariableData<void>& data) {
+              const auto& read = state->reads[i];
+              const T* src =
+                  static_cast<const T*>(data.get_data_accessor().data()) +
+                  data.get_flattened_offset();
+              for (auto run : read.runs) {
+                // The C-order position of the point in the read box.
+                Index offset = 0;
+                for (DimensionIndex d = 0; d < read.box.rank(); ++d) {
+                  offset = offset * read.box.shape()[d] +
+                           state->points[run].origin()[d] -
+                           read.box.origin()[d];
+                }
+                state->keys[run] = OrderedBits<T>(src[offset]);
+              }
+            },
+            state->pieces[i].Read());
+      });
+
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [state]() { return std::move(state->keys); }, std::move(all_read));
+}
+
+/**
+ * @brief A packed sort key and the run it belongs to.
+ */
+struct KeyedRun {
+  std::uint64_t key;
+  std::size_t run;
+};
+
+/// Inputs smaller than this are radix sorted on the calling thread.
+constexpr std::size_t kParallelSortThreshold = 1 << 16;
+
+/// The most blocks a radix sort pass is split into.
+constexpr std::size_t kMaxSortWorkers = 16;
+
+/**
+ * @brief Gets the pool that large radix sorts run on, shared by all sorts.
+ */
+inline const tensorstore::Executor& SortExecutor() {
+  static const tensorstore::Executor executor =
+      tensorstore::internal::DetachedThreadPool(kMaxSortWorkers);
+  return executor;
+}
+
+/**
+ * @brief Calls `work(w)` for each block `w < workers` on the sort pool and
+ * the calling thread, and waits until all of them are done.
+ * The calling thread claims blocks too, so a busy pool only makes the sort
+ * slower, it never waits on it.
+ */
+template <typename Work>
+void ForEachSortBlock(std::size_t workers, const Work& work) {
+  struct Claims {
+    std::atomic<std::size_t> next{0};
+    absl::Mutex mutex;
+    std::size_t done = 0;
+    std::size_t workers;
+    bool finished() const { return done == workers; }
+  };
+  auto claims = std::make_shared<Claims>();
+  claims->workers = workers;
+  // Tasks that start after every block was claimed never touch `work`.
+  auto run = [claims, workers, work = &work]() {
+    for (std::size_t w = claims->next++; w < workers; w = claims->next++) {
+      (*work)(w);
+      absl::MutexLock lock(&claims->mutex);
+      ++claims->done;
+    }
+  };
+  for (std::size_t w = 1; w < workers; ++w) {
+    SortExecutor()(run);
+  }
+  run();
+  absl::MutexLock lock(&claims->mutex);
+  claims->mutex.Await(absl::Condition(claims.get(), &Claims::finished));
+}
+
+/**
+ * @brief Stably sorts runs by the low `bits` bits of their keys.
+ * This is a least significant digit radix sort with 11 bit digits. For large
+ * inputs each pass is split into blocks that are counted and scattered on the
+ * shared sort pool.
+ */
+inline void RadixSort(std::vector<KeyedRun>& items,  // NOLINT (non-const)
+                      int bits) {
+  constexpr int kDigitBits = 11;
+  constexpr std::size_t kBuckets = std::size_t(1) << kDigitBits;
+  const std::size_t n = items.size();
+  if (n < 2 || bits <= 0) {
+    return;
+  }
+  const std::size_t workers =
+      n < kParallelSortThreshold
+          ? 1
+          : std::min<std::size_t>(
+                std::max(1u, std::thread::hardware_concurrency()),
+                kMaxSortWorkers);
+
+  std::vector<KeyedRun> sorted(n);
+  std::vector<std::size_t> counts(workers * kBuckets);
+  for (int shift = 0; shift < bits; shift += kDigitBits) {
+    std::fill(counts.begin(), counts.end(), 0);
+    ForEachSortBlock(workers, [&](std::size_t w) {
+      auto* count = counts.data() + w * kBuckets;
+      for (std::size_t i = n * w / workers; i < n * (w + 1) / workers; ++i) {
+        ++count[(items[i].key >> shift) & (kBuckets - 1)];
+      }
+    });
+    // Each worker scatters after the earlier workers of the same digit, which
+    // keeps the sort stable.
+    std::size_t total = 0;
+    for (std::size_t b = 0; b < kBuckets; ++b) {
+      for (std::size_t w = 0; w < workers; ++w) {
+        const std::size_t count = counts[w * kBuckets + b];
+        counts[w * kBuckets + b] = total;
+        total += count;
+      }
+    }
+    ForEachSortBlock(workers, [&](std::size_t w) {
+      auto* offset = counts.data() + w * kBuckets;
+      for (std::size_t i = n * w / workers; i < n * (w + 1) / workers; ++i) {
+        sorted[offset[(items[i].key >> shift) & (kBuckets - 1)]++] = items[i];
+      }
+    });
+    items.swap(sorted);
+  }
+}
+
+/**
+ * @brief Finds the stable order of runs by several keys, the first key being
+ * the most significant.
+ * Each key is offset by its minimum and the keys are packed into one 64 bit
+ * integer, which is radix sorted. Keys that don't fit together are compared
+ * one after the other instead.
+ * @param keys The `OrderedBits` of each key, one value per run.
+ * @param n The number of runs.
+ * @return The run at each position of the sorted selection.
+ */
+inline std::vector<std::size_t> SortedRunOrder(
+    const std::vector<std::vector<std::uint64_t>>& keys, std::size_t n) {
+  std::vector<std::uint64_t> mins(keys.size());
+  std::vector<int> widths(keys.size());
+  int total_bits = 0;
+  for (std::size_t k = 0; k < keys.size(); ++k) {
+    const auto [lo, hi] = std::minmax_element(keys[k].begin(), keys[k].end());
+    mins[k] = n ? *lo : 0;
+    widths[k] = n ? absl::bit_width(*hi - *lo) : 0;
+    total_bits += widths[k];
+  }
+
+  std::vector<std::size_t> order(n);
+  if (total_bits > 64) {
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&keys](std::size_t a, std::size_t b) {
+                       for (const auto& key : keys) {
+                         if (key[a] != key[b]) {
+                           return key[a] < key[b];
+                         }
+                       }
+                       return false;
+                     });
+    return order;
+  }
+
+  std::vector<KeyedRun> items(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    std::uint64_t packed = 0;
+    for (std::size_t k = 0; k < keys.size(); ++k) {
+      if (widths[k] > 0) {
+        packed = (widths[k] == 64 ? 0 : packed << widths[k]) |
+                 (keys[k][i] - mins[k]);
+      }
+    }
+    items[i] = {packed, i};
+  }
+  RadixSort(items, total_bits);
+  for (std::size_t i = 0; i < n; ++i) {
+    order[i] = items[i].run;
+  }
+  return order;
+}
+
+/**
+ * @brief Reorders elements in place so that position `i` holds the element
+ * that was at `order[i]`. Every element is moved once, following the cycles
+ * of the permutation.
+ * @param order The permutation, it is consumed.
+ */
+template <typename Element>
+void PermuteInPlace(std::vector<Element>& elements,  // NOLINT (non-const)
+                    std::vector<std::size_t>& order) {  // NOLINT (non-const)
+  for (std::size_t start = 0; start < order.size(); ++start) {
+    if (order[start] == start) {
+      continue;
+    }
+    Element held = std::move(elements[start]);
+    std::size_t i = start;
+    while (order[i] != start) {
+      const std::size_t next = order[i];
+      elements[i] = std::move(elements[next]);
+      order[i] = i;
+      i = next;
+    }
+    elements[i] = std::move(held);
+    order[i] = i;
+  }
+}
+
+}  // namespace internal
+
+/**
+ * @brief A batch of a streamed selection.
+ * @param first_run The position of the batch's first run in the selection.
+ * @param runs The index ranges of the runs in the batch.
+ * @param data The data of the runs, concatenated in order.
+ */
+template <typename T>
+struct SelectionBatch {
+  std::size_t first_run;
+  std::vector<std::vector<RangeDescriptor<Index>>> runs;
+  std::vector<T> data;
+};
+
+/**
+ * @brief A pull-based stream over the runs of a selection.
+ * Batches are yielded in selection order. Each call to `next` hands out the
+ * oldest in-flight batch and launches the next one, so memory stays bounded by
+ * the prefetch depth regardless of the size of the selection. A stream is
+ * meant to be consumed from a single thread.
+ * @details \b Usage
+ * @code
+ * MDIO_ASSIGN_OR_RETURN(auto stream,
+ *                       selector.streamSelection<float>("image", 1024));
+ * while (true) {
+ *   MDIO_ASSIGN_OR_RETURN(auto batch, stream.next().result());
+ *   if (!batch) break;
+ *   process(batch->runs, batch->data);
+ * }
+ * @endcode
+ */
+template <typename T>
+class SelectionStream {
+ public:
+  SelectionStream(Variable<> var,
+                  std::vector<std::vector<RangeDescriptor<Index>>> runs,
+                  std::size_t runs_per_batch, std::size_t prefetch)
+      : var_(std::move(var)),
+        runs_(std::make_shared<
+              const std::vector<std::vector<RangeDescriptor<Index>>>>(
+            std::move(runs))),
+        num_runs_(internal::NumReadableRuns(var_, *runs_)),
+        runs_per_batch_(runs_per_batch),
+        prefetch_(prefetch) {}
+
+  /**
+   * @brief Pulls the next batch.
+   * @return A future of the batch, or of `std::nullopt` once the selection is
+   * exhausted.
+   */
+  Future<std::optional<SelectionBatch<T>>> next() {
+    _fill();
+    if (in_flight_.empty()) {
+      return std::optional<SelectionBatch<T>>{};
+    }
+    auto [first, read] = std::move(in_flight_.front());
+    in_flight_.pop_front();
+    _fill();
+    const std::size_t last = std::min(first + runs_per_batch_, num_runs_);
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [runs = runs_, first = first, last](std::vector<T>& data) {
+          return std::optional<SelectionBatch<T>>{SelectionBatch<T>{
+              first,
+              std::vector<std::vector<RangeDescriptor<Index>>>(
+                  runs->begin() + first, runs->begin() + last),
+              std::move(data)}};
+        },
+        std::move(read));
+  }
+
+  /// True once every batch has been handed out.
+  bool done() const { return in_flight_.empty() && next_run_ >= num_runs_; }
+
+  /// The number of runs the stream yields in total.
+  std::size_t num_runs() const { return num_runs_; }
+
+ private:
+  void _fill() {
+    while (in_flight_.size() < prefetch_ && next_run_ < num_runs_) {
+      const std::size_t last = std::min(next_run_ + runs_per_batch_, num_runs_);
+      in_flight_.emplace_back(next_run_,
+                              internal::ReadRuns<T>(var_, *runs_, next_run_,
+                                                    last));
+      next_run_ = last;
+    }
+  }
+
+  Variable<> var_;
+  std::shared_ptr<const std::vector<std::vector<RangeDescriptor<Index>>>>
+      runs_;
+  std::size_t num_runs_;
+  std::size_t runs_per_batch_;
+  std::size_t prefetch_;
+  std::size_t next_run_ = 0;
+  std::deque<std::pair<std::size_t, Future<std::vector<T>>>> in_flight_;
+};
+
 /// \brief Collects valid index selections per dimension for a Dataset without
 /// performing slicing immediately.
 ///
@@ -84,6 +772,15 @@ class CoordinateSelector {
   explicit CoordinateSelector(Dataset& dataset)  // NOLINT (non-const)
       : dataset_(dataset), base_domain_(dataset.domain) {}
 
+  /**
+   * @brief Applies filters and sorts in order, then reads the selection of
+   * several Variables.
+   * Each op starts once the one before it is done and the reads start once
+   * all of them are, without blocking the caller. The CoordinateSelector must
+   * outlive the returned future.
+   * @param data_variables The names of the Variables to read, one per `OutTs`.
+   * @param ops `ValueDescriptor`s to filter by and `SortKey`s to sort by.
+   */
   template <typename... OutTs, typename... Ops>
   Future<std::tuple<std::vector<OutTs>...>> ReadDataVariables(
       std::vector<std::string> const& data_variables, Ops const&... ops) {
@@ -91,13 +788,12 @@ class CoordinateSelector {
       return absl::InvalidArgumentError(
           "ReadDataVariables: number of names must match number of OutTs");
     }
-    // 1) apply all filters & sorts in order
-    absl::Status st = absl::OkStatus();
-    ((st = st.ok() ? _applyOp(ops).status() : st), ...);
-    if (!st.ok()) return st;
-
-    // 2) kick off and await all reads
-    return _readMultiple<OutTs...>(data_variables);
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [this, data_variables]() {
+          return _readMultiple<OutTs...>(data_variables);
+        },
+        _applyOps(ops...));
   }
 
   void reset() { kept_runs_.clear(); }
@@ -109,175 +805,199 @@ class CoordinateSelector {
    * - A bug exists if the filter value does not make a perfect hyper-rectangle
    * within its dimensions.
    *
+   * The coordinate is read and scanned chunk by chunk in parallel. The
+   * selection is only updated once the returned future is ready, and the
+   * CoordinateSelector must outlive it.
    */
   template <typename T>
   mdio::Future<void> filterByCoordinate(const ValueDescriptor<T>& descriptor) {
+    internal::Span span("mdio.CoordinateSelector.filter");
+    if (span.active()) {
+      span.Attribute("mdio.variable", std::string(descriptor.label.label()));
+    }
     if (kept_runs_.empty()) {
-      return _init_runs(descriptor);
+      return span.End(_init_runs(descriptor));
     } else {
-      return _add_new_run(descriptor);
+      return span.End(_add_new_run(descriptor));
     }
   }
 
+  /**
+   * @brief Stably sorts the selection by a coordinate.
+   * Each run is ordered by its first sample of the coordinate.
+   * @param sort_key The name of the coordinate, of type `T`.
+   */
   template <typename T>
   Future<void> sortSelectionByKey(const std::string& sort_key) {
-#ifdef MDIO_INTERNAL_PROFILING
-    auto start = std::chrono::high_resolution_clock::now();
-#endif
-    const size_t n = kept_runs_.size();
-
-    // 1) Fire off all reads in parallel and gather the key values
-    std::vector<Future<VariableData<void>>> reads;
-    reads.reserve(n);
-    for (auto const& desc : kept_runs_) {
-      MDIO_ASSIGN_OR_RETURN(auto ds, dataset_.isel(desc));
-      MDIO_ASSIGN_OR_RETURN(auto var, ds.variables.at(sort_key));
-      reads.push_back(var.Read());
-    }
-
-    std::vector<T> keys;
-    keys.reserve(n);
-#ifdef MDIO_INTERNAL_PROFILING
-    std::cout << "Set up sorting of  " << sort_key << " ... ";
-    timer(start);
-    start = std::chrono::high_resolution_clock::now();
-#endif
-    for (auto& f : reads) {
-      // if (!f.status().ok()) return f.status();
-      // auto data = f.value();
-      // keys.push_back(data.get_data_accessor().data()[data.get_flattened_offset()]);
-      MDIO_ASSIGN_OR_RETURN(auto resolution, _resolve_future<void>(f));
-      auto data = std::get<0>(resolution);
-      auto data_ptr = static_cast<const T*>(std::get<1>(resolution));
-      auto offset = std::get<2>(resolution);
-      // auto n = std::get<3>(resolution);  // Not required
-      keys.push_back(data_ptr[offset]);
-    }
-#ifdef MDIO_INTERNAL_PROFILING
-    std::cout << "Waiting for reads to complete for " << sort_key << " ... ";
-    timer(start);
-    start = std::chrono::high_resolution_clock::now();
-#endif
-
-    // 2) Build and stable-sort an index array [0…n-1] by key
-    std::vector<size_t> idx(n);
-    std::iota(idx.begin(), idx.end(), 0);
-    std::stable_sort(idx.begin(), idx.end(),
-                     [&](size_t a, size_t b) { return keys[a] < keys[b]; });
-#ifdef MDIO_INTERNAL_PROFILING
-    std::cout << "Sorting time for " << sort_key << " ... ";
-    timer(start);
-    start = std::chrono::high_resolution_clock::now();
-#endif
-
-    // 3) One linear, move-only pass into a temp buffer
-    using Desc = std::decay_t<decltype(kept_runs_)>::value_type;
-    std::vector<Desc> tmp;
-    tmp.reserve(n);
-    for (size_t new_pos = 0; new_pos < n; ++new_pos) {
-      tmp.emplace_back(std::move(kept_runs_[idx[new_pos]]));
-    }
-
-    // 4) Steal the buffer back
-    kept_runs_ = std::move(tmp);
-#ifdef MDIO_INTERNAL_PROFILING
-    std::cout << "Stealing buffer back time for " << sort_key << " ... ";
-    timer(start);
-#endif
-    return absl::OkStatus();
+    return sortSelectionByKeys(SortKey<T>{sort_key});
   }
 
-  template <typename T>
-  Future<std::vector<T>> readSelection(const std::string& output_variable) {
-#ifdef MDIO_INTERNAL_PROFILING
-    auto start = std::chrono::high_resolution_clock::now();
-#endif
-    std::vector<Future<VariableData<void>>> reads;
-    reads.reserve(kept_runs_.size());
-    std::vector<T> ret;
-
-    for (const auto& desc : kept_runs_) {
-      MDIO_ASSIGN_OR_RETURN(auto ds, dataset_.isel(desc));
-      MDIO_ASSIGN_OR_RETURN(auto var, ds.variables.at(output_variable));
-      auto fut = var.Read();
-      reads.push_back(fut);
-      if (var.rank() == 1) {
-        break;
-      }
+  /**
+   * @brief Stably sorts the selection by several coordinates at once, the
+   * first one being the most significant.
+   * The coordinates are read concurrently, each only from the chunks that hold
+   * the first sample of a run. The keys are packed into one integer and radix
+   * sorted, in parallel for large selections, then the runs are permuted in
+   * place. The selection is only updated once the returned future is ready,
+   * and the CoordinateSelector must outlive it.
+   * @details \b Usage
+   * @code
+   * auto sorted = selector.sortSelectionByKeys(
+   *     mdio::SortKey<int32_t>{"offset"}, mdio::SortKey<float>{"azimuth"});
+   * @endcode
+   */
+  template <typename... Ts>
+  Future<void> sortSelectionByKeys(const SortKey<Ts>&... keys) {
+    static_assert(sizeof...(Ts) > 0, "At least one sort key is needed.");
+    internal::Span span("mdio.CoordinateSelector.sort");
+    if (span.active()) {
+      std::string names;
+      ((names += (names.empty() ? "" : ",") + keys.key), ...);
+      span.Attribute("mdio.variable", names);
     }
+    return span.End(_sortSelectionByKeys(keys...));
+  }
 
-#ifdef MDIO_INTERNAL_PROFILING
-    std::cout << "Set up reading of " << output_variable << " ... ";
-    timer(start);
-    start = std::chrono::high_resolution_clock::now();
-#endif
+  /**
+   * @brief Reads the selected runs of a Variable into one contiguous vector.
+   * Runs that fall in the same chunks are served by a single read, and each
+   * run is copied straight to its final offset as its read resolves. The
+   * output keeps the order of the selection.
+   * @param output_variable The name of the Variable to read.
+   */
+  template <typename T>
+  Future<std::vector<T>> readSelection(const std::string& output_variable) {
+    MDIO_ASSIGN_OR_RETURN(auto var, dataset_.variables.at(output_variable));
+    internal::Span span("mdio.CoordinateSelector.readSelection");
+    span.Attribute("mdio.variable", output_variable);
+    return span.End(internal::ReadRuns<T>(
+        var, kept_runs_, 0, internal::NumReadableRuns(var, kept_runs_)));
+  }
 
-    for (auto& f : reads) {
-      MDIO_ASSIGN_OR_RETURN(auto resolution, _resolve_future<void>(f));
-      auto data = std::get<0>(resolution);
-      auto data_ptr = static_cast<const T*>(std::get<1>(resolution));
-      auto offset = std::get<2>(resolution);
-      auto n = std::get<3>(resolution);
-      std::vector<T> buffer(n);
-      std::memcpy(buffer.data(), data_ptr + offset, n * sizeof(T));
-      ret.insert(ret.end(), buffer.begin(), buffer.end());
+  /**
+   * @brief Streams the selected runs of a Variable in batches.
+   * Unlike `readSelection` the selection is never materialized as a whole,
+   * at most `prefetch` batches are in flight at any time. The stream owns a
+   * copy of the selection, so later filters don't affect it.
+   * @param output_variable The name of the Variable to read.
+   * @param runs_per_batch The number of runs in each batch, the last batch may
+   * hold fewer.
+   * @param prefetch The number of batches to read ahead, at least 1.
+   */
+  template <typename T>
+  Result<SelectionStream<T>> streamSelection(const std::string& output_variable,
+                                             std::size_t runs_per_batch,
+                                             std::size_t prefetch = 2) {
+    if (runs_per_batch == 0) {
+      return absl::InvalidArgumentError("runs_per_batch must be at least 1.");
     }
-
-#ifdef MDIO_INTERNAL_PROFILING
-    std::cout << "Reading time for " << output_variable << " ... ";
-    timer(start);
-#endif
-    return ret;
+    MDIO_ASSIGN_OR_RETURN(auto var, dataset_.variables.at(output_variable));
+    return SelectionStream<T>(std::move(var), kept_runs_, runs_per_batch,
+                              std::max<std::size_t>(prefetch, 1));
   }
 
  private:
   Dataset& dataset_;
   tensorstore::IndexDomain<> base_domain_;
   std::vector<std::vector<mdio::RangeDescriptor<mdio::Index>>> kept_runs_;
-  std::map<std::string_view, VariableData<void>> cached_variables_;
+  std::map<std::string, VariableData<void>, std::less<>> cached_variables_;
+
+  /**
+   * @brief The untraced `sortSelectionByKeys`.
+   */
+  template <typename... Ts>
+  Future<void> _sortSelectionByKeys(const SortKey<Ts>&... keys) {
+    const std::size_t n = kept_runs_.size();
+    if (n == 0) {
+      return absl::OkStatus();
+    }
+
+    // Every key is read at the same time.
+    std::vector<Future<std::vector<std::uint64_t>>> reads;
+    std::vector<tensorstore::AnyFuture> futures;
+    absl::Status status = absl::OkStatus();
+    (
+        [&]() {
+          if (!status.ok()) {
+            return;
+          }
+          auto var = dataset_.variables.at(keys.key);
+          if (!var.ok()) {
+            status = var.status();
+            return;
+          }
+          reads.push_back(
+              internal::ReadOrderedRunKeys<Ts>(var.value(), kept_runs_));
+          futures.push_back(reads.back());
+        }(),
+        ...);
+    if (!status.ok()) {
+      return status;
+    }
+
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [this, reads, n]() mutable -> Result<void> {
+          if (kept_runs_.size() != n) {
+            return absl::FailedPreconditionError(
+                "The selection changed while it was being sorted.");
+          }
+          std::vector<std::vector<std::uint64_t>> keys;
+          keys.reserve(reads.size());
+          for (auto& read : reads) {
+            keys.push_back(std::move(read.value()));
+          }
+          auto order = internal::SortedRunOrder(keys, n);
+          internal::PermuteInPlace(kept_runs_, order);
+          return absl::OkStatus();
+        },
+        tensorstore::WaitAllFuture(futures));
+  }
 
   template <typename D>
   Future<void> _applyOp(D const& op) {
     if constexpr (is_value_descriptor_v<D>) {
-      auto fut = filterByCoordinate(op);
-      if (!fut.status().ok()) {
-        return fut.status();
-      }
-      return absl::OkStatus();
+      return filterByCoordinate(op);
     } else if constexpr (is_sort_key_v<D>) {
       using SortT = typename std::decay_t<D>::value_type;
-      auto fut = sortSelectionByKey<SortT>(op.key);
-      if (!fut.status().ok()) {
-        return fut.status();
-      }
-      return absl::OkStatus();
+      return sortSelectionByKey<SortT>(op.key);
     } else {
       return absl::UnimplementedError(
           "query(): RangeDescriptor and ListDescriptor not supported");
     }
   }
 
+  /**
+   * @brief Applies ops one after the other, each once the one before it is
+   * done, stopping at the first error.
+   */
+  Future<void> _applyOps() { return absl::OkStatus(); }
+
+  template <typename D, typename... Rest>
+  Future<void> _applyOps(D const& op, Rest const&... rest) {
+    auto applied = _applyOp(op);
+    if constexpr (sizeof...(Rest) == 0) {
+      return applied;
+    } else {
+      return tensorstore::MapFutureValue(
+          tensorstore::InlineExecutor{},
+          [this, rest...]() { return _applyOps(rest...); },
+          std::move(applied));
+    }
+  }
+
   // helper: expands readSelection<OutTs>(vars[I])...
   template <typename... OutTs, std::size_t... I>
   Future<std::tuple<std::vector<OutTs>...>> _readMultipleImpl(
       std::vector<std::string> const& vars, std::index_sequence<I...>) {
-    // 1) start all reads
-    auto futs = std::make_tuple(readSelection<OutTs>(vars[I])...);
-
-    // 2) wait on them in order
-    absl::Status st = absl::OkStatus();
-    std::tuple<std::vector<OutTs>...> results;
-    // fold over I...
-    (
-        [&]() {
-          if (!st.ok()) return;
-          auto& f = std::get<I>(futs);
-          st = f.status();
-          if (st.ok()) std::get<I>(results) = std::move(f.value());
-        }(),
-        ...);
-    if (!st.ok()) return st;
-    return results;
+    // Every read is in flight at once; the tuple is ready once all of them
+    // are, without blocking the caller.
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [](std::vector<OutTs>&... values) {
+          return std::tuple<std::vector<OutTs>...>(std::move(values)...);
+        },
+        readSelection<OutTs>(vars[I])...);
   }
 
   template <typename... OutTs>
@@ -302,204 +1022,244 @@ class CoordinateSelector {
   template <typename T>
   Future<void> _init_runs(const ValueDescriptor<T>& descriptor) {
     using Interval = typename Variable<void>::Interval;
-#ifdef MDIO_INTERNAL_PROFILING
-    auto start = std::chrono::high_resolution_clock::now();
-#endif
-    MDIO_ASSIGN_OR_RETURN(
-        auto var, dataset_.variables.at(std::string(descriptor.label.label())));
-
-    const T* data_ptr;
-    Index offset;
-    Index n_samples;
+    std::string label(descriptor.label.label());
+    MDIO_ASSIGN_OR_RETURN(auto var, dataset_.variables.at(label));
     MDIO_ASSIGN_OR_RETURN(auto intervals, var.get_intervals());
-    if (cached_variables_.find(descriptor.label.label()) ==
-        cached_variables_.end()) {
-      // TODO(BrianMichell): Ensure that the domain has not changed.
-      std::cout << "Reading VariableData" << std::endl;
-      auto fut = var.Read();
-      MDIO_ASSIGN_OR_RETURN(auto resolution, _resolve_future<void>(fut));
-      auto dataToCache = std::get<0>(resolution);
-      cached_variables_.insert_or_assign(descriptor.label.label(),
-                                         std::move(dataToCache));
-    }
-    auto it = cached_variables_.find(descriptor.label.label());
-    if (it == cached_variables_.end()) {
-      std::stringstream ss;
-      ss << "Cached variable not found for coordinate '"
-         << descriptor.label.label() << "'";
-      return absl::NotFoundError(ss.str());
-    }
-    auto& data = it->second;
-    data_ptr = static_cast<const T*>(data.get_data_accessor().data());
-    offset = data.get_flattened_offset();
-    n_samples = data.num_samples();
-
-    auto current_pos = intervals;
-    bool isInRun = false;
-    std::vector<std::vector<Interval>> local_runs;
-
-    std::size_t run_idx = offset;
-
-#ifdef MDIO_INTERNAL_PROFILING
-    std::cout << "Initialize and read time... ";
-    timer(start);
-    start = std::chrono::high_resolution_clock::now();
-#endif
-
-    for (mdio::Index idx = offset; idx < offset + n_samples; ++idx) {
-      bool is_match = data_ptr[idx] == descriptor.value;
-
-      if (is_match && !isInRun) {
-        // The start of a new run
-        isInRun = true;
-        for (auto i = run_idx; i < idx; ++i) {
-          // _current_position_increment<T>(current_pos, intervals);
-          _current_position_increment<void>(current_pos, intervals);
-        }
-        // _current_position_stride<T>(current_pos, intervals, idx - run_idx);
-        run_idx = idx;
-        std::vector<Interval> run = current_pos;
-        local_runs.push_back(std::move(run));
-      } else if (is_match && isInRun) {
-        // Somewhere in the middle of a run
-        // do nothing TODO: Remove me
-      } else if (!is_match && isInRun) {
-        // The end of a run
-        isInRun = false;
-        // Use 1 less than the current index to ensure we get the correct end
-        // location.
-        for (auto i = run_idx; i < idx - 1; ++i) {
-          _current_position_increment<void>(current_pos, intervals);
-        }
-        run_idx = idx;
-        auto& last_run = local_runs.back();
-        for (auto i = 0; i < current_pos.size(); ++i) {
-          last_run[i].exclusive_max = current_pos[i].inclusive_min + 1;
-        }
-        // We need to advance to the actual current position
-        _current_position_increment<void>(current_pos, intervals);
-      } else if (!is_match && !isInRun) {
-        // No run at all
-        // do nothing TODO: Remove me
-      } else {
-        // base case TODO: Remove me
-      }
-    }
-
-#ifdef MDIO_INTERNAL_PROFILING
-    std::cout << "Build runs time... ";
-    timer(start);
-    start = std::chrono::high_resolution_clock::now();
-#endif
 
-    if (local_runs.empty()) {
-      std::stringstream ss;
-      ss << "No matches for coordinate '" << descriptor.label.label() << "'";
-      return absl::NotFoundError(ss.str());
+    Future<std::vector<internal::FlatRun>> scan;
+    auto it = cached_variables_.find(label);
+    if (it == cached_variables_.end()) {
+      // Use the persisted index when there is one, otherwise read and scan.
+      scan = tensorstore::MapFutureValue(
+          tensorstore::InlineExecutor{},
+          [this, label, var, value = descriptor.value](
+              std::optional<CoordinateIndex<T>>& index)
+              -> Future<std::vector<internal::FlatRun>> {
+            if (index.has_value()) {
+              auto runs = index->find(value);
+              return std::vector<internal::FlatRun>(runs.begin(), runs.end());
+            }
+            // TODO(BrianMichell): Ensure that the domain has not changed.
+            MDIO_ASSIGN_OR_RETURN(auto buffer, from_variable<void>(var));
+            auto chunk_scan = _scan_by_chunk(var, buffer, value);
+            return tensorstore::MapFutureValue(
+                tensorstore::InlineExecutor{},
+                [this, label, buffer = std::move(buffer)](
+                    std::vector<internal::FlatRun>& runs) mutable {
+                  cached_variables_.insert_or_assign(label, std::move(buffer));
+                  return std::move(runs);
+                },
+                std::move(chunk_scan));
+          },
+          internal::ReadCoordinateIndex<T>(var));
+    } else {
+      auto& data = it->second;
+      std::vector<internal::FlatRun> runs;
+      internal::FindMatchingRuns(
+          static_cast<const T*>(data.get_data_accessor().data()) +
+              data.get_flattened_offset(),
+          data.num_samples(), descriptor.value, runs);
+      scan = tensorstore::MakeReadyFuture<std::vector<internal::FlatRun>>(
+          std::move(runs));
     }
 
-    kept_runs_ = _from_intervals<void>(local_runs);
-#ifdef MDIO_INTERNAL_PROFILING
-    std::cout << "Finalize time... ";
-    timer(start);
-#endif
-    return absl::OkStatus();
+    // `var` is captured to keep the storage of the interval labels alive.
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [this, label, var, intervals = std::move(intervals)](
+            const std::vector<internal::FlatRun>& runs) -> Result<void> {
+          if (runs.empty()) {
+            std::stringstream ss;
+            ss << "No matches for coordinate '" << label << "'";
+            return absl::NotFoundError(ss.str());
+          }
+          std::vector<std::vector<Interval>> local_runs;
+          local_runs.reserve(runs.size());
+          for (const auto& run : runs) {
+            local_runs.push_back(_run_to_intervals<void>(run, intervals));
+          }
+          kept_runs_ = _from_intervals<void>(local_runs);
+          return absl::OkStatus();
+        },
+        std::move(scan));
   }
 
   /**
    * @brief Using the existing runs, further filter the Dataset by the new
    * coordiante.
+   * Every run is read up front and each one is scanned as soon as its data
+   * arrives.
    */
   template <typename T>
   Future<void> _add_new_run(const ValueDescriptor<T>& descriptor) {
     using Interval = typename Variable<T>::Interval;
-    std::vector<std::vector<Interval>> new_runs;
-
-    std::vector<std::vector<Interval>>
-        stored_intervals;  // Use this to ensure everything remains in memory
-                           // until the Intervals are no longer needed.
-    stored_intervals.reserve(kept_runs_.size());
+    std::string label(descriptor.label.label());
 
-    bool is_first_run = true;
+    struct RunScan {
+      Variable<T> var;
+      std::vector<Interval> intervals;
+      Future<VariableData<T>> read;
+      std::vector<std::vector<Interval>> runs;
+    };
+    auto scans = std::make_shared<std::vector<RunScan>>();
+    scans->reserve(kept_runs_.size());
 
     for (const auto& desc : kept_runs_) {
       MDIO_ASSIGN_OR_RETURN(auto ds, dataset_.isel(desc));
-      MDIO_ASSIGN_OR_RETURN(
-          auto var, ds.variables.get<T>(std::string(descriptor.label.label())));
-      auto fut = var.Read();
+      MDIO_ASSIGN_OR_RETURN(auto var, ds.variables.get<T>(label));
       MDIO_ASSIGN_OR_RETURN(auto intervals, var.get_intervals());
 
-      if (is_first_run) {
-        is_first_run = false;
-        if (intervals.size() != kept_runs_[0].size()) {
-          std::cout << "WARNING: Different coordinate dimensions detected. "
-                       "This behavior is not yet supported."
-                    << std::endl;
-          std::cout
-              << "\tFor expected behavior, please ensure all previous "
-                 "dimensions are less than or equal to the current dimension."
-              << std::endl;
-        }
+      if (scans->empty() && intervals.size() != kept_runs_[0].size()) {
+        std::cout << "WARNING: Different coordinate dimensions detected. "
+                     "This behavior is not yet supported."
+                  << std::endl;
+        std::cout
+            << "\tFor expected behavior, please ensure all previous "
+               "dimensions are less than or equal to the current dimension."
+            << std::endl;
       }
+      auto read = var.Read();
+      scans->push_back(
+          RunScan{std::move(var), std::move(intervals), std::move(read), {}});
+    }
 
-      stored_intervals.push_back(std::move(
-          intervals));  // Just to ensure nothing gets freed prematurely.
-      MDIO_ASSIGN_OR_RETURN(auto resolution, _resolve_future<T>(fut));
-      auto data = std::get<0>(resolution);
-      auto data_ptr = std::get<1>(resolution);
-      auto offset = std::get<2>(resolution);
-      auto n = std::get<3>(resolution);
-
-      auto current_pos = intervals;
-      bool isInRun = false;
-
-      std::size_t run_idx = offset;
-
-      for (Index idx = offset; idx < offset + n; ++idx) {
-        bool is_match = data_ptr[idx] == descriptor.value;
-        if (is_match && !isInRun) {
-          isInRun = true;
-          for (auto i = run_idx; i < idx; ++i) {
-            _current_position_increment<T>(current_pos, intervals);
-          }
-          run_idx = idx;
-          std::vector<Interval> run = current_pos;
-          new_runs.push_back(std::move(run));
-        } else if (is_match && isInRun) {
-          // Somewhere in the middle of a run
-          // do nothing TODO: Remove me
-        } else if (!is_match && isInRun) {
-          // The end of a run
-          // TODO(BrianMichell): Ensure we are using the correct index (see
-          // above)
-          isInRun = false;
-          for (auto i = run_idx; i < idx; ++i) {
-            _current_position_increment<T>(current_pos, intervals);
+    auto all_scanned = internal::ForEachBounded(
+        scans->size(), 0,
+        [this, scans, value = descriptor.value](std::size_t i) {
+          auto& scan = (*scans)[i];
+          return tensorstore::MapFutureValue(
+              tensorstore::InlineExecutor{},
+              [this, scans, i, value](VariableData<T>& data) {
+                auto& scan = (*scans)[i];
+                std::vector<internal::FlatRun> flat_runs;
+                internal::FindMatchingRuns(
+                    data.get_data_accessor().data() +
+                        data.get_flattened_offset(),
+                    data.num_samples(), value, flat_runs);
+                scan.runs.reserve(flat_runs.size());
+                for (const auto& run : flat_runs) {
+                  scan.runs.push_back(
+                      _run_to_intervals<T>(run, scan.intervals));
+                }
+              },
+              scan.read);
+        });
+
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [this, scans, label]() -> Result<void> {
+          std::vector<std::vector<Interval>> new_runs;
+          for (auto& scan : *scans) {
+            for (auto& run : scan.runs) {
+              new_runs.push_back(std::move(run));
+            }
           }
-          run_idx = idx;
-          auto& last_run = new_runs.back();
-          for (auto i = 0; i < current_pos.size(); ++i) {
-            last_run[i].exclusive_max = current_pos[i].inclusive_min + 1;
+          if (new_runs.empty()) {
+            std::stringstream ss;
+            ss << "No matches for coordinate '" << label << "'";
+            return absl::NotFoundError(ss.str());
           }
-        } else if (!is_match && !isInRun) {
-          // No run at all
-          // do nothing TODO: Remove me
-        } else {
-          // base case TODO: Remove me
-        }
-      }
+          // TODO(BrianMichell): We need to ensure we don't accidentally drop
+          // any pre-sliced dimensions...
+          kept_runs_ = _from_intervals<T>(new_runs);
+          return absl::OkStatus();
+        },
+        std::move(all_scanned));
+  }
+
+  /**
+   * @brief Reads a coordinate into `buffer` one chunk-aligned slab at a time
+   * along the outermost dimension and scans every slab for `value` as soon as
+   * it arrives.
+   * The scans run on the threads completing the reads, so I/O and compute
+   * overlap and slabs are scanned concurrently.
+   * @return A future of the matching runs as flat offsets into the Variable,
+   * in order, with runs that cross slab boundaries joined.
+   */
+  template <typename T>
+  Future<std::vector<internal::FlatRun>> _scan_by_chunk(
+      const Variable<>& var,
+      VariableData<void>& buffer,  // NOLINT (non-const)
+      const T& value) {
+    MDIO_ASSIGN_OR_RETURN(auto intervals, var.get_intervals());
+    if (intervals.empty()) {
+      return absl::InvalidArgumentError(
+          "Coordinate filtering requires a Variable of rank 1 or higher.");
     }
+    // The chunk shape is only a hint, without one the coordinate is read as a
+    // single slab.
+    auto chunk_shape = var.get_chunk_shape();
 
-    if (new_runs.empty()) {
-      std::stringstream ss;
-      ss << "No matches for coordinate '" << descriptor.label.label() << "'";
-      return absl::NotFoundError(ss.str());
+    const Index dim_min = intervals[0].inclusive_min;
+    const Index dim_max = intervals[0].exclusive_max;
+    const Index extent = dim_max - dim_min;
+    if (extent <= 0) {
+      return std::vector<internal::FlatRun>{};
     }
+    const Index inner = buffer.num_samples() / extent;
+    const Index step =
+        chunk_shape.ok() && !chunk_shape->empty() && (*chunk_shape)[0] > 0
+            ? (*chunk_shape)[0]
+            : extent;
 
-    kept_runs_ = _from_intervals<T>(
-        new_runs);  // TODO(BrianMichell): We need to ensure we don't
-                    // accidentally drop any pre-sliced dimensions...
-    return absl::OkStatus();
+    // Slab boundaries follow the chunk grid, which is anchored at 0.
+    std::vector<Index> bounds{dim_min};
+    for (Index b = (dim_min / step + 1) * step; b < dim_max; b += step) {
+      bounds.push_back(b);
+    }
+    bounds.push_back(dim_max);
+    const std::size_t num_slabs = bounds.size() - 1;
+
+    auto array = buffer.get_data_accessor();
+    const T* base = static_cast<const T*>(array.data()) +
+                    buffer.get_flattened_offset();
+    auto slab_runs =
+        std::make_shared<std::vector<std::vector<internal::FlatRun>>>(
+            num_slabs);
+
+    auto all_scanned = internal::ForEachBounded(
+        num_slabs, 0,
+        [var, array, base, bounds, dim_min, inner, value, slab_runs,
+         label = intervals[0].label](std::size_t i) -> Future<void> {
+          const Index start = bounds[i];
+          const Index stop = bounds[i + 1];
+          RangeDescriptor<Index> desc = {label, start, stop, 1};
+          MDIO_ASSIGN_OR_RETURN(auto slab, var.slice(desc));
+          MDIO_ASSIGN_OR_RETURN(
+              auto target,
+              array | tensorstore::Dims(0).HalfOpenInterval(start, stop));
+          const Index flat_start = (start - dim_min) * inner;
+          const Index flat_size = (stop - start) * inner;
+          return tensorstore::MapFutureValue(
+              tensorstore::InlineExecutor{},
+              [array, base, flat_start, flat_size, value, slab_runs, i]() {
+                auto& runs = (*slab_runs)[i];
+                internal::FindMatchingRuns(base + flat_start, flat_size, value,
+                                           runs);
+                for (auto& run : runs) {
+                  run.start += flat_start;
+                  run.stop += flat_start;
+                }
+              },
+              slab.ReadInto(std::move(target)));
+        });
+
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [slab_runs]() {
+          std::vector<internal::FlatRun> merged;
+          for (const auto& runs : *slab_runs) {
+            for (const auto& run : runs) {
+              if (!merged.empty() && merged.back().stop == run.start) {
+                merged.back().stop = run.stop;
+              } else {
+                merged.push_back(run);
+              }
+            }
+          }
+          return merged;
+        },
+        std::move(all_scanned));
   }
 
   template <typename T>
@@ -520,37 +1280,43 @@ class CoordinateSelector {
     return ret;
   }
 
-  /// Advance a multidimensional odometer position by one step.
+  /**
+   * @brief Converts a flat run into per-dimension intervals.
+   * The flat offsets are mapped straight to N-D coordinates with div/mod on
+   * the extents. Each interval spans from the coordinate of the first element
+   * to one past the coordinate of the last element of the run.
+   */
   template <typename T>
-  void _current_position_increment(
-      std::vector<typename Variable<T>::Interval>&
-          position,  // NOLINT (non-const)
-      const std::vector<typename Variable<T>::Interval>& interval) const {
-    for (std::size_t d = position.size(); d-- > 0;) {
-      if (position[d].inclusive_min + 1 < interval[d].exclusive_max) {
-        ++position[d].inclusive_min;
-        return;
-      }
-      position[d].inclusive_min = interval[d].inclusive_min;
+  std::vector<typename Variable<T>::Interval> _run_to_intervals(
+      const internal::FlatRun& run,
+      const std::vector<typename Variable<T>::Interval>& intervals) const {
+    std::vector<typename Variable<T>::Interval> ret(intervals);
+    Index first = run.start;
+    Index last = run.stop - 1;
+    for (std::size_t d = intervals.size(); d-- > 0;) {
+      const Index extent =
+          intervals[d].exclusive_max - intervals[d].inclusive_min;
+      ret[d].label = _stable_label(intervals[d].label);
+      ret[d].inclusive_min = intervals[d].inclusive_min + first % extent;
+      ret[d].exclusive_max = intervals[d].inclusive_min + last % extent + 1;
+      first /= extent;
+      last /= extent;
     }
+    return ret;
   }
 
-  template <typename T>
-  void _current_position_stride(
-      std::vector<typename Variable<T>::Interval>&
-          position,  // NOLINT (non-const)
-      const std::vector<typename Variable<T>::Interval>& interval,
-      const std::size_t num_elements) {
-    auto dims = position.size();
-    if (position[dims - 1].exclusive_max <
-        position[dims - 1].inclusive_min + num_elements) {
-      position[dims - 1].inclusive_min =
-          position[dims - 1].inclusive_min + num_elements;
-      return;
-    }
-    for (auto i = 0; i < num_elements; ++i) {
-      _current_position_increment<T>(position, interval);
+  /**
+   * @brief Rebinds a dimension label to the storage of the base domain.
+   * Labels of sliced Variables refer to index transforms that are released
+   * once the slice goes out of scope.
+   */
+  DimensionIdentifier _stable_label(const DimensionIdentifier& label) const {
+    for (const auto& base_label : base_domain_.labels()) {
+      if (base_label == label.label()) {
+        return base_label;
+      }
     }
+    return label;
   }
 
   template <typename T>
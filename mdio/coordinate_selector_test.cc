@@ -17,8 +17,12 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <memory>
+#include <numeric>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -338,4 +342,261 @@ TEST(Intersection, get_inline_range_dead) {
   // }
 }
 
+TEST(Intersection, streamSelection) {
+  auto pathResult = SetupDataset();
+  ASSERT_TRUE(pathResult.status().ok()) << pathResult.status();
+  auto path = pathResult.value();
+
+  auto dsFut = mdio::Dataset::Open(path, mdio::constants::kOpen);
+  ASSERT_TRUE(dsFut.status().ok()) << dsFut.status();
+  auto ds = dsFut.value();
+
+  mdio::CoordinateSelector cs(ds);
+  auto isFut = cs.filterByCoordinate(
+      mdio::ValueDescriptor<bool>{"live_mask", true});
+  ASSERT_TRUE(isFut.status().ok()) << isFut.status();
+
+  auto expectedFut = cs.readSelection<int32_t>("inline");
+  ASSERT_TRUE(expectedFut.status().ok()) << expectedFut.status();
+  auto expected = expectedFut.value();
+
+  auto streamRes = cs.streamSelection<int32_t>("inline", 3, 2);
+  ASSERT_TRUE(streamRes.status().ok()) << streamRes.status();
+  auto stream = std::move(streamRes).value();
+
+  std::vector<int32_t> streamed;
+  std::size_t runs = 0;
+  while (true) {
+    auto batch = stream.next().result();
+    ASSERT_TRUE(batch.ok()) << batch.status();
+    if (!batch.value()) {
+      break;
+    }
+    EXPECT_EQ(batch.value()->first_run, runs);
+    EXPECT_LE(batch.value()->runs.size(), 3);
+    runs += batch.value()->runs.size();
+    streamed.insert(streamed.end(), batch.value()->data.begin(),
+                    batch.value()->data.end());
+  }
+  EXPECT_TRUE(stream.done());
+  EXPECT_EQ(runs, stream.num_runs());
+  EXPECT_EQ(streamed, expected);
+
+  EXPECT_FALSE(cs.streamSelection<int32_t>("inline", 0).status().ok());
+}
+
+TEST(Intersection, sortSelectionByKeys) {
+  auto pathResult = SetupDataset();
+  ASSERT_TRUE(pathResult.status().ok()) << pathResult.status();
+  auto path = pathResult.value();
+
+  auto dsFut = mdio::Dataset::Open(path, mdio::constants::kOpen);
+  ASSERT_TRUE(dsFut.status().ok()) << dsFut.status();
+  auto ds = dsFut.value();
+
+  mdio::CoordinateSelector cs(ds);
+  auto isFut = cs.filterByCoordinate(
+      mdio::ValueDescriptor<bool>{"live_mask", true});
+  ASSERT_TRUE(isFut.status().ok()) << isFut.status();
+  auto before = cs.readSelection<int32_t>("inline").result();
+  ASSERT_TRUE(before.ok()) << before.status();
+
+  // The coordinates already increase, so the stable sort keeps the order.
+  auto sortFut = cs.sortSelectionByKeys(mdio::SortKey<int32_t>{"crossline"},
+                                        mdio::SortKey<int32_t>{"inline"});
+  ASSERT_TRUE(sortFut.status().ok()) << sortFut.status();
+  auto after = cs.readSelection<int32_t>("inline").result();
+  ASSERT_TRUE(after.ok()) << after.status();
+  EXPECT_EQ(after.value(), before.value());
+
+  EXPECT_FALSE(cs.sortSelectionByKey<float>("inline").status().ok());
+  EXPECT_FALSE(cs.sortSelectionByKey<int32_t>("no_such_key").status().ok());
+}
+
+TEST(Intersection, readDataVariables) {
+  auto pathResult = SetupDataset();
+  ASSERT_TRUE(pathResult.status().ok()) << pathResult.status();
+  auto path = pathResult.value();
+
+  auto dsFut = mdio::Dataset::Open(path, mdio::constants::kOpen);
+  ASSERT_TRUE(dsFut.status().ok()) << dsFut.status();
+  auto ds = dsFut.value();
+
+  mdio::CoordinateSelector expected_cs(ds);
+  ASSERT_TRUE(expected_cs
+                  .filterByCoordinate(
+                      mdio::ValueDescriptor<bool>{"live_mask", true})
+                  .status()
+                  .ok());
+  auto expected = expected_cs.readSelection<int32_t>("inline").result();
+  ASSERT_TRUE(expected.ok()) << expected.status();
+
+  // The filter, the sort and the reads are chained on one future. The
+  // coordinates already increase, so the stable sort keeps the order.
+  mdio::CoordinateSelector cs(ds);
+  auto read = cs.ReadDataVariables<int32_t, int32_t>(
+                    {"inline", "crossline"},
+                    mdio::ValueDescriptor<bool>{"live_mask", true},
+                    mdio::SortKey<int32_t>{"crossline"})
+                  .result();
+  ASSERT_TRUE(read.ok()) << read.status();
+  EXPECT_EQ(std::get<0>(read.value()), expected.value());
+  EXPECT_EQ(std::get<1>(read.value()).size(), expected.value().size());
+
+  // An op that fails stops the chain.
+  cs.reset();
+  auto failed = cs.ReadDataVariables<int32_t>(
+                      {"inline"},
+                      mdio::ValueDescriptor<bool>{"live_mask", true},
+                      mdio::SortKey<int32_t>{"no_such_key"})
+                    .result();
+  EXPECT_FALSE(failed.ok());
+}
+
+TEST(FindMatchingRuns, blockBoundaries) {
+  // Runs that start, stop and span across the 64 element blocks.
+  std::vector<int32_t> data(300, 0);
+  std::vector<std::pair<mdio::Index, mdio::Index>> expected = {
+      {0, 3}, {60, 70}, {127, 128}, {128, 256}, {299, 300}};
+  // {127, 128} and {128, 256} are one contiguous run.
+  for (const auto& [start, stop] : expected) {
+    for (auto i = start; i < stop; ++i) {
+      data[i] = 7;
+    }
+  }
+
+  std::vector<mdio::internal::FlatRun> runs;
+  mdio::internal::FindMatchingRuns(data.data(), data.size(), int32_t{7},
+                                   runs);
+  ASSERT_EQ(runs.size(), 4);
+  EXPECT_EQ(runs[0].start, 0);
+  EXPECT_EQ(runs[0].stop, 3);
+  EXPECT_EQ(runs[1].start, 60);
+  EXPECT_EQ(runs[1].stop, 70);
+  EXPECT_EQ(runs[2].start, 127);
+  EXPECT_EQ(runs[2].stop, 256);
+  EXPECT_EQ(runs[3].start, 299);
+  EXPECT_EQ(runs[3].stop, 300);
+}
+
+TEST(FindMatchingRuns, allOrNothing) {
+  std::vector<float> data(130, 1.5f);
+  std::vector<mdio::internal::FlatRun> runs;
+  mdio::internal::FindMatchingRuns(data.data(), data.size(), 1.5f, runs);
+  ASSERT_EQ(runs.size(), 1);
+  EXPECT_EQ(runs[0].start, 0);
+  EXPECT_EQ(runs[0].stop, 130);
+
+  runs.clear();
+  mdio::internal::FindMatchingRuns(data.data(), data.size(), 2.5f, runs);
+  EXPECT_TRUE(runs.empty());
+
+  runs.clear();
+  mdio::internal::FindMatchingRuns(data.data(), 0, 1.5f, runs);
+  EXPECT_TRUE(runs.empty());
+}
+
+TEST(FindMatchingRuns, alternating) {
+  std::unique_ptr<bool[]> data(new bool[100]);
+  for (int i = 0; i < 100; ++i) {
+    data[i] = i % 2 == 0;
+  }
+  std::vector<mdio::internal::FlatRun> runs;
+  mdio::internal::FindMatchingRuns(data.get(), 100, true, runs);
+  ASSERT_EQ(runs.size(), 50);
+  for (int i = 0; i < 50; ++i) {
+    EXPECT_EQ(runs[i].start, 2 * i);
+    EXPECT_EQ(runs[i].stop, 2 * i + 1);
+  }
+}
+
+TEST(PlanCoalescedReads, sameChunk) {
+  // Three runs along the first dimension, the first two share a chunk.
+  std::vector<tensorstore::Box<>> boxes = {tensorstore::Box<>({0, 0}, {2, 8}),
+                                           tensorstore::Box<>({3, 0}, {1, 8}),
+                                           tensorstore::Box<>({5, 0}, {1, 8})};
+  auto reads = mdio::internal::PlanCoalescedReads(boxes, {4, 8});
+  ASSERT_EQ(reads.size(), 2);
+  EXPECT_EQ(reads[0].box, tensorstore::Box<>({0, 0}, {4, 8}));
+  EXPECT_EQ(reads[0].runs, (std::vector<std::size_t>{0, 1}));
+  EXPECT_EQ(reads[1].box, tensorstore::Box<>({5, 0}, {1, 8}));
+  EXPECT_EQ(reads[1].runs, (std::vector<std::size_t>{2}));
+
+  // Without a chunk shape nothing is merged.
+  reads = mdio::internal::PlanCoalescedReads(boxes, {});
+  EXPECT_EQ(reads.size(), 3);
+}
+
+TEST(CopyBoxToContiguous, subBox) {
+  // A 3x4 buffer holding [10, 13) x [20, 24).
+  std::vector<int32_t> src(12);
+  std::iota(src.begin(), src.end(), 0);
+  tensorstore::Box<> src_box({10, 20}, {3, 4});
+
+  std::vector<int32_t> out(4);
+  mdio::internal::CopyBoxToContiguous(src.data(), src_box,
+                                      tensorstore::Box<>({11, 21}, {2, 2}),
+                                      out.data());
+  EXPECT_EQ(out, (std::vector<int32_t>{5, 6, 9, 10}));
+}
+
+TEST(OrderedBits, preservesOrder) {
+  std::vector<int32_t> ints = {-2147483647 - 1, -5, -1, 0, 1, 7, 2147483647};
+  for (std::size_t i = 1; i < ints.size(); ++i) {
+    EXPECT_LT(mdio::internal::OrderedBits(ints[i - 1]),
+              mdio::internal::OrderedBits(ints[i]));
+  }
+  std::vector<double> doubles = {-1e300, -2.5, -0.5, 0.0, 1e-300, 3.0, 1e300};
+  for (std::size_t i = 1; i < doubles.size(); ++i) {
+    EXPECT_LT(mdio::internal::OrderedBits(doubles[i - 1]),
+              mdio::internal::OrderedBits(doubles[i]));
+  }
+  EXPECT_LT(mdio::internal::OrderedBits(-1.0f),
+            mdio::internal::OrderedBits(1.0f));
+}
+
+TEST(SortedRunOrder, stableMultiKey) {
+  // The first key is the most significant, ties keep their order.
+  std::vector<std::vector<std::uint64_t>> keys = {{2, 1, 2, 1, 1},
+                                                  {0, 9, 0, 3, 9}};
+  auto order = mdio::internal::SortedRunOrder(keys, 5);
+  EXPECT_EQ(order, (std::vector<std::size_t>{3, 1, 4, 0, 2}));
+
+  // Keys too wide to pack together are compared one by one.
+  std::vector<std::vector<std::uint64_t>> wide = {
+      {~0ULL, 0, ~0ULL}, {0, ~0ULL, ~0ULL - 1}};
+  order = mdio::internal::SortedRunOrder(wide, 3);
+  EXPECT_EQ(order, (std::vector<std::size_t>{1, 0, 2}));
+}
+
+TEST(SortedRunOrder, parallelRadix) {
+  // Large enough to split the passes across threads.
+  const std::size_t n = mdio::internal::kParallelSortThreshold * 4 + 3;
+  std::vector<std::vector<std::uint64_t>> keys(2,
+                                               std::vector<std::uint64_t>(n));
+  std::uint64_t state = 12345;
+  for (std::size_t i = 0; i < n; ++i) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    keys[0][i] = state >> 54;
+    keys[1][i] = (state >> 20) & 0xfffff;
+  }
+  auto order = mdio::internal::SortedRunOrder(keys, n);
+
+  std::vector<std::size_t> expected(n);
+  std::iota(expected.begin(), expected.end(), 0);
+  std::stable_sort(expected.begin(), expected.end(),
+                   [&keys](std::size_t a, std::size_t b) {
+                     return std::make_pair(keys[0][a], keys[1][a]) <
+                            std::make_pair(keys[0][b], keys[1][b]);
+                   });
+  EXPECT_EQ(order, expected);
+}
+
+TEST(PermuteInPlace, cycles) {
+  std::vector<std::string> elements = {"a", "b", "c", "d", "e"};
+  std::vector<std::size_t> order = {3, 0, 4, 1, 2};
+  mdio::internal::PermuteInPlace(elements, order);
+  EXPECT_EQ(elements, (std::vector<std::string>{"d", "a", "e", "b", "c"}));
+}
+
 }  // namespace
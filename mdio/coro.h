@@ -0,0 +1,214 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file coro.h
+ * @brief Lets coroutines await and return MDIO futures.
+ * MDIO itself is C++17, so everything here is only defined when the including
+ * translation unit is compiled with coroutine support, which
+ * `MDIO_HAS_COROUTINES` reports.
+ */
+
+#ifndef MDIO_CORO_H_
+#define MDIO_CORO_H_
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define MDIO_HAS_COROUTINES 1
+#else
+#define MDIO_HAS_COROUTINES 0
+#endif
+
+#if MDIO_HAS_COROUTINES
+
+#include <coroutine>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "mdio/impl.h"
+#include "tensorstore/util/executor.h"
+#include "tensorstore/util/future.h"
+
+// NOLINTBEGIN(bugprone-macro-parentheses)
+#define MDIO_CO_CONCAT_IMPL(a, b) a##b
+#define MDIO_CO_CONCAT(a, b) MDIO_CO_CONCAT_IMPL(a, b)
+#define MDIO_CO_ASSIGN_OR_RETURN_IMPL(result, lhs, expr) \
+  auto result = co_await(expr);                          \
+  if (!result.ok()) {                                    \
+    co_return result.status();                           \
+  }                                                      \
+  lhs = std::move(result).value();
+// NOLINTEND(bugprone-macro-parentheses)
+
+/**
+ * @brief Awaits a future or result and assigns its value, or returns its
+ * error from the coroutine.
+ * The coroutine analogue of `MDIO_ASSIGN_OR_RETURN`.
+ */
+#define MDIO_CO_ASSIGN_OR_RETURN(lhs, expr) \
+  MDIO_CO_ASSIGN_OR_RETURN_IMPL(            \
+      MDIO_CO_CONCAT(mdio_co_result_, __LINE__), lhs, expr)
+
+namespace mdio {
+namespace internal {
+
+/**
+ * @brief Suspends a coroutine until a future is ready.
+ * The coroutine resumes on the thread that readies the future, or on the
+ * executor if one is given. Either way no thread blocks while it waits.
+ */
+template <typename T>
+class FutureAwaiter {
+ public:
+  explicit FutureAwaiter(Future<T> future,
+                         std::optional<tensorstore::Executor> executor = {})
+      : future_(std::move(future)), executor_(std::move(executor)) {}
+
+  bool await_ready() const { return future_.ready(); }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    future_.ExecuteWhenReady(
+        [handle, executor = std::move(executor_)](ReadyFuture<T>) {
+          if (executor) {
+            (*executor)([handle] { handle.resume(); });
+          } else {
+            handle.resume();
+          }
+        });
+  }
+
+  /// The result is copied, other holders of the future may still read it.
+  Result<T> await_resume() { return future_.result(); }
+
+ private:
+  Future<T> future_;
+  std::optional<tensorstore::Executor> executor_;
+};
+
+/**
+ * @brief Hands a result to `co_await` without suspending.
+ * Lets `MDIO_CO_ASSIGN_OR_RETURN` unwrap synchronous results as well.
+ */
+template <typename T>
+class ResultAwaiter {
+ public:
+  explicit ResultAwaiter(Result<T> result) : result_(std::move(result)) {}
+
+  bool await_ready() const noexcept { return true; }
+
+  void await_suspend(std::coroutine_handle<>) noexcept {}
+
+  Result<T> await_resume() { return std::move(result_); }
+
+ private:
+  Result<T> result_;
+};
+
+/**
+ * @brief The promise of a coroutine that returns a `Future<T>`.
+ * The coroutine starts eagerly and its frame is freed once it returns. Its
+ * `co_return` takes anything a `Result<T>` can be made from, so a
+ * `Future<void>` coroutine ends with `co_return absl::OkStatus();`.
+ */
+template <typename T>
+class FuturePromise {
+ public:
+  FuturePromise() {
+    auto pair = tensorstore::PromiseFuturePair<T>::Make();
+    promise_ = std::move(pair.promise);
+    future_ = std::move(pair.future);
+  }
+
+  Future<T> get_return_object() { return std::move(future_); }
+
+  std::suspend_never initial_suspend() noexcept { return {}; }
+
+  std::suspend_never final_suspend() noexcept { return {}; }
+
+  void return_value(Result<T> result) {
+    promise_.SetResult(std::move(result));
+  }
+
+  void unhandled_exception() {
+    promise_.SetResult(
+        absl::InternalError("A coroutine exited with an exception."));
+  }
+
+  /// Lets `co_await` take MDIO futures and results directly.
+  template <typename U>
+  FutureAwaiter<U> await_transform(Future<U> future) {
+    return FutureAwaiter<U>(std::move(future));
+  }
+
+  template <typename U>
+  ResultAwaiter<U> await_transform(Result<U> result) {
+    return ResultAwaiter<U>(std::move(result));
+  }
+
+  template <typename Awaitable,
+            std::enable_if_t<
+                !tensorstore::IsFuture<std::decay_t<Awaitable>>::value &&
+                    !tensorstore::IsResult<std::decay_t<Awaitable>>::value,
+                int> = 0>
+  Awaitable&& await_transform(Awaitable&& awaitable) {
+    return std::forward<Awaitable>(awaitable);
+  }
+
+ private:
+  tensorstore::Promise<T> promise_;
+  Future<T> future_;
+};
+
+}  // namespace internal
+
+/**
+ * @brief Awaits a future and resumes the coroutine on an executor.
+ * Without an executor the coroutine resumes on whichever thread completes
+ * the future, often an I/O thread, so a coroutine that does significant work
+ * after awaiting should name the pool to continue on.
+ * @details \b Usage
+ * @code
+ * mdio::Future<double> AverageAmplitude(mdio::Dataset ds,
+ *                                       tensorstore::Executor pool) {
+ *   MDIO_CO_ASSIGN_OR_RETURN(auto seismic,
+ *                            ds.variables.get<float>("seismic"));
+ *   MDIO_CO_ASSIGN_OR_RETURN(auto data,
+ *                            mdio::Await(seismic.Read(), pool));
+ *   co_return Average(data);
+ * }
+ * @endcode
+ * @param future The future to wait for.
+ * @param executor The executor to resume on.
+ */
+template <typename T>
+internal::FutureAwaiter<T> Await(Future<T> future,
+                                 tensorstore::Executor executor) {
+  return internal::FutureAwaiter<T>(std::move(future), std::move(executor));
+}
+
+}  // namespace mdio
+
+/**
+ * Coroutines declared to return a `Future<T>` are driven by a
+ * `FuturePromise<T>`, so MDIO functions and coroutines share one signature.
+ */
+template <typename T, typename... Args>
+struct std::coroutine_traits<tensorstore::Future<T>, Args...> {
+  using promise_type = mdio::internal::FuturePromise<T>;
+};
+
+#endif  // MDIO_HAS_COROUTINES
+
+#endif  // MDIO_CORO_H_
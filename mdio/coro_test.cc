@@ -0,0 +1,100 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mdio/coro.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+#include "absl/functional/any_invocable.h"
+#include "mdio/impl.h"
+#include "tensorstore/util/future.h"
+
+namespace {
+
+#if MDIO_HAS_COROUTINES
+
+mdio::Future<int> AddLater(mdio::Future<int> a, mdio::Future<int> b) {
+  MDIO_CO_ASSIGN_OR_RETURN(int x, std::move(a));
+  MDIO_CO_ASSIGN_OR_RETURN(int y, std::move(b));
+  co_return x + y;
+}
+
+mdio::Future<void> Check(mdio::Result<int> value) {
+  MDIO_CO_ASSIGN_OR_RETURN(int x, std::move(value));
+  if (x < 0) {
+    co_return absl::InvalidArgumentError("negative");
+  }
+  co_return absl::OkStatus();
+}
+
+TEST(Coro, awaitsWithoutBlocking) {
+  auto a = tensorstore::PromiseFuturePair<int>::Make();
+  auto b = tensorstore::PromiseFuturePair<int>::Make();
+  auto sum = AddLater(a.future, b.future);
+  // The coroutine is suspended on the first future.
+  EXPECT_FALSE(sum.ready());
+  a.promise.SetResult(2);
+  EXPECT_FALSE(sum.ready());
+  b.promise.SetResult(40);
+  ASSERT_TRUE(sum.ready());
+  ASSERT_TRUE(sum.result().ok()) << sum.status();
+  EXPECT_EQ(sum.value(), 42);
+}
+
+TEST(Coro, propagatesErrors) {
+  auto a = tensorstore::PromiseFuturePair<int>::Make();
+  auto sum = AddLater(a.future, tensorstore::MakeReadyFuture<int>(1));
+  a.promise.SetResult(absl::NotFoundError("missing"));
+  EXPECT_EQ(sum.status().code(), absl::StatusCode::kNotFound);
+
+  EXPECT_TRUE(Check(3).status().ok());
+  EXPECT_EQ(Check(-3).status().code(), absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(Check(absl::AbortedError("stop")).status().code(),
+            absl::StatusCode::kAborted);
+}
+
+TEST(Coro, resumesOnExecutor) {
+  std::vector<absl::AnyInvocable<void() &&>> queued;
+  tensorstore::Executor executor =
+      [&queued](absl::AnyInvocable<void() &&> task) {
+        queued.push_back(std::move(task));
+      };
+  auto a = tensorstore::PromiseFuturePair<int>::Make();
+  auto doubled = [](mdio::Future<int> future,
+                    tensorstore::Executor on) -> mdio::Future<int> {
+    MDIO_CO_ASSIGN_OR_RETURN(int x, mdio::Await(std::move(future), on));
+    co_return 2 * x;
+  }(a.future, executor);
+  a.promise.SetResult(21);
+  // The resumption waits on the executor.
+  ASSERT_EQ(queued.size(), 1);
+  EXPECT_FALSE(doubled.ready());
+  std::move(queued[0])();
+  ASSERT_TRUE(doubled.ready());
+  EXPECT_EQ(doubled.value(), 42);
+}
+
+#else
+
+TEST(Coro, unavailable) {
+  GTEST_SKIP() << "Coroutines need C++20.";
+}
+
+#endif  // MDIO_HAS_COROUTINES
+
+}  // namespace
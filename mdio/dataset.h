@@ -22,6 +22,8 @@
 #include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <set>
 #include <stdexcept>
 #include <string>
@@ -31,10 +33,18 @@
 #include <utility>
 #include <vector>
 
+#include "mdio/coordinate_index.h"
 #include "mdio/dataset_factory.h"
+#include "mdio/disk_cache.h"
+#include "mdio/request_policy.h"
+#include "mdio/telemetry.h"
 #include "mdio/variable.h"
 #include "mdio/variable_collection.h"
+#include "tensorstore/driver/zarr/dtype.h"
 #include "tensorstore/driver/zarr/metadata.h"
+#include "tensorstore/kvstore/generation.h"
+#include "tensorstore/transaction.h"
+#include "tensorstore/util/endian.h"
 #include "tensorstore/util/future.h"
 
 // clang-format off
@@ -118,16 +128,36 @@ Result<nlohmann::json> get_zarray(const ::nlohmann::json metadata) {
   return ::nlohmann::json(zarr_metadata);
 }
 
+/**
+ * @brief Options for `write_zmetadata`.
+ */
+struct ZMetadataWriteOptions {
+  /// Also write the root .zattrs and .zgroup, which don't change once the
+  /// Dataset has been created.
+  bool write_group = true;
+  /// Only replace the consolidated metadata if it is still at this
+  /// generation. The unknown generation writes unconditionally.
+  tensorstore::StorageGeneration if_equal =
+      tensorstore::StorageGeneration::Unknown();
+  /// Stage the writes in this transaction, they are done when it commits.
+  tensorstore::Transaction transaction = tensorstore::no_transaction;
+};
+
 /**
  * @brief Writes the zmetadata for the dataset.
- *
+ * The metadata is written compactly.
  * @param dataset_metadata The metadata for the dataset.
  * @param json_variables The JSON variables.
- * @return An `mdio::Future<void>` representing the asynchronous write.
+ * @param context The Context to write in, the default one if null.
+ * @param options What to write and the generation to write over.
+ * @return An `mdio::Future` of the generation of the new consolidated metadata,
+ * or a failed precondition if it was changed since `options.if_equal`.
  */
-Future<void> write_zmetadata(
+Future<tensorstore::TimestampedStorageGeneration> write_zmetadata(
     const ::nlohmann::json& dataset_metadata,
-    const std::vector<::nlohmann::json>& json_variables) {
+    const std::vector<::nlohmann::json>& json_variables,
+    const Context& context = Context(),
+    const ZMetadataWriteOptions& options = {}) {
   // header material at the root of the dataset ...
   // Configure a kvstore (we can't deduce if it's in memory etc).
   // {
@@ -138,8 +168,9 @@ Future<void> write_zmetadata(
   //    }
   //}
   auto zattrs = dataset_metadata;
+  // A Zarr v3 Dataset consolidates into the root zarr.json instead.
+  const bool zarr3 = internal::IsZarr3(json_variables[0]);
 
-  // FIXME - generalize for zarr v3
   ::nlohmann::json zgroup;
   zgroup["zarr_format"] = 2;
 
@@ -163,7 +194,10 @@ Future<void> write_zmetadata(
     zattrs_key =
         std::filesystem::path(json["kvstore"]["path"]).stem() / ".zattrs";
 
-    MDIO_ASSIGN_OR_RETURN(zmetadata["metadata"][zarray_key], get_zarray(json))
+    if (!zarr3) {
+      MDIO_ASSIGN_OR_RETURN(zmetadata["metadata"][zarray_key],
+                            get_zarray(json))
+    }
 
     nlohmann::json fixedJson = json["attributes"];
     fixedJson["_ARRAY_DIMENSIONS"] = fixedJson["dimension_names"];
@@ -194,7 +228,17 @@ Future<void> write_zmetadata(
         fixedJson.erase("coordinates");
       }
     }
-    zmetadata["metadata"][zattrs_key] = fixedJson;
+    if (zarr3) {
+      nlohmann::json array = json["metadata"];
+      array["zarr_format"] = 3;
+      array["node_type"] = "array";
+      array["attributes"] = fixedJson;
+      zmetadata["metadata"][std::filesystem::path(json["kvstore"]["path"])
+                                .stem()
+                                .string()] = array;
+    } else {
+      zmetadata["metadata"][zattrs_key] = fixedJson;
+    }
   }
 
   nlohmann::json kvstore = nlohmann::json::object();
@@ -215,45 +259,169 @@ Future<void> write_zmetadata(
     kvstore["path"] = cloudPath;
   }
 
-  auto kvs_future = tensorstore::kvstore::Open(kvstore);
+  auto kvs_future = OpenKvStore(kvstore, context);
+  if (options.transaction != tensorstore::no_transaction) {
+    kvs_future = tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [transaction = options.transaction](const tensorstore::KvStore& kvs) {
+          return kvs | transaction;
+        },
+        kvs_future);
+  }
 
-  auto zattrs_future = tensorstore::MapFutureValue(
-      tensorstore::InlineExecutor{},
-      [zattrs = std::move(zattrs)](const tensorstore::KvStore& kvstore) {
-        return tensorstore::kvstore::Write(kvstore, "/.zattrs",
-                                           absl::Cord(zattrs.dump(4)));
-      },
-      kvs_future);
+  // A committer that lost a race gets the unknown generation back.
+  tensorstore::kvstore::WriteOptions write_options;
+  write_options.generation_conditions.if_equal = options.if_equal;
+  auto check_generation = [](const tensorstore::TimestampedStorageGeneration&
+                                 stamp)
+      -> Result<tensorstore::TimestampedStorageGeneration> {
+    if (tensorstore::StorageGeneration::IsUnknown(stamp.generation)) {
+      return absl::FailedPreconditionError(
+          "The consolidated metadata was changed by another writer, reopen "
+          "the Dataset before committing.");
+    }
+    return stamp;
+  };
+
+  std::string key = "/.zmetadata";
+  std::string consolidated;
+  if (zarr3) {
+    // Inline consolidated metadata, as written by zarr-python.
+    zmetadata["metadata"].erase(".zattrs");
+    zmetadata["metadata"].erase(".zgroup");
+    ::nlohmann::json group = {
+        {"zarr_format", 3},
+        {"node_type", "group"},
+        {"attributes", zattrs},
+        {"consolidated_metadata",
+         {{"kind", "inline"},
+          {"must_understand", false},
+          {"metadata", zmetadata["metadata"]}}}};
+    key = "/zarr.json";
+    consolidated = group.dump();
+  } else {
+    consolidated = zmetadata.dump();
+  }
 
   auto zmetadata_future = tensorstore::MapFutureValue(
       tensorstore::InlineExecutor{},
-      [zmetadata = std::move(zmetadata)](const tensorstore::KvStore& kvstore) {
-        return tensorstore::kvstore::Write(kvstore, "/.zmetadata",
-                                           absl::Cord(zmetadata.dump(4)));
+      [key, consolidated = std::move(consolidated),
+       write_options = std::move(write_options)](
+          const tensorstore::KvStore& kvstore) {
+        return tensorstore::kvstore::Write(kvstore, key,
+                                           absl::Cord(consolidated),
+                                           write_options);
       },
       kvs_future);
 
-  auto zgroup_future = tensorstore::MapFutureValue(
+  // Zarr v3 keeps the group in zarr.json.
+  if (zarr3 || !options.write_group) {
+    return tensorstore::MapFutureValue(tensorstore::InlineExecutor{},
+                                       check_generation, zmetadata_future);
+  }
+
+  // The group is only rewritten by the committer that won the race, so it
+  // always agrees with the consolidated metadata.
+  return tensorstore::MapFutureValue(
       tensorstore::InlineExecutor{},
-      [zgroup = std::move(zgroup)](const tensorstore::KvStore& kvstore) {
-        return tensorstore::kvstore::Write(kvstore, "/.zgroup",
-                                           absl::Cord(zgroup.dump(4)));
+      [check_generation, zattrs = std::move(zattrs),
+       zgroup = std::move(zgroup)](
+          const tensorstore::KvStore& kvstore,
+          const tensorstore::TimestampedStorageGeneration& stamp)
+          -> Future<tensorstore::TimestampedStorageGeneration> {
+        MDIO_ASSIGN_OR_RETURN(auto committed, check_generation(stamp))
+        auto zattrs_future = tensorstore::kvstore::Write(
+            kvstore, "/.zattrs", absl::Cord(zattrs.dump()));
+        auto zgroup_future = tensorstore::kvstore::Write(
+            kvstore, "/.zgroup", absl::Cord(zgroup.dump()));
+        return tensorstore::MapFutureValue(
+            tensorstore::InlineExecutor{},
+            [committed](const tensorstore::TimestampedStorageGeneration&,
+                        const tensorstore::TimestampedStorageGeneration&) {
+              return committed;
+            },
+            std::move(zattrs_future), std::move(zgroup_future));
       },
-      kvs_future);
+      kvs_future, zmetadata_future);
+}
 
-  return tensorstore::WaitAllFuture(zattrs_future, zmetadata_future,
-                                    zgroup_future);
+/**
+ * @brief Gets the consolidated form of one Variable for `write_zmetadata`.
+ * @param var The Variable, as held by its Dataset.
+ * @return The spec of the Variable with its attributes.
+ */
+inline Result<::nlohmann::json> variable_zmetadata_json(const Variable<>& var) {
+  MDIO_ASSIGN_OR_RETURN(auto spec, var.get_store().spec())
+  // Get the JSON, drop transform, and add attributes
+  MDIO_ASSIGN_OR_RETURN(auto json, spec.ToJson(IncludeDefaults{}))
+  json.erase("transform");
+  json.erase("dtype");
+  json["metadata"].erase("filters");
+  json["metadata"].erase("order");
+  json["metadata"].erase("zarr_format");
+  // On local file systems there is a trailing slash that needs to be
+  // removed.
+  std::string path = json["kvstore"]["path"].get<std::string>();
+  path.pop_back();
+  json["kvstore"]["path"] = path;
+  nlohmann::json meta = var.getMetadata();
+  if (meta.contains("coordinates")) {
+    meta["attributes"]["coordinates"] = meta["coordinates"];
+    meta.erase("coordinates");
+  }
+  if (meta.contains("dimension_names")) {
+    meta["attributes"]["dimension_names"] = meta["dimension_names"];
+    meta.erase("dimension_names");
+  }
+  if (meta.contains("long_name")) {
+    meta["attributes"]["long_name"] = meta["long_name"];
+    meta.erase("long_name");
+  }
+  if (meta.contains("metadata")) {
+    if (meta["metadata"].contains("chunkGrid")) {
+      meta["metadata"].erase("chunkGrid");  // We never serialize this
+    }
+    if (!meta.contains("attributes")) {
+      meta["attributes"] = nlohmann::json::object();
+    }
+    meta["attributes"]["metadata"].merge_patch(meta["metadata"]);
+    meta.erase("metadata");
+  }
+  json.update(meta);
+  return json;
 }
 
+/**
+ * @brief The consolidated metadata a Dataset last read or wrote.
+ * It is shared by a Dataset and its slices, so `CommitMetadata` only
+ * serializes the Variables whose attributes changed since the last commit.
+ */
+struct ZMetadataCache {
+  /// The consolidated form of one Variable.
+  struct Fragment {
+    /// The attributes the fragment was made from. Attributes are replaced
+    /// rather than modified, so a different pointer means a stale fragment.
+    std::shared_ptr<UserAttributes> attributes;
+    ::nlohmann::json json;
+  };
+
+  std::mutex mutex;
+  std::unordered_map<std::string, Fragment> fragments;
+  /// The generation of the .zmetadata (zarr.json for Zarr v3), unknown if it
+  /// hasn't been read or written by this Dataset.
+  tensorstore::StorageGeneration generation;
+};
+
 /**
  * @brief Retrieves the .zmetadata for the dataset.
  * This is for executing a read on the dataset's consolidated metadata.
  * It will also attempt to infer the driver based on the prefix of the path.
  * It will default to the "file" driver if no prefix is found.
  * @param dataset_path The path to the dataset.
+ * @param context The Context to open the kvstore in, the default one if null.
  */
 Future<tensorstore::KvStore> dataset_kvs_store(
-    const std::string& dataset_path) {
+    const std::string& dataset_path, const Context& context = Context()) {
   // the tensorstore driver needs a bucket field
   ::nlohmann::json kvstore;
 
@@ -268,7 +436,7 @@ Future<tensorstore::KvStore> dataset_kvs_store(
   } else {
     kvstore["driver"] = "file";
     kvstore["path"] = output_file;
-    return tensorstore::kvstore::Open(kvstore);
+    return OpenKvStore(kvstore, context);
   }  // FIXME - we need azure support ...
 
   std::vector<std::string> file_parts = absl::StrSplit(output_file, '/');
@@ -285,47 +453,146 @@ Future<tensorstore::KvStore> dataset_kvs_store(
   // update the bucket and path ...
   kvstore["bucket"] = bucket;
   kvstore["path"] = filepath;
+  ApplyRequestPolicy(kvstore);
 
-  return tensorstore::kvstore::Open(kvstore);
+  return OpenKvStore(kvstore, context);
 }
 
 /**
- * @brief Retrieves the .zmetadata for the dataset.
+ * @brief The parsed consolidated metadata of the Datasets opened by the
+ * process, by path. An entry is reused while the store reports the same
+ * generation for it, so a repeat open only costs a conditional read.
+ */
+struct ConsolidatedMemo {
+  /// The consolidated form, as returned by `consolidated_from_zmetadata`.
+  using Consolidated =
+      std::tuple<::nlohmann::json, std::vector<::nlohmann::json>,
+                 std::vector<::nlohmann::json>, tensorstore::StorageGeneration>;
+  struct Entry {
+    /// The key the consolidated metadata was read from.
+    std::string key;
+    Consolidated consolidated;
+  };
+  /// Beyond this many paths the memo starts over.
+  static constexpr std::size_t kMaxEntries = 256;
+
+  std::mutex mutex;
+  std::unordered_map<std::string, Entry> entries;
+};
+
+inline ConsolidatedMemo& ProcessConsolidatedMemo() {
+  static ConsolidatedMemo memo;
+  return memo;
+}
+
+/**
+ * @brief Retrieves the .zmetadata for the dataset along with the consolidated
+ * metadata of every Variable.
  * This is for executing a read on the dataset's consolidated metadata.
  * It will also attempt to infer the driver based on the prefix of the path.
  * It will default to the "file" driver if no prefix is found.
  * @param dataset_path The path to the dataset.
- * @return An `mdio::Future` containing the .zmetadata JSON on success, or an
+ * @param context The Context to read in, the default one if null.
+ * @return An `mdio::Future` containing the Dataset metadata, the Variable
+ * specs, in the same order each Variable's consolidated {"name", "zarray",
+ * "zattrs"} and the generation of the consolidated metadata on success, or an
  * error on failure.
  */
-Future<std::tuple<::nlohmann::json, std::vector<::nlohmann::json>>>
-from_zmetadata(const std::string& dataset_path) {
+Future<std::tuple<::nlohmann::json, std::vector<::nlohmann::json>,
+                  std::vector<::nlohmann::json>,
+                  tensorstore::StorageGeneration>>
+consolidated_from_zmetadata(const std::string& dataset_path,
+                            const Context& context = Context()) {
   // e.g. dataset_path = "zarrs/acceptance/";
   //  FIXME - enable async
-  auto kvs_future = mdio::internal::dataset_kvs_store(dataset_path).result();
+  auto kvs_future =
+      mdio::internal::dataset_kvs_store(dataset_path, context).result();
 
   if (!kvs_future.ok()) {
     return internal::CheckMissingDriverStatus(kvs_future.status());
   }
-  auto kvs_read_result =
-      tensorstore::kvstore::Read(kvs_future.value(), ".zmetadata").result();
+
+  // An unchanged consolidated metadata is not downloaded or parsed again.
+  auto& memo = ProcessConsolidatedMemo();
+  std::optional<ConsolidatedMemo::Entry> memoized;
+  {
+    std::lock_guard<std::mutex> lock(memo.mutex);
+    auto found = memo.entries.find(dataset_path);
+    if (found != memo.entries.end()) {
+      memoized = found->second;
+    }
+  }
+  if (memoized.has_value()) {
+    tensorstore::kvstore::ReadOptions options;
+    options.generation_conditions.if_not_equal =
+        std::get<3>(memoized->consolidated);
+    auto revalidated =
+        PolicyRead(kvs_future.value(), memoized->key, options).result();
+    if (revalidated.ok() && revalidated->aborted()) {
+      Count(TelemetryCounter::kCacheHits, 1);
+      return tensorstore::MakeReadyFuture<ConsolidatedMemo::Consolidated>(
+          std::move(memoized->consolidated));
+    }
+  }
+
+  // Remote metadata is read through the disk cache, if enabled.
+  auto cache = absl::StartsWith(dataset_path, "gs://") ||
+                       absl::StartsWith(dataset_path, "s3://")
+                   ? GetDiskCache()
+                   : nullptr;
+  auto read = [&](const std::string& key) {
+    return CachedRead(kvs_future.value(), key, dataset_path + "|" + key,
+                      cache);
+  };
+  auto kvs_read_result = read(".zmetadata").result();
   if (!kvs_read_result.ok()) {
     return internal::CheckMissingDriverStatus(kvs_read_result.status());
   }
 
+  // Without a .zmetadata the Dataset may be Zarr v3, consolidated in zarr.json.
+  const bool has_trailing_slash =
+      !dataset_path.empty() && dataset_path.back() == '/';
+  bool zarr3 = false;
+  if (!kvs_read_result.value().has_value() && has_trailing_slash) {
+    kvs_read_result = read("zarr.json").result();
+    if (!kvs_read_result.ok()) {
+      return internal::CheckMissingDriverStatus(kvs_read_result.status());
+    }
+    zarr3 = kvs_read_result.value().has_value();
+  }
+
   ::nlohmann::json zmetadata;
   try {
     zmetadata =
         ::nlohmann::json::parse(std::string(kvs_read_result.value().value));
   } catch (const nlohmann::json::parse_error& e) {
     // It's a common error to not have a trailing slash on the dataset path.
-    if (!dataset_path.empty() && dataset_path.back() != '/') {
+    if (!has_trailing_slash) {
       std::string fixPath = dataset_path + "/";
-      return mdio::internal::from_zmetadata(fixPath);
+      return mdio::internal::consolidated_from_zmetadata(fixPath, context);
     }
     return absl::Status(absl::StatusCode::kInvalidArgument, e.what());
   }
 
+  if (zarr3) {
+    if (!zmetadata.contains("consolidated_metadata") ||
+        !zmetadata["consolidated_metadata"].contains("metadata")) {
+      return absl::Status(absl::StatusCode::kInvalidArgument,
+                          "zarr.json does not contain consolidated metadata.");
+    }
+    // Reshape into the Zarr v2 layout, one ".zarray" key per array.
+    ::nlohmann::json consolidated;
+    consolidated[".zattrs"] =
+        zmetadata.value("attributes", ::nlohmann::json::object());
+    for (auto& item :
+         zmetadata["consolidated_metadata"]["metadata"].items()) {
+      if (item.value().value("node_type", "") == "array") {
+        consolidated[item.key() + "/.zarray"] = item.value();
+      }
+    }
+    zmetadata = ::nlohmann::json{{"metadata", consolidated}};
+  }
+
   if (!zmetadata.contains("metadata")) {
     return absl::Status(absl::StatusCode::kInvalidArgument,
                         "zmetadata does not contain metadata.");
@@ -363,6 +630,7 @@ from_zmetadata(const std::string& dataset_path) {
   // Remove .zattrs from metadata
   zmetadata["metadata"].erase(".zattrs");
   std::vector<nlohmann::json> json_vars_from_zmeta;
+  std::vector<nlohmann::json> consolidated_vars;
   // Assemble a list of json for opening the variables in the dataset.
   for (auto& element : zmetadata["metadata"].items()) {
     // FIXME - remove hard code .zarray
@@ -370,14 +638,24 @@ from_zmetadata(const std::string& dataset_path) {
       std::string variable_name =
           element.key().substr(0, element.key().find("/"));
       nlohmann::json new_dict = {
-          {"driver", "zarr"},
+          {"driver", zarr3 ? "zarr3" : "zarr"},
           {"kvstore",
            {{"driver", driver}, {"path", dataset_path + "/" + variable_name}}}};
       if (driver != "file") {
         new_dict["kvstore"]["bucket"] = bucket;
         new_dict["kvstore"]["path"] = cloudPath + variable_name;
+        ApplyRequestPolicy(new_dict["kvstore"]);
       }
       json_vars_from_zmeta.push_back(new_dict);
+      // Zarr v3 keeps the attributes with the array metadata.
+      consolidated_vars.push_back(
+          {{"name", variable_name},
+           {"zarray", element.value()},
+           {"zattrs",
+            zarr3 ? element.value().value("attributes",
+                                          nlohmann::json::object())
+                  : zmetadata["metadata"].value(variable_name + "/.zattrs",
+                                                nlohmann::json::object())}});
     }
   }
   if (!json_vars_from_zmeta.size()) {
@@ -385,15 +663,350 @@ from_zmetadata(const std::string& dataset_path) {
                         "Not variables found in zmetadata.");
   }
 
-  return tensorstore::ReadyFuture<
-      std::tuple<::nlohmann::json, std::vector<::nlohmann::json>>>(
-      std::make_tuple(dataset_metadata, json_vars_from_zmeta));
+  const auto& generation = kvs_read_result.value().stamp.generation;
+  ConsolidatedMemo::Consolidated consolidated{
+      dataset_metadata, json_vars_from_zmeta, consolidated_vars, generation};
+  if (!tensorstore::StorageGeneration::IsUnknown(generation) &&
+      !tensorstore::StorageGeneration::IsNoValue(generation)) {
+    std::lock_guard<std::mutex> lock(memo.mutex);
+    if (memo.entries.size() >= ConsolidatedMemo::kMaxEntries) {
+      memo.entries.clear();
+    }
+    memo.entries.insert_or_assign(
+        dataset_path,
+        ConsolidatedMemo::Entry{zarr3 ? "zarr.json" : ".zmetadata",
+                                consolidated});
+  }
+  return tensorstore::MakeReadyFuture<ConsolidatedMemo::Consolidated>(
+      std::move(consolidated));
+}
+
+/**
+ * @brief Retrieves the .zmetadata for the dataset.
+ * This is for executing a read on the dataset's consolidated metadata.
+ * It will also attempt to infer the driver based on the prefix of the path.
+ * It will default to the "file" driver if no prefix is found.
+ * @param dataset_path The path to the dataset.
+ * @param context The Context to read in, the default one if null.
+ * @return An `mdio::Future` containing the .zmetadata JSON on success, or an
+ * error on failure.
+ */
+Future<std::tuple<::nlohmann::json, std::vector<::nlohmann::json>>>
+from_zmetadata(const std::string& dataset_path,
+               const Context& context = Context()) {
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [](const std::tuple<::nlohmann::json, std::vector<::nlohmann::json>,
+                          std::vector<::nlohmann::json>,
+                          tensorstore::StorageGeneration>& consolidated) {
+        return std::make_tuple(std::get<0>(consolidated),
+                               std::get<1>(consolidated));
+      },
+      consolidated_from_zmetadata(dataset_path, context));
+}
+
+/**
+ * @brief Shared state for `ForEachBounded`.
+ * Keeps the launch callable and the completion promise alive until every
+ * operation has finished.
+ */
+template <typename Launch>
+struct BoundedFanOutState {
+  BoundedFanOutState(std::size_t count, Launch&& launch,
+                     tensorstore::Promise<void> promise)
+      : remaining(count),
+        count(count),
+        launch(std::move(launch)),
+        promise(std::move(promise)) {}
+
+  std::mutex mutex;
+  std::size_t next = 0;
+  std::size_t remaining;
+  const std::size_t count;
+  Launch launch;
+  tensorstore::Promise<void> promise;
+};
+
+/**
+ * @brief Records the completion of one operation.
+ * @return True if there is still work outstanding.
+ */
+template <typename Launch>
+bool CompleteBounded(const std::shared_ptr<BoundedFanOutState<Launch>>& state,
+                     const absl::Status& status) {
+  if (!status.ok()) {
+    // Only the first error is kept, later results are ignored.
+    state->promise.SetResult(status);
+    return false;
+  }
+  bool done;
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    done = --state->remaining == 0;
+  }
+  if (done) {
+    state->promise.SetResult(absl::OkStatus());
+  }
+  return !done;
+}
+
+/**
+ * @brief Launches operations one at a time until one has to be waited on.
+ * Operations that complete immediately are handled in the loop rather than by
+ * recursion so that large fan-outs do not grow the stack.
+ */
+template <typename Launch>
+void PumpBounded(std::shared_ptr<BoundedFanOutState<Launch>> state) {
+  while (true) {
+    std::size_t index;
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      if (state->next >= state->count || !state->promise.result_needed()) {
+        return;
+      }
+      index = state->next++;
+    }
+    Future<void> future = state->launch(index);
+    if (future.ready()) {
+      if (!CompleteBounded(state, future.status())) {
+        return;
+      }
+      continue;
+    }
+    future.ExecuteWhenReady(
+        [state](tensorstore::ReadyFuture<void> readyFut) {
+          if (CompleteBounded(state, readyFut.status())) {
+            PumpBounded(state);
+          }
+        });
+    return;
+  }
+}
+
+/**
+ * @brief Runs `count` asynchronous operations, keeping at most
+ * `max_in_flight` of them outstanding at any time.
+ * Launching stops at the first error, which becomes the result.
+ * @param count The number of operations to run.
+ * @param max_in_flight The maximum number of outstanding operations, 0 means
+ * all of them at once.
+ * @param launch Callable of signature `Future<void>(std::size_t index)`.
+ * @return A future that is ready once every operation has completed.
+ */
+template <typename Launch>
+Future<void> ForEachBounded(std::size_t count, std::size_t max_in_flight,
+                            Launch&& launch) {
+  if (count == 0) {
+    return absl::OkStatus();
+  }
+  if (max_in_flight == 0 || max_in_flight > count) {
+    max_in_flight = count;
+  }
+  using LaunchT = std::decay_t<Launch>;
+  auto pair = tensorstore::PromiseFuturePair<void>::Make();
+  auto state = std::make_shared<BoundedFanOutState<LaunchT>>(
+      count, LaunchT(std::forward<Launch>(launch)), std::move(pair.promise));
+  for (std::size_t i = 0; i < max_in_flight; ++i) {
+    PumpBounded(state);
+  }
+  return pair.future;
+}
+
+/**
+ * @brief Gets the structured dtype of a Variable and the spec that opens one
+ * of its fields.
+ * The spec keeps the metadata of the open store and doesn't recheck it, so
+ * opening it in the Context of the open store is served from the metadata
+ * cache instead of the kvstore.
+ * @param var A Variable with a structured Zarr v2 dtype.
+ * @param field The field to select, or "" for the raw bytes of each record.
+ * @return The spec and the parsed dtype, or an error if the Variable isn't
+ * structured or doesn't have the field.
+ */
+inline Result<
+    std::pair<::nlohmann::json, tensorstore::internal_zarr::ZarrDType>>
+struct_field_spec(const Variable<>& var, const std::string& field) {
+  MDIO_ASSIGN_OR_RETURN(
+      auto spec,
+      var.get_store().spec(tensorstore::ContextBindingMode::strip))
+  MDIO_ASSIGN_OR_RETURN(auto json, spec.ToJson(IncludeDefaults{}))
+  if (!json.contains("metadata") || !json["metadata"].contains("dtype") ||
+      !json["metadata"]["dtype"].is_array()) {
+    return absl::Status(absl::StatusCode::kInvalidArgument,
+                        "Variable '" + var.get_variable_name() +
+                            "' is not a structured dtype.");
+  }
+  MDIO_ASSIGN_OR_RETURN(
+      auto dtype,
+      tensorstore::internal_zarr::ParseDType(json["metadata"]["dtype"]))
+  if (!field.empty() &&
+      std::none_of(dtype.fields.begin(), dtype.fields.end(),
+                   [&field](const auto& f) { return f.name == field; })) {
+    return absl::Status(absl::StatusCode::kInvalidArgument,
+                        "Field: '" + field + "' not found in Variable '" +
+                            var.get_variable_name() + "'.");
+  }
+  // The view of the open store doesn't apply to the other fields.
+  for (const char* key : {"dtype", "rank", "schema", "transform", "field"}) {
+    json.erase(key);
+  }
+  if (!field.empty()) {
+    json["field"] = field;
+  }
+  json["recheck_cached_metadata"] = false;
+  return std::make_pair(std::move(json), std::move(dtype));
+}
+
+/**
+ * @brief Opens a field of a structured Variable over the same region.
+ * The labels and intervals of `var` are kept, apart from the byte dimension of
+ * a raw record view. The attributes are shared with `var` rather than read
+ * again.
+ * @param var The Variable to select the field from.
+ * @param spec A spec from `struct_field_spec`.
+ * @param context The Context `var` was opened in.
+ */
+template <typename T = void, DimensionIndex R = dynamic_rank,
+          ReadWriteMode M = ReadWriteMode::dynamic>
+Future<Variable<T, R, M>> open_struct_field(const Variable<>& var,
+                                            const ::nlohmann::json& spec,
+                                            const Context& context) {
+  MDIO_ASSIGN_OR_RETURN(auto intervals, var.get_intervals())
+  // The byte dimension of the records is the only unlabeled one.
+  intervals.erase(
+      std::remove_if(intervals.begin(), intervals.end(),
+                     [](const auto& interval) {
+                       return interval.label.label().empty();
+                     }),
+      intervals.end());
+
+  auto store_future =
+      context ? tensorstore::Open<T, R, M>(spec, context, constants::kOpen)
+              : tensorstore::Open<T, R, M>(spec, constants::kOpen);
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [var, intervals](const tensorstore::TensorStore<T, R, M>& store)
+          -> Result<Variable<T, R, M>> {
+        tensorstore::TensorStore<T, R, M> view = store;
+        for (std::size_t i = 0; i < intervals.size(); ++i) {
+          const auto& interval = intervals[i];
+          MDIO_ASSIGN_OR_RETURN(
+              view, view | tensorstore::Dims(i).Label(
+                                   std::string(interval.label.label())) |
+                        tensorstore::Dims(i).HalfOpenInterval(
+                            interval.inclusive_min, interval.exclusive_max))
+        }
+        return Variable<T, R, M>{var.get_variable_name(), var.get_long_name(),
+                                 var.getReducedMetadata(), view,
+                                 var.attributes};
+      },
+      std::move(store_future));
+}
+
+/**
+ * @brief Copies one field out of a read of raw structured records.
+ * @param records The records, with the bytes of each one as the last
+ * dimension.
+ * @param field The field of the records' dtype to copy.
+ * @return The field's values over the other dimensions of the records.
+ */
+inline Result<VariableData<>> decode_struct_field(
+    const VariableData<>& records,
+    const tensorstore::internal_zarr::ZarrDType::Field& field) {
+  if (!field.field_shape.empty()) {
+    return absl::Status(
+        absl::StatusCode::kUnimplemented,
+        "Field: '" + field.name + "' has a sub-array dtype, select it with "
+                                  "SelectField instead.");
+  }
+  const auto& bytes = records.data.data;
+  const DimensionIndex rank = bytes.rank() - 1;
+  if (rank < 0 || bytes.shape()[rank] < field.byte_offset + field.num_bytes) {
+    return absl::Status(absl::StatusCode::kInvalidArgument,
+                        "Records don't contain field: '" + field.name + "'.");
+  }
+
+  std::vector<Index> origin(bytes.origin().begin(),
+                            bytes.origin().begin() + rank);
+  std::vector<Index> shape(bytes.shape().begin(), bytes.shape().begin() + rank);
+  std::vector<std::string> labels;
+  for (DimensionIndex d = 0; d < rank; ++d) {
+    labels.emplace_back(records.data.domain.labels()[d]);
+  }
+  MDIO_ASSIGN_OR_RETURN(auto domain, tensorstore::IndexDomainBuilder<>(rank)
+                                         .origin(origin)
+                                         .shape(shape)
+                                         .labels(labels)
+                                         .Finalize())
+  auto values =
+      tensorstore::AllocateArray(tensorstore::BoxView<>(origin, shape),
+                                 tensorstore::c_order,
+                                 tensorstore::default_init, field.dtype);
+
+  const auto* source = static_cast<const std::byte*>(
+      static_cast<const void*>(bytes.byte_strided_origin_pointer().get()));
+  auto* target =
+      static_cast<std::byte*>(values.byte_strided_origin_pointer().get());
+  const Index byte_stride = bytes.byte_strides()[rank];
+  const Index item_bytes = field.dtype.size();
+  const bool swap = field.endian != tensorstore::endian::native;
+  const Index count = values.num_elements();
+  std::vector<Index> position(rank, 0);
+  for (Index n = 0; n < count; ++n) {
+    const std::byte* record = source;
+    for (DimensionIndex d = 0; d < rank; ++d) {
+      record += position[d] * bytes.byte_strides()[d];
+    }
+    std::byte* value = target + n * field.num_bytes;
+    for (Index b = 0; b < field.num_bytes; ++b) {
+      value[b] = record[(field.byte_offset + b) * byte_stride];
+    }
+    if (swap && item_bytes > 1) {
+      for (Index e = 0; e < field.num_bytes; e += item_bytes) {
+        std::reverse(value + e, value + e + item_bytes);
+      }
+    }
+    // Advance to the next record in C order.
+    for (DimensionIndex d = rank - 1; d >= 0; --d) {
+      if (++position[d] < shape[d]) {
+        break;
+      }
+      position[d] = 0;
+    }
+  }
+
+  LabeledArray<void, dynamic_rank, offset_origin> labeled{domain, values};
+  return VariableData<>{records.variableName, records.longName,
+                        records.metadata, labeled};
 }
 }  // namespace internal
 
 using coordinate_map =
     std::unordered_map<std::string, std::vector<std::string>>;
 
+namespace internal {
+
+/**
+ * @brief Checks if a Variable is a coordinate, either named after a dimension
+ * or listed as a coordinate by a Variable.
+ */
+inline bool IsCoordinate(const std::string& name,
+                         const coordinate_map& coordinates,
+                         const tensorstore::IndexDomain<>& domain) {
+  const auto labels = domain.labels();
+  if (std::find(labels.begin(), labels.end(), name) != labels.end()) {
+    return true;
+  }
+  for (const auto& [variable, names] : coordinates) {
+    if (std::find(names.begin(), names.end(), name) != names.end()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace internal
+
 /**
  * @brief The Dataset class
  * The dataset represents a collection of variables sharing a common grid.
@@ -403,18 +1016,21 @@ class Dataset {
   Dataset(const nlohmann::json& metadata, const VariableCollection& variables,
           const coordinate_map& coordinates,
           const tensorstore::IndexDomain<>& domain)
-      : metadata(metadata),
-        variables(variables),
-        coordinates(coordinates),
-        domain(domain) {}
+      : Dataset(std::make_shared<const nlohmann::json>(metadata), variables,
+                coordinates, domain) {}
 
   friend std::ostream& operator<<(std::ostream& os, const Dataset& dataset) {
     // Output metadata
-    os << "Metadata: " << dataset.metadata.dump(4) << "\n";
+    os << "Metadata: " << dataset.metadata->dump(4) << "\n";
 
     // Output variables
     const auto keys = dataset.variables.get_iterable_accessor();
     for (const auto& key : keys) {
+      // Printing doesn't open the Variables of a lazily opened Dataset.
+      if (!dataset.variables.is_open(key)) {
+        os << "Variable: " << key << " - Not opened\n";
+        continue;
+      }
       os << "Variable: " << key
          << " - Dimensions: " << dataset.variables.at(key).value().dimensions()
          << "\n";
@@ -533,50 +1149,27 @@ class Dataset {
    */
   template <typename... Descriptors>
   Result<Dataset> isel(Descriptors&... descriptors) {
-    VariableCollection vars;
-
-    // the shape of the new domain
-    std::map<std::string, tensorstore::IndexDomainDimension<>> dims;
-    std::vector<std::string> keys = variables.get_iterable_accessor();
-
-    for (const auto& name : keys) {
-      MDIO_ASSIGN_OR_RETURN(auto variable,
-                            variables.at(name).value().slice(
-                                std::forward<Descriptors>(descriptors)...))
-      // add to variable
-      vars.add(name, variable);
-
-      // FIXME - check consistent dims ...
-      DimensionIndex idx = 0;
-      for (const auto label : variable.get_store().domain().labels()) {
-        // structarrays must have a byte dimension.
-        if (!label.empty()) {
-          dims[label] = variable.get_store().domain()[idx];
-        }
-        ++idx;
-      }
-    }
-
-    size_t size = dims.size();
-    std::vector<std::string> labels(size);
-    std::vector<Index> origin(size);
-    std::vector<Index> shape(size);
-
-    DimensionIndex idx = 0;
-    for (const auto& [key, val] : dims) {
-      labels[idx] = key;
-      origin[idx] = val.interval().inclusive_min();
-      shape[idx] = val.interval().size();
-      ++idx;
+    if constexpr (sizeof...(Descriptors) == 0) {
+      return *this;
+    } else {
+      return isel(std::vector<RangeDescriptor<Index>>{
+          RangeDescriptor<Index>(descriptors)...});
     }
+  }
 
-    MDIO_ASSIGN_OR_RETURN(auto new_domain,
-                          tensorstore::IndexDomainBuilder<>(size)
-                              .origin(origin)
-                              .shape(shape)
-                              .labels(labels)
-                              .Finalize())
-    return Dataset{metadata, vars, coordinates, new_domain};
+  /**
+   * @brief Performs an indexed slice on the Dataset with a runtime number of
+   * descriptors.
+   * A dimension may be described more than once, in which case the ranges are
+   * selected in the order given and concatenated along that dimension. Every
+   * Variable is sliced once, regardless of the number of descriptors.
+   * @param slices The descriptors to use for the slice.
+   * @return An `mdio::Result` containing a sliced Dataset if successful, or an
+   * error if the slice is invalid.
+   */
+  Result<Dataset> isel(const std::vector<RangeDescriptor<Index>>& slices) {
+    internal::Span span("mdio.Dataset.isel");
+    return span.End(_isel(slices));
   }
 
   /**
@@ -588,73 +1181,6 @@ class Dataset {
                                   typename outer_type<Rest>::type>);
   }
 
-  // Generate an index sequence
-  template <size_t... I>
-  struct index_sequence {};
-
-  template <size_t N, size_t... I>
-  struct make_index_sequence : make_index_sequence<N - 1, N - 1, I...> {};
-
-  template <size_t... I>
-  struct make_index_sequence<0, I...> : index_sequence<I...> {};
-
-  // Function to call `isel` with a parameter pack expanded from the vector
-  /**
-   * @brief Internal use only.
-   * Calls the `isel` method with a parameter pack expanded from the vector.
-   */
-  template <std::size_t... I>
-  Result<Dataset> call_isel_with_vector_impl(
-      const std::vector<RangeDescriptor<Index>>& slices,
-      std::index_sequence<I...>) {
-    return isel(slices[I]...);
-  }
-
-  // Wrapper function that generates the index sequence
-  /**
-   * @brief This version of isel is only expected to be used interally.
-   * Documentation is provided for clarity and usage in the case where
-   * the number of descriptors cannot be known at compile time.
-   * Calls the `isel` method with a vector of `RangeDescriptor` objects.
-   * Limited to `internal::kMaxNumSlices` slices which may not be equal to the
-   * number of descriptors.
-   */
-  Result<Dataset> isel(const std::vector<RangeDescriptor<Index>>& slices) {
-    if (slices.empty()) {
-      return absl::InvalidArgumentError("No slices provided.");
-    }
-
-    // 1) Group descriptors by their dimension label
-    std::map<std::string_view, std::vector<RangeDescriptor<Index>>> groups;
-    for (auto& desc : slices) {
-      groups[desc.label.label()].push_back(desc);
-    }
-
-    // 2) Walk through each dimension-group and break it into kMax-sized windows
-    Dataset current = *this;
-    for (auto& [label, descs] : groups) {
-      for (size_t i = 0; i < descs.size(); i += internal::kMaxNumSlices) {
-        size_t end = std::min(i + internal::kMaxNumSlices, descs.size());
-        std::vector<RangeDescriptor<Index>> window(descs.begin() + i,
-                                                   descs.begin() + end);
-
-        // 3) Pad this window up to kMax (if your impl still needs padding)
-        window.reserve(internal::kMaxNumSlices);
-        for (size_t p = window.size(); p < internal::kMaxNumSlices; ++p) {
-          window.emplace_back(
-              RangeDescriptor<Index>{internal::kInertSliceKey, 0, 1, 1});
-        }
-
-        MDIO_ASSIGN_OR_RETURN(
-            current,
-            current.call_isel_with_vector_impl(
-                window, std::make_index_sequence<internal::kMaxNumSlices>{}));
-      }
-    }
-
-    return current;
-  }
-
   /**
    * @brief Internal use only.
    * Converts the `sel` descriptors to their `isel` equivalents.
@@ -677,50 +1203,92 @@ class Dataset {
         return trueStatus;
       }
       auto var = varRes.value();
+
+      // Prefer the persisted index, any failure falls back to a full scan.
+      auto indexRes = internal::ReadCoordinateIndex<ValueType>(var).result();
+      if (indexRes.ok() && indexRes.value().has_value()) {
+        const auto& index = *indexRes.value();
+        auto& indices = label_to_indices[descriptor.label.label()];
+        if constexpr ((std::is_same_v<
+                           Descriptors,
+                           ListDescriptor<typename Descriptors::type>> &&
+                       ...)) {
+          std::set<ValueType> values;
+          for (auto val : descriptor.values) {
+            if (!values.insert(val).second || index.count(val) > 1) {
+              trueStatus = absl::InvalidArgumentError(
+                  "Repeated value found in ListDescriptor.");
+              return trueStatus;
+            }
+            auto runs = index.find(val);
+            if (runs.empty()) {
+              trueStatus = absl::InvalidArgumentError(
+                  "Value not found in ListDescriptor.");
+              return trueStatus;
+            }
+            indices.push_back(runs[0].start);
+          }
+        } else {
+          for (const auto& run : index.find(descriptor.value)) {
+            for (Index i = run.start; i < run.stop; ++i) {
+              indices.push_back(i);
+            }
+          }
+        }
+        return absl::OkStatus();
+      }
+
       auto varFut = var.Read();
       if (!varFut.status().ok()) {
         trueStatus = varFut.status();
         return trueStatus;
       }
       auto varDat = varFut.value();
-      auto varAccessor = varDat.get_data_accessor();
-
-      std::vector<Index> indices;
       auto offset = varDat.get_flattened_offset();
+      const ValueType* data = varDat.get_data_accessor().data();
+      const Index end = var.num_samples() + offset;
       if constexpr ((std::is_same_v<
                          Descriptors,
                          ListDescriptor<typename Descriptors::type>> &&
                      ...)) {
-        std::set<ValueType> values;
-        for (auto val : descriptor.values) {
-          if (values.count(val) > 0) {
+        // Map each wanted value to its position in the list so the coordinate
+        // only has to be streamed once.
+        constexpr Index kNotFound = -1;
+        std::unordered_map<ValueType, std::size_t> wanted;
+        wanted.reserve(descriptor.values.size());
+        for (std::size_t k = 0; k < descriptor.values.size(); ++k) {
+          if (!wanted.emplace(descriptor.values[k], k).second) {
             trueStatus = absl::InvalidArgumentError(
                 "Repeated value found in ListDescriptor.");
             return trueStatus;
           }
-          values.insert(val);
-          bool found = false;
-          for (Index i = offset; i < var.num_samples() + offset; ++i) {
-            if (varAccessor({i}) == val) {
-              if (found) {
-                trueStatus = absl::InvalidArgumentError(
-                    "Repeated value found in ListDescriptor.");
-                return trueStatus;
-              }
-              label_to_indices[descriptor.label.label()].push_back(i);
-              found = true;
-            }
+        }
+        std::vector<Index> found(descriptor.values.size(), kNotFound);
+        for (Index i = offset; i < end; ++i) {
+          auto it = wanted.find(data[i]);
+          if (it == wanted.end()) {
+            continue;
+          }
+          if (found[it->second] != kNotFound) {
+            trueStatus = absl::InvalidArgumentError(
+                "Repeated value found in ListDescriptor.");
+            return trueStatus;
           }
-          if (!found) {
+          found[it->second] = i;
+        }
+        auto& indices = label_to_indices[descriptor.label.label()];
+        for (auto i : found) {
+          if (i == kNotFound) {
             trueStatus = absl::InvalidArgumentError(
                 "Value not found in ListDescriptor.");
             return trueStatus;
           }
+          indices.push_back(i);
         }
       } else {
         // We must check for every occurance of the value
-        for (Index i = offset; i < var.num_samples() + offset; ++i) {
-          if (varAccessor({i}) == descriptor.value) {
+        for (Index i = offset; i < end; ++i) {
+          if (data[i] == descriptor.value) {
             label_to_indices[descriptor.label.label()].push_back(i);
           }
         }
@@ -748,254 +1316,9 @@ class Dataset {
    */
   template <typename... Descriptors>
   Result<Dataset> sel(Descriptors... descriptors) {
-    /*
-    Case 1: ValueDescriptor with repeated values: Get all occurrences of the
-    value Case 2: ListDescriptor with repeated values (single element): Return
-    Invalid Reindexing error Case 3: ListDescriptor with repeated values
-    (multiple elements): Return Invalid Reindexing error (Case 2) Case 4: Same
-    as Case 1 Case 5: RangeDescriptor with repeated values: Return Invalid
-    Reindexing error Case 6: RangeDescriptor with unique values: Get the range
-    from start to stop, include everything in-between
-
-    Case fail: label is not 1D
-    Case fail: label is repeated. This is a dictionary in xarray, so not
-    allowed.
-    */
-
-    /*
-    Valid cases:
-      Case 1: ValueDescriptor with unique value: Get the single value.
-        No error state.
-        Get the index and convert to conventional isel.
-      Case 2: ValueDescriptor with non-unique value: Get all occurrences of the
-    value. No error state. Case 3: ListDescriptor with unique values: Get the
-    individual values. Error state for repeated values. Case 4: RangeDescriptor
-    with unique start and stop values: Get the range from start to stop, include
-    everything in-between. Error state for repeated start/stop values. Any
-    repeated values that are not start/stop are fair game. Get the start and
-    stop indicies and create a single isel.
-    */
-
-    // Check that all descriptors are of the same outer type
-    if (!are_same<Descriptors...>()) {
-      return absl::InvalidArgumentError(
-          "All descriptors must be of the same type.");
-    }
-
-    // Validate each descriptor (for example, ListDescriptor not yet supported)
-    auto validateDescriptors = [this](auto& descriptor) {
-      using DescriptorType = typename outer_type<decltype(descriptor)>::type;
-      if constexpr (std::is_same_v<
-                        std::remove_reference_t<DescriptorType>,
-                        ListDescriptor<typename std::remove_reference_t<
-                            decltype(descriptor)>::type>>) {
-        return absl::UnimplementedError(
-            "Support for ListDescriptor is not yet implemented.");
-      }
-      // TODO(BrianMichell): Remove this check when SliceDescriptor is removed
-      if constexpr (std::is_same_v<DescriptorType, SliceDescriptor>) {
-        return absl::InvalidArgumentError(
-            "SliceDescriptor is deprecated and will be removed in future "
-            "versions. Please use RangeDescriptor instead.\nThe sel method "
-            "does not support SliceDescriptor.");
-      }
-
-      MDIO_ASSIGN_OR_RETURN(
-          auto var, variables.at(std::string(descriptor.label.label())));
-      if (var.dimensions().rank() != 1) {
-        return absl::InvalidArgumentError("Label must be 1D.");
-      }
-
-      return absl::OkStatus();
-    };
-
-    std::set<std::string_view> labels;
-
-    // Call validateDescriptors for each descriptor
-    {
-      // Manage the scope of status
-      absl::Status status;
-      for (auto& descriptor : {descriptors...}) {
-        status = validateDescriptors(descriptor);
-        if (!status.ok()) {
-          return status;
-        }
-        if (labels.count(descriptor.label.label()) > 0) {
-          return absl::InvalidArgumentError("Label must not be repeated.");
-        }
-        if (descriptor.label.index() !=
-            std::numeric_limits<DimensionIndex>::max()) {
-          return absl::InvalidArgumentError(
-              "Expected label to be a dimension name but got an index.");
-        }
-        labels.insert(descriptor.label.label());
-      }
-    }
-
-    // Check if the descriptors are of type ValueDescriptor
-    if constexpr ((std::is_same_v<
-                       Descriptors,
-                       ValueDescriptor<typename Descriptors::type>> &&
-                   ...)) {
-      auto slicer = descriptor_to_index(descriptors...);
-      if (!slicer.status().ok()) {
-        return slicer.status();
-      }
-
-      auto label_to_indices = slicer.value();
-
-      // Build out the slice descriptors
-      std::vector<RangeDescriptor<Index>> slices;
-      for (auto& elem : label_to_indices) {
-        auto size = elem.second.size();
-        for (int i = 0; i < size; ++i) {
-          slices.emplace_back(RangeDescriptor<Index>(
-              {elem.first, elem.second[i], elem.second[i] + 1, 1}));
-        }
-      }
-
-      if (slices.empty()) {
-        return absl::InvalidArgumentError(
-            "No slices could be made from the given descriptors.");
-      }
-      // The map 'label_to_indices' is now populated with all the relevant
-      // indices. You can now proceed with further processing based on this map.
-
-      return isel(
-          static_cast<const std::vector<RangeDescriptor<Index>>&>(slices));
-    } else if constexpr ((std::is_same_v</*NOLINT: readability/braces*/
-                                         Descriptors,
-                                         ListDescriptor<
-                                             typename Descriptors::type>> &&
-                          ...)) {
-      auto slicer = descriptor_to_index(descriptors...);
-      if (!slicer.status().ok()) {
-        return slicer.status();
-      }
-
-      auto label_to_indices = slicer.value();
-
-      // Build out the slice descriptors
-      std::vector<RangeDescriptor<Index>> slices;
-      for (auto& elem : label_to_indices) {
-        auto size = elem.second.size();
-        for (int i = 0; i < size; ++i) {
-          slices.emplace_back(RangeDescriptor<Index>(
-              {elem.first, elem.second[i], elem.second[i] + 1, 1}));
-        }
-      }
-
-      if (slices.empty()) {
-        return absl::InvalidArgumentError(
-            "No slices could be made from the given descriptors.");
-      }
-      // The map 'label_to_indices' is now populated with all the relevant
-      // indices. You can now proceed with further processing based on this map.
-
-      return isel(
-          static_cast<const std::vector<RangeDescriptor<Index>>&>(slices));
-    } else {
-      std::map<std::string_view, std::pair<Index, Index>>
-          label_to_range;  // pair.first = start, pair.second = stop
-      absl::Status trueStatus =
-          absl::OkStatus();  // A hack to allow for true error status return.
-
-      auto processDescriptor = [this, &label_to_range,
-                                &trueStatus](auto& descriptor) -> absl::Status {
-        using ValueType =
-            typename extract_descriptor_Ttype<decltype(descriptor)>::type;
-
-        if (descriptor.start == descriptor.stop) {
-          trueStatus = absl::InvalidArgumentError(
-              "Start and stop values must be different.");
-          return trueStatus;
-        }
-
-        auto varRes =
-            variables.get<ValueType>(std::string(descriptor.label.label()));
-        if (!varRes.status().ok()) {
-          trueStatus = varRes.status();
-          return trueStatus;
-        }
-        auto var = varRes.value();
-        auto varFut = var.Read();
-        if (!varFut.status().ok()) {
-          trueStatus = varFut.status();
-          return trueStatus;
-        }
-        auto varDat = varFut.value();
-        auto varAccessor = varDat.get_data_accessor();
-
-        std::pair<bool, Index> start = {false, 0};
-        std::pair<bool, Index> stop = {false, 0};
-        auto offset = varDat.get_flattened_offset();
-
-        for (Index i = offset; i < var.num_samples() + offset; i++) {
-          if (varAccessor({i}) == descriptor.start) {
-            if (start.first) {
-              trueStatus = absl::InvalidArgumentError("Repeated start value.");
-              return trueStatus;
-            }
-            start = {true, i};
-          }
-          if (varAccessor({i}) == descriptor.stop) {
-            if (stop.first) {
-              trueStatus = absl::InvalidArgumentError("Repeated stop value.");
-              return trueStatus;
-            }
-            stop = {true, i};
-          }
-        }
-
-        if (!start.first) {
-          trueStatus = absl::InvalidArgumentError("Start value not found.");
-          return trueStatus;
-        }
-        if (!stop.first) {
-          trueStatus = absl::InvalidArgumentError("Stop value not found.");
-          return trueStatus;
-        }
-
-        // Xarray behavior is to effectively remove the Variable in this case.
-        if (start.second >= stop.second) {
-          trueStatus = absl::UnimplementedError(
-              "Start value happens after stop value. This is not a supported "
-              "case.");
-          return trueStatus;
-        }
-        // This case should be caught by the earlier check, but it's here for
-        // completeness.
-        if (label_to_range.count(descriptor.label.label()) > 0) {
-          trueStatus =
-              absl::InvalidArgumentError("Label must not be repeated.");
-          return trueStatus;
-        }
-        label_to_range[descriptor.label.label()] = {start.second, stop.second};
-        return absl::OkStatus();
-      };
-
-      auto status = (processDescriptor(descriptors).ok() && ...);
-      if (!status) {
-        return trueStatus;
-      }
-
-      std::vector<RangeDescriptor<Index>> slices;
-      for (auto& elem : label_to_range) {
-        slices.emplace_back(RangeDescriptor<Index>(
-            {elem.first, elem.second.first, elem.second.second + 1, 1}));
-      }
-
-      if (slices.empty()) {
-        return absl::InvalidArgumentError(
-            "No slices could be made from the given descriptors.");
-      }
-
-      return isel(
-          static_cast<const std::vector<RangeDescriptor<Index>>&>(slices));
-    }
-
-    return absl::OkStatus();
-  }
+    internal::Span span("mdio.Dataset.sel");
+    return span.End(_sel(descriptors...));
+  }
 
   /**
    * @brief Performs a label-based slice on the Dataset
@@ -1031,7 +1354,7 @@ class Dataset {
       coords = {{label, coordinates.at(label)}};
     }
 
-    return Dataset{metadata, vars, coords, domain};
+    return Dataset{metadata, vars, coords, domain, context, zmetadata_cache};
   }
 
   /**
@@ -1059,43 +1382,183 @@ class Dataset {
                           "Open from path is only valid in open-mode.");
     }
 
-    MDIO_ASSIGN_OR_RETURN(auto params_from_zmetadata,
-                          mdio::internal::from_zmetadata(dataset_path).result())
-    auto [dataset_metadata, json_vars] = params_from_zmetadata;
-
-    return mdio::Dataset::Open(dataset_metadata, json_vars,
-                               std::forward<Option>(options)...);
+    internal::Span span("mdio.Dataset.Open");
+    span.Attribute("mdio.path", dataset_path);
+    auto consolidated = mdio::internal::consolidated_from_zmetadata(
+                            dataset_path, transact_options.context)
+                            .result();
+    if (!consolidated.ok()) {
+      span.End(consolidated.status());
+      return consolidated.status();
+    }
+    auto [dataset_metadata, json_vars, layouts, generation] =
+        consolidated.value();
+
+    // Later commits only replace the consolidated metadata that was read.
+    return span.End(tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [generation = generation](Dataset& dataset) {
+          dataset.zmetadata_cache->generation = generation;
+          return dataset;
+        },
+        mdio::Dataset::Open(dataset_metadata, json_vars,
+                            std::forward<Option>(options)...)));
   }
 
   /**
-   * @brief Opens the Dataset from a constructed JSON schema.
-   * This method should be used in conjunction with the dataset_factory
-   * Construct function. It expects a fully valid metadata and vector of MDIO
-   * compliant Variable specs.
-   * @param metadata The metadata for the dataset.
-   * @param json_variables A vector of correctly constructed Variable specs.
-   * @return An `mdio::Result` containing a Dataset if successful, or an error
-   * if the schema is invalid.
+   * @brief Opens a Dataset from a file path without opening its Variables.
+   * Only the consolidated metadata is read. Each Variable is opened the first
+   * time it is retrieved from `variables` and then kept, so a Dataset with
+   * many Variables on a cloud store opens in a single round trip.
+   * @param dataset_path The path to the dataset.
+   * @details \b Usage
+   * @code
+   * MDIO_ASSIGN_OR_RETURN(auto ds, mdio::Dataset::OpenLazy(
+   *      dataset_path, mdio::constants::kOpen).result());
+   * // Only now is "seismic" opened
+   * MDIO_ASSIGN_OR_RETURN(auto seismic, ds.variables.get<float>("seismic"));
+   * @endcode
+   * @return An `mdio::Future` containing a Dataset if successful, or an error
+   * if the path is invalid. Errors opening a Variable are reported when it is
+   * retrieved.
    */
   template <typename... Option>
-  static Future<Dataset> Open(
-      const ::nlohmann::json& metadata,
-      const std::vector<::nlohmann::json>& json_variables,
-      Option&&... options) {
-    // I need to know if we are intending to create a dataset from scratch?
+  static Future<Dataset> OpenLazy(const std::string& dataset_path,
+                                  Option&&... options) {
     TENSORSTORE_INTERNAL_ASSIGN_OPTIONS_OR_RETURN(TransactionalOpenOptions,
                                                   transact_options, options)
-    bool do_create = transact_options.open_mode == constants::kCreateClean ||
-                     transact_options.open_mode == constants::kCreate;
 
-    // FIXME - publish dataset
-    std::vector<Future<mdio::Variable<>>> variables;
-    std::vector<tensorstore::Promise<void>> promises;
-    std::vector<tensorstore::AnyFuture> futures;
-    for (const auto& json : json_variables) {
-      auto pair = tensorstore::PromiseFuturePair<void>::Make();
+    if (transact_options.open_mode != constants::kOpen) {
+      return absl::Status(absl::StatusCode::kInvalidArgument,
+                          "Open from path is only valid in open-mode.");
+    }
 
-      auto var = mdio::Variable<>::Open(json, std::forward<Option>(options)...);
+    // Every Variable opens in the same Context.
+    Context context = transact_options.context ? transact_options.context
+                                               : Context::Default();
+    internal::Span span("mdio.Dataset.OpenLazy");
+    span.Attribute("mdio.path", dataset_path);
+    MDIO_ASSIGN_OR_RETURN(auto consolidated,
+                          span.End(mdio::internal::consolidated_from_zmetadata(
+                                       dataset_path, context)
+                                       .result()))
+    auto [metadata, json_vars, layouts, generation] = consolidated;
+    if (metadata.contains("api_version") && !metadata.contains("apiVersion")) {
+      return absl::Status(absl::StatusCode::kInvalidArgument,
+                          "Detected MDIO v0 dataset model " +
+                              metadata["api_version"].get<std::string>() +
+                              " but expected v1");
+    }
+
+    mdio::VariableCollection collection;
+    mdio::coordinate_map coords;
+    std::unordered_map<std::string, Index> shape_size;
+    for (std::size_t i = 0; i < json_vars.size(); ++i) {
+      const auto& layout = layouts[i];
+      const std::string name = layout["name"].get<std::string>();
+      const auto& zattrs = layout["zattrs"];
+      if (zattrs.contains("coordinates")) {
+        std::vector<std::string> coords_vec =
+            absl::StrSplit(zattrs["coordinates"].get<std::string>(), ' ');
+        coords[name] = coords_vec;
+      }
+
+      // The domain is the same as the one the opened Variables would give.
+      const auto& zarray = layout["zarray"];
+      const auto labels =
+          zattrs.value("_ARRAY_DIMENSIONS",
+                       zarray.value("dimension_names", ::nlohmann::json()));
+      const auto& shape = zarray["shape"];
+      if (!labels.is_array() || labels.size() != shape.size()) {
+        return absl::Status(
+            absl::StatusCode::kInvalidArgument,
+            "Consolidated metadata of Variable '" + name +
+                "' does not name all of its dimensions.");
+      }
+      for (std::size_t d = 0; d < shape.size(); ++d) {
+        // FIXME check that if exists shape is the same ...
+        shape_size[labels[d].get<std::string>()] = shape[d].get<Index>();
+      }
+      if (zarray.contains("dtype") && zarray["dtype"].is_array()) {
+        // Structured data types are opened with a trailing byte dimension.
+        shape_size[""] = dtype_num_bytes(zarray["dtype"]);
+      }
+    }
+
+    std::vector<std::string> keys;
+    std::vector<Index> values;
+    keys.reserve(shape_size.size());
+    values.reserve(shape_size.size());
+    for (const auto& pair : shape_size) {
+      keys.push_back(pair.first);
+      values.push_back(pair.second);
+    }
+    MDIO_ASSIGN_OR_RETURN(auto dataset_domain,
+                          tensorstore::IndexDomainBuilder<>(shape_size.size())
+                              .shape(values)
+                              .labels(keys)
+                              .Finalize())
+
+    for (std::size_t i = 0; i < json_vars.size(); ++i) {
+      const std::string name = layouts[i]["name"].get<std::string>();
+      const bool coordinate =
+          internal::IsCoordinate(name, coords, dataset_domain);
+      collection.add_lazy(name, [json = json_vars[i], context, coordinate,
+                                 options...]() -> Future<Variable<>> {
+        auto opened = mdio::Variable<>::Open(json, options..., context);
+        if (!coordinate) {
+          return opened;
+        }
+        return tensorstore::MapFutureValue(
+            tensorstore::InlineExecutor{},
+            [](Variable<>& var) {
+              var.TrackCoordinateIndex();
+              return var;
+            },
+            std::move(opened));
+      });
+    }
+
+    Dataset dataset{metadata, collection, coords, dataset_domain};
+    dataset.context = context;
+    dataset.zmetadata_cache->generation = generation;
+    return tensorstore::MakeReadyFuture<Dataset>(std::move(dataset));
+  }
+
+  /**
+   * @brief Opens the Dataset from a constructed JSON schema.
+   * This method should be used in conjunction with the dataset_factory
+   * Construct function. It expects a fully valid metadata and vector of MDIO
+   * compliant Variable specs.
+   * @param metadata The metadata for the dataset.
+   * @param json_variables A vector of correctly constructed Variable specs.
+   * @return An `mdio::Result` containing a Dataset if successful, or an error
+   * if the schema is invalid.
+   */
+  template <typename... Option>
+  static Future<Dataset> Open(
+      const ::nlohmann::json& metadata,
+      const std::vector<::nlohmann::json>& json_variables,
+      Option&&... options) {
+    // I need to know if we are intending to create a dataset from scratch?
+    TENSORSTORE_INTERNAL_ASSIGN_OPTIONS_OR_RETURN(TransactionalOpenOptions,
+                                                  transact_options, options)
+    bool do_create = transact_options.open_mode == constants::kCreateClean ||
+                     transact_options.open_mode == constants::kCreate;
+    // Without a Context from the caller the Variables still share one, so
+    // they use a single cache and I/O budget.
+    Context context = transact_options.context ? transact_options.context
+                                               : Context::Default();
+
+    // FIXME - publish dataset
+    std::vector<Future<mdio::Variable<>>> variables;
+    std::vector<tensorstore::Promise<void>> promises;
+    std::vector<tensorstore::AnyFuture> futures;
+    for (const auto& json : json_variables) {
+      auto pair = tensorstore::PromiseFuturePair<void>::Make();
+
+      // The options are reused for every Variable, so they are not forwarded.
+      auto var = mdio::Variable<>::Open(json, options..., context);
 
       // Attach a continuation to the first future
       var.ExecuteWhenReady(
@@ -1112,9 +1575,11 @@ class Dataset {
     }
 
     // here we have to publish the zmetadata ...
+    Future<tensorstore::TimestampedStorageGeneration> zmetadata_future;
     if (do_create) {
-      futures.push_back(
-          mdio::internal::write_zmetadata(metadata, json_variables));
+      zmetadata_future =
+          mdio::internal::write_zmetadata(metadata, json_variables, context);
+      futures.push_back(zmetadata_future);
     }
 
     // ready when everything's available ...
@@ -1123,7 +1588,8 @@ class Dataset {
     auto pair = tensorstore::PromiseFuturePair<Dataset>::Make();
     all_done_future.ExecuteWhenReady(
         [promise = std::move(pair.promise), variables = std::move(variables),
-         metadata](tensorstore::ReadyFuture<void> readyFut) {
+         metadata, context,
+         zmetadata_future](tensorstore::ReadyFuture<void> readyFut) {
           if (metadata.contains("api_version") &&
               !metadata.contains("apiVersion")) {
             promise.SetResult(
@@ -1189,8 +1655,20 @@ class Dataset {
             return;
           }
 
+          // Writes to the coordinates delete their index.
+          for (const auto& name : collection.get_keys()) {
+            if (internal::IsCoordinate(name, coords, dataset_domain.value())) {
+              collection.at(name).value().TrackCoordinateIndex();
+            }
+          }
+
           Dataset new_dataset{metadata, collection, coords,
                               dataset_domain.value()};
+          new_dataset.context = context;
+          if (!zmetadata_future.null() && zmetadata_future.result().ok()) {
+            new_dataset.zmetadata_cache->generation =
+                zmetadata_future.value().generation;
+          }
           promise.SetResult(std::move(new_dataset));
         });
     return pair.future;
@@ -1198,12 +1676,13 @@ class Dataset {
 
   /**
    * @brief Selects a field from a Variable with a structured data type.
-   * This will need to re-open the Variable.
-   * The new Variable will replace the original one in the Dataset once the
-   * future has been resolved. Attempting to access the Variable before the
-   * future has been resolved may result in a race condition.
+   * The field is opened from the cached metadata of the open Variable, so no
+   * I/O is needed. The new Variable keeps the same region and attributes, and
+   * replaces the original one in the Dataset once the future has been
+   * resolved. Attempting to access the Variable before the future has been
+   * resolved may result in a race condition.
    * @param variableName The name of the variable to select the field from.
-   * @param fieldName The name of the field to select.
+   * @param fieldName The name of the field to select, or "" for the raw bytes.
    * @return An `mdio::Future` if the selection was valid and successful, or an
    * error if the selection was invalid.
    */
@@ -1218,135 +1697,266 @@ class Dataset {
           "Variable '" + variableName + "' not found in the dataset.");
     }
 
-    // Grab the Variable from the Dataset
     MDIO_ASSIGN_OR_RETURN(auto var, variables.at(variableName));
-    // Preserve the intervals so it can be re-sliced to the same dimensions
-    MDIO_ASSIGN_OR_RETURN(auto intervals, var.get_intervals());
-    intervals.pop_back();  // Remove the byte dimension (Doesn't matter if it
-                           // doesn't exist)
-
-    // Ensure that the Variable is of dtype structarray
-    auto spec = var.spec();
-    if (!spec.status().ok()) {
-      // Something went wrong with Tensorstore retrieving the spec
-      return spec.status();
-    }
-    auto specJsonResult = spec.value().ToJson(IncludeDefaults{});
-    if (!specJsonResult.status().ok()) {
-      return specJsonResult.status();
-    }
-    nlohmann::json specJson = specJsonResult.value();
-    if (!specJson["metadata"]["dtype"].is_array()) {
+    MDIO_ASSIGN_OR_RETURN(auto spec,
+                          internal::struct_field_spec(var, fieldName));
+
+    auto fieldedVar =
+        internal::open_struct_field<T, R, M>(var, spec.first, context);
+    auto pair = tensorstore::PromiseFuturePair<mdio::Variable<T, R, M>>::Make();
+    fieldedVar.ExecuteWhenReady(
+        [this, promise = pair.promise, variableName](
+            tensorstore::ReadyFuture<mdio::Variable<T, R, M>> readyFut) {
+          auto ready_result = readyFut.result();
+          if (ready_result.ok()) {
+            this->variables.add(variableName, ready_result.value());
+          }
+          promise.SetResult(std::move(ready_result));
+        });
+    return pair.future;
+  }
+
+  /**
+   * @brief Reads several fields of a Variable with a structured data type.
+   * The raw records are read once and every field is decoded from them, which
+   * is cheaper than a `SelectField` and `Read` per field. The Variable in the
+   * Dataset is left as it is.
+   * @details \b Usage
+   * @code
+   * auto fields = dataset.SelectFields("image_headers", {"cdp-x", "cdp-y"});
+   * MDIO_ASSIGN_OR_RETURN(auto headers, fields.result());
+   * auto cdpX = static_cast<mdio::dtypes::int32_t*>(
+   *     headers[0].get_data_accessor().data());
+   * @endcode
+   * @param variableName The name of the variable to read the fields from.
+   * @param fieldNames The names of the fields to read.
+   * @return A future of the fields' data, in the order of `fieldNames`, or an
+   * error if a field doesn't exist.
+   */
+  Future<std::vector<VariableData<>>> SelectFields(
+      const std::string& variableName,
+      const std::vector<std::string>& fieldNames) {
+    if (!variables.contains_key(variableName)) {
       return absl::Status(
           absl::StatusCode::kInvalidArgument,
-          "Variable '" + variableName + "' is not a structured dtype.");
+          "Variable '" + variableName + "' not found in the dataset.");
     }
 
-    // Ensure the field exists in the Variable
-    int found = -1;
-    if (fieldName == "") {
-      found = -2;
-    } else {
-      for (std::size_t i = 0; i < specJson["metadata"]["dtype"].size(); i++) {
-        if (specJson["metadata"]["dtype"][i][0] == fieldName) {
-          found = i;
-          break;
-        }
+    MDIO_ASSIGN_OR_RETURN(auto var, variables.at(variableName));
+    MDIO_ASSIGN_OR_RETURN(auto spec, internal::struct_field_spec(var, ""));
+    std::vector<tensorstore::internal_zarr::ZarrDType::Field> fields;
+    for (const auto& name : fieldNames) {
+      auto field = std::find_if(
+          spec.second.fields.begin(), spec.second.fields.end(),
+          [&name](const auto& f) { return f.name == name; });
+      if (name.empty() || field == spec.second.fields.end()) {
+        return absl::Status(absl::StatusCode::kInvalidArgument,
+                            "Field: '" + name + "' not found in Variable '" +
+                                variableName + "'.");
       }
+      fields.push_back(*field);
     }
-    if (found == -1) {
-      return absl::Status(absl::StatusCode::kInvalidArgument,
-                          "Field: '" + fieldName + "' not found in Variable '" +
-                              variableName + "'.");
-    }
-
-    // Create a new Variable with the selected field
-    std::string baseStr = R"(
-            {
-                "driver": "zarr",
-                "field": "FIELD",
-                "kvstore": {
-                    "driver": "DRIVER",
-                    "path": "PATH"
-                }
-            }
-        )";
-    nlohmann::json base = nlohmann::json::parse(baseStr, nullptr, false);
-    if (base.is_discarded()) {
-      return absl::Status(absl::StatusCode::kInternal,
-                          "Failed to parse base JSON.");
-    }
-    if (found >= 0) {
-      base["field"] = specJson["metadata"]["dtype"][found][0];
-    } else {
-      base.erase("field");
-    }
-    base["kvstore"]["driver"] = specJson["kvstore"]["driver"];
-    base["kvstore"]["path"] = specJson["kvstore"]["path"];
-    // Remove trailing slashes. This causes issue #130
-    while (base["kvstore"]["path"].get<std::string>().back() == '/') {
-      base["kvstore"]["path"] =
-          base["kvstore"]["path"].get<std::string>().substr(
-              0, base["kvstore"]["path"].get<std::string>().size() - 1);
-    }
 
-    // Handle cloud stores
-    if (specJson["kvstore"].contains("bucket")) {
-      base["kvstore"]["bucket"] = specJson["kvstore"]["bucket"];
-      std::string cloudPath = base["kvstore"]["path"].get<std::string>();
-      cloudPath
-          .pop_back();  // We need to remove the trailing / from a cloud path
-      base["kvstore"]["path"] = cloudPath;
+    // A Variable that has had a field selected is reopened as raw records.
+    Future<Variable<>> records =
+        var.dtype() == constants::kByte
+            ? tensorstore::MakeReadyFuture<Variable<>>(var)
+            : internal::open_struct_field(var, spec.first, context);
+    auto data = tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [](Variable<>& records) -> Future<VariableData<>> {
+          return records.Read();
+        },
+        std::move(records));
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [fields = std::move(fields)](const VariableData<>& records)
+            -> Result<std::vector<VariableData<>>> {
+          std::vector<VariableData<>> decoded;
+          decoded.reserve(fields.size());
+          for (const auto& field : fields) {
+            MDIO_ASSIGN_OR_RETURN(auto values,
+                                  internal::decode_struct_field(records, field))
+            decoded.push_back(std::move(values));
+          }
+          return decoded;
+        },
+        std::move(data));
+  }
+
+  /**
+   * @brief Reads several Variables of the Dataset together.
+   * All of the reads are issued up front, bounded by `max_in_flight`, instead
+   * of being planned one Variable at a time. This lets the kvstore layer
+   * pipeline requests, which matters most on object stores such as S3 or GCS.
+   * @param names The names of the Variables to read.
+   * @param max_in_flight The maximum number of Variable reads outstanding at
+   * once. The default of 0 issues every read immediately.
+   * @details \b Usage
+   * @code
+   * auto readFuture = dataset.ReadVariables({"seismic", "cdp_x", "cdp_y"});
+   * MDIO_ASSIGN_OR_RETURN(auto data, readFuture.result());
+   * auto& seismic = data.at("seismic");
+   * @endcode
+   * @return A future of a map from Variable name to its VariableData, or the
+   * first error encountered.
+   */
+  Future<std::map<std::string, VariableData<>>> ReadVariables(
+      const std::vector<std::string>& names, std::size_t max_in_flight = 0) {
+    auto vars = std::make_shared<std::vector<Variable<>>>();
+    vars->reserve(names.size());
+    for (const auto& name : names) {
+      MDIO_ASSIGN_OR_RETURN(auto var, variables.at(name));
+      vars->push_back(std::move(var));
     }
 
-    auto fieldedVar = mdio::Variable<T, R, M>::Open(base, constants::kOpen);
+    struct ReadState {
+      std::mutex mutex;
+      std::map<std::string, VariableData<>> results;
+    };
+    auto state = std::make_shared<ReadState>();
+
+    auto all_done = internal::ForEachBounded(
+        vars->size(), max_in_flight,
+        [vars, state](std::size_t i) -> Future<void> {
+          return tensorstore::MapFutureValue(
+              tensorstore::InlineExecutor{},
+              [state, name = (*vars)[i].get_variable_name()](
+                  const VariableData<>& data) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->results.insert_or_assign(name, data);
+              },
+              (*vars)[i].Read());
+        });
 
-    auto pair = tensorstore::PromiseFuturePair<mdio::Variable<T, R, M>>::Make();
-    fieldedVar.ExecuteWhenReady(
-        [this, promise = pair.promise, variableName, intervals](
-            tensorstore::ReadyFuture<mdio::Variable<T, R, M>> readyFut) {
-          auto ready_result = readyFut.result();
-          if (!ready_result.ok()) {
-            promise.SetResult(ready_result.status());
-          } else {
-            // Re-slice the Variable to the same dimensions as the original
-            std::vector<mdio::RangeDescriptor<Index>> slices;
-            slices.reserve(intervals.size() - 1);
-            for (const auto& interval : intervals) {
-              slices.emplace_back(mdio::RangeDescriptor<Index>(
-                  {interval.label, interval.inclusive_min,
-                   interval.exclusive_max, 1}));
-            }
-            auto slicedVarRes = ready_result.value().slice(slices);
-            if (!slicedVarRes.status().ok()) {
-              promise.SetResult(slicedVarRes.status());
-            } else {
-              this->variables.add(variableName, ready_result.value());
-              promise.SetResult(slicedVarRes);
-            }
-          }
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [state]() -> std::map<std::string, VariableData<>> {
+          return std::move(state->results);
+        },
+        std::move(all_done));
+  }
+
+  /**
+   * @brief Writes several VariableData objects back to the Dataset together.
+   * Each VariableData is written to the Variable of the same name, bounded by
+   * `max_in_flight` outstanding writes.
+   * @param data The VariableData objects to write.
+   * @param max_in_flight The maximum number of Variable writes outstanding at
+   * once. The default of 0 issues every write immediately.
+   * @return A future that is ready when every write has been committed, or the
+   * first error encountered.
+   */
+  Future<void> WriteVariables(const std::vector<VariableData<>>& data,
+                              std::size_t max_in_flight = 0) {
+    auto vars = std::make_shared<std::vector<Variable<>>>();
+    vars->reserve(data.size());
+    for (const auto& varData : data) {
+      MDIO_ASSIGN_OR_RETURN(auto var, variables.at(varData.variableName));
+      vars->push_back(std::move(var));
+    }
+    auto sources = std::make_shared<std::vector<VariableData<>>>(data);
+
+    return internal::ForEachBounded(
+        vars->size(), max_in_flight,
+        [vars, sources](std::size_t i) -> Future<void> {
+          return (*vars)[i].Write((*sources)[i]).commit_future;
         });
-    return pair.future;
+  }
+
+  /**
+   * @brief Builds a value index for a coordinate Variable and stores it
+   * alongside the Variable's data.
+   * Once present, `sel` and `CoordinateSelector` resolve values of the
+   * coordinate from the index instead of reading and scanning the coordinate.
+   * The index describes the coordinate as it is when built. Writing the
+   * coordinate, or committing a new shape for it, deletes the index, and
+   * values are scanned for again until it is rebuilt. Only coordinates, named
+   * after a dimension or listed by a Variable, can have an index.
+   * @tparam T The dtype of the coordinate.
+   * @param name The name of the coordinate Variable, it must not be sliced.
+   * @details \b Usage
+   * @code
+   * auto indexFuture = dataset.BuildCoordinateIndex<mdio::dtypes::int32_t>(
+   *     "inline");
+   * if (!indexFuture.status().ok()) {
+   *   return indexFuture.status();
+   * }
+   * @endcode
+   * @return A future that is ready once the index has been written.
+   */
+  template <typename T>
+  Future<void> BuildCoordinateIndex(const std::string& name) {
+    if (!internal::IsCoordinate(name, coordinates, this->domain)) {
+      return absl::InvalidArgumentError(
+          "A coordinate index can only be built for a coordinate, '" + name +
+          "' is not one.");
+    }
+    MDIO_ASSIGN_OR_RETURN(auto var, variables.get<T>(name));
+    MDIO_ASSIGN_OR_RETURN(auto store_shape, var.get_store_shape());
+    auto domain = var.dimensions();
+    for (DimensionIndex i = 0; i < domain.rank(); ++i) {
+      if (domain.origin()[i] != 0 || domain.shape()[i] != store_shape[i]) {
+        return absl::InvalidArgumentError(
+            "A coordinate index must be built from an unsliced Variable.");
+      }
+    }
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [var](VariableData<T>& data) -> Future<void> {
+          auto index = CoordinateIndex<T>::Build(
+              data.get_data_accessor().data() + data.get_flattened_offset(),
+              data.num_samples());
+          return tensorstore::MapFutureValue(
+              tensorstore::InlineExecutor{},
+              [var]() {
+                // The next write has to delete the new index again.
+                var.TrackCoordinateIndex();
+              },
+              internal::WriteCoordinateIndex(var, index));
+        },
+        var.Read());
   }
 
   /**
    * @brief Commits changes made to the Variables metadata to durable media.
+   * Only the modified Variables are serialized, the others reuse the form
+   * cached by the last commit. The consolidated metadata is only replaced if
+   * nobody else has written it since this Dataset read or last wrote it.
+   * @param transaction The transaction to stage the writes in, if any. The
+   * returned future is then ready once the transaction commits, see
+   * `Dataset::Transaction`.
    * @return A future representing the completion of the commit or an error if
-   * no changes were made but the commit was requested.
+   * no changes were made but the commit was requested. A failed precondition
+   * means the Dataset has to be reopened to commit over another writer.
    */
-  tensorstore::Future<void> CommitMetadata() {
+  tensorstore::Future<void> CommitMetadata(
+      const tensorstore::Transaction& transaction =
+          tensorstore::no_transaction) {
     auto keys = variables.get_iterable_accessor();
 
     // Build out list of modified variables
     std::vector<std::string> modifiedVariables;
+    std::vector<tensorstore::KvStore> reshaped;
     for (const auto& key : keys) {
       auto var = variables.at(key).value();
+      // Fold the statistics of tracked writes into the attributes first.
+      auto published = var.PublishTrackedStats();
+      if (!published.ok()) {
+        return published.status();
+      }
       if (var.was_updated() || var.should_publish()) {
         modifiedVariables.push_back(key);
       }
       if (var.should_publish()) {
         // Reset the flag. This should only get set by the trim util.
         var.set_metadata_publish_flag(false);
+        // The coordinate index describes the old shape.
+        auto kvs = var.get_store().kvstore();
+        if (kvs.valid()) {
+          kvs.transaction = tensorstore::no_transaction;
+          reshaped.push_back(std::move(kvs));
+        }
       }
     }
 
@@ -1358,56 +1968,46 @@ class Dataset {
       return err;
     }
 
-    // We need to update the entire .zmetadata file
+    // Only the modified Variables are serialized again, the consolidated
+    // form of the others is kept from the last commit.
     std::vector<nlohmann::json> json_vars;
-    std::vector<std::shared_ptr<Variable<>>>
-        vars;  // Keeps the Variables in memory using shared_ptr
-    for (const auto& key : keys) {
-      auto var = std::make_shared<Variable<>>(variables.at(key).value());
-      vars.push_back(var);
-      // Get the JSON, drop transform, and add attributes
-      nlohmann::json json =
-          var->get_store().spec().value().ToJson(IncludeDefaults{}).value();
-      json.erase("transform");
-      json.erase("dtype");
-      json["metadata"].erase("filters");
-      json["metadata"].erase("order");
-      json["metadata"].erase("zarr_format");
-      // On local file systems there is a trailing slash that needs to be
-      // removed.
-      std::string path = json["kvstore"]["path"].get<std::string>();
-      path.pop_back();
-      json["kvstore"]["path"] = path;
-      nlohmann::json meta = var->getMetadata();
-      if (meta.contains("coordinates")) {
-        meta["attributes"]["coordinates"] = meta["coordinates"];
-        meta.erase("coordinates");
-      }
-      if (meta.contains("dimension_names")) {
-        meta["attributes"]["dimension_names"] = meta["dimension_names"];
-        meta.erase("dimension_names");
-      }
-      if (meta.contains("long_name")) {
-        meta["attributes"]["long_name"] = meta["long_name"];
-        meta.erase("long_name");
-      }
-      if (meta.contains("metadata")) {
-        if (meta["metadata"].contains("chunkGrid")) {
-          meta["metadata"].erase("chunkGrid");  // We never serialize this
-        }
-        if (!meta.contains("attributes")) {
-          meta["attributes"] = nlohmann::json::object();
+    {
+      std::lock_guard<std::mutex> lock(zmetadata_cache->mutex);
+      for (const auto& key : keys) {
+        auto var = variables.at(key).value();
+        auto fragment = zmetadata_cache->fragments.find(key);
+        const bool dirty =
+            fragment == zmetadata_cache->fragments.end() ||
+            fragment->second.attributes != *var.attributes ||
+            std::find(modifiedVariables.begin(), modifiedVariables.end(),
+                      key) != modifiedVariables.end();
+        if (dirty) {
+          MDIO_ASSIGN_OR_RETURN(auto json,
+                                internal::variable_zmetadata_json(var))
+          internal::ZMetadataCache::Fragment made{*var.attributes,
+                                                  std::move(json)};
+          fragment = zmetadata_cache->fragments
+                         .insert_or_assign(key, std::move(made))
+                         .first;
         }
-        meta["attributes"]["metadata"].merge_patch(meta["metadata"]);
-        meta.erase("metadata");
+        json_vars.push_back(fragment->second.json);
       }
-      json.update(meta);
-      json_vars.emplace_back(json);
     }
 
-    // Now let's get the .zmetadata going.
-    auto zmetadata_future =
-        mdio::internal::write_zmetadata(metadata, json_vars);
+    internal::Span span("mdio.Dataset.CommitMetadata");
+    if (span.active()) {
+      span.Attribute("mdio.variables",
+                     std::to_string(modifiedVariables.size()));
+    }
+
+    // Now let's get the .zmetadata going. The root .zattrs and .zgroup never
+    // change, and a concurrent commit since ours is reported as an error.
+    internal::ZMetadataWriteOptions write_options;
+    write_options.write_group = false;
+    write_options.if_equal = zmetadata_cache->generation;
+    write_options.transaction = transaction;
+    auto zmetadata_future = mdio::internal::write_zmetadata(
+        *metadata, json_vars, context, write_options);
     // Finally we can loop through the updated Variables and update them.
 
     std::vector<tensorstore::Future<tensorstore::TimestampedStorageGeneration>>
@@ -1420,7 +2020,7 @@ class Dataset {
       auto pair = tensorstore::PromiseFuturePair<
           tensorstore::TimestampedStorageGeneration>::Make();
       auto var = std::make_shared<Variable<>>(variables.at(key).value());
-      auto updateFuture = var->PublishMetadata();
+      auto updateFuture = var->PublishMetadata(transaction);
       updateFuture.ExecuteWhenReady(
           [promise = std::move(pair.promise),
            var](tensorstore::ReadyFuture<
@@ -1431,14 +2031,29 @@ class Dataset {
     }
 
     futures.push_back(zmetadata_future);
+    std::vector<Future<void>> deleted_indexes;
+    for (const auto& kvs : reshaped) {
+      deleted_indexes.push_back(internal::DeleteCoordinateIndex(kvs));
+      futures.push_back(deleted_indexes.back());
+    }
 
     auto all_done_future = tensorstore::WaitAllFuture(futures);
 
     auto pair = tensorstore::PromiseFuturePair<void>::Make();
     all_done_future.ExecuteWhenReady(
         [promise = std::move(pair.promise),
-         updates = std::move(variableFutures)](
-            tensorstore::ReadyFuture<void> readyFut) {
+         updates = std::move(variableFutures), zmetadata_future,
+         deleted_indexes = std::move(deleted_indexes),
+         cache = zmetadata_cache](tensorstore::ReadyFuture<void> readyFut) {
+          auto written = zmetadata_future.result();
+          if (!written.ok()) {
+            promise.SetResult(written.status());
+            return;
+          }
+          {
+            std::lock_guard<std::mutex> lock(cache->mutex);
+            cache->generation = written->generation;
+          }
           for (const auto& update : updates) {
             auto _update = update.result();
             if (!_update.ok()) {
@@ -1446,17 +2061,36 @@ class Dataset {
               return;
             }
           }
+          for (const auto& deleted : deleted_indexes) {
+            if (!deleted.status().ok()) {
+              promise.SetResult(deleted.status());
+              return;
+            }
+          }
           promise.SetResult(absl::OkStatus());
           return;
         });
-    return pair.future;
+    return span.End(pair.future);
   }
 
+  class Transaction;
+
+  /**
+   * @brief Starts a transaction over the Variables and metadata of the
+   * Dataset. See `Dataset::Transaction`.
+   * @param mode The tensorstore transaction mode. `tensorstore::isolated`
+   * hides the writes until the commit. `tensorstore::atomic_isolated` also
+   * makes the commit all or nothing, for kvstores that support it.
+   * @return The transaction, nothing is written until it is committed.
+   */
+  Transaction StartTransaction(
+      tensorstore::TransactionMode mode = tensorstore::isolated) const;
+
   /**
    * @brief Gets the Dataset level metadata.
    * @return A const reference to the Dataset's metadata.
    */
-  const nlohmann::json& getMetadata() const { return metadata; }
+  const nlohmann::json& getMetadata() const { return *metadata; }
 
   /// variables contained in the dataset
   VariableCollection variables;
@@ -1467,8 +2101,523 @@ class Dataset {
   /// enumerate the dimensions
   tensorstore::IndexDomain<> domain;
 
+  /**
+   * @brief Gets the Context shared by the Variables of the Dataset.
+   * Variables reopened by the Dataset, such as by `SelectField`, use it too.
+   * @return The Context, null if the Dataset was not opened by MDIO.
+   */
+  const Context& get_context() const { return context; }
+
+ private:
+  Dataset(std::shared_ptr<const nlohmann::json> metadata,
+          const VariableCollection& variables,
+          const coordinate_map& coordinates,
+          const tensorstore::IndexDomain<>& domain,
+          const Context& context = Context(),
+          std::shared_ptr<internal::ZMetadataCache> zmetadata_cache = nullptr)
+      : variables(variables),
+        coordinates(coordinates),
+        domain(domain),
+        metadata(std::move(metadata)),
+        context(context),
+        zmetadata_cache(zmetadata_cache
+                            ? std::move(zmetadata_cache)
+                            : std::make_shared<internal::ZMetadataCache>()) {}
+
+  /**
+   * @brief The untraced `isel` of a runtime number of descriptors.
+   */
+  Result<Dataset> _isel(const std::vector<RangeDescriptor<Index>>& slices) {
+    if (slices.empty()) {
+      return absl::InvalidArgumentError("No slices provided.");
+    }
+
+    // Labeled slices mean the same thing for every Variable, so the new domain
+    // follows from the Dataset's and the Variables are sliced on access.
+    if (std::all_of(slices.begin(), slices.end(), [](const auto& desc) {
+          return desc.label.label().data() != nullptr;
+        })) {
+      MDIO_ASSIGN_OR_RETURN(auto new_domain,
+                            internal::SliceDomain(domain, slices))
+      return Dataset{metadata, variables.slice(slices), coordinates,
+                     new_domain, context, zmetadata_cache};
+    }
+
+    // An index slice is relative to each Variable's own dimensions.
+    VariableCollection vars;
+
+    // the shape of the new domain
+    std::map<std::string, tensorstore::IndexDomainDimension<>> dims;
+    std::vector<std::string> keys = variables.get_iterable_accessor();
+
+    for (const auto& name : keys) {
+      MDIO_ASSIGN_OR_RETURN(auto variable,
+                            variables.at(name).value().slice(slices))
+      // add to variable
+      vars.add(name, variable);
+
+      // FIXME - check consistent dims ...
+      DimensionIndex idx = 0;
+      for (const auto label : variable.get_store().domain().labels()) {
+        // structarrays must have a byte dimension.
+        if (!label.empty()) {
+          dims[label] = variable.get_store().domain()[idx];
+        }
+        ++idx;
+      }
+    }
+
+    size_t size = dims.size();
+    std::vector<std::string> labels(size);
+    std::vector<Index> origin(size);
+    std::vector<Index> shape(size);
+
+    DimensionIndex idx = 0;
+    for (const auto& [key, val] : dims) {
+      labels[idx] = key;
+      origin[idx] = val.interval().inclusive_min();
+      shape[idx] = val.interval().size();
+      ++idx;
+    }
+
+    MDIO_ASSIGN_OR_RETURN(auto new_domain,
+                          tensorstore::IndexDomainBuilder<>(size)
+                              .origin(origin)
+                              .shape(shape)
+                              .labels(labels)
+                              .Finalize())
+    return Dataset{metadata, vars, coordinates,
+                   new_domain, context, zmetadata_cache};
+  }
+
+  /**
+   * @brief The untraced `sel`.
+   */
+  template <typename... Descriptors>
+  Result<Dataset> _sel(Descriptors... descriptors) {
+    /*
+    Case 1: ValueDescriptor with repeated values: Get all occurrences of the
+    value Case 2: ListDescriptor with repeated values (single element): Return
+    Invalid Reindexing error Case 3: ListDescriptor with repeated values
+    (multiple elements): Return Invalid Reindexing error (Case 2) Case 4: Same
+    as Case 1 Case 5: RangeDescriptor with repeated values: Return Invalid
+    Reindexing error Case 6: RangeDescriptor with unique values: Get the range
+    from start to stop, include everything in-between
+
+    Case fail: label is not 1D
+    Case fail: label is repeated. This is a dictionary in xarray, so not
+    allowed.
+    */
+
+    /*
+    Valid cases:
+      Case 1: ValueDescriptor with unique value: Get the single value.
+        No error state.
+        Get the index and convert to conventional isel.
+      Case 2: ValueDescriptor with non-unique value: Get all occurrences of the
+    value. No error state. Case 3: ListDescriptor with unique values: Get the
+    individual values. Error state for repeated values. Case 4: RangeDescriptor
+    with unique start and stop values: Get the range from start to stop, include
+    everything in-between. Error state for repeated start/stop values. Any
+    repeated values that are not start/stop are fair game. Get the start and
+    stop indicies and create a single isel.
+    */
+
+    // Check that all descriptors are of the same outer type
+    if (!are_same<Descriptors...>()) {
+      return absl::InvalidArgumentError(
+          "All descriptors must be of the same type.");
+    }
+
+    // Validate each descriptor (for example, ListDescriptor not yet supported)
+    auto validateDescriptors = [this](auto& descriptor) {
+      using DescriptorType = typename outer_type<decltype(descriptor)>::type;
+      if constexpr (std::is_same_v<
+                        std::remove_reference_t<DescriptorType>,
+                        ListDescriptor<typename std::remove_reference_t<
+                            decltype(descriptor)>::type>>) {
+        return absl::UnimplementedError(
+            "Support for ListDescriptor is not yet implemented.");
+      }
+      // TODO(BrianMichell): Remove this check when SliceDescriptor is removed
+      if constexpr (std::is_same_v<DescriptorType, SliceDescriptor>) {
+        return absl::InvalidArgumentError(
+            "SliceDescriptor is deprecated and will be removed in future "
+            "versions. Please use RangeDescriptor instead.\nThe sel method "
+            "does not support SliceDescriptor.");
+      }
+
+      MDIO_ASSIGN_OR_RETURN(
+          auto var, variables.at(std::string(descriptor.label.label())));
+      if (var.dimensions().rank() != 1) {
+        return absl::InvalidArgumentError("Label must be 1D.");
+      }
+
+      return absl::OkStatus();
+    };
+
+    std::set<std::string_view> labels;
+
+    // Call validateDescriptors for each descriptor
+    {
+      // Manage the scope of status
+      absl::Status status;
+      for (auto& descriptor : {descriptors...}) {
+        status = validateDescriptors(descriptor);
+        if (!status.ok()) {
+          return status;
+        }
+        if (labels.count(descriptor.label.label()) > 0) {
+          return absl::InvalidArgumentError("Label must not be repeated.");
+        }
+        if (descriptor.label.index() !=
+            std::numeric_limits<DimensionIndex>::max()) {
+          return absl::InvalidArgumentError(
+              "Expected label to be a dimension name but got an index.");
+        }
+        labels.insert(descriptor.label.label());
+      }
+    }
+
+    // Check if the descriptors are of type ValueDescriptor
+    if constexpr ((std::is_same_v<
+                       Descriptors,
+                       ValueDescriptor<typename Descriptors::type>> &&
+                   ...)) {
+      auto slicer = descriptor_to_index(descriptors...);
+      if (!slicer.status().ok()) {
+        return slicer.status();
+      }
+
+      auto label_to_indices = slicer.value();
+
+      // Build out the slice descriptors
+      std::vector<RangeDescriptor<Index>> slices;
+      for (auto& elem : label_to_indices) {
+        auto size = elem.second.size();
+        for (int i = 0; i < size; ++i) {
+          slices.emplace_back(RangeDescriptor<Index>(
+              {elem.first, elem.second[i], elem.second[i] + 1, 1}));
+        }
+      }
+
+      if (slices.empty()) {
+        return absl::InvalidArgumentError(
+            "No slices could be made from the given descriptors.");
+      }
+      // The map 'label_to_indices' is now populated with all the relevant
+      // indices. You can now proceed with further processing based on this map.
+
+      return isel(
+          static_cast<const std::vector<RangeDescriptor<Index>>&>(slices));
+    } else if constexpr ((std::is_same_v</*NOLINT: readability/braces*/
+                                         Descriptors,
+                                         ListDescriptor<
+                                             typename Descriptors::type>> &&
+                          ...)) {
+      auto slicer = descriptor_to_index(descriptors...);
+      if (!slicer.status().ok()) {
+        return slicer.status();
+      }
+
+      auto label_to_indices = slicer.value();
+
+      // Build out the slice descriptors
+      std::vector<RangeDescriptor<Index>> slices;
+      for (auto& elem : label_to_indices) {
+        auto size = elem.second.size();
+        for (int i = 0; i < size; ++i) {
+          slices.emplace_back(RangeDescriptor<Index>(
+              {elem.first, elem.second[i], elem.second[i] + 1, 1}));
+        }
+      }
+
+      if (slices.empty()) {
+        return absl::InvalidArgumentError(
+            "No slices could be made from the given descriptors.");
+      }
+      // The map 'label_to_indices' is now populated with all the relevant
+      // indices. You can now proceed with further processing based on this map.
+
+      return isel(
+          static_cast<const std::vector<RangeDescriptor<Index>>&>(slices));
+    } else {
+      std::map<std::string_view, std::pair<Index, Index>>
+          label_to_range;  // pair.first = start, pair.second = stop
+      absl::Status trueStatus =
+          absl::OkStatus();  // A hack to allow for true error status return.
+
+      auto processDescriptor = [this, &label_to_range,
+                                &trueStatus](auto& descriptor) -> absl::Status {
+        using ValueType =
+            typename extract_descriptor_Ttype<decltype(descriptor)>::type;
+
+        if (descriptor.start == descriptor.stop) {
+          trueStatus = absl::InvalidArgumentError(
+              "Start and stop values must be different.");
+          return trueStatus;
+        }
+
+        auto varRes =
+            variables.get<ValueType>(std::string(descriptor.label.label()));
+        if (!varRes.status().ok()) {
+          trueStatus = varRes.status();
+          return trueStatus;
+        }
+        auto var = varRes.value();
+
+        std::pair<bool, Index> start = {false, 0};
+        std::pair<bool, Index> stop = {false, 0};
+
+        // Prefer the persisted index, any failure falls back to a full scan.
+        auto indexRes = internal::ReadCoordinateIndex<ValueType>(var).result();
+        if (indexRes.ok() && indexRes.value().has_value()) {
+          const auto& index = *indexRes.value();
+          if (index.count(descriptor.start) > 1) {
+            trueStatus = absl::InvalidArgumentError("Repeated start value.");
+            return trueStatus;
+          }
+          if (index.count(descriptor.stop) > 1) {
+            trueStatus = absl::InvalidArgumentError("Repeated stop value.");
+            return trueStatus;
+          }
+          auto startRuns = index.find(descriptor.start);
+          auto stopRuns = index.find(descriptor.stop);
+          if (!startRuns.empty()) {
+            start = {true, startRuns[0].start};
+          }
+          if (!stopRuns.empty()) {
+            stop = {true, stopRuns[0].start};
+          }
+        } else {
+          auto varFut = var.Read();
+          if (!varFut.status().ok()) {
+            trueStatus = varFut.status();
+            return trueStatus;
+          }
+          auto varDat = varFut.value();
+          auto varAccessor = varDat.get_data_accessor();
+          auto offset = varDat.get_flattened_offset();
+
+          for (Index i = offset; i < var.num_samples() + offset; i++) {
+            if (varAccessor({i}) == descriptor.start) {
+              if (start.first) {
+                trueStatus =
+                    absl::InvalidArgumentError("Repeated start value.");
+                return trueStatus;
+              }
+              start = {true, i};
+            }
+            if (varAccessor({i}) == descriptor.stop) {
+              if (stop.first) {
+                trueStatus = absl::InvalidArgumentError("Repeated stop value.");
+                return trueStatus;
+              }
+              stop = {true, i};
+            }
+          }
+        }
+
+        if (!start.first) {
+          trueStatus = absl::InvalidArgumentError("Start value not found.");
+          return trueStatus;
+        }
+        if (!stop.first) {
+          trueStatus = absl::InvalidArgumentError("Stop value not found.");
+          return trueStatus;
+        }
+
+        // Xarray behavior is to effectively remove the Variable in this case.
+        if (start.second >= stop.second) {
+          trueStatus = absl::UnimplementedError(
+              "Start value happens after stop value. This is not a supported "
+              "case.");
+          return trueStatus;
+        }
+        // This case should be caught by the earlier check, but it's here for
+        // completeness.
+        if (label_to_range.count(descriptor.label.label()) > 0) {
+          trueStatus =
+              absl::InvalidArgumentError("Label must not be repeated.");
+          return trueStatus;
+        }
+        label_to_range[descriptor.label.label()] = {start.second, stop.second};
+        return absl::OkStatus();
+      };
+
+      auto status = (processDescriptor(descriptors).ok() && ...);
+      if (!status) {
+        return trueStatus;
+      }
+
+      std::vector<RangeDescriptor<Index>> slices;
+      for (auto& elem : label_to_range) {
+        slices.emplace_back(RangeDescriptor<Index>(
+            {elem.first, elem.second.first, elem.second.second + 1, 1}));
+      }
+
+      if (slices.empty()) {
+        return absl::InvalidArgumentError(
+            "No slices could be made from the given descriptors.");
+      }
+
+      return isel(
+          static_cast<const std::vector<RangeDescriptor<Index>>&>(slices));
+    }
+
+    return absl::OkStatus();
+  }
+
+  /// the metadata associated with the dataset (root .zattrs), shared between
+  /// a Dataset and its slices
+  std::shared_ptr<const ::nlohmann::json> metadata;
+
+  /// the Context the Variables were opened in, shared with the slices
+  Context context;
+
+  /// the consolidated metadata last read or written, shared with the slices
+  std::shared_ptr<internal::ZMetadataCache> zmetadata_cache;
+};
+
+/**
+ * @brief Groups writes to many Variables of a Dataset, and the metadata
+ * commit, into a single tensorstore transaction with one commit.
+ * Nothing is visible to readers until `Commit`. Writes to the same chunk are
+ * coalesced, so each chunk touched is read and written at most once when the
+ * transaction commits.
+ * @details \b Usage
+ * @code
+ * auto transaction = dataset.StartTransaction();
+ * auto written = transaction.Write(seismicData);
+ * if (!written.ok()) {
+ *   return written.status();
+ * }
+ * written = transaction.Write(headerData);
+ * // ... update attributes of the Variables
+ * auto staged = transaction.CommitMetadata();
+ * auto committed = transaction.Commit().result();
+ * @endcode
+ * Statistics of tracked writes are folded in when the data commits, after the
+ * metadata of the same transaction was staged, so they are published by the
+ * next `CommitMetadata`. A Transaction is not thread safe.
+ */
+class Dataset::Transaction {
+ public:
+  /**
+   * @brief Stages a write of the Variable of the same name as `data`.
+   * @param data The VariableData to write.
+   * @return An error if the write could not be staged. Errors of the write
+   * itself are reported by `Commit`.
+   */
+  template <typename T = void, DimensionIndex R = dynamic_rank,
+            ArrayOriginKind OriginKind = offset_origin>
+  Result<void> Write(const VariableData<T, R, OriginKind>& data) {
+    MDIO_ASSIGN_OR_RETURN(auto var, get<T, R>(data.variableName))
+    auto write = var.Write(data);
+    if (write.commit_future.ready() && !write.commit_future.status().ok()) {
+      return write.commit_future.status();
+    }
+    futures.push_back(std::move(write.commit_future));
+    return absl::OkStatus();
+  }
+
+  /**
+   * @brief Gets a Variable of the Dataset whose writes are staged in the
+   * transaction, for example to write a slice of it.
+   * @param name The name of the Variable.
+   * @return The Variable bound to the transaction.
+   */
+  template <typename T = void, DimensionIndex R = dynamic_rank,
+            ReadWriteMode M = ReadWriteMode::dynamic>
+  Result<Variable<T, R, M>> get(const std::string& name) const {
+    if (committed) {
+      return absl::FailedPreconditionError(
+          "The transaction was already committed or aborted.");
+    }
+    MDIO_ASSIGN_OR_RETURN(auto var, dataset.variables.get<T, R, M>(name))
+    MDIO_ASSIGN_OR_RETURN(auto store, var.get_store() | transaction)
+    var.set_store(store);
+    return var;
+  }
+
+  /**
+   * @brief Stages the metadata of the modified Variables, as
+   * `Dataset::CommitMetadata` does.
+   * @return An error if there is nothing to commit or the metadata could not
+   * be staged.
+   */
+  Result<void> CommitMetadata() {
+    if (committed) {
+      return absl::FailedPreconditionError(
+          "The transaction was already committed or aborted.");
+    }
+    auto staged = dataset.CommitMetadata(transaction);
+    if (staged.ready() && !staged.status().ok()) {
+      return staged.status();
+    }
+    futures.push_back(std::move(staged));
+    return absl::OkStatus();
+  }
+
+  /**
+   * @brief Commits everything staged in the transaction.
+   * @return A future that is ready once the writes are durable, with the
+   * first error of the commit or of any staged write.
+   */
+  Future<void> Commit() {
+    if (committed) {
+      return absl::FailedPreconditionError(
+          "The transaction was already committed or aborted.");
+    }
+    committed = true;
+    auto staged = std::make_shared<std::vector<tensorstore::AnyFuture>>(
+        std::move(futures));
+    futures.clear();
+    staged->push_back(transaction.CommitAsync());
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [staged]() -> Result<void> {
+          for (const auto& future : *staged) {
+            if (!future.status().ok()) {
+              return future.status();
+            }
+          }
+          return absl::OkStatus();
+        },
+        tensorstore::WaitAllFuture(*staged));
+  }
+
+  /**
+   * @brief Discards everything staged in the transaction.
+   */
+  void Abort() {
+    committed = true;
+    futures.clear();
+    transaction.Abort();
+  }
+
+  /**
+   * @brief Gets the underlying tensorstore transaction.
+   */
+  const tensorstore::Transaction& get_transaction() const {
+    return transaction;
+  }
+
  private:
-  /// the metadata associated with the dataset (root .zattrs)
-  ::nlohmann::json metadata;
+  friend class Dataset;
+
+  Transaction(const Dataset& dataset, tensorstore::TransactionMode mode)
+      : dataset(dataset), transaction(mode) {}
+
+  Dataset dataset;
+  tensorstore::Transaction transaction;
+  /// The staged writes, ready once the transaction commits.
+  std::vector<tensorstore::AnyFuture> futures;
+  bool committed = false;
 };
+
+inline Dataset::Transaction Dataset::StartTransaction(
+    tensorstore::TransactionMode mode) const {
+  return Transaction(*this, mode);
+}
 }  // namespace mdio
@@ -15,14 +15,19 @@
 #ifndef MDIO_DATASET_FACTORY_H_
 #define MDIO_DATASET_FACTORY_H_
 
+#include <cmath>
+#include <optional>
 #include <set>
 #include <string>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
 
+#include "mdio/chunk_planner.h"
 #include "mdio/dataset_validator.h"
 #include "mdio/impl.h"
+#include "mdio/request_policy.h"
+#include "mdio/telemetry.h"
 // #include "tensorstore/tensorstore.h"
 
 #include "absl/strings/escaping.h"
@@ -115,10 +120,41 @@ absl::Status transform_dtype(nlohmann::json& input /*NOLINT*/,
   return absl::OkStatus();
 }
 
+/**
+ * @brief Reads an integer compression level from a compressor spec
+ * This function is intended to be an internal helper function for formatting
+ * Variable specs
+ * @param compressor A MDIO compressor spec
+ * @param fallback The level to use if none is given
+ * @param min The smallest valid level
+ * @param max The largest valid level
+ * @return The level or InvalidArgumentError if it is out of range
+ */
+tensorstore::Result<int> compressor_level(const nlohmann::json& compressor,
+                                          int fallback, int min, int max) {
+  if (!compressor.contains("level")) {
+    return fallback;
+  }
+  if (!compressor["level"].is_number_integer() ||
+      compressor["level"].get<int64_t>() > max ||
+      compressor["level"].get<int64_t>() < min) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Compressor level for %s must be between %d and %d",
+                        compressor["name"].get<std::string>(), min, max));
+  }
+  return compressor["level"].get<int>();
+}
+
 /**
  * @brief Modifies a Variable spec to use proper Zarr compressor
  * This function is intended to be an internal helper function for formatting
  * Variable specs It will modify with side-effect on "input"
+ * Supported compressors are the Zarr v2 codecs shared by tensorstore and
+ * numcodecs: "blosc" with any of its sub-codecs, "zstd", "zlib" and "bz2".
+ * There is no ZFP codec in the Zarr v2 driver, so "zfp" is emulated: in
+ * "fixed_accuracy" and "fixed_precision" mode the samples are quantized on
+ * write (recorded as ["attributes"]["metadata"]["quantizationV1"]) and stored
+ * with zstd, "reversible" is lossless zstd. Readers see plain zstd chunks.
  * @param input A MDIO Variable spec
  * @param variable A Variable stub (Will be modified)
  * @return OkStatus if successful, InvalidArgumentError if compressor is invalid
@@ -126,47 +162,125 @@ absl::Status transform_dtype(nlohmann::json& input /*NOLINT*/,
  */
 absl::Status transform_compressor(nlohmann::json& input /*NOLINT*/,
                                   nlohmann::json& variable /*NOLINT*/) {
-  if (input.contains("compressor")) {
-    if (input["compressor"].contains("name")) {
-      if (input["compressor"]["name"] != "blosc") {
-        return absl::InvalidArgumentError("Only blosc compressor is supported");
-      }
-      variable["metadata"]["compressor"]["id"] = input["compressor"]["name"];
-    } else {
-      return absl::InvalidArgumentError("Compressor name must be specified");
-    }
-
-    if (input["compressor"].contains("algorithm")) {
-      variable["metadata"]["compressor"]["cname"] =
-          input["compressor"]["algorithm"];
-    } else {  // DEFAULT
-      variable["metadata"]["compressor"]["cname"] = "lz4";
-    }
-    if (input["compressor"].contains("level")) {
-      if (input["compressor"]["level"] > 9 ||
-          input["compressor"]["level"] < 0) {
+  if (!input.contains("compressor") || input["compressor"].is_null()) {
+    variable["metadata"]["compressor"] = nullptr;
+    return absl::OkStatus();
+  }
+  const nlohmann::json& compressor = input["compressor"];
+  if (!compressor.contains("name")) {
+    return absl::InvalidArgumentError("Compressor name must be specified");
+  }
+  const std::string name = compressor["name"].get<std::string>();
+
+  if (name == "blosc") {
+    variable["metadata"]["compressor"]["id"] = name;
+    if (compressor.contains("algorithm")) {
+      static const std::set<std::string> kBloscAlgorithms = {
+          "blosclz", "lz4", "lz4hc", "zlib", "zstd"};
+      if (!compressor["algorithm"].is_string() ||
+          kBloscAlgorithms.count(compressor["algorithm"]) == 0) {
         return absl::InvalidArgumentError(
-            "Compressor level must be between 0 and 9");
+            "Blosc algorithm must be one of blosclz, lz4, lz4hc, zlib or "
+            "zstd");
       }
-      variable["metadata"]["compressor"]["clevel"] =
-          input["compressor"]["level"];
+      variable["metadata"]["compressor"]["cname"] = compressor["algorithm"];
     } else {  // DEFAULT
-      variable["metadata"]["compressor"]["clevel"] = 5;
+      variable["metadata"]["compressor"]["cname"] = "lz4";
     }
-    if (input["compressor"].contains("shuffle")) {
-      variable["metadata"]["compressor"]["shuffle"] =
-          input["compressor"]["shuffle"];
+    // Every Blosc sub-codec shares Blosc's 0-9 level scale.
+    MDIO_ASSIGN_OR_RETURN(auto level, compressor_level(compressor, 5, 0, 9));
+    variable["metadata"]["compressor"]["clevel"] = level;
+    if (compressor.contains("shuffle")) {
+      variable["metadata"]["compressor"]["shuffle"] = compressor["shuffle"];
     } else {  // DEFAULT
       variable["metadata"]["compressor"]["shuffle"] = 1;
     }
-    if (input["compressor"].contains("blocksize")) {
+    if (compressor.contains("blocksize")) {
       variable["metadata"]["compressor"]["blocksize"] =
-          input["compressor"]["blocksize"];
+          compressor["blocksize"];
     } else {  // DEFAULT
       variable["metadata"]["compressor"]["blocksize"] = 0;
     }
+  } else if (name == "zstd") {
+    MDIO_ASSIGN_OR_RETURN(auto level,
+                          compressor_level(compressor, 3, -131072, 22));
+    variable["metadata"]["compressor"] = {{"id", "zstd"}, {"level", level}};
+  } else if (name == "zlib") {
+    MDIO_ASSIGN_OR_RETURN(auto level, compressor_level(compressor, 1, 0, 9));
+    variable["metadata"]["compressor"] = {{"id", "zlib"}, {"level", level}};
+  } else if (name == "bz2") {
+    MDIO_ASSIGN_OR_RETURN(auto level, compressor_level(compressor, 1, 1, 9));
+    variable["metadata"]["compressor"] = {{"id", "bz2"}, {"level", level}};
+  } else if (name == "zfp") {
+    const std::string dtype = input["dataType"].is_string()
+                                  ? input["dataType"].get<std::string>()
+                                  : "";
+    if (dtype != "float32" && dtype != "float64") {
+      return absl::InvalidArgumentError(
+          "The zfp compressor requires a float32 or float64 Variable");
+    }
+    const std::string mode = compressor.contains("mode")
+                                 ? compressor["mode"].get<std::string>()
+                                 : "";
+    if (mode == "fixed_accuracy") {
+      if (!compressor.contains("tolerance") ||
+          !compressor["tolerance"].is_number() ||
+          compressor["tolerance"].get<double>() <= 0) {
+        return absl::InvalidArgumentError(
+            "zfp fixed_accuracy mode requires a positive tolerance");
+      }
+      variable["attributes"]["metadata"]["quantizationV1"] = {
+          {"mode", mode}, {"tolerance", compressor["tolerance"]}};
+    } else if (mode == "fixed_precision") {
+      if (!compressor.contains("precision") ||
+          !compressor["precision"].is_number_integer() ||
+          compressor["precision"].get<int64_t>() < 1) {
+        return absl::InvalidArgumentError(
+            "zfp fixed_precision mode requires a precision of at least 1 bit");
+      }
+      variable["attributes"]["metadata"]["quantizationV1"] = {
+          {"mode", mode}, {"precision", compressor["precision"]}};
+    } else if (mode != "reversible") {
+      return absl::InvalidArgumentError(
+          "zfp mode must be fixed_accuracy, fixed_precision or reversible");
+    }
+    variable["metadata"]["compressor"] = {{"id", "zstd"}, {"level", 3}};
   } else {
-    variable["metadata"]["compressor"] = nullptr;
+    return absl::InvalidArgumentError(
+        "Compressor must be one of blosc, zstd, zlib, bz2 or zfp");
+  }
+  return absl::OkStatus();
+}
+
+/**
+ * @brief Checks the scaled integer storage of a Variable spec
+ * This function is intended to be an internal helper function for formatting
+ * Variable specs
+ * A "scaleOffsetV1" entry in the metadata stores floating point samples as
+ * integers of at most 32 bits, see `ReadAs` and `WriteAs`. It is kept with the
+ * rest of the metadata in the Variable's attributes.
+ * @param input A MDIO Variable spec
+ * @return OkStatus if successful, InvalidArgumentError if the Variable can't
+ * be stored as scaled integers
+ */
+absl::Status transform_scale_offset(const nlohmann::json& input) {
+  if (!input.contains("metadata") ||
+      !input["metadata"].contains("scaleOffsetV1")) {
+    return absl::OkStatus();
+  }
+  static const std::set<std::string> kScaledTypes = {
+      "int8", "int16", "int32", "uint8", "uint16", "uint32"};
+  if (!input["dataType"].is_string() ||
+      kScaledTypes.count(input["dataType"].get<std::string>()) == 0) {
+    return absl::InvalidArgumentError(
+        "scaleOffsetV1 requires an integer Variable of at most 32 bits");
+  }
+  const auto& encoding = input["metadata"]["scaleOffsetV1"];
+  if (!encoding.contains("scale") || !encoding["scale"].is_number() ||
+      encoding["scale"].get<double>() == 0 ||
+      !std::isfinite(encoding["scale"].get<double>())) {
+    return absl::InvalidArgumentError(
+        "scaleOffsetV1 requires a finite, non-zero scale");
   }
   return absl::OkStatus();
 }
@@ -249,10 +363,86 @@ absl::Status transform_metadata(const std::string& path,
   if (bucket != "NULL") {
     variable["kvstore"]["bucket"] = bucket;
   }
+  mdio::internal::ApplyRequestPolicy(variable["kvstore"]);
 
   return absl::OkStatus();
 }
 
+/**
+ * @brief Gets the size of one element of a Zarr dtype
+ * This function is intended to be an internal helper function for formatting
+ * Variable specs
+ * @param dtype A numpy style dtype or a list of [name, dtype] fields
+ * @return The number of bytes in one element
+ */
+uint64_t dtype_num_bytes(const nlohmann::json& dtype) {
+  if (dtype.is_array()) {
+    uint64_t num_bytes = 0;
+    for (const auto& field : dtype) {
+      num_bytes += dtype_num_bytes(field[1]);
+    }
+    return num_bytes;
+  }
+  // The size follows the byte order and kind, e.g. "<f4" or "<c16".
+  return std::stoull(dtype.get<std::string>().substr(2));
+}
+
+/**
+ * @brief Modifies a Variable spec to use a sensible chunk shape
+ * This function is intended to be an internal helper function for formatting
+ * Variable specs
+ * Without a chunkGrid the chunks are planned from the "chunkPlanV1" hint, or
+ * balanced if there is none. An explicit regular chunkGrid is used as is but
+ * tiny or oversized chunks are reported.
+ * @param input A MDIO Variable spec
+ * @param variable A Variable stub with its dtype and shape set (Will be
+ * modified)
+ * @return A warning about the explicit chunk shape, or `std::nullopt`.
+ */
+std::optional<std::string> transform_chunks(const nlohmann::json& input,
+                      nlohmann::json& variable /*NOLINT*/) {
+  const auto shape =
+      variable["metadata"]["shape"].get<std::vector<uint64_t>>();
+  const uint64_t item_bytes = dtype_num_bytes(variable["metadata"]["dtype"]);
+
+  mdio::ChunkPlanOptions options;
+  if (input.contains("metadata") && input["metadata"].contains("chunkPlanV1")) {
+    const auto& plan = input["metadata"]["chunkPlanV1"];
+    if (plan.contains("accessPattern")) {
+      options.hint = mdio::AccessHintFromString(plan["accessPattern"])
+                         .value_or(mdio::AccessHint::kBalanced);
+    }
+    if (plan.contains("targetChunkBytes")) {
+      options.target_bytes = plan["targetChunkBytes"].get<uint64_t>();
+    }
+  }
+
+  if (!input.contains("metadata") ||
+      !input["metadata"].contains("chunkGrid")) {
+    variable["metadata"]["chunks"] =
+        mdio::PlanChunkShape(shape, item_bytes, options);
+    return std::nullopt;
+  }
+
+  const auto& chunkShape =
+      input["metadata"]["chunkGrid"]["configuration"]["chunkShape"];
+  variable["metadata"]["chunks"] = chunkShape;
+  // Rectilinear grids have a list of lengths per dimension and aren't checked.
+  for (const auto& length : chunkShape) {
+    if (!length.is_number_integer()) {
+      return std::nullopt;
+    }
+  }
+  auto warning = mdio::CheckChunkShape(
+      shape, chunkShape.get<std::vector<uint64_t>>(), item_bytes, options);
+  if (!warning.has_value()) {
+    return std::nullopt;
+  }
+  mdio::internal::Count(mdio::TelemetryCounter::kChunkShapeWarnings, 1);
+  return absl::StrFormat("Variable %s has %s",
+                         input["name"].get<std::string>(), *warning);
+}
+
 /**
  * @brief Constructs an MDIO Variable spec from an MDIO Dataset Variable list
  * element This function is intended to be an internal helper function for
@@ -293,16 +483,15 @@ tensorstore::Result<nlohmann::json> from_json_to_spec(
     return compressorStatus;
   }
 
+  auto scaleOffsetStatus = transform_scale_offset(json);
+  if (!scaleOffsetStatus.ok()) {
+    return scaleOffsetStatus;
+  }
+
   transform_shape(json, variableStub, dimensionMap);
+  transform_chunks(json, variableStub);
 
   if (json.contains("metadata")) {
-    if (json["metadata"].contains("chunkGrid")) {
-      variableStub["metadata"]["chunks"] =
-          json["metadata"]["chunkGrid"]["configuration"]["chunkShape"];
-    } else {  // No chunking specified
-      variableStub["metadata"]["chunks"] = variableStub["metadata"]["shape"];
-    }
-
     if (!json["dataType"].contains("fields")) {
       variableStub["metadata"]["fill_value"] = nlohmann::json::value_t::null;
       if (json["dataType"] == "complex64") {
@@ -315,30 +504,15 @@ tensorstore::Result<nlohmann::json> from_json_to_spec(
         variableStub["metadata"]["fill_value"] = std::nan("");
       }
     } else {
-      // Accumulate the total number of bytes (N)
-      uint16_t num_bytes = 0;
       // We're going to use the variable dtype because it's already in byte
       // format
-      std::string dtype;
-      for (auto field : variableStub["metadata"]["dtype"]) {
-        dtype = field[1].get<std::string>();
-        if (dtype.at(1) != 'c') {
-          num_bytes += std::stoi(dtype.substr(2));
-        } else {  // Complex
-          if (dtype.at(2) == '8') {
-            num_bytes += 8;
-          } else {
-            num_bytes += 16;
-          }
-        }
-      }
-      std::string raw(num_bytes, '\0');
+      std::string raw(dtype_num_bytes(variableStub["metadata"]["dtype"]),
+                      '\0');
       variableStub["metadata"]["fill_value"] = encode_base64(raw);
     }
 
-    variableStub["attributes"]["metadata"] = json["metadata"];
-  } else {  // No metadata supplied means no chunkGrid
-    variableStub["metadata"]["chunks"] = variableStub["metadata"]["shape"];
+    // Merged, the compressor may have recorded a quantization.
+    variableStub["attributes"]["metadata"].update(json["metadata"]);
   }
 
   auto transform_result = transform_metadata(path, variableStub);
@@ -394,6 +568,150 @@ tensorstore::Result<nlohmann::json> from_json_to_spec(
   return variableStub;
 }
 
+/**
+ * @brief Gets the shard shape of a MDIO Dataset Variable list element
+ * This function is intended to be an internal helper function for formatting
+ * Variable specs
+ * @param json A MDIO Dataset Variable list element
+ * @return The shard shape, or an empty array if the Variable is not sharded
+ */
+nlohmann::json get_shard_shape(const nlohmann::json& json) {
+  if (json.contains("metadata") && json["metadata"].contains("chunkGrid") &&
+      json["metadata"]["chunkGrid"].contains("configuration") &&
+      json["metadata"]["chunkGrid"]["configuration"].contains("shardShape")) {
+    return json["metadata"]["chunkGrid"]["configuration"]["shardShape"];
+  }
+  return nlohmann::json::array();
+}
+
+/**
+ * @brief Converts a Zarr v2 compressor to the equivalent Zarr v3 codec
+ * This function is intended to be an internal helper function for formatting
+ * Variable specs
+ * @param compressor The "compressor" of a Zarr v2 Variable spec
+ * @return The codec, null if there is no compressor, or InvalidArgumentError
+ * if the compressor has no Zarr v3 equivalent
+ */
+tensorstore::Result<nlohmann::json> to_zarr3_codec(
+    const nlohmann::json& compressor) {
+  if (compressor.is_null()) {
+    return nlohmann::json(nullptr);
+  }
+  const std::string id = compressor["id"].get<std::string>();
+  if (id == "blosc") {
+    nlohmann::json configuration = {{"cname", compressor["cname"]},
+                                    {"clevel", compressor["clevel"]},
+                                    {"blocksize", compressor["blocksize"]}};
+    // -1 (automatic) leaves the choice to the codec.
+    const int shuffle = compressor["shuffle"].get<int>();
+    if (shuffle == 0) {
+      configuration["shuffle"] = "noshuffle";
+    } else if (shuffle == 1) {
+      configuration["shuffle"] = "shuffle";
+    } else if (shuffle == 2) {
+      configuration["shuffle"] = "bitshuffle";
+    }
+    return nlohmann::json{{"name", "blosc"}, {"configuration", configuration}};
+  } else if (id == "zstd") {
+    return nlohmann::json{{"name", "zstd"},
+                          {"configuration", {{"level", compressor["level"]}}}};
+  } else if (id == "zlib") {
+    return nlohmann::json{{"name", "gzip"},
+                          {"configuration", {{"level", compressor["level"]}}}};
+  }
+  return absl::InvalidArgumentError("Compressor " + id +
+                                    " has no Zarr v3 codec");
+}
+
+/**
+ * @brief Converts a Zarr v2 Variable spec to a Zarr v3 Variable spec
+ * This function is intended to be an internal helper function for formatting
+ * Variable specs
+ * The chunks of a sharded Variable become the inner chunks of the
+ * "sharding_indexed" codec and the shards become the stored objects. The MDIO
+ * attributes are unchanged and get stored in the "attributes" of zarr.json.
+ * @param input A MDIO Dataset Variable list element
+ * @param variable A Zarr v2 Variable spec from `from_json_to_spec`
+ * @return A Zarr v3 Variable spec or an error if the Variable can't be
+ * represented in Zarr v3
+ */
+tensorstore::Result<nlohmann::json> to_zarr3_spec(
+    const nlohmann::json& input, const nlohmann::json& variable) {
+  if (input["dataType"].contains("fields")) {
+    return absl::InvalidArgumentError(
+        "Structured data types can not be stored in a sharded (Zarr v3) "
+        "Dataset: " +
+        input["name"].get<std::string>());
+  }
+  const std::string dtype = input["dataType"].get<std::string>();
+  const auto& v2 = variable["metadata"];
+
+  nlohmann::json metadata;
+  metadata["data_type"] = dtype;
+  metadata["shape"] = v2["shape"];
+  metadata["dimension_names"] = variable["attributes"]["dimension_names"];
+  metadata["chunk_key_encoding"] = {{"name", "default"}};
+  if (dtype[0] == 'f') {
+    metadata["fill_value"] = "NaN";
+  } else if (dtype[0] == 'c') {
+    metadata["fill_value"] = {0.0, 0.0};
+  } else if (dtype == "bool") {
+    metadata["fill_value"] = false;
+  } else {
+    metadata["fill_value"] = 0;
+  }
+
+  nlohmann::json codecs = nlohmann::json::array();
+  // Single byte types have no endianness.
+  if (dtype == "bool" || dtype == "int8" || dtype == "uint8") {
+    codecs.push_back({{"name", "bytes"}});
+  } else {
+    codecs.push_back(
+        {{"name", "bytes"}, {"configuration", {{"endian", "little"}}}});
+  }
+  MDIO_ASSIGN_OR_RETURN(auto compressor, to_zarr3_codec(v2["compressor"]));
+  if (!compressor.is_null()) {
+    codecs.push_back(compressor);
+  }
+
+  const auto chunks = v2["chunks"].get<std::vector<uint64_t>>();
+  const auto shards = get_shard_shape(input).get<std::vector<uint64_t>>();
+  if (shards.empty()) {
+    metadata["chunk_grid"] = {{"name", "regular"},
+                              {"configuration", {{"chunk_shape", chunks}}}};
+    metadata["codecs"] = codecs;
+  } else {
+    if (shards.size() != chunks.size()) {
+      return absl::InvalidArgumentError(
+          "shardShape and chunkShape must have the same rank for " +
+          input["name"].get<std::string>());
+    }
+    for (std::size_t i = 0; i < shards.size(); ++i) {
+      if (chunks[i] == 0 || shards[i] % chunks[i] != 0) {
+        return absl::InvalidArgumentError(
+            "shardShape must be a multiple of chunkShape for " +
+            input["name"].get<std::string>());
+      }
+    }
+    metadata["chunk_grid"] = {{"name", "regular"},
+                              {"configuration", {{"chunk_shape", shards}}}};
+    nlohmann::json index_codecs = nlohmann::json::array(
+        {{{"name", "bytes"}, {"configuration", {{"endian", "little"}}}},
+         {{"name", "crc32c"}}});
+    metadata["codecs"] = nlohmann::json::array(
+        {{{"name", "sharding_indexed"},
+          {"configuration",
+           {{"chunk_shape", chunks},
+            {"codecs", codecs},
+            {"index_codecs", index_codecs}}}}});
+  }
+
+  nlohmann::json spec = variable;
+  spec["driver"] = "zarr3";
+  spec["metadata"] = metadata;
+  return spec;
+}
+
 /**
  * @brief Accumulates a map of the dimensions in a Dataset and their sizes
  * This function is intended to be an internal helper function for formatting
@@ -456,12 +774,24 @@ Construct(nlohmann::json& spec /*NOLINT*/, const std::string& path) {
 
   std::unordered_map<std::string, uint64_t> dimensionMap = dimensions.value();
 
+  // A single sharded Variable makes the whole Dataset Zarr v3.
+  bool zarr3 = false;
+  for (auto& variable : spec["variables"]) {
+    zarr3 = zarr3 || !get_shard_shape(variable).empty();
+  }
+
   std::vector<nlohmann::json> datasetSpec;
   for (auto& variable : spec["variables"]) {
     auto variableSpec = from_json_to_spec(variable, dimensionMap, path);
     if (!variableSpec.status().ok()) {
       return variableSpec.status();
     }
+    if (zarr3) {
+      variableSpec = to_zarr3_spec(variable, variableSpec.value());
+      if (!variableSpec.status().ok()) {
+        return variableSpec.status();
+      }
+    }
     datasetSpec.emplace_back(variableSpec.value());
   }
   if (!spec.contains("metadata")) {
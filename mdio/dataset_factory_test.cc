@@ -160,7 +160,19 @@ TEST(Toy, create) {
 
     )";
   nlohmann::json j = nlohmann::json::parse(schema);
+  // zfp is emulated by quantizing in front of zstd.
   auto res = Construct(j, "zarrs/toy_dataset");
+  ASSERT_TRUE(res.status().ok()) << res.status();
+  auto variables = std::get<1>(res.value());
+  EXPECT_EQ(variables[2]["metadata"]["compressor"]["id"], "zstd");
+  EXPECT_EQ(variables[2]["attributes"]["metadata"]["quantizationV1"]["mode"],
+            "fixed_accuracy");
+  EXPECT_EQ(variables[2]["attributes"]["metadata"]["chunkGrid"]["name"],
+            "regular");
+
+  // A fixed rate can't be emulated.
+  j["variables"][2]["compressor"]["mode"] = "fixed_rate";
+  res = Construct(j, "zarrs/toy_dataset");
   ASSERT_FALSE(res.status().ok()) << res.status();
 
   j["variables"][2].erase("compressor");
@@ -169,6 +181,44 @@ TEST(Toy, create) {
   ASSERT_TRUE(res.status().ok()) << res.status();
 }
 
+TEST(Toy, compressors) {
+  nlohmann::json variable = {{"name", "v"}, {"dataType", "float32"}};
+  nlohmann::json stub;
+
+  variable["compressor"] = {{"name", "zstd"}, {"level", 19}};
+  ASSERT_TRUE(transform_compressor(variable, stub).ok());
+  EXPECT_EQ(stub["metadata"]["compressor"],
+            nlohmann::json({{"id", "zstd"}, {"level", 19}}));
+
+  variable["compressor"] = {{"name", "zlib"}};
+  ASSERT_TRUE(transform_compressor(variable, stub).ok());
+  EXPECT_EQ(stub["metadata"]["compressor"]["level"], 1);
+
+  variable["compressor"] = {{"name", "blosc"}, {"algorithm", "lz4hc"},
+                            {"level", 9}};
+  ASSERT_TRUE(transform_compressor(variable, stub).ok());
+  EXPECT_EQ(stub["metadata"]["compressor"]["cname"], "lz4hc");
+  EXPECT_EQ(stub["metadata"]["compressor"]["clevel"], 9);
+
+  // Levels are checked against the codec's own range.
+  variable["compressor"] = {{"name", "blosc"}, {"level", 19}};
+  EXPECT_FALSE(transform_compressor(variable, stub).ok());
+  variable["compressor"] = {{"name", "bz2"}, {"level", 0}};
+  EXPECT_FALSE(transform_compressor(variable, stub).ok());
+  variable["compressor"] = {{"name", "blosc"}, {"algorithm", "snappy"}};
+  EXPECT_FALSE(transform_compressor(variable, stub).ok());
+  variable["compressor"] = {{"name", "lzma"}};
+  EXPECT_FALSE(transform_compressor(variable, stub).ok());
+
+  // Lossy zfp requires a floating point Variable.
+  variable["compressor"] = {{"name", "zfp"}, {"mode", "fixed_precision"},
+                            {"precision", 12}};
+  ASSERT_TRUE(transform_compressor(variable, stub).ok());
+  EXPECT_EQ(stub["attributes"]["metadata"]["quantizationV1"]["precision"], 12);
+  variable["dataType"] = "int16";
+  EXPECT_FALSE(transform_compressor(variable, stub).ok());
+}
+
 TEST(Teapot, create) {
   std::string teapotSchema = R"(
         {
@@ -632,6 +682,46 @@ TEST(Variable, maxSizeReached) {
   ASSERT_TRUE(res.status().ok()) << res.status();
 }
 
+TEST(Variable, plannedChunks) {
+  nlohmann::json j = nlohmann::json::parse(manifest);
+  auto& twoD = j["variables"][0];
+  twoD["dimensions"][0]["size"] = 4096;
+  twoD["dimensions"][1]["size"] = 4096;
+  j["variables"][1]["dimensions"][0]["size"] = 4096;
+  j["variables"][2]["dimensions"][0]["size"] = 4096;
+  twoD["metadata"].erase("chunkGrid");
+  twoD["metadata"]["chunkPlanV1"] = {{"accessPattern", "trace"},
+                                     {"targetChunkBytes", 1 << 20}};
+  auto res = Construct(j, "zarrs/simple_dataset");
+  ASSERT_TRUE(res.status().ok()) << res.status();
+  std::vector<nlohmann::json> variables = std::get<1>(res.value());
+  // Whole traces of 4096 float32 samples, 64 to a 1 MiB chunk.
+  EXPECT_EQ(variables[0]["metadata"]["chunks"], nlohmann::json({64, 4096}));
+  // Small coordinates remain a single chunk.
+  EXPECT_EQ(variables[1]["metadata"]["chunks"], nlohmann::json({4096}));
+
+  j["variables"][0]["metadata"]["chunkPlanV1"]["accessPattern"] = "diagonal";
+  EXPECT_FALSE(Construct(j, "zarrs/simple_dataset").status().ok());
+}
+
+TEST(Variable, chunkShapeWarning) {
+  nlohmann::json input = {
+      {"name", "tiny"},
+      {"metadata",
+       {{"chunkGrid",
+         {{"name", "regular"},
+          {"configuration", {{"chunkShape", {2, 2}}}}}}}}};
+  nlohmann::json variable = {
+      {"metadata", {{"dtype", "<f4"}, {"shape", {4096, 4096}}}}};
+  auto warning = transform_chunks(input, variable);
+  ASSERT_TRUE(warning.has_value());
+  EXPECT_THAT(*warning, ::testing::HasSubstr("Variable tiny has chunks of"));
+  EXPECT_EQ(variable["metadata"]["chunks"], nlohmann::json({2, 2}));
+
+  input["metadata"]["chunkGrid"]["configuration"]["chunkShape"] = {512, 512};
+  EXPECT_FALSE(transform_chunks(input, variable).has_value());
+}
+
 TEST(Xarray, open) {
   nlohmann::json j = nlohmann::json::parse(manifest);
   auto res = Construct(j, "zarrs/simple_dataset");
@@ -646,4 +736,37 @@ TEST(Xarray, open) {
   }
 }
 
+TEST(Zarr3, sharded) {
+  nlohmann::json j = nlohmann::json::parse(manifest);
+  j["variables"][0]["metadata"]["chunkGrid"]["configuration"]["shardShape"] = {
+      10, 10};
+  auto res = Construct(j, "zarrs/sharded_dataset");
+  ASSERT_TRUE(res.status().ok()) << res.status();
+
+  std::vector<nlohmann::json> variables = std::get<1>(res.value());
+  // Every Variable is Zarr v3 once one of them is sharded.
+  for (auto& variable : variables) {
+    EXPECT_EQ(variable["driver"], "zarr3") << variable;
+  }
+  auto& metadata = variables[0]["metadata"];
+  EXPECT_EQ(metadata["chunk_grid"]["configuration"]["chunk_shape"],
+            nlohmann::json({10, 10}));
+  EXPECT_EQ(metadata["codecs"][0]["name"], "sharding_indexed");
+  EXPECT_EQ(metadata["codecs"][0]["configuration"]["chunk_shape"],
+            nlohmann::json({5, 5}));
+
+  for (auto& variable : variables) {
+    auto varStatus =
+        mdio::Variable<>::Open(variable, mdio::constants::kCreateClean);
+    EXPECT_TRUE(varStatus.status().ok()) << varStatus.status();
+  }
+
+  // Shards must hold a whole number of chunks.
+  j = nlohmann::json::parse(manifest);
+  j["variables"][0]["metadata"]["chunkGrid"]["configuration"]["shardShape"] = {
+      10, 7};
+  res = Construct(j, "zarrs/sharded_dataset");
+  EXPECT_FALSE(res.status().ok());
+}
+
 }  // namespace
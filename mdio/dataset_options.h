@@ -0,0 +1,167 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MDIO_DATASET_OPTIONS_H_
+#define MDIO_DATASET_OPTIONS_H_
+
+#include <cstddef>
+#include <optional>
+#include <type_traits>
+
+#include "absl/status/status.h"
+#include "mdio/impl.h"
+#include "tensorstore/context.h"
+#include "tensorstore/kvstore/kvstore.h"
+#include "tensorstore/open_options.h"
+
+// clang-format off
+#include <nlohmann/json.hpp>  // NOLINT
+// clang-format on
+
+namespace mdio {
+
+/**
+ * @brief Resource limits shared by every Variable of a Dataset.
+ * The options are turned into a single `mdio::Context`. Passing that Context
+ * to `Dataset::Open` or `Dataset::from_json` makes all of the Variables share
+ * one chunk cache and one set of I/O concurrency limits. Unset limits keep the
+ * Tensorstore defaults.
+ * @details \b Usage
+ * @code
+ * mdio::DatasetOptions options;
+ * options.cache_pool_bytes = 1 << 30;
+ * options.s3_request_concurrency = 16;
+ * MDIO_ASSIGN_OR_RETURN(auto context, options.MakeContext());
+ * auto dataset = mdio::Dataset::Open(path, mdio::constants::kOpen, context);
+ * @endcode
+ */
+struct DatasetOptions {
+  /// The byte budget of the chunk cache. Tensorstore doesn't cache by default.
+  std::optional<std::size_t> cache_pool_bytes;
+  /// The number of threads copying and (de)compressing chunks.
+  std::optional<std::size_t> data_copy_concurrency;
+  /// The number of concurrent local file operations.
+  std::optional<std::size_t> file_io_concurrency;
+  /// The number of concurrent S3 requests.
+  std::optional<std::size_t> s3_request_concurrency;
+  /// The number of concurrent GCS requests.
+  std::optional<std::size_t> gcs_request_concurrency;
+  /// Any other Tensorstore context resources, applied over the ones above.
+  ::nlohmann::json resources = ::nlohmann::json::object();
+
+  /**
+   * @brief Gets the Tensorstore context spec of the options.
+   */
+  ::nlohmann::json ToJson() const {
+    ::nlohmann::json spec = ::nlohmann::json::object();
+    if (cache_pool_bytes.has_value()) {
+      spec["cache_pool"] = {{"total_bytes_limit", *cache_pool_bytes}};
+    }
+    if (data_copy_concurrency.has_value()) {
+      spec["data_copy_concurrency"] = {{"limit", *data_copy_concurrency}};
+    }
+    if (file_io_concurrency.has_value()) {
+      spec["file_io_concurrency"] = {{"limit", *file_io_concurrency}};
+    }
+    if (s3_request_concurrency.has_value()) {
+      spec["s3_request_concurrency"] = {{"limit", *s3_request_concurrency}};
+    }
+    if (gcs_request_concurrency.has_value()) {
+      spec["gcs_request_concurrency"] = {{"limit", *gcs_request_concurrency}};
+    }
+    spec.update(resources);
+    return spec;
+  }
+
+  /**
+   * @brief Creates a new Context with these limits.
+   * Every call creates independent resources, so each tenant of a process
+   * should make its own Context.
+   * @return The Context or an error if `resources` is not a valid spec.
+   */
+  Result<Context> MakeContext() const {
+    MDIO_ASSIGN_OR_RETURN(auto spec, Context::Spec::FromJson(ToJson()))
+    return Context(spec);
+  }
+};
+
+namespace internal {
+
+/**
+ * @brief Gets the Context given in a list of open options.
+ * @return The last Context given, or a null Context if there is none.
+ */
+template <typename... Option>
+Context ContextFromOptions(const Option&... options) {
+  Context context;
+  (
+      [&context](const auto& option) {
+        using O = std::decay_t<decltype(option)>;
+        if constexpr (std::is_base_of_v<tensorstore::OpenOptions, O>) {
+          if (option.context) {
+            context = option.context;
+          }
+        } else if constexpr (std::is_same_v<O, Context>) {
+          context = option;
+        }
+      }(options),
+      ...);
+  return context;
+}
+
+/**
+ * @brief Collects a list of open options into one.
+ * @return The options, or an error if one of them conflicts with another.
+ */
+template <typename... Option>
+Result<tensorstore::TransactionalOpenOptions> OpenOptionsFromOptions(
+    const Option&... options) {
+  tensorstore::TransactionalOpenOptions open_options;
+  absl::Status status;
+  (
+      [&open_options, &status](const auto& option) {
+        using O = std::decay_t<decltype(option)>;
+        if (!status.ok()) {
+          return;
+        }
+        if constexpr (std::is_same_v<O,
+                                     tensorstore::TransactionalOpenOptions>) {
+          open_options = option;
+        } else {
+          status = open_options.Set(option);
+        }
+      }(options),
+      ...);
+  if (!status.ok()) {
+    return status;
+  }
+  return open_options;
+}
+
+/**
+ * @brief Opens a kvstore in the given Context.
+ * A null Context opens it in the default one.
+ */
+inline Future<tensorstore::KvStore> OpenKvStore(const ::nlohmann::json& spec,
+                                                const Context& context) {
+  if (context) {
+    return tensorstore::kvstore::Open(spec, context);
+  }
+  return tensorstore::kvstore::Open(spec);
+}
+
+}  // namespace internal
+}  // namespace mdio
+
+#endif  // MDIO_DATASET_OPTIONS_H_
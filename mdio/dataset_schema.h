@@ -215,6 +215,31 @@ It should NOT be modified unless the MDIO Dataset model schema is updated.
          "title": "BloscShuffle",
          "type": "integer"
       },
+      "BZ2": {
+         "additionalProperties": false,
+         "description": "Data Model for BZ2 options.",
+         "properties": {
+            "name": {
+               "const": "bz2",
+               "description": "Name of the compressor.",
+               "title": "Name",
+               "type": "string"
+            },
+            "level": {
+               "default": 1,
+               "description": "The compression level.",
+               "maximum": 9,
+               "minimum": 1,
+               "title": "Level",
+               "type": "integer"
+            }
+         },
+         "required": [
+            "name"
+         ],
+         "title": "BZ2",
+         "type": "object"
+      },
       "CenteredBinHistogram": {
          "additionalProperties": false,
          "description": "Class representing a center bin histogram.",
@@ -288,6 +313,15 @@ It should NOT be modified unless the MDIO Dataset model schema is updated.
                   {
                      "$ref": "#/$defs/ZFP"
                   },
+                  {
+                     "$ref": "#/$defs/Zstd"
+                  },
+                  {
+                     "$ref": "#/$defs/Zlib"
+                  },
+                  {
+                     "$ref": "#/$defs/BZ2"
+                  },
                   {
                      "type": "null"
                   }
@@ -636,6 +670,14 @@ It should NOT be modified unless the MDIO Dataset model schema is updated.
                },
                "title": "Chunkshape",
                "type": "array"
+            },
+            "shardShape": {
+               "description": "Lengths of the shard along each dimension of the array. Each must be a multiple of the chunk length. Sharded datasets are stored as Zarr v3 with chunks packed into shards.",
+               "items": {
+                  "type": "integer"
+               },
+               "title": "Shardshape",
+               "type": "array"
             }
          },
          "required": [
@@ -881,6 +923,15 @@ It should NOT be modified unless the MDIO Dataset model schema is updated.
                   {
                      "$ref": "#/$defs/ZFP"
                   },
+                  {
+                     "$ref": "#/$defs/Zstd"
+                  },
+                  {
+                     "$ref": "#/$defs/Zlib"
+                  },
+                  {
+                     "$ref": "#/$defs/BZ2"
+                  },
                   {
                      "type": "null"
                   }
@@ -969,6 +1020,50 @@ It should NOT be modified unless the MDIO Dataset model schema is updated.
                "description": "Chunk grid specification for the array.",
                "title": "Chunkgrid"
             },
+            "chunkPlanV1": {
+               "additionalProperties": false,
+               "description": "Guides the chunk shape chosen when no chunkGrid is given.",
+               "properties": {
+                  "accessPattern": {
+                     "default": "balanced",
+                     "description": "The dominant read pattern of the array.",
+                     "enum": [
+                        "trace",
+                        "inline",
+                        "time",
+                        "balanced"
+                     ],
+                     "type": "string"
+                  },
+                  "targetChunkBytes": {
+                     "description": "The uncompressed size a chunk aims for.",
+                     "minimum": 1,
+                     "type": "integer"
+                  }
+               },
+               "title": "Chunkplanv1",
+               "type": "object"
+            },
+            "scaleOffsetV1": {
+               "additionalProperties": false,
+               "description": "Stores floating point samples as integers, a stored sample q is q * scale + offset.",
+               "properties": {
+                  "offset": {
+                     "default": 0,
+                     "description": "The value of the stored integer 0.",
+                     "type": "number"
+                  },
+                  "scale": {
+                     "description": "The step between stored integers.",
+                     "type": "number"
+                  }
+               },
+               "required": [
+                  "scale"
+               ],
+               "title": "Scaleoffsetv1",
+               "type": "object"
+            },
             "unitsV1": {
                "anyOf": [
                   {
@@ -1167,6 +1262,56 @@ It should NOT be modified unless the MDIO Dataset model schema is updated.
          ],
          "title": "ZFPMode",
          "type": "string"
+      },
+      "Zlib": {
+         "additionalProperties": false,
+         "description": "Data Model for Zlib options.",
+         "properties": {
+            "name": {
+               "const": "zlib",
+               "description": "Name of the compressor.",
+               "title": "Name",
+               "type": "string"
+            },
+            "level": {
+               "default": 1,
+               "description": "The compression level.",
+               "maximum": 9,
+               "minimum": 0,
+               "title": "Level",
+               "type": "integer"
+            }
+         },
+         "required": [
+            "name"
+         ],
+         "title": "Zlib",
+         "type": "object"
+      },
+      "Zstd": {
+         "additionalProperties": false,
+         "description": "Data Model for Zstandard options.",
+         "properties": {
+            "name": {
+               "const": "zstd",
+               "description": "Name of the compressor.",
+               "title": "Name",
+               "type": "string"
+            },
+            "level": {
+               "default": 3,
+               "description": "The compression level.",
+               "maximum": 22,
+               "minimum": -131072,
+               "title": "Level",
+               "type": "integer"
+            }
+         },
+         "required": [
+            "name"
+         ],
+         "title": "Zstd",
+         "type": "object"
       }
    },
    "$schema": "https://json-schema.org/draft/2020-12/schema",
@@ -17,7 +17,10 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <filesystem>
+#include <map>
+#include <mutex>
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -411,6 +414,50 @@ TEST(Dataset, isel) {
       << "Inline range should end at 5";
 }
 
+TEST(Dataset, iselIsLazy) {
+  auto json_vars = GetToyExample();
+
+  auto dataset = mdio::Dataset::from_json(json_vars, "zarrs/acceptance",
+                                          mdio::constants::kCreateClean)
+                     .result();
+  ASSERT_TRUE(dataset.ok()) << dataset.status();
+
+  std::vector<mdio::RangeDescriptor<mdio::Index>> slices = {
+      {"inline", 10, 20, 1}, {"crossline", 0, 4, 1}, {"inline", 40, 45, 1}};
+  auto slice = dataset->isel(
+      static_cast<const std::vector<mdio::RangeDescriptor<mdio::Index>>&>(
+          slices));
+  ASSERT_TRUE(slice.ok()) << slice.status();
+
+  // The slice shares the metadata of the Dataset.
+  EXPECT_EQ(&slice->getMetadata(), &dataset->getMetadata());
+
+  // The domain is derived without slicing the Variables, it must agree with
+  // them once they are accessed.
+  auto inlineRange = slice->domain[2];
+  EXPECT_EQ(inlineRange.interval().inclusive_min(), 10);
+  EXPECT_EQ(inlineRange.interval().size(), 15);
+  EXPECT_EQ(slice->domain[0].interval().size(), 4);
+
+  for (const auto& key : slice->variables.get_iterable_accessor()) {
+    auto var = slice->variables.at(key);
+    ASSERT_TRUE(var.ok()) << var.status();
+    auto varDomain = var->dimensions();
+    for (mdio::DimensionIndex i = 0; i < varDomain.rank(); ++i) {
+      auto label = varDomain.labels()[i];
+      if (label.empty()) {
+        continue;
+      }
+      const auto labels = slice->domain.labels();
+      auto it = std::find(labels.begin(), labels.end(), label);
+      ASSERT_NE(it, labels.end()) << label;
+      EXPECT_EQ(varDomain[i].interval(),
+                slice->domain[it - labels.begin()].interval())
+          << key << " " << label;
+    }
+  }
+}
+
 TEST(Dataset, iselWithStride) {
   // Tests the integrity of data that is written with a strided slice.
   std::string iselPath = "zarrs/acceptance";
@@ -796,6 +843,34 @@ TEST(Dataset, selList) {
   ASSERT_TRUE(sliceRes.ok()) << sliceRes.status();
 }
 
+TEST(Dataset, selListSamples) {
+  std::string path = "zarrs/selTester.mdio";
+  auto dsRes = makePopulated(path);
+  ASSERT_TRUE(dsRes.ok()) << dsRes.status();
+  auto ds = dsRes.value();
+
+  mdio::ListDescriptor<mdio::dtypes::int32_t> ilValues = {"inline",
+                                                          {2, 1, 5, 7}};
+  auto sliceRes = ds.sel(ilValues);
+  ASSERT_TRUE(sliceRes.ok()) << sliceRes.status();
+  auto dataVarRes = sliceRes.value().variables.at("data");
+  ASSERT_TRUE(dataVarRes.status().ok()) << dataVarRes.status();
+  auto samples = dataVarRes.value().num_samples();
+  EXPECT_EQ(samples, 4 * 15 * 20)
+      << "Expected 4*15*20 samples for data but got " << samples;
+}
+
+TEST(Dataset, selListRepeatedInList) {
+  std::string path = "zarrs/selTester.mdio";
+  auto dsRes = makePopulated(path);
+  ASSERT_TRUE(dsRes.ok()) << dsRes.status();
+  auto ds = dsRes.value();
+
+  mdio::ListDescriptor<mdio::dtypes::int32_t> ilValues = {"inline", {2, 2}};
+  auto sliceRes = ds.sel(ilValues);
+  ASSERT_FALSE(sliceRes.ok());
+}
+
 TEST(Dataset, selListMissingCoord) {
   std::string path = "zarrs/selTester.mdio";
   auto dsRes = makePopulated(path);
@@ -960,6 +1035,60 @@ TEST(Dataset, selectFieldName) {
       << "Expected selected variable to be named image_headers";
 }
 
+TEST(Dataset, selectFields) {
+  auto json_var = GetToyExample();
+  auto dataset = mdio::Dataset::from_json(json_var, "zarrs/fields",
+                                          mdio::constants::kCreateClean)
+                     .result();
+  ASSERT_TRUE(dataset.ok()) << dataset.status();
+  auto ds = dataset.value();
+
+  mdio::RangeDescriptor<mdio::Index> desc = {"inline", 10, 20, 1};
+  auto sliced = ds.isel(desc);
+  ASSERT_TRUE(sliced.ok()) << sliced.status();
+
+  // Fill two of the fields through their views.
+  for (const auto& [name, scale] :
+       std::vector<std::pair<std::string, int>>{{"cdp-x", 1}, {"cdp-y", 2}}) {
+    auto field =
+        sliced->SelectField<mdio::dtypes::int32_t>("image_headers", name)
+            .result();
+    ASSERT_TRUE(field.ok()) << field.status();
+    EXPECT_EQ(field->dimensions().shape()[0], 10);
+    auto data = mdio::from_variable<mdio::dtypes::int32_t>(field.value());
+    ASSERT_TRUE(data.ok()) << data.status();
+    auto ptr = data->get_data_accessor().data() + data->get_flattened_offset();
+    for (mdio::Index i = 0; i < 10 * 512; ++i) {
+      ptr[i] = static_cast<mdio::dtypes::int32_t>(i * scale);
+    }
+    ASSERT_TRUE(field->Write(data.value()).commit_future.result().ok());
+  }
+
+  // The Dataset now holds the cdp-y view, the records are read once.
+  auto fields = sliced->SelectFields("image_headers", {"cdp-y", "cdp-x"});
+  ASSERT_TRUE(fields.result().ok()) << fields.status();
+  auto headers = fields.value();
+  ASSERT_EQ(headers.size(), 2);
+  EXPECT_EQ(headers[0].dtype(), mdio::constants::kInt32);
+  EXPECT_EQ(headers[0].rank(), 2);
+  EXPECT_EQ(headers[0].dimensions().labels()[0], "inline");
+  EXPECT_EQ(headers[0].dimensions().origin()[0], 10);
+  auto cdpY = static_cast<mdio::dtypes::int32_t*>(
+                  headers[0].get_data_accessor().data()) +
+              headers[0].get_flattened_offset();
+  auto cdpX = static_cast<mdio::dtypes::int32_t*>(
+                  headers[1].get_data_accessor().data()) +
+              headers[1].get_flattened_offset();
+  EXPECT_EQ(cdpX[700], 700);
+  EXPECT_EQ(cdpY[700], 1400);
+
+  EXPECT_FALSE(
+      sliced->SelectFields("image_headers", {"NotAField"}).result().ok());
+  EXPECT_FALSE(sliced->SelectFields("image", {"cdp-x"}).result().ok());
+
+  std::filesystem::remove_all("zarrs/fields");
+}
+
 TEST(Dataset, fromConsolidatedMeta) {
   auto json_vars = GetToyExample();
 
@@ -976,6 +1105,170 @@ TEST(Dataset, fromConsolidatedMeta) {
   ASSERT_TRUE(new_dataset.status().ok()) << new_dataset.status();
 }
 
+TEST(Dataset, sharedContext) {
+  mdio::DatasetOptions options;
+  options.cache_pool_bytes = 1 << 20;
+  options.data_copy_concurrency = 2;
+  options.file_io_concurrency = 4;
+  auto spec = options.ToJson();
+  EXPECT_EQ(spec["cache_pool"]["total_bytes_limit"], 1 << 20);
+  EXPECT_EQ(spec["file_io_concurrency"]["limit"], 4);
+  EXPECT_FALSE(spec.contains("s3_request_concurrency"));
+  auto context = options.MakeContext();
+  ASSERT_TRUE(context.ok()) << context.status();
+
+  auto json_vars = GetToyExample();
+  auto dataset =
+      mdio::Dataset::from_json(json_vars, "zarrs/context",
+                               mdio::constants::kCreateClean, context.value())
+          .result();
+  ASSERT_TRUE(dataset.ok()) << dataset.status();
+  EXPECT_TRUE(dataset->get_context());
+
+  auto opened = mdio::Dataset::Open("zarrs/context/", mdio::constants::kOpen,
+                                    context.value())
+                    .result();
+  ASSERT_TRUE(opened.ok()) << opened.status();
+  mdio::RangeDescriptor<mdio::Index> desc = {"inline", 0, 10, 1};
+  auto sliced = opened->isel(desc);
+  ASSERT_TRUE(sliced.ok()) << sliced.status();
+  EXPECT_TRUE(sliced->get_context());
+
+  // The structured field is reopened in the same Context.
+  auto field = sliced->SelectField("image_headers", "cdp-x");
+  ASSERT_TRUE(field.result().ok()) << field.status();
+
+  // Without a Context the Variables still share a default one.
+  auto shared =
+      mdio::Dataset::Open("zarrs/context/", mdio::constants::kOpen).result();
+  ASSERT_TRUE(shared.ok()) << shared.status();
+  EXPECT_TRUE(shared->get_context());
+
+  options.resources = {{"cache_pool", {{"total_bytes_limit", "lots"}}}};
+  EXPECT_FALSE(options.MakeContext().ok());
+
+  std::filesystem::remove_all("zarrs/context");
+}
+
+TEST(Dataset, openLazy) {
+  auto json_vars = GetToyExample();
+  auto dataset = mdio::Dataset::from_json(json_vars, "zarrs/lazy",
+                                          mdio::constants::kCreateClean)
+                     .result();
+  ASSERT_TRUE(dataset.ok()) << dataset.status();
+
+  auto eager =
+      mdio::Dataset::Open("zarrs/lazy/", mdio::constants::kOpen).result();
+  ASSERT_TRUE(eager.ok()) << eager.status();
+  auto lazy =
+      mdio::Dataset::OpenLazy("zarrs/lazy/", mdio::constants::kOpen).result();
+  ASSERT_TRUE(lazy.ok()) << lazy.status();
+
+  // Nothing is opened but the layout matches the eager open.
+  auto keys = lazy->variables.get_iterable_accessor();
+  EXPECT_EQ(keys, eager->variables.get_iterable_accessor());
+  for (const auto& key : keys) {
+    EXPECT_FALSE(lazy->variables.is_open(key)) << key;
+  }
+  EXPECT_EQ(lazy->coordinates, eager->coordinates);
+  std::map<std::string, mdio::Index> lazy_dims, eager_dims;
+  for (mdio::DimensionIndex d = 0; d < lazy->domain.rank(); ++d) {
+    lazy_dims[std::string(lazy->domain.labels()[d])] = lazy->domain.shape()[d];
+  }
+  for (mdio::DimensionIndex d = 0; d < eager->domain.rank(); ++d) {
+    eager_dims[std::string(eager->domain.labels()[d])] =
+        eager->domain.shape()[d];
+  }
+  EXPECT_EQ(lazy_dims, eager_dims);
+
+  // Slices are recorded and applied once the Variable is opened.
+  mdio::RangeDescriptor<mdio::Index> desc = {"inline", 0, 10, 1};
+  auto sliced = lazy->isel(desc);
+  ASSERT_TRUE(sliced.ok()) << sliced.status();
+  auto image = sliced->variables.get<float>("image");
+  ASSERT_TRUE(image.ok()) << image.status();
+  EXPECT_EQ(image->dimensions().shape()[0], 10);
+
+  // The opened Variable is shared with the original Dataset.
+  EXPECT_TRUE(lazy->variables.is_open("image"));
+  EXPECT_FALSE(lazy->variables.is_open("velocity"));
+
+  std::filesystem::remove_all("zarrs/lazy");
+}
+
+TEST(Dataset, zarr3Sharded) {
+  const std::string schema = R"(
+{
+  "metadata": {
+    "name": "sharded",
+    "apiVersion": "1.0.0",
+    "createdOn": "2023-12-12T15:02:06.413469-06:00"
+  },
+  "variables": [
+    {
+      "name": "image",
+      "dataType": "float32",
+      "dimensions": [{"name": "x", "size": 20}, {"name": "y", "size": 30}],
+      "metadata": {
+        "chunkGrid": {
+          "name": "regular",
+          "configuration": {"chunkShape": [5, 5], "shardShape": [10, 15]}
+        }
+      },
+      "coordinates": ["x", "y"],
+      "compressor": {"name": "blosc", "algorithm": "zstd"}
+    },
+    {
+      "name": "x",
+      "dataType": "uint32",
+      "dimensions": [{"name": "x", "size": 20}]
+    },
+    {
+      "name": "y",
+      "dataType": "uint32",
+      "dimensions": [{"name": "y", "size": 30}]
+    }
+  ]
+}
+  )";
+  auto json_vars = ::nlohmann::json::parse(schema);
+  auto dataset = mdio::Dataset::from_json(json_vars, "zarrs/sharded",
+                                          mdio::constants::kCreateClean)
+                     .result();
+  ASSERT_TRUE(dataset.ok()) << dataset.status();
+  EXPECT_TRUE(std::filesystem::exists("zarrs/sharded/zarr.json"));
+  EXPECT_FALSE(std::filesystem::exists("zarrs/sharded/.zmetadata"));
+
+  auto image = dataset->variables.get<float>("image");
+  ASSERT_TRUE(image.ok()) << image.status();
+  auto chunks = image->get_chunk_shape();
+  ASSERT_TRUE(chunks.ok()) << chunks.status();
+  EXPECT_EQ((*chunks)[0], 10);
+  EXPECT_EQ((*chunks)[1], 15);
+
+  auto data = mdio::from_variable<float>(image.value());
+  ASSERT_TRUE(data.ok()) << data.status();
+  auto ptr = data->get_data_accessor().data() + data->get_flattened_offset();
+  for (mdio::Index i = 0; i < 600; ++i) {
+    ptr[i] = static_cast<float>(i);
+  }
+  ASSERT_TRUE(image->Write(data.value()).commit_future.result().ok());
+
+  auto reopened =
+      mdio::Dataset::Open("zarrs/sharded/", mdio::constants::kOpen).result();
+  ASSERT_TRUE(reopened.ok()) << reopened.status();
+  auto reopened_image = reopened->variables.get<float>("image");
+  ASSERT_TRUE(reopened_image.ok()) << reopened_image.status();
+  EXPECT_EQ(reopened_image->get_long_name(), image->get_long_name());
+  auto read = reopened_image->Read().result();
+  ASSERT_TRUE(read.ok()) << read.status();
+  auto read_ptr =
+      read->get_data_accessor().data() + read->get_flattened_offset();
+  EXPECT_EQ(read_ptr[599], 599.0f);
+
+  std::filesystem::remove_all("zarrs/sharded");
+}
+
 TEST(Dataset, open) {
   auto json_schema = GetToyExample();
 
@@ -1328,6 +1621,136 @@ TEST(Dataset, commitSlicedMetadata) {
   EXPECT_TRUE(commitRes.status().ok()) << commitRes.status();
 }
 
+TEST(Dataset, commitMetadataConflict) {
+  const std::string path = "zarrs/commit_conflict";
+  auto json_vars = GetToyExample();
+  auto created =
+      mdio::Dataset::from_json(json_vars, path, mdio::constants::kCreateClean)
+          .result();
+  ASSERT_TRUE(created.ok()) << created.status();
+
+  auto first = mdio::Dataset::Open(path + "/", mdio::constants::kOpen).result();
+  ASSERT_TRUE(first.ok()) << first.status();
+  auto second =
+      mdio::Dataset::Open(path + "/", mdio::constants::kOpen).result();
+  ASSERT_TRUE(second.ok()) << second.status();
+
+  auto update = [](mdio::Dataset& ds, const std::string& value) {
+    auto image = ds.variables.at("image");
+    ASSERT_TRUE(image.ok()) << image.status();
+    auto attrs = image->GetAttributes();
+    attrs["attributes"]["owner"] = value;
+    auto updated = image->UpdateAttributes<float>(attrs);
+    ASSERT_TRUE(updated.ok()) << updated.status();
+  };
+
+  update(first.value(), "first");
+  ASSERT_TRUE(first->CommitMetadata().result().ok());
+
+  // The second Dataset read the metadata the first one has since replaced.
+  update(second.value(), "second");
+  auto conflict = second->CommitMetadata().result();
+  EXPECT_EQ(conflict.status().code(), absl::StatusCode::kFailedPrecondition)
+      << conflict.status();
+
+  // The first Dataset keeps committing over its own writes.
+  update(first.value(), "again");
+  ASSERT_TRUE(first->CommitMetadata().result().ok());
+
+  // The consolidated metadata is written compactly.
+  std::ifstream zmetadata(path + "/.zmetadata");
+  std::stringstream contents;
+  contents << zmetadata.rdbuf();
+  EXPECT_EQ(contents.str().find('\n'), std::string::npos);
+  auto reopened =
+      mdio::Dataset::Open(path + "/", mdio::constants::kOpen).result();
+  ASSERT_TRUE(reopened.ok()) << reopened.status();
+  auto image = reopened->variables.at("image");
+  ASSERT_TRUE(image.ok()) << image.status();
+  EXPECT_EQ(image->GetAttributes()["attributes"]["owner"], "again");
+
+  std::filesystem::remove_all(path);
+}
+
+TEST(Dataset, zmetadataConflictKeepsGroup) {
+  const std::string path = "zarrs/zmetadata_conflict";
+  auto created = mdio::Dataset::from_json(GetToyExample(), path,
+                                          mdio::constants::kCreateClean)
+                     .result();
+  ASSERT_TRUE(created.ok()) << created.status();
+  std::vector<::nlohmann::json> json_vars;
+  for (const auto& key : created->variables.get_keys()) {
+    auto var = created->variables.at(key);
+    ASSERT_TRUE(var.ok()) << var.status();
+    auto json = mdio::internal::variable_zmetadata_json(var.value());
+    ASSERT_TRUE(json.ok()) << json.status();
+    json_vars.push_back(json.value());
+  }
+  auto metadata = created->getMetadata();
+
+  auto first = mdio::internal::write_zmetadata(metadata, json_vars).result();
+  ASSERT_TRUE(first.ok()) << first.status();
+  ASSERT_TRUE(
+      mdio::internal::write_zmetadata(metadata, json_vars).result().ok());
+
+  // A committer over the first generation lost the race to the second.
+  mdio::internal::ZMetadataWriteOptions options;
+  options.if_equal = first->generation;
+  auto stale = metadata;
+  stale["attributes"]["owner"] = "stale";
+  auto conflict = mdio::internal::write_zmetadata(stale, json_vars,
+                                                  mdio::Context(), options)
+                      .result();
+  EXPECT_EQ(conflict.status().code(), absl::StatusCode::kFailedPrecondition)
+      << conflict.status();
+
+  // The group still agrees with the consolidated metadata.
+  std::ifstream zattrs(path + "/.zattrs");
+  auto group = ::nlohmann::json::parse(zattrs);
+  EXPECT_FALSE(group["attributes"].contains("owner")) << group.dump();
+
+  std::filesystem::remove_all(path);
+}
+
+TEST(Dataset, openMemoized) {
+  const std::string path = "zarrs/memoized/";
+  auto json_vars = GetToyExample();
+  auto created =
+      mdio::Dataset::from_json(json_vars, path, mdio::constants::kCreateClean)
+          .result();
+  ASSERT_TRUE(created.ok()) << created.status();
+
+  auto first = mdio::Dataset::Open(path, mdio::constants::kOpen).result();
+  ASSERT_TRUE(first.ok()) << first.status();
+  auto& memo = mdio::internal::ProcessConsolidatedMemo();
+  {
+    std::lock_guard<std::mutex> lock(memo.mutex);
+    ASSERT_EQ(memo.entries.count(path), 1);
+  }
+
+  // A commit changes the generation, the next open sees the new metadata.
+  auto image = first->variables.at("image");
+  ASSERT_TRUE(image.ok()) << image.status();
+  auto attrs = image->GetAttributes();
+  attrs["attributes"]["owner"] = "memo";
+  ASSERT_TRUE(image->UpdateAttributes<float>(attrs).ok());
+  ASSERT_TRUE(first->CommitMetadata().result().ok());
+
+  auto second = mdio::Dataset::Open(path, mdio::constants::kOpen).result();
+  ASSERT_TRUE(second.ok()) << second.status();
+  auto reread = second->variables.at("image");
+  ASSERT_TRUE(reread.ok()) << reread.status();
+  EXPECT_EQ(reread->GetAttributes()["attributes"]["owner"], "memo");
+
+  // An unchanged Dataset is served from the memo.
+  auto third = mdio::Dataset::Open(path, mdio::constants::kOpen).result();
+  ASSERT_TRUE(third.ok()) << third.status();
+  EXPECT_EQ(third->variables.get_keys().size(),
+            second->variables.get_keys().size());
+
+  std::filesystem::remove_all(path);
+}
+
 TEST(Dataset, openNonExistent) {
   auto json_vars = GetToyExample();
 
@@ -1389,4 +1812,232 @@ TEST(Dataset, mockV0) {
       << reopenedDsFut.value();
 }
 
+TEST(Dataset, readVariables) {
+  std::string path = "zarrs/selTester.mdio";
+  auto dsRes = makePopulated(path);
+  ASSERT_TRUE(dsRes.ok()) << dsRes.status();
+  auto ds = dsRes.value();
+
+  auto readFut =
+      ds.ReadVariables({"data", "inline", "crossline", "depth"}, 2);
+  ASSERT_TRUE(readFut.status().ok()) << readFut.status();
+  auto data = readFut.value();
+  ASSERT_EQ(data.size(), 4);
+
+  auto crossline = data.at("crossline").get_data_accessor();
+  auto xlineAccessor =
+      tensorstore::StaticDataTypeCast<mdio::dtypes::int32_t,
+                                      tensorstore::unchecked>(crossline);
+  for (mdio::Index i = 0; i < 15; ++i) {
+    EXPECT_EQ(xlineAccessor({i}), i + 18);
+  }
+  EXPECT_EQ(data.at("data").num_samples(), 10 * 15 * 20);
+
+  auto missingFut = ds.ReadVariables({"data", "notAVariable"});
+  EXPECT_FALSE(missingFut.status().ok());
+}
+
+TEST(Dataset, writeVariables) {
+  std::string path = "zarrs/selTester.mdio";
+  auto dsRes = makePopulated(path);
+  ASSERT_TRUE(dsRes.ok()) << dsRes.status();
+  auto ds = dsRes.value();
+
+  auto readFut = ds.ReadVariables({"crossline", "depth"});
+  ASSERT_TRUE(readFut.status().ok()) << readFut.status();
+  auto data = readFut.value();
+
+  std::vector<mdio::VariableData<>> toWrite;
+  for (auto& [name, varData] : data) {
+    auto accessor =
+        tensorstore::StaticDataTypeCast<mdio::dtypes::int32_t,
+                                        tensorstore::unchecked>(
+            varData.get_data_accessor());
+    accessor({0}) = -1;
+    toWrite.push_back(varData);
+  }
+  auto writeFut = ds.WriteVariables(toWrite, 1);
+  ASSERT_TRUE(writeFut.status().ok()) << writeFut.status();
+
+  auto rereadFut = ds.ReadVariables({"crossline", "depth"});
+  ASSERT_TRUE(rereadFut.status().ok()) << rereadFut.status();
+  for (auto& [name, varData] : rereadFut.value()) {
+    auto accessor =
+        tensorstore::StaticDataTypeCast<mdio::dtypes::int32_t,
+                                        tensorstore::unchecked>(
+            varData.get_data_accessor());
+    EXPECT_EQ(accessor({0}), -1) << name;
+  }
+}
+
+TEST(Dataset, transaction) {
+  std::string path = "zarrs/transaction.mdio";
+  auto dsRes = makePopulated(path);
+  ASSERT_TRUE(dsRes.ok()) << dsRes.status();
+  auto ds = dsRes.value();
+
+  auto readFut = ds.ReadVariables({"crossline", "depth"});
+  ASSERT_TRUE(readFut.status().ok()) << readFut.status();
+  auto data = readFut.value();
+
+  auto transaction = ds.StartTransaction();
+  for (auto& [name, varData] : data) {
+    auto accessor =
+        tensorstore::StaticDataTypeCast<mdio::dtypes::int32_t,
+                                        tensorstore::unchecked>(
+            varData.get_data_accessor());
+    accessor({0}) = -1;
+    auto written = transaction.Write(varData);
+    ASSERT_TRUE(written.ok()) << written.status();
+  }
+  auto image = ds.variables.at("data");
+  ASSERT_TRUE(image.ok()) << image.status();
+  auto attrs = image->GetAttributes();
+  attrs["attributes"]["owner"] = "transaction";
+  ASSERT_TRUE(image->UpdateAttributes<float>(attrs).ok());
+  auto staged = transaction.CommitMetadata();
+  ASSERT_TRUE(staged.ok()) << staged.status();
+
+  // Nothing is visible before the commit.
+  auto beforeFut = ds.ReadVariables({"crossline"});
+  ASSERT_TRUE(beforeFut.status().ok()) << beforeFut.status();
+  auto before = tensorstore::StaticDataTypeCast<mdio::dtypes::int32_t,
+                                                tensorstore::unchecked>(
+      beforeFut.value().at("crossline").get_data_accessor());
+  EXPECT_NE(before({0}), -1);
+
+  auto committed = transaction.Commit().result();
+  ASSERT_TRUE(committed.ok()) << committed.status();
+  EXPECT_FALSE(transaction.Commit().result().ok());
+  EXPECT_FALSE(transaction.Write(data.at("depth")).ok());
+
+  auto rereadFut = ds.ReadVariables({"crossline", "depth"});
+  ASSERT_TRUE(rereadFut.status().ok()) << rereadFut.status();
+  for (auto& [name, varData] : rereadFut.value()) {
+    auto accessor =
+        tensorstore::StaticDataTypeCast<mdio::dtypes::int32_t,
+                                        tensorstore::unchecked>(
+            varData.get_data_accessor());
+    EXPECT_EQ(accessor({0}), -1) << name;
+  }
+  auto reopened = mdio::Dataset::Open(path, mdio::constants::kOpen).result();
+  ASSERT_TRUE(reopened.ok()) << reopened.status();
+  auto reopenedImage = reopened->variables.at("data");
+  ASSERT_TRUE(reopenedImage.ok()) << reopenedImage.status();
+  EXPECT_EQ(reopenedImage->GetAttributes()["attributes"]["owner"],
+            "transaction");
+
+  std::filesystem::remove_all(path);
+}
+
+TEST(Dataset, selWithCoordinateIndex) {
+  std::string path = "zarrs/selTester.mdio";
+  auto dsRes = makePopulated(path);
+  ASSERT_TRUE(dsRes.ok()) << dsRes.status();
+  auto ds = dsRes.value();
+
+  auto indexFut = ds.BuildCoordinateIndex<mdio::dtypes::int32_t>("inline");
+  ASSERT_TRUE(indexFut.status().ok()) << indexFut.status();
+  EXPECT_TRUE(std::filesystem::exists(path + "/inline/.zindex"));
+
+  mdio::ValueDescriptor<mdio::dtypes::int32_t> ilValue = {"inline", 3};
+  auto sliceRes = ds.sel(ilValue);
+  ASSERT_TRUE(sliceRes.ok()) << sliceRes.status();
+  auto samples = sliceRes.value().variables.at("inline").value().num_samples();
+  EXPECT_EQ(samples, 2) << "Expected 2 samples for inline but got " << samples;
+
+  std::vector<mdio::dtypes::int32_t> selCoords = {2, 1, 5, 7};
+  mdio::ListDescriptor<mdio::dtypes::int32_t> ilValues = {"inline", selCoords};
+  sliceRes = ds.sel(ilValues);
+  ASSERT_TRUE(sliceRes.ok()) << sliceRes.status();
+
+  mdio::ListDescriptor<mdio::dtypes::int32_t> repeated = {"inline", {3}};
+  EXPECT_FALSE(ds.sel(repeated).ok());
+
+  mdio::ListDescriptor<mdio::dtypes::int32_t> missing = {"inline", {2, 9}};
+  EXPECT_FALSE(ds.sel(missing).ok());
+
+  mdio::RangeDescriptor<mdio::dtypes::int32_t> ilRange = {"inline", 2, 5, 1};
+  EXPECT_TRUE(ds.sel(ilRange).ok());
+  mdio::RangeDescriptor<mdio::dtypes::int32_t> badRange = {"inline", 3, 5, 1};
+  EXPECT_FALSE(ds.sel(badRange).ok());
+
+  // Sliced Variables can't be indexed.
+  mdio::RangeDescriptor<mdio::Index> desc = {"inline", 0, 5, 1};
+  auto slicedRes = ds.isel(desc);
+  ASSERT_TRUE(slicedRes.ok()) << slicedRes.status();
+  EXPECT_FALSE(slicedRes.value()
+                   .BuildCoordinateIndex<mdio::dtypes::int32_t>("inline")
+                   .status()
+                   .ok());
+}
+
+TEST(Dataset, coordinateIndexDeletedOnWrite) {
+  std::string path = "zarrs/selStale.mdio";
+  auto dsRes = makePopulated(path);
+  ASSERT_TRUE(dsRes.ok()) << dsRes.status();
+  auto ds = dsRes.value();
+  auto inlineRes = ds.variables.get<mdio::dtypes::int32_t>("inline");
+  ASSERT_TRUE(inlineRes.ok()) << inlineRes.status();
+  auto inline_var = inlineRes.value();
+
+  // Gives every sample its own inline number, starting from `first`.
+  auto renumber = [&inline_var](mdio::dtypes::int32_t first) {
+    auto data = mdio::from_variable<mdio::dtypes::int32_t>(inline_var);
+    ASSERT_TRUE(data.ok()) << data.status();
+    auto ptr = data->get_data_accessor().data() + data->get_flattened_offset();
+    for (mdio::Index i = 0; i < data->num_samples(); ++i) {
+      ptr[i] = first + static_cast<mdio::dtypes::int32_t>(i);
+    }
+    ASSERT_TRUE(inline_var.Write(data.value()).commit_future.result().ok());
+  };
+
+  for (mdio::dtypes::int32_t first : {100, 200}) {
+    auto indexFut = ds.BuildCoordinateIndex<mdio::dtypes::int32_t>("inline");
+    ASSERT_TRUE(indexFut.status().ok()) << indexFut.status();
+    ASSERT_TRUE(std::filesystem::exists(path + "/inline/.zindex"));
+
+    // The write deletes the index, the values are scanned for instead.
+    renumber(first);
+    EXPECT_FALSE(std::filesystem::exists(path + "/inline/.zindex"));
+    mdio::ValueDescriptor<mdio::dtypes::int32_t> renumbered = {"inline",
+                                                               first + 1};
+    auto sliceRes = ds.sel(renumbered);
+    ASSERT_TRUE(sliceRes.ok()) << sliceRes.status();
+    EXPECT_EQ(sliceRes->variables.at("inline").value().num_samples(), 1);
+  }
+
+  std::filesystem::remove_all(path);
+}
+
+TEST(Dataset, coordinateIndexDeletedAfterReopen) {
+  std::string path = "zarrs/selReopened.mdio";
+  auto dsRes = makePopulated(path);
+  ASSERT_TRUE(dsRes.ok()) << dsRes.status();
+  auto ds = dsRes.value();
+
+  // Only coordinates can have an index.
+  EXPECT_FALSE(
+      ds.BuildCoordinateIndex<mdio::dtypes::float32_t>("data").status().ok());
+
+  for (bool lazy : {false, true}) {
+    auto indexFut = ds.BuildCoordinateIndex<mdio::dtypes::int32_t>("inline");
+    ASSERT_TRUE(indexFut.status().ok()) << indexFut.status();
+    ASSERT_TRUE(std::filesystem::exists(path + "/inline/.zindex"));
+
+    auto reopened =
+        lazy ? mdio::Dataset::OpenLazy(path, mdio::constants::kOpen).result()
+             : mdio::Dataset::Open(path, mdio::constants::kOpen).result();
+    ASSERT_TRUE(reopened.ok()) << reopened.status();
+    auto inlineRes = reopened->variables.get<mdio::dtypes::int32_t>("inline");
+    ASSERT_TRUE(inlineRes.ok()) << inlineRes.status();
+    auto data = mdio::from_variable<mdio::dtypes::int32_t>(inlineRes.value());
+    ASSERT_TRUE(data.ok()) << data.status();
+    ASSERT_TRUE(inlineRes->Write(data.value()).commit_future.result().ok());
+    EXPECT_FALSE(std::filesystem::exists(path + "/inline/.zindex")) << lazy;
+  }
+
+  std::filesystem::remove_all(path);
+}
+
 }  // namespace
@@ -16,6 +16,7 @@
 #define MDIO_DATASET_VALIDATOR_H_
 
 #include <fstream>
+#include <memory>
 #include <string>
 #include <unordered_set>
 
@@ -43,18 +44,31 @@ bool contains(const std::unordered_set<std::string>& set,
  * InvalidArgumentError if validation fails for any reason
  */
 absl::Status validate_schema(nlohmann::json& spec /*NOLINT*/) {
-  nlohmann::json targetSchema =
-      nlohmann::json::parse(kDatasetSchema, nullptr, false);
-  if (targetSchema.is_discarded()) {
+  // The schema is parsed and compiled once per process, validation doesn't
+  // modify the validator so it is shared between threads.
+  static const std::unique_ptr<const nlohmann::json_schema::json_validator>
+      validator =
+          []() -> std::unique_ptr<const nlohmann::json_schema::json_validator> {
+    nlohmann::json targetSchema =
+        nlohmann::json::parse(kDatasetSchema, nullptr, false);
+    if (targetSchema.is_discarded()) {
+      return nullptr;
+    }
+    auto compiled = std::make_unique<nlohmann::json_schema::json_validator>(
+        nullptr, nlohmann::json_schema::default_string_format_check);
+    try {
+      compiled->set_root_schema(targetSchema);
+    } catch (const std::exception&) {
+      return nullptr;
+    }
+    return compiled;
+  }();
+  if (!validator) {
     return absl::NotFoundError("Failed to load schema");
   }
 
-  nlohmann::json_schema::json_validator validator(
-      nullptr, nlohmann::json_schema::default_string_format_check);
-  validator.set_root_schema(targetSchema);
-
   try {
-    validator.validate(spec);
+    validator->validate(spec);
   } catch (const std::exception& e) {
     return absl::Status(
         absl::StatusCode::kInvalidArgument,
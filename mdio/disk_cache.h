@@ -0,0 +1,482 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MDIO_DISK_CACHE_H_
+#define MDIO_DISK_CACHE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/cord.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mdio/impl.h"
+#include "mdio/request_policy.h"
+#include "mdio/telemetry.h"
+#include "tensorstore/internal/intrusive_ptr.h"
+#include "tensorstore/kvstore/driver.h"
+#include "tensorstore/kvstore/generation.h"
+#include "tensorstore/kvstore/key_range.h"
+#include "tensorstore/kvstore/kvstore.h"
+#include "tensorstore/kvstore/operations.h"
+#include "tensorstore/util/future.h"
+
+// clang-format off
+#include <nlohmann/json.hpp>  // NOLINT
+// clang-format on
+
+namespace mdio {
+
+/**
+ * @brief Options for the local disk cache of remote metadata and chunks.
+ */
+struct DiskCacheOptions {
+  /// The directory of the cache, e.g. on local NVMe. It is created if needed
+  /// and can be shared by every process of the node.
+  std::string directory;
+  /// The byte budget of the cache, the least recently used entries are
+  /// evicted beyond it.
+  std::size_t max_bytes = 1024 * 1024 * 1024;
+  /// Entries validated more recently than this are used without contacting
+  /// the store. The default of 0 revalidates every read, which still avoids
+  /// downloading unchanged values.
+  absl::Duration max_staleness = absl::ZeroDuration();
+};
+
+namespace internal {
+
+/**
+ * @brief A generation keyed cache of values in a local directory.
+ * Each entry is one file, replaced atomically by a rename, so processes can
+ * share the directory without locking. A hit touches the file, which orders
+ * the entries for eviction.
+ */
+class DiskCache {
+ public:
+  /// A cached value and the generation it had in the store.
+  struct Entry {
+    absl::Cord value;
+    tensorstore::StorageGeneration generation;
+    /// When the store last confirmed the generation.
+    absl::Time validated;
+  };
+
+  explicit DiskCache(DiskCacheOptions options) : options(std::move(options)) {}
+
+  /**
+   * @brief Gets the entry of a key, if it is cached and readable.
+   */
+  std::optional<Entry> Get(const std::string& key) const {
+    const auto path = PathOf(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+      return std::nullopt;
+    }
+    std::string contents((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+    // "<validated nanos, kValidatedWidth digits>\n<generation size>\n"
+    // "<generation><value>"
+    const auto first = contents.find('\n');
+    const auto second = contents.find('\n', first + 1);
+    if (first != kValidatedWidth || second == std::string::npos) {
+      return std::nullopt;
+    }
+    std::int64_t validated = 0;
+    std::size_t generation_size = 0;
+    try {
+      validated = std::stoll(contents.substr(0, first));
+      generation_size = std::stoull(contents.substr(first + 1, second - first));
+    } catch (const std::exception&) {
+      return std::nullopt;
+    }
+    if (second + 1 + generation_size > contents.size()) {
+      return std::nullopt;
+    }
+    Entry entry;
+    entry.generation.value = contents.substr(second + 1, generation_size);
+    entry.value = absl::Cord(contents.substr(second + 1 + generation_size));
+    entry.validated = absl::FromUnixNanos(validated);
+    std::error_code ec;
+    std::filesystem::last_write_time(
+        path, std::filesystem::file_time_type::clock::now(), ec);
+    return entry;
+  }
+
+  /**
+   * @brief Caches the value of a key, then evicts over the byte budget.
+   * Failures are ignored, the cache is only an optimization.
+   */
+  void Put(const std::string& key, const absl::Cord& value,
+           const tensorstore::StorageGeneration& generation) const {
+    std::error_code ec;
+    std::filesystem::create_directories(options.directory, ec);
+    const auto path = PathOf(key);
+    // A unique temporary name, so concurrent writers don't interleave.
+    std::random_device random;
+    auto temp = path;
+    temp += "." + std::to_string(random()) + ".tmp";
+    {
+      std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+      if (!file) {
+        return;
+      }
+      file << ValidatedField(absl::Now()) << '\n'
+           << generation.value.size() << '\n'
+           << generation.value << std::string(value);
+      if (!file) {
+        file.close();
+        std::filesystem::remove(temp, ec);
+        return;
+      }
+    }
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+      std::filesystem::remove(temp, ec);
+      return;
+    }
+    Evict();
+  }
+
+  /**
+   * @brief Records that the store confirmed the entry of a key.
+   * Only the timestamp is rewritten in place, the value is left as it is.
+   */
+  void Touch(const std::string& key) const {
+    std::fstream file(PathOf(key),
+                      std::ios::in | std::ios::out | std::ios::binary);
+    if (file) {
+      file << ValidatedField(absl::Now());
+    }
+  }
+
+  /**
+   * @brief Removes the entry of a key.
+   */
+  void Erase(const std::string& key) const {
+    std::error_code ec;
+    std::filesystem::remove(PathOf(key), ec);
+  }
+
+  /**
+   * @brief Removes the least recently used entries until the cache is within
+   * its byte budget.
+   */
+  void Evict() const {
+    struct File {
+      std::filesystem::path path;
+      std::filesystem::file_time_type used;
+      std::uintmax_t size;
+    };
+    std::vector<File> files;
+    std::uintmax_t total = 0;
+    std::error_code ec;
+    for (const auto& item :
+         std::filesystem::directory_iterator(options.directory, ec)) {
+      std::error_code item_ec;
+      const auto size = item.file_size(item_ec);
+      const auto used = item.last_write_time(item_ec);
+      if (item_ec || !item.is_regular_file(item_ec)) {
+        continue;
+      }
+      files.push_back({item.path(), used, size});
+      total += size;
+    }
+    if (total <= options.max_bytes) {
+      return;
+    }
+    std::sort(files.begin(), files.end(),
+              [](const File& a, const File& b) { return a.used < b.used; });
+    for (const auto& file : files) {
+      if (total <= options.max_bytes) {
+        break;
+      }
+      if (std::filesystem::remove(file.path, ec)) {
+        total -= file.size;
+      }
+    }
+  }
+
+  DiskCacheOptions options;
+
+ private:
+  /// The validated time has a fixed width, so `Touch` can rewrite it.
+  static constexpr std::size_t kValidatedWidth = 20;
+
+  static std::string ValidatedField(absl::Time time) {
+    return absl::StrFormat("%020d", absl::ToUnixNanos(time));
+  }
+
+  /// Entries are named by a hash of the key that is stable across processes.
+  std::filesystem::path PathOf(const std::string& key) const {
+    std::uint64_t hash = 14695981039346656037ULL;  // FNV-1a
+    for (unsigned char c : key) {
+      hash = (hash ^ c) * 1099511628211ULL;
+    }
+    static constexpr char kHex[] = "0123456789abcdef";
+    std::string name(16, '0');
+    for (int i = 15; i >= 0; --i, hash >>= 4) {
+      name[i] = kHex[hash & 0xf];
+    }
+    return std::filesystem::path(options.directory) / name;
+  }
+};
+
+/**
+ * @brief The disk cache of the process, null if it is disabled.
+ */
+inline std::shared_ptr<const DiskCache>& ProcessDiskCache() {
+  static std::shared_ptr<const DiskCache> cache;
+  return cache;
+}
+
+inline std::mutex& ProcessDiskCacheMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+inline std::shared_ptr<const DiskCache> GetDiskCache() {
+  std::lock_guard<std::mutex> lock(ProcessDiskCacheMutex());
+  return ProcessDiskCache();
+}
+
+/**
+ * @brief Reads a key through a disk cache.
+ * A fresh entry is returned without contacting the store. Otherwise the store
+ * is only asked for the value if its generation changed.
+ * @param kvstore The kvstore to read from.
+ * @param key The key to read.
+ * @param cache_key The name of the value in the cache, unique across stores.
+ * @param cache The disk cache, the read goes straight to the store if null.
+ */
+inline Future<tensorstore::kvstore::ReadResult> CachedRead(
+    const tensorstore::KvStore& kvstore, const std::string& key,
+    const std::string& cache_key, std::shared_ptr<const DiskCache> cache) {
+  if (!cache) {
+    Count(TelemetryCounter::kCacheMisses, 1);
+    return PolicyRead(kvstore, key);
+  }
+  auto entry = cache->Get(cache_key);
+  tensorstore::kvstore::ReadOptions options;
+  if (entry.has_value()) {
+    if (absl::Now() - entry->validated < cache->options.max_staleness) {
+      Count(TelemetryCounter::kCacheHits, 1);
+      return tensorstore::MakeReadyFuture<tensorstore::kvstore::ReadResult>(
+          tensorstore::kvstore::ReadResult::Value(
+              entry->value, {entry->generation, entry->validated}));
+    }
+    options.generation_conditions.if_not_equal = entry->generation;
+  }
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [cache, cache_key, entry = std::move(entry)](
+          tensorstore::kvstore::ReadResult& read) {
+        if (entry.has_value() && read.aborted()) {
+          // Unchanged, the cached value is confirmed.
+          Count(TelemetryCounter::kCacheHits, 1);
+          cache->Touch(cache_key);
+          return tensorstore::kvstore::ReadResult::Value(
+              entry->value, {entry->generation, read.stamp.time});
+        }
+        Count(TelemetryCounter::kCacheMisses, 1);
+        if (read.has_value()) {
+          cache->Put(cache_key, read.value, read.stamp.generation);
+        } else {
+          cache->Erase(cache_key);
+        }
+        return std::move(read);
+      },
+      PolicyRead(kvstore, key, options));
+}
+
+/**
+ * @brief A kvstore driver that reads whole values of a remote store through
+ * a disk cache.
+ * Byte range and `if_equal` reads go straight to the store, and writes drop
+ * the cached entry. The spec is that of the store, so it is unchanged when
+ * serialized.
+ */
+class DiskCacheDriver : public tensorstore::kvstore::Driver {
+ public:
+  /**
+   * @param base The driver of the store.
+   * @param prefix Names the store in the cache, e.g. "gs://bucket/".
+   * @param cache The disk cache.
+   */
+  DiskCacheDriver(tensorstore::kvstore::DriverPtr base, std::string prefix,
+                  std::shared_ptr<const DiskCache> cache)
+      : base(std::move(base)),
+        prefix(std::move(prefix)),
+        cache(std::move(cache)) {}
+
+  Future<tensorstore::kvstore::ReadResult> Read(
+      Key key, tensorstore::kvstore::ReadOptions options) override {
+    if (!options.byte_range.IsFull() ||
+        !tensorstore::StorageGeneration::IsUnknown(
+            options.generation_conditions.if_equal)) {
+      return base->Read(std::move(key), std::move(options));
+    }
+    auto cache_key = prefix + key;
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [if_not_equal = std::move(options.generation_conditions.if_not_equal)](
+            tensorstore::kvstore::ReadResult& read) {
+          // The caller already has this generation.
+          if (read.has_value() &&
+              !tensorstore::StorageGeneration::IsUnknown(if_not_equal) &&
+              read.stamp.generation == if_not_equal) {
+            return tensorstore::kvstore::ReadResult::Unspecified(
+                std::move(read.stamp));
+          }
+          return std::move(read);
+        },
+        CachedRead(tensorstore::KvStore(base, ""), key, cache_key, cache));
+  }
+
+  Future<tensorstore::TimestampedStorageGeneration> Write(
+      Key key, std::optional<Value> value,
+      tensorstore::kvstore::WriteOptions options) override {
+    return tensorstore::MapFuture(
+        tensorstore::InlineExecutor{},
+        [cache = cache, cache_key = prefix + key](
+            tensorstore::Result<tensorstore::TimestampedStorageGeneration>&
+                written) {
+          cache->Erase(cache_key);
+          return std::move(written);
+        },
+        base->Write(std::move(key), std::move(value), std::move(options)));
+  }
+
+  Future<const void> DeleteRange(tensorstore::KeyRange range) override {
+    return base->DeleteRange(std::move(range));
+  }
+
+  void ListImpl(tensorstore::kvstore::ListOptions options,
+                tensorstore::kvstore::ListReceiver receiver) override {
+    base->ListImpl(std::move(options), std::move(receiver));
+  }
+
+  std::string DescribeKey(std::string_view key) override {
+    return base->DescribeKey(key);
+  }
+
+  Result<tensorstore::kvstore::DriverSpecPtr> GetBoundSpec() const override {
+    return base->GetBoundSpec();
+  }
+
+  tensorstore::kvstore::SupportedFeatures GetSupportedFeatures(
+      const tensorstore::KeyRange& key_range) const override {
+    return base->GetSupportedFeatures(key_range);
+  }
+
+  void EncodeCacheKey(std::string* out) const override {
+    base->EncodeCacheKey(out);
+    out->append("|mdio_disk_cache");
+  }
+
+ private:
+  tensorstore::kvstore::DriverPtr base;
+  std::string prefix;
+  std::shared_ptr<const DiskCache> cache;
+};
+
+/**
+ * @brief Names a gs:// or s3:// store in the disk cache.
+ * @param spec The JSON spec of the kvstore.
+ * @return "gs://<bucket>/" or "s3://<bucket>/", nothing for other stores.
+ */
+inline std::optional<std::string> DiskCachePrefix(
+    const ::nlohmann::json& spec) {
+  if (!spec.is_object() || !spec.contains("bucket") ||
+      !spec["bucket"].is_string()) {
+    return std::nullopt;
+  }
+  const std::string driver = spec.value("driver", "");
+  const auto bucket = spec["bucket"].get<std::string>();
+  if (driver == "gcs") {
+    return "gs://" + bucket + "/";
+  } else if (driver == "s3") {
+    return "s3://" + bucket + "/";
+  }
+  return std::nullopt;
+}
+
+/**
+ * @brief Reads a kvstore through a disk cache.
+ * @param kvstore The kvstore, its path and transaction are kept.
+ * @param prefix Names the store in the cache, see `DiskCachePrefix`.
+ * @param cache The disk cache.
+ */
+inline tensorstore::KvStore CacheKvStore(
+    tensorstore::KvStore kvstore, std::string prefix,
+    std::shared_ptr<const DiskCache> cache) {
+  tensorstore::kvstore::DriverPtr driver =
+      tensorstore::internal::MakeIntrusivePtr<DiskCacheDriver>(
+          std::move(kvstore.driver), std::move(prefix), std::move(cache));
+  return tensorstore::KvStore(std::move(driver), std::move(kvstore.path),
+                              std::move(kvstore.transaction));
+}
+
+}  // namespace internal
+
+/**
+ * @brief Keeps the consolidated metadata and the chunks of remote (gs:// and
+ * s3://) Datasets in a local directory, shared by every process of the node.
+ * Opening a Dataset or reading a chunk then only asks the store whether the
+ * value changed, or skips the store entirely within `max_staleness`. Only
+ * Variables opened after this call read through the cache.
+ * @param options The directory and budget of the cache.
+ * @return An error if the directory could not be created.
+ */
+inline Result<void> EnableDiskCache(const DiskCacheOptions& options) {
+  if (options.directory.empty()) {
+    return absl::InvalidArgumentError("The disk cache needs a directory.");
+  }
+  std::error_code ec;
+  std::filesystem::create_directories(options.directory, ec);
+  if (ec) {
+    return absl::InvalidArgumentError("Could not create the disk cache '" +
+                                      options.directory + "': " + ec.message());
+  }
+  std::lock_guard<std::mutex> lock(internal::ProcessDiskCacheMutex());
+  internal::ProcessDiskCache() =
+      std::make_shared<const internal::DiskCache>(options);
+  return absl::OkStatus();
+}
+
+/**
+ * @brief Stops using the disk cache. The cached entries are kept.
+ */
+inline void DisableDiskCache() {
+  std::lock_guard<std::mutex> lock(internal::ProcessDiskCacheMutex());
+  internal::ProcessDiskCache() = nullptr;
+}
+
+}  // namespace mdio
+
+#endif  // MDIO_DISK_CACHE_H_
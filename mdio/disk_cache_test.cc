@@ -0,0 +1,192 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mdio/disk_cache.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+
+namespace {
+
+mdio::Result<tensorstore::KvStore> OpenStore() {
+  ::nlohmann::json spec = {{"driver", "file"}, {"path", "disk_cache_store/"}};
+  return tensorstore::kvstore::Open(spec).result();
+}
+
+mdio::Result<std::string> ReadThrough(
+    const tensorstore::KvStore& store,
+    std::shared_ptr<const mdio::internal::DiskCache> cache) {
+  MDIO_ASSIGN_OR_RETURN(
+      auto read,
+      mdio::internal::CachedRead(store, "key", "store|key", cache).result())
+  return std::string(read.value);
+}
+
+TEST(DiskCache, revalidates) {
+  auto store = OpenStore();
+  ASSERT_TRUE(store.ok()) << store.status();
+  ASSERT_TRUE(
+      tensorstore::kvstore::Write(store.value(), "key", absl::Cord("one"))
+          .result()
+          .ok());
+
+  mdio::DiskCacheOptions options;
+  options.directory = "disk_cache_dir";
+  auto cache = std::make_shared<const mdio::internal::DiskCache>(options);
+  EXPECT_EQ(ReadThrough(store.value(), cache).value(), "one");
+  auto entry = cache->Get("store|key");
+  ASSERT_TRUE(entry.has_value());
+  EXPECT_EQ(std::string(entry->value), "one");
+  // Unchanged values come from the cache.
+  EXPECT_EQ(ReadThrough(store.value(), cache).value(), "one");
+
+  // A changed value is noticed and cached.
+  ASSERT_TRUE(
+      tensorstore::kvstore::Write(store.value(), "key", absl::Cord("two"))
+          .result()
+          .ok());
+  EXPECT_EQ(ReadThrough(store.value(), cache).value(), "two");
+  EXPECT_EQ(std::string(cache->Get("store|key")->value), "two");
+
+  // Within the staleness the store isn't asked.
+  options.max_staleness = absl::Hours(1);
+  auto stale = std::make_shared<const mdio::internal::DiskCache>(options);
+  ASSERT_TRUE(
+      tensorstore::kvstore::Write(store.value(), "key", absl::Cord("three"))
+          .result()
+          .ok());
+  EXPECT_EQ(ReadThrough(store.value(), stale).value(), "two");
+  EXPECT_EQ(ReadThrough(store.value(), cache).value(), "three");
+
+  // A deleted value is dropped from the cache.
+  ASSERT_TRUE(tensorstore::kvstore::Delete(store.value(), "key").result().ok());
+  auto missing =
+      mdio::internal::CachedRead(store.value(), "key", "store|key", cache)
+          .result();
+  ASSERT_TRUE(missing.ok()) << missing.status();
+  EXPECT_FALSE(missing->has_value());
+  EXPECT_FALSE(cache->Get("store|key").has_value());
+
+  std::filesystem::remove_all("disk_cache_store");
+  std::filesystem::remove_all("disk_cache_dir");
+}
+
+TEST(DiskCache, touchesOnlyTheTimestamp) {
+  mdio::DiskCacheOptions options;
+  options.directory = "disk_cache_touch";
+  mdio::internal::DiskCache cache(options);
+  cache.Put("a", absl::Cord("value"), tensorstore::StorageGeneration{"1"});
+  auto before = cache.Get("a");
+  ASSERT_TRUE(before.has_value());
+  cache.Touch("a");
+  auto after = cache.Get("a");
+  ASSERT_TRUE(after.has_value());
+  EXPECT_GE(after->validated, before->validated);
+  EXPECT_EQ(std::string(after->value), "value");
+  EXPECT_EQ(after->generation, tensorstore::StorageGeneration{"1"});
+  // Touching a missing entry doesn't create it.
+  cache.Touch("b");
+  EXPECT_FALSE(cache.Get("b").has_value());
+
+  std::filesystem::remove_all("disk_cache_touch");
+}
+
+TEST(DiskCache, cachesThroughKvStore) {
+  auto store = OpenStore();
+  ASSERT_TRUE(store.ok()) << store.status();
+  ASSERT_TRUE(
+      tensorstore::kvstore::Write(store.value(), "chunk", absl::Cord("one"))
+          .result()
+          .ok());
+
+  mdio::DiskCacheOptions options;
+  options.directory = "disk_cache_kvs";
+  options.max_staleness = absl::Hours(1);
+  auto cache = std::make_shared<const mdio::internal::DiskCache>(options);
+  auto cached = mdio::internal::CacheKvStore(store.value(), "test://", cache);
+  const std::string cache_key = "test://" + cached.path + "chunk";
+
+  auto read = tensorstore::kvstore::Read(cached, "chunk").result();
+  ASSERT_TRUE(read.ok()) << read.status();
+  EXPECT_EQ(std::string(read->value), "one");
+  ASSERT_TRUE(cache->Get(cache_key).has_value());
+  // The spec is that of the store.
+  EXPECT_EQ(cached.spec().value().ToJson().value(),
+            store->spec().value().ToJson().value());
+
+  // Within the staleness the cached value is used.
+  ASSERT_TRUE(
+      tensorstore::kvstore::Write(store.value(), "chunk", absl::Cord("two"))
+          .result()
+          .ok());
+  read = tensorstore::kvstore::Read(cached, "chunk").result();
+  ASSERT_TRUE(read.ok()) << read.status();
+  EXPECT_EQ(std::string(read->value), "one");
+
+  // A caller that has the generation gets no value.
+  tensorstore::kvstore::ReadOptions unchanged;
+  unchanged.generation_conditions.if_not_equal = read->stamp.generation;
+  auto aborted =
+      tensorstore::kvstore::Read(cached, "chunk", unchanged).result();
+  ASSERT_TRUE(aborted.ok()) << aborted.status();
+  EXPECT_TRUE(aborted->aborted());
+
+  // Byte ranges go to the store.
+  tensorstore::kvstore::ReadOptions ranged;
+  ranged.byte_range = tensorstore::OptionalByteRangeRequest(0, 2);
+  auto partial = tensorstore::kvstore::Read(cached, "chunk", ranged).result();
+  ASSERT_TRUE(partial.ok()) << partial.status();
+  EXPECT_EQ(std::string(partial->value), "tw");
+
+  // Writes drop the cached value.
+  ASSERT_TRUE(tensorstore::kvstore::Write(cached, "chunk", absl::Cord("three"))
+                  .result()
+                  .ok());
+  EXPECT_FALSE(cache->Get(cache_key).has_value());
+  read = tensorstore::kvstore::Read(cached, "chunk").result();
+  ASSERT_TRUE(read.ok()) << read.status();
+  EXPECT_EQ(std::string(read->value), "three");
+
+  std::filesystem::remove_all("disk_cache_store");
+  std::filesystem::remove_all("disk_cache_kvs");
+}
+
+TEST(DiskCache, evicts) {
+  mdio::DiskCacheOptions options;
+  options.directory = "disk_cache_evict";
+  options.max_bytes = 0;
+  mdio::internal::DiskCache cache(options);
+  cache.Put("a", absl::Cord("value"), tensorstore::StorageGeneration{"1"});
+  EXPECT_FALSE(cache.Get("a").has_value());
+
+  options.max_bytes = 1024;
+  mdio::internal::DiskCache roomy(options);
+  roomy.Put("a", absl::Cord("value"), tensorstore::StorageGeneration{"1"});
+  ASSERT_TRUE(roomy.Get("a").has_value());
+  EXPECT_EQ(roomy.Get("a")->generation, tensorstore::StorageGeneration{"1"});
+
+  EXPECT_FALSE(mdio::EnableDiskCache({}).ok());
+  EXPECT_TRUE(mdio::EnableDiskCache(options).ok());
+  EXPECT_NE(mdio::internal::GetDiskCache(), nullptr);
+  mdio::DisableDiskCache();
+  EXPECT_EQ(mdio::internal::GetDiskCache(), nullptr);
+
+  std::filesystem::remove_all("disk_cache_evict");
+}
+
+}  // namespace
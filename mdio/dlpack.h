@@ -0,0 +1,343 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file dlpack.h
+ * @brief Hands VariableData to Python without copying, through DLPack or the
+ * buffer protocol.
+ * Nothing here depends on Python; a binding wraps the exports in a capsule or
+ * a `Py_buffer`.
+ */
+
+#ifndef MDIO_DLPACK_H_
+#define MDIO_DLPACK_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mdio/impl.h"
+#include "mdio/variable.h"
+
+// clang-format off
+#include <nlohmann/json.hpp>  // NOLINT
+// clang-format on
+
+#if __has_include(<dlpack/dlpack.h>)
+#include <dlpack/dlpack.h>
+#define MDIO_HAS_DLPACK_H 1
+#endif
+
+namespace mdio {
+namespace internal {
+
+#if defined(MDIO_HAS_DLPACK_H)
+using ::DLDataType;
+using ::DLDataTypeCode;
+using ::DLDevice;
+using ::DLManagedTensor;
+using ::DLTensor;
+using ::kDLBfloat;
+using ::kDLBool;
+using ::kDLComplex;
+using ::kDLCPU;
+using ::kDLFloat;
+using ::kDLInt;
+using ::kDLUInt;
+#else
+// The subset of the DLPack 0.8 ABI that MDIO produces, for builds without the
+// dlpack headers. The layouts are those of dlpack.h, but the names are kept
+// out of the global namespace so they can't clash with it.
+enum DLDeviceType {
+  kDLCPU = 1,
+};
+
+struct DLDevice {
+  DLDeviceType device_type;
+  int32_t device_id;
+};
+
+enum DLDataTypeCode {
+  kDLInt = 0U,
+  kDLUInt = 1U,
+  kDLFloat = 2U,
+  kDLOpaqueHandle = 3U,
+  kDLBfloat = 4U,
+  kDLComplex = 5U,
+  kDLBool = 6U,
+};
+
+struct DLDataType {
+  uint8_t code;
+  uint8_t bits;
+  uint16_t lanes;
+};
+
+struct DLTensor {
+  void* data;
+  DLDevice device;
+  int32_t ndim;
+  DLDataType dtype;
+  int64_t* shape;
+  int64_t* strides;
+  uint64_t byte_offset;
+};
+
+struct DLManagedTensor {
+  DLTensor dl_tensor;
+  void* manager_ctx;
+  void (*deleter)(DLManagedTensor* self);
+};
+#endif
+
+}  // namespace internal
+
+/// The DLPack tensor of `ToDLPack`, that of dlpack.h when it is available.
+using DLManagedTensor = internal::DLManagedTensor;
+
+/**
+ * @brief A strided view of VariableData in the terms of the Python buffer
+ * protocol (PEP 3118).
+ * The fields map one to one onto `Py_buffer`, or onto `pybind11::buffer_info`,
+ * and `owner` keeps the samples alive for as long as Python holds the view.
+ */
+struct BufferExport {
+  std::shared_ptr<const void> owner;
+  void* data = nullptr;
+  /// The struct module format of one element, e.g. "f" for float32.
+  std::string format;
+  Index itemsize = 0;
+  std::vector<Index> shape;
+  /// Strides in bytes.
+  std::vector<Index> strides;
+  bool readonly = false;
+  /// The NumPy type string of one element, e.g. "<f4".
+  std::string typestr;
+
+  /**
+   * @brief Gets the NumPy `__array_interface__` of the view.
+   * Python objects that return it from `__array_interface__` can be passed to
+   * `numpy.asarray` as they are.
+   */
+  nlohmann::json ArrayInterface() const {
+    return {{"version", 3},
+            {"shape", shape},
+            {"strides", strides},
+            {"typestr", typestr},
+            {"data",
+             {reinterpret_cast<std::uintptr_t>(data), readonly}}};
+  }
+};
+
+namespace internal {
+
+/**
+ * @brief The element formats of a dtype in DLPack, struct module and NumPy
+ * terms.
+ */
+struct ExportDtype {
+  DLDataType dlpack;
+  /// Empty if NumPy has no such type.
+  const char* format;
+  const char* typestr;
+};
+
+inline Result<ExportDtype> GetExportDtype(DataType dtype) {
+  using tensorstore::DataTypeId;
+  const auto dl = [&dtype](DLDataTypeCode code) {
+    return DLDataType{static_cast<uint8_t>(code),
+                      static_cast<uint8_t>(dtype.size() * 8), 1};
+  };
+  switch (dtype.id()) {
+    case DataTypeId::bool_t:
+      return ExportDtype{dl(kDLBool), "?", "|b1"};
+    case DataTypeId::int8_t:
+      return ExportDtype{dl(kDLInt), "b", "|i1"};
+    case DataTypeId::int16_t:
+      return ExportDtype{dl(kDLInt), "h", "<i2"};
+    case DataTypeId::int32_t:
+      return ExportDtype{dl(kDLInt), "i", "<i4"};
+    case DataTypeId::int64_t:
+      return ExportDtype{dl(kDLInt), "q", "<i8"};
+    case DataTypeId::byte_t:
+    case DataTypeId::uint8_t:
+      return ExportDtype{dl(kDLUInt), "B", "|u1"};
+    case DataTypeId::uint16_t:
+      return ExportDtype{dl(kDLUInt), "H", "<u2"};
+    case DataTypeId::uint32_t:
+      return ExportDtype{dl(kDLUInt), "I", "<u4"};
+    case DataTypeId::uint64_t:
+      return ExportDtype{dl(kDLUInt), "Q", "<u8"};
+    case DataTypeId::float16_t:
+      return ExportDtype{dl(kDLFloat), "e", "<f2"};
+    case DataTypeId::bfloat16_t:
+      return ExportDtype{dl(kDLBfloat), "", ""};
+    case DataTypeId::float32_t:
+      return ExportDtype{dl(kDLFloat), "f", "<f4"};
+    case DataTypeId::float64_t:
+      return ExportDtype{dl(kDLFloat), "d", "<f8"};
+    case DataTypeId::complex64_t:
+      return ExportDtype{dl(kDLComplex), "Zf", "<c8"};
+    case DataTypeId::complex128_t:
+      return ExportDtype{dl(kDLComplex), "Zd", "<c16"};
+    default:
+      return absl::InvalidArgumentError(
+          "The dtype '" + std::string(dtype.name()) +
+          "' has no DLPack or NumPy equivalent.");
+  }
+}
+
+/**
+ * @brief The samples of VariableData as a pointer, a shape and byte strides,
+ * sharing ownership of the buffer.
+ */
+struct ExportLayout {
+  std::shared_ptr<const void> owner;
+  void* data;
+  std::vector<Index> shape;
+  std::vector<Index> byte_strides;
+  DataType dtype;
+};
+
+template <typename T, DimensionIndex R, ArrayOriginKind OriginKind>
+ExportLayout GetExportLayout(const VariableData<T, R, OriginKind>& variable) {
+  // The accessors aren't const, but only share the buffer.
+  auto data = const_cast<VariableData<T, R, OriginKind>&>(variable)
+                  .get_data_accessor();
+  ExportLayout layout;
+  layout.owner = data.element_pointer().pointer();
+  layout.data = const_cast<void*>(static_cast<const void*>(
+      data.byte_strided_origin_pointer().get()));
+  layout.shape.assign(data.shape().begin(), data.shape().end());
+  layout.byte_strides.assign(data.byte_strides().begin(),
+                             data.byte_strides().end());
+  layout.dtype = data.dtype();
+  return layout;
+}
+
+/// What a DLManagedTensor owns, freed by its deleter.
+struct DLPackContext {
+  std::shared_ptr<const void> owner;
+  std::vector<int64_t> shape;
+  std::vector<int64_t> strides;
+  DLManagedTensor tensor;
+};
+
+}  // namespace internal
+
+/**
+ * @brief Exports VariableData as a DLPack tensor, without copying.
+ * The tensor shares the samples with the VariableData, so writes through
+ * either are seen by both, and keeps them alive until its deleter is called.
+ * A binding hands it to Python in a capsule named "dltensor", whose
+ * destructor calls the deleter unless a consumer renamed it to
+ * "used_dltensor".
+ * @details \b Usage
+ * @code
+ * MDIO_ASSIGN_OR_RETURN(auto data, seismic.Read().result());
+ * MDIO_ASSIGN_OR_RETURN(DLManagedTensor* tensor, mdio::ToDLPack(data));
+ * // pybind11: py::capsule(tensor, "dltensor", DeleteUnusedDLTensor)
+ * @endcode
+ * @param data The samples to export, their strides are kept.
+ * @return The managed tensor, owned by the caller.
+ */
+template <typename T, DimensionIndex R, ArrayOriginKind OriginKind>
+Result<DLManagedTensor*> ToDLPack(const VariableData<T, R, OriginKind>& data) {
+  auto layout = internal::GetExportLayout(data);
+  MDIO_ASSIGN_OR_RETURN(auto dtype, internal::GetExportDtype(layout.dtype))
+  const Index itemsize = layout.dtype.size();
+  auto context = std::make_unique<internal::DLPackContext>();
+  context->owner = std::move(layout.owner);
+  context->shape.assign(layout.shape.begin(), layout.shape.end());
+  for (const Index stride : layout.byte_strides) {
+    // DLPack strides count elements.
+    if (stride % itemsize != 0) {
+      return absl::InvalidArgumentError(
+          "The strides of '" + data.variableName +
+          "' are not a whole number of elements.");
+    }
+    context->strides.push_back(stride / itemsize);
+  }
+  auto& tensor = context->tensor;
+  tensor.dl_tensor.data = layout.data;
+  tensor.dl_tensor.device = internal::DLDevice{internal::kDLCPU, 0};
+  tensor.dl_tensor.ndim = static_cast<int32_t>(context->shape.size());
+  tensor.dl_tensor.dtype = dtype.dlpack;
+  tensor.dl_tensor.shape = context->shape.data();
+  tensor.dl_tensor.strides = context->strides.data();
+  tensor.dl_tensor.byte_offset = 0;
+  tensor.manager_ctx = context.get();
+  tensor.deleter = [](DLManagedTensor* self) {
+    delete static_cast<internal::DLPackContext*>(self->manager_ctx);
+  };
+  return &context.release()->tensor;
+}
+
+/**
+ * @brief Exports VariableData for the Python buffer protocol, without
+ * copying.
+ * @param data The samples to export, their strides are kept.
+ * @return The view, or an error if NumPy has no matching dtype.
+ */
+template <typename T, DimensionIndex R, ArrayOriginKind OriginKind>
+Result<BufferExport> ToBuffer(const VariableData<T, R, OriginKind>& data) {
+  auto layout = internal::GetExportLayout(data);
+  MDIO_ASSIGN_OR_RETURN(auto dtype, internal::GetExportDtype(layout.dtype))
+  if (*dtype.format == '\0') {
+    return absl::InvalidArgumentError("NumPy has no dtype for '" +
+                                      std::string(layout.dtype.name()) +
+                                      "', export it with ToDLPack.");
+  }
+  BufferExport buffer;
+  buffer.owner = std::move(layout.owner);
+  buffer.data = layout.data;
+  buffer.format = dtype.format;
+  buffer.typestr = dtype.typestr;
+  buffer.itemsize = layout.dtype.size();
+  buffer.shape = std::move(layout.shape);
+  buffer.strides = std::move(layout.byte_strides);
+  buffer.readonly = std::is_const_v<T>;
+  return buffer;
+}
+
+/**
+ * @brief Describes VariableData the way `xarray.DataArray` takes it.
+ * The dimension labels become `dims`, the origin of every dimension tells
+ * where a slice sits in the full Variable, and the attributes, which name
+ * the coordinates of the Variable, become `attrs`.
+ * @return A JSON object with "name", "long_name", "dims", "origin" and
+ * "attrs".
+ */
+template <typename T, DimensionIndex R, ArrayOriginKind OriginKind>
+nlohmann::json ExportLabels(const VariableData<T, R, OriginKind>& data) {
+  const auto domain = data.dimensions();
+  nlohmann::json dims = nlohmann::json::array();
+  nlohmann::json origin = nlohmann::json::array();
+  for (DimensionIndex d = 0; d < domain.rank(); ++d) {
+    dims.push_back(std::string(domain.labels()[d]));
+    origin.push_back(domain.origin()[d]);
+  }
+  return {{"name", data.variableName},
+          {"long_name", data.longName},
+          {"dims", dims},
+          {"origin", origin},
+          {"attrs", data.metadata}};
+}
+
+}  // namespace mdio
+
+#endif  // MDIO_DLPACK_H_
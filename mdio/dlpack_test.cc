@@ -0,0 +1,128 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mdio/dlpack.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "mdio/dataset.h"
+#include "mdio/utils/test_fixtures.h"
+
+namespace {
+
+// Reads inlines 2 to 4 of seismic, numbered by their position.
+mdio::Result<mdio::VariableData<float>> ReadSlice() {
+  auto schema = mdio::testing::SeismicSchema({6, 4, 3}, {2, 4, 3});
+  MDIO_ASSIGN_OR_RETURN(auto dataset,
+                        mdio::Dataset::from_json(schema, "zarrs/exported",
+                                                 mdio::constants::kCreateClean)
+                            .result())
+  MDIO_ASSIGN_OR_RETURN(auto seismic, dataset.variables.get<float>("seismic"))
+  mdio::RangeDescriptor<mdio::Index> inlines = {"inline", 2, 4, 1};
+  MDIO_ASSIGN_OR_RETURN(auto slice, seismic.slice(inlines))
+  MDIO_ASSIGN_OR_RETURN(auto data, mdio::from_variable<float>(slice))
+  float* samples =
+      data.get_data_accessor().data() + data.get_flattened_offset();
+  for (int i = 0; i < 2 * 4 * 3; ++i) {
+    samples[i] = static_cast<float>(i);
+  }
+  return data;
+}
+
+TEST(DLPack, sharesSamples) {
+  mdio::DLManagedTensor* tensor;
+  {
+    auto data = ReadSlice();
+    ASSERT_TRUE(data.ok()) << data.status();
+    auto exported = mdio::ToDLPack(data.value());
+    ASSERT_TRUE(exported.ok()) << exported.status();
+    tensor = exported.value();
+    EXPECT_EQ(tensor->dl_tensor.data, data->get_data_accessor().data() +
+                                          data->get_flattened_offset());
+  }
+  // The tensor outlives the VariableData it was exported from.
+  const DLTensor& dl = tensor->dl_tensor;
+  EXPECT_EQ(dl.device.device_type, mdio::internal::kDLCPU);
+  EXPECT_EQ(dl.dtype.code, mdio::internal::kDLFloat);
+  EXPECT_EQ(dl.dtype.bits, 32);
+  EXPECT_EQ(dl.dtype.lanes, 1);
+  ASSERT_EQ(dl.ndim, 3);
+  EXPECT_THAT(std::vector<int64_t>(dl.shape, dl.shape + 3),
+              ::testing::ElementsAre(2, 4, 3));
+  EXPECT_THAT(std::vector<int64_t>(dl.strides, dl.strides + 3),
+              ::testing::ElementsAre(12, 3, 1));
+  EXPECT_EQ(static_cast<const float*>(dl.data)[13], 13.0f);
+  tensor->deleter(tensor);
+  std::filesystem::remove_all("zarrs/exported");
+}
+
+TEST(DLPack, buffer) {
+  auto data = ReadSlice();
+  ASSERT_TRUE(data.ok()) << data.status();
+  auto buffer = mdio::ToBuffer(data.value());
+  ASSERT_TRUE(buffer.ok()) << buffer.status();
+  EXPECT_EQ(buffer->format, "f");
+  EXPECT_EQ(buffer->itemsize, 4);
+  EXPECT_THAT(buffer->shape, ::testing::ElementsAre(2, 4, 3));
+  EXPECT_THAT(buffer->strides, ::testing::ElementsAre(48, 12, 4));
+  EXPECT_FALSE(buffer->readonly);
+  EXPECT_EQ(buffer->owner.get(), data->get_data_accessor().data());
+
+  auto interface = buffer->ArrayInterface();
+  EXPECT_EQ(interface["version"], 3);
+  EXPECT_EQ(interface["typestr"], "<f4");
+  EXPECT_EQ(interface["shape"], ::nlohmann::json({2, 4, 3}));
+  EXPECT_EQ(interface["data"][0].get<std::uintptr_t>(),
+            reinterpret_cast<std::uintptr_t>(buffer->data));
+  std::filesystem::remove_all("zarrs/exported");
+}
+
+TEST(DLPack, labels) {
+  auto data = ReadSlice();
+  ASSERT_TRUE(data.ok()) << data.status();
+  auto labels = mdio::ExportLabels(data.value());
+  EXPECT_EQ(labels["name"], "seismic");
+  EXPECT_EQ(labels["long_name"], "Amplitude");
+  EXPECT_EQ(labels["dims"],
+            ::nlohmann::json({"inline", "crossline", "depth"}));
+  // The slice starts at the third inline.
+  EXPECT_EQ(labels["origin"], ::nlohmann::json({2, 0, 0}));
+  std::filesystem::remove_all("zarrs/exported");
+}
+
+TEST(DLPack, dtypes) {
+  using tensorstore::dtype_v;
+  namespace dtypes = tensorstore::dtypes;
+  auto bf16 = mdio::internal::GetExportDtype(dtype_v<dtypes::bfloat16_t>);
+  ASSERT_TRUE(bf16.ok()) << bf16.status();
+  EXPECT_EQ(bf16->dlpack.code, mdio::internal::kDLBfloat);
+  EXPECT_EQ(bf16->dlpack.bits, 16);
+  EXPECT_STREQ(bf16->format, "");
+
+  auto flag = mdio::internal::GetExportDtype(dtype_v<dtypes::bool_t>);
+  ASSERT_TRUE(flag.ok()) << flag.status();
+  EXPECT_EQ(flag->dlpack.code, mdio::internal::kDLBool);
+  EXPECT_EQ(flag->dlpack.bits, 8);
+  EXPECT_STREQ(flag->typestr, "|b1");
+
+  EXPECT_FALSE(mdio::internal::GetExportDtype(dtype_v<dtypes::string_t>).ok());
+}
+
+}  // namespace
@@ -0,0 +1,314 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MDIO_MAPPED_READ_H_
+#define MDIO_MAPPED_READ_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mdio/impl.h"
+#include "mdio/variable.h"
+#include "tensorstore/array.h"
+#include "tensorstore/box.h"
+#include "tensorstore/index_space/index_transform.h"
+#include "tensorstore/index_space/dim_expression.h"
+#include "tensorstore/util/division.h"
+#include "tensorstore/util/endian.h"
+#include "tensorstore/util/future.h"
+
+// clang-format off
+#include <nlohmann/json.hpp>  // NOLINT
+// clang-format on
+
+namespace mdio {
+namespace internal {
+
+/**
+ * @brief Where and how the chunks of a Variable are stored, for a Variable
+ * whose chunk files hold the samples as they are in memory.
+ */
+struct MappedLayout {
+  /// The directory of the chunk files, with a trailing slash.
+  std::string path;
+  std::string separator;
+  std::vector<Index> chunks;
+};
+
+/**
+ * @brief Checks if the domain of a Variable indexes its stored array directly,
+ * so an index of the Variable is also an index of the chunk grid.
+ */
+template <typename T, DimensionIndex R, ReadWriteMode M>
+bool IndexesStoredArray(const Variable<T, R, M>& var) {
+  const auto transform = var.get_store().transform();
+  if (transform.input_rank() != transform.output_rank()) {
+    return false;
+  }
+  for (DimensionIndex d = 0; d < transform.output_rank(); ++d) {
+    const auto map = transform.output_index_maps()[d];
+    using tensorstore::OutputIndexMethod;
+    if (map.method() != OutputIndexMethod::single_input_dimension ||
+        map.input_dimension() != d || map.stride() != 1 || map.offset() != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Gets the chunk layout of a Variable that can be read by mapping its
+ * chunk files.
+ * That is a Zarr v2 Variable in a local file store, without compressor or
+ * filters, in C order and native byte order, whose domain indexes the stored
+ * array directly.
+ * @return The layout, or nothing if the Variable has to be read normally.
+ */
+template <typename T, DimensionIndex R, ReadWriteMode M>
+std::optional<MappedLayout> GetMappedLayout(const Variable<T, R, M>& var) {
+  auto spec_res = var.get_spec();
+  if (!spec_res.ok()) {
+    return std::nullopt;
+  }
+  const auto& spec = spec_res.value();
+  if (spec.value("driver", "") != "zarr" || !spec.contains("kvstore") ||
+      spec["kvstore"].value("driver", "") != "file" ||
+      !spec.contains("metadata")) {
+    return std::nullopt;
+  }
+  const auto& metadata = spec["metadata"];
+  if (!metadata.value("compressor", ::nlohmann::json()).is_null() ||
+      !metadata.value("filters", ::nlohmann::json()).is_null() ||
+      metadata.value("order", "C") != "C" || !metadata.contains("dtype") ||
+      !metadata["dtype"].is_string() || !metadata.contains("chunks")) {
+    return std::nullopt;
+  }
+  const auto dtype = metadata["dtype"].get<std::string>();
+  if (dtype.empty()) {
+    return std::nullopt;
+  }
+  const bool little =
+      tensorstore::endian::native == tensorstore::endian::little;
+  if (dtype[0] != '|' && (dtype[0] == '<') != little) {
+    return std::nullopt;
+  }
+
+  if (!IndexesStoredArray(var)) {
+    return std::nullopt;
+  }
+
+  MappedLayout layout;
+  layout.path = spec["kvstore"].value("path", "");
+  if (!layout.path.empty() && layout.path.back() != '/') {
+    layout.path += '/';
+  }
+  layout.separator = metadata.value("dimension_separator", ".");
+  layout.chunks = metadata["chunks"].get<std::vector<Index>>();
+  if (static_cast<DimensionIndex>(layout.chunks.size()) !=
+      var.get_store().transform().input_rank()) {
+    return std::nullopt;
+  }
+  return layout;
+}
+
+/**
+ * @brief Maps the chunk file of a cell of the chunk grid.
+ * The mapping is private, so modifying the samples doesn't modify the file.
+ * @return An array of the whole chunk, in the index space of the Variable, or
+ * a not found error if the chunk was never written.
+ */
+inline Result<SharedArray<void, dynamic_rank, offset_origin>> MapChunk(
+    const MappedLayout& layout, const std::vector<Index>& cell,
+    DataType dtype) {
+  std::string key = layout.path;
+  for (std::size_t d = 0; d < cell.size(); ++d) {
+    key += (d ? layout.separator : "") + std::to_string(cell[d]);
+  }
+  if (cell.empty()) {
+    key += "0";
+  }
+
+  const DimensionIndex rank = cell.size();
+  std::vector<Index> origin(rank), shape(rank), byte_strides(rank);
+  Index stride = dtype.size();
+  for (DimensionIndex d = rank - 1; d >= 0; --d) {
+    origin[d] = cell[d] * layout.chunks[d];
+    shape[d] = layout.chunks[d];
+    byte_strides[d] = stride;
+    stride *= layout.chunks[d];
+  }
+
+  const int fd = ::open(key.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return absl::NotFoundError("No chunk file '" + key + "'.");
+  }
+  struct stat info;
+  if (::fstat(fd, &info) != 0 || info.st_size < stride) {
+    ::close(fd);
+    return absl::DataLossError("The chunk file '" + key +
+                               "' is not an uncompressed chunk.");
+  }
+  const std::size_t size = info.st_size;
+  void* mapped =
+      ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED) {
+    return absl::InternalError("Could not map the chunk file '" + key + "'.");
+  }
+  std::shared_ptr<void> base(mapped,
+                             [size](void* ptr) { ::munmap(ptr, size); });
+
+  // The element pointer of an offset origin array is at the zero index.
+  Index to_origin = 0;
+  for (DimensionIndex d = 0; d < rank; ++d) {
+    to_origin += origin[d] * byte_strides[d];
+  }
+  tensorstore::SharedElementPointer<void> element(std::move(base), dtype);
+  element = tensorstore::AddByteOffset(std::move(element), -to_origin);
+  return SharedArray<void, dynamic_rank, offset_origin>(
+      std::move(element),
+      tensorstore::StridedLayout<dynamic_rank, offset_origin>(origin, shape,
+                                                              byte_strides));
+}
+
+/**
+ * @brief Checks if a box of a chunk is contiguous in C order, so it can be
+ * handed out without copying.
+ */
+inline bool IsContiguousInChunk(tensorstore::BoxView<> box,
+                                const std::vector<Index>& chunks) {
+  DimensionIndex partial = -1;
+  for (DimensionIndex d = 0; d < box.rank(); ++d) {
+    if (box.shape()[d] != chunks[d]) {
+      partial = d;
+    }
+  }
+  for (DimensionIndex d = 0; d < partial; ++d) {
+    if (box.shape()[d] != 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace internal
+
+/**
+ * @brief Reads a Variable by mapping its chunk files into memory.
+ * For a Zarr v2 Variable on a local file store without compression (see
+ * `transform_compressor`) the samples are used straight from the page cache.
+ * A selection that is contiguous inside one chunk, such as a trace or a whole
+ * chunk, is returned as a view of the mapped file. Any other selection is
+ * gathered from the mapped chunks into one copy. Variables that are
+ * compressed, remote, or have unwritten chunks are read with `Variable::Read`.
+ * @pre The chunk files are not truncated while mapped. Tensorstore replaces
+ * chunk files rather than modifying them, so writes through MDIO are safe.
+ * @details \b Usage
+ * @code
+ * MDIO_ASSIGN_OR_RETURN(auto scratch, ds.variables.get<float>("scratch"));
+ * MDIO_ASSIGN_OR_RETURN(auto data, mdio::ReadMapped(scratch).result());
+ * @endcode
+ * @return A future of the samples, in the index space of the Variable.
+ */
+template <typename T = void>
+Future<VariableData<T>> ReadMapped(const Variable<T>& var) {
+  auto fallback = [&var]() {
+    Variable<T> copy = var;
+    return copy.Read();
+  };
+  auto layout = internal::GetMappedLayout(var);
+  if (!layout.has_value()) {
+    return fallback();
+  }
+  const auto domain = var.dimensions();
+  const DimensionIndex rank = domain.rank();
+  std::vector<Index> first(rank), last(rank);
+  for (DimensionIndex d = 0; d < rank; ++d) {
+    if (domain.shape()[d] == 0) {
+      return fallback();
+    }
+    first[d] = tensorstore::FloorOfRatio(domain.origin()[d],
+                                         layout->chunks[d]);
+    last[d] = tensorstore::FloorOfRatio(
+        domain.origin()[d] + domain.shape()[d] - 1, layout->chunks[d]);
+  }
+
+  auto make_data = [&var, &domain](SharedArray<void, dynamic_rank,
+                                               offset_origin>
+                                       array) -> Result<VariableData<T>> {
+    auto typed = tensorstore::StaticDataTypeCast<T, tensorstore::unchecked>(
+        std::move(array));
+    LabeledArray<T, dynamic_rank, offset_origin> labeled{domain, typed};
+    return VariableData<T>{var.get_variable_name(), var.get_long_name(),
+                           var.getMetadata(), labeled};
+  };
+
+  // Inside a single chunk the mapped samples are handed out as they are.
+  if (first == last &&
+      internal::IsContiguousInChunk(domain.box(), layout->chunks)) {
+    auto chunk = internal::MapChunk(*layout, first, var.dtype());
+    if (!chunk.ok()) {
+      return fallback();
+    }
+    MDIO_ASSIGN_OR_RETURN(
+        auto view,
+        chunk.value() | tensorstore::AllDims().BoxSlice(domain.box()))
+    return make_data(tensorstore::SharedArray<void, dynamic_rank,
+                                              offset_origin>(view));
+  }
+
+  // Otherwise the chunks are gathered into a single array.
+  auto gathered = tensorstore::AllocateArray(
+      domain.box(), tensorstore::c_order, tensorstore::default_init,
+      var.dtype());
+  std::vector<Index> cell = first;
+  while (true) {
+    auto chunk = internal::MapChunk(*layout, cell, var.dtype());
+    if (!chunk.ok()) {
+      return fallback();
+    }
+    tensorstore::Box<> region(rank);
+    tensorstore::Intersect(chunk->domain(), domain.box(),
+                           tensorstore::MutableBoxView<>(region));
+    MDIO_ASSIGN_OR_RETURN(
+        auto from, chunk.value() | tensorstore::AllDims().BoxSlice(region))
+    MDIO_ASSIGN_OR_RETURN(
+        auto to, gathered | tensorstore::AllDims().BoxSlice(region))
+    tensorstore::CopyArray(from, to);
+
+    DimensionIndex d = rank - 1;
+    for (; d >= 0; --d) {
+      if (++cell[d] <= last[d]) {
+        break;
+      }
+      cell[d] = first[d];
+    }
+    if (d < 0) {
+      break;
+    }
+  }
+  return make_data(std::move(gathered));
+}
+
+}  // namespace mdio
+
+#endif  // MDIO_MAPPED_READ_H_
@@ -0,0 +1,110 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mdio/mapped_read.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "mdio/utils/test_fixtures.h"
+
+namespace {
+
+// Uncompressed, so the chunks can be mapped.
+::nlohmann::json MappedSpec(const std::string& path) {
+  auto json = mdio::testing::VariableSpec(path, {"x", "y"}, {20, 30}, {8, 16},
+                                          "<f4", -1.0);
+  json["metadata"]["compressor"] = nullptr;
+  return json;
+}
+
+// Opens the Variable with the value x * 100 + y.
+mdio::Result<mdio::Variable<float>> MakeMapped(const ::nlohmann::json& json) {
+  return mdio::testing::MakeVariable<float>(
+      json,
+      [](const std::vector<mdio::Index>& p) { return p[0] * 100 + p[1]; });
+}
+
+// Checks a read of rows [x0, x1) and columns [y0, y1).
+void ExpectRegion(const mdio::Variable<float>& var, mdio::Index x0,
+                  mdio::Index x1, mdio::Index y0, mdio::Index y1) {
+  mdio::RangeDescriptor<mdio::Index> xs = {"x", x0, x1, 1};
+  mdio::RangeDescriptor<mdio::Index> ys = {"y", y0, y1, 1};
+  auto region = var.slice(xs, ys);
+  ASSERT_TRUE(region.ok()) << region.status();
+  auto data = mdio::ReadMapped(region.value()).result();
+  ASSERT_TRUE(data.ok()) << data.status();
+  EXPECT_EQ(data->num_samples(), (x1 - x0) * (y1 - y0));
+  auto accessor = data->get_data_accessor();
+  for (mdio::Index x = x0; x < x1; ++x) {
+    for (mdio::Index y = y0; y < y1; ++y) {
+      ASSERT_EQ(accessor({x, y}), x * 100 + y) << x << ", " << y;
+    }
+  }
+}
+
+TEST(ReadMapped, uncompressed) {
+  auto var = MakeMapped(MappedSpec("mapped_variable"));
+  ASSERT_TRUE(var.ok()) << var.status();
+  ASSERT_TRUE(mdio::internal::GetMappedLayout(var.value()).has_value());
+
+  // Contiguous in one chunk, a view of the mapped file.
+  ExpectRegion(var.value(), 9, 12, 0, 16);
+  ExpectRegion(var.value(), 3, 4, 18, 25);
+  // Gathered from one or more chunks.
+  ExpectRegion(var.value(), 1, 3, 2, 5);
+  ExpectRegion(var.value(), 0, 20, 0, 30);
+  ExpectRegion(var.value(), 5, 17, 10, 20);
+
+  // The mapping is private, the file is untouched by changes to the view.
+  mdio::RangeDescriptor<mdio::Index> row = {"x", 0, 1, 1};
+  auto first = var->slice(row);
+  ASSERT_TRUE(first.ok()) << first.status();
+  mdio::RangeDescriptor<mdio::Index> cols = {"y", 0, 16, 1};
+  first = first->slice(cols);
+  ASSERT_TRUE(first.ok()) << first.status();
+  auto view = mdio::ReadMapped(first.value()).result();
+  ASSERT_TRUE(view.ok()) << view.status();
+  view->get_data_accessor()({0, 0}) = 42;
+  ExpectRegion(var.value(), 0, 1, 0, 16);
+
+  std::filesystem::remove_all("mapped_variable");
+}
+
+TEST(ReadMapped, fallback) {
+  // Compressed Variables are read normally.
+  auto json = MappedSpec("compressed_variable");
+  json["metadata"].erase("compressor");
+  auto var = MakeMapped(json);
+  ASSERT_TRUE(var.ok()) << var.status();
+  EXPECT_FALSE(mdio::internal::GetMappedLayout(var.value()).has_value());
+  ExpectRegion(var.value(), 5, 17, 10, 20);
+  std::filesystem::remove_all("compressed_variable");
+
+  // Unwritten chunks take the fill value.
+  json = MappedSpec("sparse_variable");
+  auto sparse =
+      mdio::Variable<float>::Open(json, mdio::constants::kCreateClean).result();
+  ASSERT_TRUE(sparse.ok()) << sparse.status();
+  auto data = mdio::ReadMapped(sparse.value()).result();
+  ASSERT_TRUE(data.ok()) << data.status();
+  EXPECT_EQ(data->get_data_accessor()({0, 0}), -1.0f);
+  std::filesystem::remove_all("sparse_variable");
+}
+
+}  // namespace
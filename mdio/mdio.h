@@ -21,7 +21,20 @@
 #ifndef MDIO_MDIO_H_
 #define MDIO_MDIO_H_
 
+#include "mdio/arbitrary_line.h"
+#include "mdio/chunked_writer.h"
+#include "mdio/compute.h"
+#include "mdio/compute_stats.h"
+#include "mdio/convert.h"
 #include "mdio/coordinate_selector.h"
+#include "mdio/coro.h"
 #include "mdio/dataset.h"
+#include "mdio/partition.h"
+#include "mdio/request_policy.h"
+#include "mdio/sparse_read.h"
+#include "mdio/spatial_index.h"
+#include "mdio/telemetry.h"
+#include "mdio/tile_reader.h"
+#include "mdio/typed_dataset.h"
 
 #endif  // MDIO_MDIO_H_
@@ -0,0 +1,437 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MDIO_PARTITION_H_
+#define MDIO_PARTITION_H_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mdio/dataset.h"
+#include "mdio/impl.h"
+#include "mdio/variable.h"
+#include "tensorstore/util/division.h"
+#include "tensorstore/util/future.h"
+
+// clang-format off
+#include <nlohmann/json.hpp>  // NOLINT
+// clang-format on
+
+namespace mdio {
+
+/**
+ * @brief Options for `PlanPartitions`.
+ */
+struct PartitionOptions {
+  /// The dimensions to split, slowest first. Others are never split.
+  std::vector<std::string> dimensions = {"inline", "crossline"};
+  /// A boolean Variable over `dimensions` whose live entries weigh the work,
+  /// e.g. "trace_mask". Empty weighs every trace the same.
+  std::string weight_mask;
+  /// The Variables the workers write, whose chunks must not be shared. Empty
+  /// means every Variable over all of `dimensions`, so 1-D coordinates are
+  /// left to the coordinator.
+  std::vector<std::string> variables;
+};
+
+/**
+ * @brief The part of a Dataset one worker processes.
+ * A partition is a few boxes over the split dimensions. The boxes of
+ * different partitions never share a chunk of any Variable of the Dataset.
+ */
+struct Partition {
+  /// The labels of the split dimensions, shared so descriptors stay valid as
+  /// partitions are copied and moved.
+  std::shared_ptr<const std::vector<std::string>> labels;
+  /// The [start, stop) extent of every split dimension, per box.
+  std::vector<std::vector<std::array<Index, 2>>> boxes;
+  /// The share of the work in the partition, the live traces if weighted.
+  double weight = 0;
+
+  bool empty() const { return boxes.empty(); }
+
+  /**
+   * @brief Gets the descriptors of every box, to pass to `isel`.
+   * The descriptors refer to the labels of the partition, so one of its
+   * copies must outlive them.
+   */
+  std::vector<std::vector<RangeDescriptor<Index>>> descriptors() const {
+    std::vector<std::vector<RangeDescriptor<Index>>> out;
+    for (const auto& box : boxes) {
+      auto& desc = out.emplace_back();
+      for (std::size_t d = 0; d < box.size(); ++d) {
+        desc.push_back({(*labels)[d], box[d][0], box[d][1], 1});
+      }
+    }
+    return out;
+  }
+
+  /**
+   * @brief Serializes the partition to send to a worker.
+   */
+  nlohmann::json ToJson() const {
+    nlohmann::json json = {{"labels", labels ? *labels
+                                             : std::vector<std::string>{}},
+                           {"weight", weight},
+                           {"boxes", nlohmann::json::array()}};
+    for (const auto& box : boxes) {
+      auto& extents = json["boxes"].emplace_back(nlohmann::json::array());
+      for (const auto& extent : box) {
+        extents.push_back({extent[0], extent[1]});
+      }
+    }
+    return json;
+  }
+
+  /**
+   * @brief Reconstructs a partition written by `ToJson`.
+   */
+  static Result<Partition> FromJson(const nlohmann::json& json) {
+    const auto invalid = [] {
+      return absl::InvalidArgumentError("Malformed partition.");
+    };
+    if (!json.is_object() || !json.contains("labels") ||
+        !json.contains("boxes") || !json["labels"].is_array() ||
+        !json["boxes"].is_array()) {
+      return invalid();
+    }
+    Partition partition;
+    std::vector<std::string> labels;
+    for (const auto& label : json["labels"]) {
+      if (!label.is_string()) {
+        return invalid();
+      }
+      labels.push_back(label.get<std::string>());
+    }
+    partition.labels =
+        std::make_shared<const std::vector<std::string>>(std::move(labels));
+    partition.weight = json.value("weight", 0.0);
+    for (const auto& extents : json["boxes"]) {
+      if (!extents.is_array() ||
+          extents.size() != partition.labels->size()) {
+        return invalid();
+      }
+      auto& box = partition.boxes.emplace_back();
+      for (const auto& extent : extents) {
+        if (!extent.is_array() || extent.size() != 2 ||
+            !extent[0].is_number_integer() || !extent[1].is_number_integer()) {
+          return invalid();
+        }
+        box.push_back({extent[0].get<Index>(), extent[1].get<Index>()});
+        if (box.back()[0] > box.back()[1]) {
+          return invalid();
+        }
+      }
+    }
+    return partition;
+  }
+};
+
+namespace internal {
+
+/**
+ * @brief Splits a run [start, stop) of C-order cells of a grid into boxes.
+ * A run becomes at most two partial rows and one box of whole rows per
+ * dimension, so a contiguous share of the grid stays a few boxes.
+ * @param shape The shape of the grid.
+ * @param prefix The extents of the dimensions before `dim`.
+ */
+inline void RunToBoxes(const std::vector<Index>& shape, std::size_t dim,
+                       Index start, Index stop,
+                       std::vector<std::array<Index, 2>>& prefix,  // NOLINT
+                       std::vector<std::vector<std::array<Index, 2>>>&
+                           boxes) {  // NOLINT (non-const)
+  if (start >= stop) {
+    return;
+  }
+  if (dim + 1 == shape.size()) {
+    prefix.push_back({start, stop});
+    boxes.push_back(prefix);
+    prefix.pop_back();
+    return;
+  }
+  Index inner = 1;
+  for (std::size_t d = dim + 1; d < shape.size(); ++d) {
+    inner *= shape[d];
+  }
+  Index first = start / inner;
+  const Index last = stop / inner;
+  const auto row = [&](Index i, Index from, Index to) {
+    prefix.push_back({i, i + 1});
+    RunToBoxes(shape, dim + 1, from, to, prefix, boxes);
+    prefix.pop_back();
+  };
+  if (first == last) {
+    row(first, start % inner, stop % inner);
+    return;
+  }
+  if (start % inner != 0) {
+    row(first, start % inner, inner);
+    ++first;
+  }
+  if (first < last) {
+    prefix.push_back({first, last});
+    for (std::size_t d = dim + 1; d < shape.size(); ++d) {
+      prefix.push_back({0, shape[d]});
+    }
+    boxes.push_back(prefix);
+    prefix.resize(dim);
+  }
+  if (stop % inner != 0) {
+    row(last, 0, stop % inner);
+  }
+}
+
+/**
+ * @brief The grid of blocks the partitions are made of.
+ * Along every split dimension a block spans the least common multiple of the
+ * chunk sizes of the Variables over it, so no chunk straddles two blocks.
+ */
+struct PartitionGrid {
+  std::vector<std::string> labels;
+  std::vector<Index> origin;
+  std::vector<Index> extent;
+  std::vector<Index> step;
+  /// The blocks along every dimension.
+  std::vector<Index> shape;
+
+  /// The [start, stop) of block `i` along dimension `d`.
+  std::array<Index, 2> Extent(std::size_t d, Index i) const {
+    const Index first = tensorstore::FloorOfRatio(origin[d], step[d]) + i;
+    return {std::max(origin[d], first * step[d]),
+            std::min(origin[d] + extent[d], (first + 1) * step[d])};
+  }
+};
+
+/**
+ * @brief Lays the blocks over the split dimensions of a Dataset.
+ */
+inline Result<PartitionGrid> MakePartitionGrid(
+    Dataset& dataset,  // NOLINT (non-const)
+    const PartitionOptions& options) {
+  if (options.dimensions.empty()) {
+    return absl::InvalidArgumentError("No dimensions to partition.");
+  }
+  PartitionGrid grid;
+  const auto labels = dataset.domain.labels();
+  for (const auto& name : options.dimensions) {
+    auto it = std::find(labels.begin(), labels.end(), name);
+    if (it == labels.end()) {
+      return absl::InvalidArgumentError("The Dataset has no dimension '" +
+                                        name + "' to partition.");
+    }
+    const auto d = it - labels.begin();
+    grid.labels.push_back(name);
+    grid.origin.push_back(dataset.domain.origin()[d]);
+    grid.extent.push_back(dataset.domain.shape()[d]);
+    grid.step.push_back(1);
+  }
+  const bool all = options.variables.empty();
+  const auto names = all ? dataset.variables.get_keys() : options.variables;
+  for (const auto& name : names) {
+    MDIO_ASSIGN_OR_RETURN(auto var, dataset.variables.at(name))
+    auto var_labels = var.dimensions().labels();
+    std::vector<std::ptrdiff_t> dims;
+    for (const auto& label : grid.labels) {
+      auto it = std::find(var_labels.begin(), var_labels.end(), label);
+      dims.push_back(it == var_labels.end() ? -1 : it - var_labels.begin());
+    }
+    if (all && std::count(dims.begin(), dims.end(), -1) != 0) {
+      continue;
+    }
+    MDIO_ASSIGN_OR_RETURN(auto chunks, var.get_chunk_shape())
+    for (std::size_t g = 0; g < grid.labels.size(); ++g) {
+      if (dims[g] < 0) {
+        continue;
+      }
+      const Index chunk = chunks[dims[g]];
+      if (chunk > 0) {
+        grid.step[g] = std::lcm(grid.step[g], chunk);
+      }
+    }
+  }
+  for (std::size_t g = 0; g < grid.labels.size(); ++g) {
+    const Index first = tensorstore::FloorOfRatio(grid.origin[g], grid.step[g]);
+    const Index end = tensorstore::CeilOfRatio(grid.origin[g] + grid.extent[g],
+                                               grid.step[g]);
+    grid.shape.push_back(grid.extent[g] == 0 ? 0 : end - first);
+  }
+  return grid;
+}
+
+/**
+ * @brief Cuts the C-order blocks into contiguous runs of similar weight.
+ */
+inline std::vector<Partition> BalancePartitions(
+    const PartitionGrid& grid, const std::vector<double>& weights,
+    std::size_t workers) {
+  auto labels = std::make_shared<const std::vector<std::string>>(grid.labels);
+  std::vector<Partition> partitions(workers);
+  const double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+  const Index num_blocks = weights.size();
+  Index start = 0;
+  double done = 0;
+  for (std::size_t w = 0; w < workers; ++w) {
+    auto& partition = partitions[w];
+    partition.labels = labels;
+    // Every worker aims for an even share of what is left, so the last one
+    // isn't left with the rounding of the others.
+    const double target = (total - done) / (workers - w);
+    const bool last = w + 1 == workers;
+    // Leave a block for every later worker while there are enough of them.
+    const Index max_stop =
+        last ? num_blocks
+             : std::max<Index>(start, num_blocks - (workers - w - 1));
+    Index stop = start;
+    double weight = 0;
+    if (total == 0) {
+      // Without any weight the blocks are shared by count.
+      stop = last ? num_blocks
+                  : std::min(max_stop, start + (num_blocks - start) /
+                                                   Index(workers - w));
+    } else {
+      while (stop < max_stop &&
+             (last || stop == start || weight + weights[stop] / 2 <= target)) {
+        weight += weights[stop++];
+      }
+    }
+    std::vector<std::array<Index, 2>> prefix;
+    std::vector<std::vector<std::array<Index, 2>>> block_boxes;
+    RunToBoxes(grid.shape, 0, start, stop, prefix, block_boxes);
+    for (const auto& block_box : block_boxes) {
+      auto& box = partition.boxes.emplace_back();
+      for (std::size_t d = 0; d < block_box.size(); ++d) {
+        box.push_back({grid.Extent(d, block_box[d][0])[0],
+                       grid.Extent(d, block_box[d][1] - 1)[1]});
+      }
+    }
+    partition.weight = weight;
+    done += weight;
+    start = stop;
+  }
+  return partitions;
+}
+
+}  // namespace internal
+
+/**
+ * @brief Splits a Dataset into chunk aligned, balanced partitions.
+ * The split dimensions are cut on the boundaries of the chunks of every
+ * Variable the workers write, so partitions can be written concurrently
+ * without two of them touching one chunk. Each worker gets a contiguous run
+ * of blocks in C order, of about the same number of traces, or of live traces
+ * when weighted by a mask.
+ * @details \b Usage
+ * @code
+ * mdio::PartitionOptions options;
+ * options.weight_mask = "trace_mask";
+ * MDIO_ASSIGN_OR_RETURN(auto parts,
+ *                       mdio::PlanPartitions(ds, 200, options).result());
+ * SendToWorker(w, parts[w].ToJson().dump());
+ * // On the worker
+ * MDIO_ASSIGN_OR_RETURN(auto part, mdio::Partition::FromJson(json));
+ * for (const auto& box : part.descriptors()) {
+ *   MDIO_ASSIGN_OR_RETURN(auto region, ds.isel(box));
+ * }
+ * @endcode
+ * @param dataset The Dataset to split.
+ * @param workers The number of partitions. Partitions are empty if there are
+ * fewer blocks than workers.
+ * @param options The dimensions to split and the weighting mask.
+ * @return A future of one partition per worker.
+ */
+inline Future<std::vector<Partition>> PlanPartitions(
+    Dataset& dataset,  // NOLINT (non-const)
+    std::size_t workers, const PartitionOptions& options = {}) {
+  if (workers == 0) {
+    return absl::InvalidArgumentError("At least one worker is needed.");
+  }
+  MDIO_ASSIGN_OR_RETURN(auto grid,
+                        internal::MakePartitionGrid(dataset, options))
+  const Index num_blocks = std::accumulate(grid.shape.begin(), grid.shape.end(),
+                                           Index{1}, std::multiplies<Index>());
+
+  if (options.weight_mask.empty()) {
+    std::vector<double> weights(num_blocks);
+    for (Index b = 0; b < num_blocks; ++b) {
+      double volume = 1;
+      Index rest = b;
+      for (std::size_t d = grid.shape.size(); d-- > 0;) {
+        const auto extent = grid.Extent(d, rest % grid.shape[d]);
+        volume *= extent[1] - extent[0];
+        rest /= grid.shape[d];
+      }
+      weights[b] = volume;
+    }
+    return internal::BalancePartitions(grid, weights, workers);
+  }
+
+  MDIO_ASSIGN_OR_RETURN(auto mask,
+                        dataset.variables.get<bool>(options.weight_mask))
+  const auto mask_domain = mask.dimensions();
+  bool matches = mask_domain.rank() ==
+                 static_cast<DimensionIndex>(grid.labels.size());
+  for (DimensionIndex d = 0; matches && d < mask_domain.rank(); ++d) {
+    matches = mask_domain.labels()[d] == grid.labels[d] &&
+              mask_domain.origin()[d] == grid.origin[d] &&
+              mask_domain.shape()[d] == grid.extent[d];
+  }
+  if (!matches) {
+    return absl::InvalidArgumentError("The weight mask '" +
+                                      options.weight_mask +
+                                      "' must span the split dimensions.");
+  }
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [grid, num_blocks, workers](VariableData<bool>& data) {
+        const bool* live =
+            data.get_data_accessor().data() + data.get_flattened_offset();
+        const std::size_t rank = grid.shape.size();
+        std::vector<double> weights(num_blocks);
+        std::vector<Index> position(rank, 0);
+        const Index count = data.num_samples();
+        for (Index i = 0; i < count; ++i) {
+          if (live[i]) {
+            // The block of the trace, from its position within the mask.
+            Index block = 0;
+            for (std::size_t d = 0; d < rank; ++d) {
+              const Index index = grid.origin[d] + position[d];
+              block = block * grid.shape[d] +
+                      tensorstore::FloorOfRatio(index, grid.step[d]) -
+                      tensorstore::FloorOfRatio(grid.origin[d], grid.step[d]);
+            }
+            weights[block] += 1;
+          }
+          for (std::size_t d = rank; d-- > 0;) {
+            if (++position[d] < grid.extent[d]) {
+              break;
+            }
+            position[d] = 0;
+          }
+        }
+        return internal::BalancePartitions(grid, weights, workers);
+      },
+      mask.Read());
+}
+
+}  // namespace mdio
+
+#endif  // MDIO_PARTITION_H_
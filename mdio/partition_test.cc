@@ -0,0 +1,210 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mdio/partition.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char kSchema[] = R"(
+{
+  "metadata": {
+    "name": "partitioned",
+    "apiVersion": "1.0.0",
+    "createdOn": "2023-12-12T15:02:06.413469-06:00"
+  },
+  "variables": [
+    {
+      "name": "seismic",
+      "dataType": "float32",
+      "dimensions": [
+        {"name": "inline", "size": 20},
+        {"name": "crossline", "size": 8},
+        {"name": "depth", "size": 16}
+      ],
+      "metadata": {
+        "chunkGrid": {
+          "name": "regular",
+          "configuration": {"chunkShape": [4, 4, 16]}
+        }
+      },
+      "coordinates": ["trace_mask"]
+    },
+    {
+      "name": "trace_mask",
+      "dataType": "bool",
+      "dimensions": ["inline", "crossline"],
+      "metadata": {
+        "chunkGrid": {
+          "name": "regular",
+          "configuration": {"chunkShape": [4, 8]}
+        }
+      }
+    },
+    {
+      "name": "inline",
+      "dataType": "uint32",
+      "dimensions": [{"name": "inline", "size": 20}]
+    },
+    {
+      "name": "crossline",
+      "dataType": "uint32",
+      "dimensions": [{"name": "crossline", "size": 8}]
+    },
+    {
+      "name": "depth",
+      "dataType": "uint32",
+      "dimensions": [{"name": "depth", "size": 16}]
+    }
+  ]
+}
+)";
+
+mdio::Result<mdio::Dataset> MakeDataset() {
+  auto schema = ::nlohmann::json::parse(kSchema);
+  return mdio::Dataset::from_json(schema, "zarrs/partitioned",
+                                  mdio::constants::kCreateClean)
+      .result();
+}
+
+// Checks that every trace is in exactly one partition and that boxes start
+// and stop on chunk boundaries.
+void ExpectTiling(const std::vector<mdio::Partition>& partitions,
+                  mdio::Index inlines, mdio::Index crosslines,
+                  mdio::Index step) {
+  std::vector<int> owners(inlines * crosslines, 0);
+  for (const auto& partition : partitions) {
+    for (const auto& box : partition.boxes) {
+      ASSERT_EQ(box.size(), 2);
+      for (const auto& extent : box) {
+        EXPECT_EQ(extent[0] % step, 0);
+      }
+      EXPECT_TRUE(box[0][1] % step == 0 || box[0][1] == inlines);
+      EXPECT_TRUE(box[1][1] % step == 0 || box[1][1] == crosslines);
+      for (mdio::Index i = box[0][0]; i < box[0][1]; ++i) {
+        for (mdio::Index j = box[1][0]; j < box[1][1]; ++j) {
+          ++owners[i * crosslines + j];
+        }
+      }
+    }
+  }
+  for (int owner : owners) {
+    EXPECT_EQ(owner, 1);
+  }
+}
+
+TEST(Partition, chunkAligned) {
+  auto dataset = MakeDataset();
+  ASSERT_TRUE(dataset.ok()) << dataset.status();
+
+  // The chunks of seismic and of trace_mask meet every 4 inlines and every 8
+  // crosslines. The 1-D coordinates are not written by the workers.
+  auto partitions = mdio::PlanPartitions(dataset.value(), 3).result();
+  ASSERT_TRUE(partitions.ok()) << partitions.status();
+  ASSERT_EQ(partitions->size(), 3);
+  ExpectTiling(partitions.value(), 20, 8, 4);
+  double total = 0;
+  for (const auto& partition : partitions.value()) {
+    EXPECT_FALSE(partition.empty());
+    total += partition.weight;
+  }
+  EXPECT_EQ(total, 20 * 8);
+
+  // More workers than the 5 blocks leaves some of them without work.
+  auto many = mdio::PlanPartitions(dataset.value(), 16).result();
+  ASSERT_TRUE(many.ok()) << many.status();
+  ExpectTiling(many.value(), 20, 8, 4);
+  int empty = 0;
+  for (const auto& partition : many.value()) {
+    empty += partition.empty();
+  }
+  EXPECT_EQ(empty, 11);
+  std::filesystem::remove_all("zarrs/partitioned");
+}
+
+TEST(Partition, weightedByMask) {
+  auto dataset = MakeDataset();
+  ASSERT_TRUE(dataset.ok()) << dataset.status();
+  auto mask = dataset->variables.get<bool>("trace_mask");
+  ASSERT_TRUE(mask.ok()) << mask.status();
+  auto data = mdio::from_variable<bool>(mask.value());
+  ASSERT_TRUE(data.ok()) << data.status();
+  bool* live = data->get_data_accessor().data() + data->get_flattened_offset();
+  // Only the first 8 inlines have traces.
+  for (int i = 0; i < 20 * 8; ++i) {
+    live[i] = i < 8 * 8;
+  }
+  ASSERT_TRUE(mask->Write(data.value()).commit_future.result().ok());
+
+  mdio::PartitionOptions options;
+  options.weight_mask = "trace_mask";
+  auto partitions = mdio::PlanPartitions(dataset.value(), 2, options).result();
+  ASSERT_TRUE(partitions.ok()) << partitions.status();
+  ExpectTiling(partitions.value(), 20, 8, 4);
+  EXPECT_EQ((*partitions)[0].weight, 32);
+  EXPECT_EQ((*partitions)[1].weight, 32);
+  // The first worker stops half way through the live inlines.
+  ASSERT_EQ((*partitions)[0].boxes.size(), 1);
+  EXPECT_EQ((*partitions)[0].boxes[0][0][1], 4);
+
+  options.weight_mask = "seismic";
+  EXPECT_FALSE(mdio::PlanPartitions(dataset.value(), 2, options).status().ok());
+  std::filesystem::remove_all("zarrs/partitioned");
+}
+
+TEST(Partition, json) {
+  auto dataset = MakeDataset();
+  ASSERT_TRUE(dataset.ok()) << dataset.status();
+  auto partitions = mdio::PlanPartitions(dataset.value(), 3).result();
+  ASSERT_TRUE(partitions.ok()) << partitions.status();
+
+  const auto& original = (*partitions)[1];
+  auto restored = mdio::Partition::FromJson(
+      ::nlohmann::json::parse(original.ToJson().dump()));
+  ASSERT_TRUE(restored.ok()) << restored.status();
+  EXPECT_EQ(restored->boxes, original.boxes);
+  EXPECT_EQ(restored->weight, original.weight);
+
+  // A worker selects its part straight from the descriptors.
+  for (const auto& box : restored->descriptors()) {
+    auto region = dataset->isel(box);
+    ASSERT_TRUE(region.ok()) << region.status();
+  }
+
+  EXPECT_FALSE(
+      mdio::Partition::FromJson(::nlohmann::json::parse(R"({"labels": 1})"))
+          .ok());
+  std::filesystem::remove_all("zarrs/partitioned");
+}
+
+TEST(Partition, runToBoxes) {
+  // Cells 3 to 14 of a 4 by 4 grid: a partial row, two whole rows and a
+  // partial row.
+  std::vector<std::array<mdio::Index, 2>> prefix;
+  std::vector<std::vector<std::array<mdio::Index, 2>>> boxes;
+  mdio::internal::RunToBoxes({4, 4}, 0, 3, 14, prefix, boxes);
+  using Box = std::vector<std::array<mdio::Index, 2>>;
+  EXPECT_THAT(boxes, ::testing::ElementsAre(Box{{0, 1}, {3, 4}},
+                                            Box{{1, 3}, {0, 4}},
+                                            Box{{3, 4}, {0, 2}}));
+}
+
+}  // namespace
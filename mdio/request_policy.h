@@ -0,0 +1,503 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MDIO_REQUEST_POLICY_H_
+#define MDIO_REQUEST_POLICY_H_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mdio/telemetry.h"
+#include "tensorstore/kvstore/kvstore.h"
+#include "tensorstore/kvstore/operations.h"
+#include "tensorstore/util/future.h"
+#include "tensorstore/util/result.h"
+
+// clang-format off
+#include <nlohmann/json.hpp>  // NOLINT
+// clang-format on
+
+namespace mdio {
+
+/**
+ * @brief How MDIO requests to a store are timed out, hedged and retried.
+ * The retries and backoff also apply to every S3 and GCS request Tensorstore
+ * makes for the Variables, through the "s3_request_retries" and
+ * "gcs_request_retries" resources of their kvstore specs. Deadlines and
+ * hedging apply to the requests MDIO makes itself, such as the metadata reads
+ * of `Dataset::Open`.
+ */
+struct RequestPolicy {
+  /// The time an attempt may take before another one is started.
+  absl::Duration deadline = absl::InfiniteDuration();
+  /// The latency percentile, in (0, 1), after which a duplicate of a request
+  /// is sent. Zero disables hedging.
+  double hedge_percentile = 0;
+  /// A duplicate is never sent sooner than this.
+  absl::Duration min_hedge_delay = absl::Milliseconds(50);
+  /// The number of latencies observed before requests are hedged.
+  std::size_t hedge_warmup = 16;
+  /// The number of retries of one request.
+  int max_retries = 4;
+  /// The delay before the first retry, doubled for every retry after it.
+  absl::Duration initial_backoff = absl::Milliseconds(100);
+  absl::Duration max_backoff = absl::Seconds(10);
+  /// The share of requests that may be retried or hedged, across the process.
+  double retry_budget = 0.1;
+  /// The retries and hedges that can be spent at once, the budget starts full.
+  double retry_burst = 10;
+
+  /**
+   * @brief Gets the Tensorstore retry resource of the policy.
+   */
+  ::nlohmann::json RetriesJson() const {
+    return {{"max_retries", max_retries},
+            {"initial_delay", absl::FormatDuration(initial_backoff)},
+            {"max_delay", absl::FormatDuration(max_backoff)}};
+  }
+};
+
+namespace internal {
+
+/**
+ * @brief Runs tasks at a point in time, on one thread of the process.
+ */
+class RequestTimer {
+ public:
+  /// Never destroyed, tasks may still be scheduled during shutdown.
+  static RequestTimer& Get() {
+    static RequestTimer* timer = new RequestTimer();
+    return *timer;
+  }
+
+  void At(absl::Time when, std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    tasks.emplace(when, std::move(task));
+    if (!started) {
+      started = true;
+      std::thread([this] { Run(); }).detach();
+    }
+    wake.notify_one();
+  }
+
+ private:
+  void Run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      if (tasks.empty()) {
+        wake.wait(lock);
+        continue;
+      }
+      const absl::Time now = absl::Now();
+      auto first = tasks.begin();
+      if (first->first > now) {
+        wake.wait_for(lock, absl::ToChronoNanoseconds(first->first - now));
+        continue;
+      }
+      auto task = std::move(first->second);
+      tasks.erase(first);
+      lock.unlock();
+      task();
+      lock.lock();
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::multimap<absl::Time, std::function<void()>> tasks;
+  bool started = false;
+};
+
+/**
+ * @brief The policy of the process with the latencies and retry budget it
+ * shares between requests.
+ */
+class RequestState {
+ public:
+  /// The number of recent latencies the hedge delay is taken from.
+  static constexpr std::size_t kLatencyWindow = 256;
+
+  explicit RequestState(RequestPolicy policy)
+      : policy(std::move(policy)), tokens(this->policy.retry_burst) {}
+
+  const RequestPolicy policy;
+
+  /**
+   * @brief Adds the share of a new request to the retry budget.
+   */
+  void Deposit() {
+    std::lock_guard<std::mutex> lock(mutex);
+    tokens = std::min(policy.retry_burst, tokens + policy.retry_budget);
+  }
+
+  /**
+   * @brief Takes a retry or hedge from the budget.
+   * @return False if the budget is spent.
+   */
+  bool Withdraw() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tokens < 1) {
+      return false;
+    }
+    tokens -= 1;
+    return true;
+  }
+
+  void RecordLatency(absl::Duration latency) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (latencies.size() < kLatencyWindow) {
+      latencies.push_back(latency);
+    } else {
+      latencies[next_latency] = latency;
+    }
+    next_latency = (next_latency + 1) % kLatencyWindow;
+  }
+
+  /**
+   * @brief Gets how long a request runs before a duplicate is sent.
+   * @return The delay, or nothing if hedging is disabled or still warming up.
+   */
+  std::optional<absl::Duration> HedgeDelay() {
+    if (policy.hedge_percentile <= 0 || policy.hedge_percentile >= 1) {
+      return std::nullopt;
+    }
+    std::vector<absl::Duration> window;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (latencies.empty() || latencies.size() < policy.hedge_warmup) {
+        return std::nullopt;
+      }
+      window = latencies;
+    }
+    auto nth = window.begin() + static_cast<std::ptrdiff_t>(
+                                    policy.hedge_percentile * window.size());
+    std::nth_element(window.begin(), nth, window.end());
+    return std::max(policy.min_hedge_delay, *nth);
+  }
+
+  /**
+   * @brief Gets the delay before a retry, `retry` counting from 1.
+   */
+  absl::Duration Backoff(int retry) const {
+    absl::Duration delay = policy.initial_backoff;
+    for (int i = 1; i < retry && delay < policy.max_backoff; ++i) {
+      delay *= 2;
+    }
+    return std::min(delay, policy.max_backoff);
+  }
+
+ private:
+  std::mutex mutex;
+  double tokens;
+  std::vector<absl::Duration> latencies;
+  std::size_t next_latency = 0;
+};
+
+inline std::shared_ptr<RequestState>& ProcessRequestState() {
+  static std::shared_ptr<RequestState> state;
+  return state;
+}
+
+inline std::mutex& ProcessRequestMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+/**
+ * @brief The request policy of the process, null if none is set.
+ */
+inline std::shared_ptr<RequestState> GetRequestState() {
+  std::lock_guard<std::mutex> lock(ProcessRequestMutex());
+  return ProcessRequestState();
+}
+
+/**
+ * @brief Checks if a failed attempt is worth repeating.
+ */
+inline bool IsRetryable(const absl::Status& status) {
+  return absl::IsUnavailable(status) || absl::IsDeadlineExceeded(status) ||
+         absl::IsResourceExhausted(status);
+}
+
+/**
+ * @brief One request and its attempts, see `RunWithPolicy`.
+ */
+template <typename T>
+struct PolicyRequest {
+  std::shared_ptr<RequestState> state;
+  std::function<tensorstore::Future<T>()> launch;
+  tensorstore::Promise<T> promise;
+  Span span{"mdio.Request"};
+
+  std::mutex mutex;
+  bool done = false;
+  /// Settled attempts failed or ran past the deadline, but may still win.
+  std::vector<bool> settled;
+  std::size_t unsettled = 0;
+  /// Retries waiting out their backoff.
+  int scheduled = 0;
+  int retries = 0;
+  /// The attempt that is the hedge, if one was sent.
+  std::optional<std::size_t> hedge;
+};
+
+/**
+ * @brief Reports the outcome of a request and resolves its future.
+ */
+template <typename T>
+void FinishRequest(const std::shared_ptr<PolicyRequest<T>>& request,
+                   tensorstore::Result<T> result, const char* outcome) {
+  request->span.Attribute("mdio.attempts",
+                          std::to_string(request->settled.size()));
+  request->span.Attribute("mdio.outcome", outcome);
+  request->span.End(result.status());
+  request->promise.SetResult(std::move(result));
+}
+
+template <typename T>
+void LaunchAttempt(const std::shared_ptr<PolicyRequest<T>>& request);
+
+/**
+ * @brief Gives up on an attempt, the request is retried if the budget allows
+ * and fails once nothing is left in flight.
+ * Called with the request's mutex held.
+ * @return True if the request failed.
+ */
+template <typename T>
+bool SettleAttempt(const std::shared_ptr<PolicyRequest<T>>& request,
+                   std::size_t attempt) {
+  request->settled[attempt] = true;
+  --request->unsettled;
+  auto& state = *request->state;
+  if (request->retries < state.policy.max_retries &&
+      request->promise.result_needed() && state.Withdraw()) {
+    ++request->retries;
+    ++request->scheduled;
+    Count(TelemetryCounter::kRetries, 1);
+    RequestTimer::Get().At(absl::Now() + state.Backoff(request->retries),
+                           [request] { LaunchAttempt(request); });
+    return false;
+  }
+  if (request->unsettled == 0 && request->scheduled == 0) {
+    request->done = true;
+    return true;
+  }
+  return false;
+}
+
+template <typename T>
+void OnAttemptReady(const std::shared_ptr<PolicyRequest<T>>& request,
+                    std::size_t attempt, absl::Time launched,
+                    tensorstore::Result<T> result) {
+  const char* outcome = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(request->mutex);
+    if (request->done) {
+      return;
+    }
+    if (result.ok() || !IsRetryable(result.status())) {
+      request->done = true;
+      if (!result.ok()) {
+        outcome = "failed";
+      } else if (attempt == 0) {
+        outcome = "ok";
+      } else if (request->hedge == attempt) {
+        outcome = "hedged";
+      } else {
+        outcome = "retried";
+      }
+    } else if (!request->settled[attempt]) {
+      if (!SettleAttempt(request, attempt)) {
+        return;
+      }
+      outcome = "failed";
+    } else {
+      return;
+    }
+  }
+  if (result.ok()) {
+    request->state->RecordLatency(absl::Now() - launched);
+  }
+  FinishRequest(request, std::move(result), outcome);
+}
+
+template <typename T>
+void OnAttemptDeadline(const std::shared_ptr<PolicyRequest<T>>& request,
+                       std::size_t attempt) {
+  {
+    std::lock_guard<std::mutex> lock(request->mutex);
+    if (request->done || request->settled[attempt] ||
+        !SettleAttempt(request, attempt)) {
+      return;
+    }
+  }
+  FinishRequest(request,
+                tensorstore::Result<T>(absl::DeadlineExceededError(
+                    "The request ran past its deadline.")),
+                "deadline_exceeded");
+}
+
+template <typename T>
+void OnHedge(const std::shared_ptr<PolicyRequest<T>>& request) {
+  {
+    std::lock_guard<std::mutex> lock(request->mutex);
+    if (request->done || request->hedge.has_value() ||
+        request->unsettled == 0 || !request->promise.result_needed() ||
+        !request->state->Withdraw()) {
+      return;
+    }
+    request->hedge = request->settled.size();
+    ++request->scheduled;
+  }
+  Count(TelemetryCounter::kHedgedRequests, 1);
+  LaunchAttempt(request);
+}
+
+template <typename T>
+void LaunchAttempt(const std::shared_ptr<PolicyRequest<T>>& request) {
+  std::size_t attempt;
+  {
+    std::lock_guard<std::mutex> lock(request->mutex);
+    --request->scheduled;
+    if (request->done) {
+      return;
+    }
+    attempt = request->settled.size();
+    request->settled.push_back(false);
+    ++request->unsettled;
+  }
+  const absl::Time launched = absl::Now();
+  const absl::Duration deadline = request->state->policy.deadline;
+  if (deadline != absl::InfiniteDuration()) {
+    RequestTimer::Get().At(launched + deadline, [request, attempt] {
+      OnAttemptDeadline(request, attempt);
+    });
+  }
+  request->launch().ExecuteWhenReady(
+      [request, attempt, launched](tensorstore::ReadyFuture<T> ready) {
+        OnAttemptReady(request, attempt, launched, ready.result());
+      });
+}
+
+/**
+ * @brief Runs a request under the request policy of the process.
+ * An attempt that fails with a transient error, or runs past the deadline, is
+ * retried with exponential backoff while the process' retry budget allows. A
+ * request still running after the hedge delay gets a duplicate, whichever
+ * attempt succeeds first wins. Each request is reported as an "mdio.Request"
+ * span with the number of attempts and its outcome, one of "ok", "retried",
+ * "hedged", "failed" or "deadline_exceeded".
+ * @param name The key requested, reported with the span.
+ * @param launch Starts one attempt of the request.
+ * @return The result of the winning attempt, or the last error.
+ */
+template <typename T>
+tensorstore::Future<T> RunWithPolicy(
+    const std::string& name, std::function<tensorstore::Future<T>()> launch) {
+  auto state = GetRequestState();
+  if (!state) {
+    return launch();
+  }
+  state->Deposit();
+  auto pair = tensorstore::PromiseFuturePair<T>::Make();
+  auto request = std::make_shared<PolicyRequest<T>>();
+  request->state = state;
+  request->launch = std::move(launch);
+  request->promise = std::move(pair.promise);
+  request->span.Attribute("mdio.key", name);
+  request->scheduled = 1;
+  if (auto delay = state->HedgeDelay(); delay.has_value()) {
+    RequestTimer::Get().At(absl::Now() + *delay,
+                           [request] { OnHedge(request); });
+  }
+  LaunchAttempt(request);
+  return std::move(pair.future);
+}
+
+/**
+ * @brief Reads a key under the request policy of the process, see
+ * `RunWithPolicy`.
+ */
+inline tensorstore::Future<tensorstore::kvstore::ReadResult> PolicyRead(
+    const tensorstore::KvStore& kvstore, const std::string& key,
+    tensorstore::kvstore::ReadOptions options = {}) {
+  return RunWithPolicy<tensorstore::kvstore::ReadResult>(
+      key, [kvstore, key, options = std::move(options)] {
+        return tensorstore::kvstore::Read(kvstore, key, options);
+      });
+}
+
+/**
+ * @brief Adds the retries of the request policy to an S3 or GCS kvstore spec.
+ * Other kvstores are left as they are.
+ */
+inline void ApplyRequestPolicy(::nlohmann::json& kvstore /*NOLINT*/) {
+  auto state = GetRequestState();
+  if (!state || !kvstore.is_object()) {
+    return;
+  }
+  const std::string driver = kvstore.value("driver", "");
+  if (driver == "s3" || driver == "gcs") {
+    kvstore[driver + "_request_retries"] = state->policy.RetriesJson();
+  }
+}
+
+}  // namespace internal
+
+/**
+ * @brief Applies a request policy to the stores MDIO opens from now on.
+ * The latencies and retry budget are shared by every request of the process.
+ * Requests already in flight keep the policy they started with.
+ * @details \b Usage
+ * @code
+ * mdio::RequestPolicy policy;
+ * policy.deadline = absl::Seconds(5);
+ * policy.hedge_percentile = 0.95;
+ * mdio::SetRequestPolicy(policy);
+ * auto dataset = mdio::Dataset::Open("s3://bucket/survey.mdio",
+ *                                    mdio::constants::kOpen);
+ * @endcode
+ * @param policy The policy, replacing any set before.
+ */
+inline void SetRequestPolicy(RequestPolicy policy) {
+  std::lock_guard<std::mutex> lock(internal::ProcessRequestMutex());
+  internal::ProcessRequestState() =
+      std::make_shared<internal::RequestState>(std::move(policy));
+}
+
+/**
+ * @brief Goes back to sending each request once, with the Tensorstore
+ * defaults for retries.
+ */
+inline void ClearRequestPolicy() {
+  std::lock_guard<std::mutex> lock(internal::ProcessRequestMutex());
+  internal::ProcessRequestState() = nullptr;
+}
+
+}  // namespace mdio
+
+#endif  // MDIO_REQUEST_POLICY_H_
@@ -0,0 +1,217 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mdio/request_policy.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// clang-format off
+#include <nlohmann/json.hpp>  // NOLINT
+// clang-format on
+
+namespace {
+
+// Collects what the hooks report.
+struct Recorder {
+  std::mutex mutex;
+  std::vector<mdio::TelemetrySpan> spans;
+  std::map<mdio::TelemetryCounter, std::int64_t> counters;
+
+  mdio::TelemetryHooks Hooks() {
+    mdio::TelemetryHooks hooks;
+    hooks.on_span = [this](const mdio::TelemetrySpan& span) {
+      std::lock_guard<std::mutex> lock(mutex);
+      spans.push_back(span);
+    };
+    hooks.on_counter = [this](mdio::TelemetryCounter counter,
+                              std::int64_t value) {
+      std::lock_guard<std::mutex> lock(mutex);
+      counters[counter] += value;
+    };
+    return hooks;
+  }
+
+  std::string Outcome() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& span : spans) {
+      for (const auto& [key, value] : span.attributes) {
+        if (span.name == "mdio.Request" && key == "mdio.outcome") {
+          return value;
+        }
+      }
+    }
+    return "";
+  }
+
+  std::int64_t Counter(mdio::TelemetryCounter counter) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters[counter];
+  }
+};
+
+// A fast policy, so retries don't slow the tests down.
+mdio::RequestPolicy TestPolicy() {
+  mdio::RequestPolicy policy;
+  policy.initial_backoff = absl::Milliseconds(1);
+  policy.max_backoff = absl::Milliseconds(4);
+  return policy;
+}
+
+TEST(RequestPolicy, retriesTransientErrors) {
+  static Recorder recorder;
+  mdio::SetTelemetryHooks(recorder.Hooks());
+  mdio::SetRequestPolicy(TestPolicy());
+  std::atomic<int> attempts{0};
+  auto result = mdio::internal::RunWithPolicy<int>(
+                    "chunk", [&attempts]() -> tensorstore::Future<int> {
+                      if (++attempts < 3) {
+                        return absl::UnavailableError("throttled");
+                      }
+                      return tensorstore::MakeReadyFuture<int>(42);
+                    })
+                    .result();
+  ASSERT_TRUE(result.ok()) << result.status();
+  EXPECT_EQ(result.value(), 42);
+  EXPECT_EQ(attempts, 3);
+  EXPECT_EQ(recorder.Counter(mdio::TelemetryCounter::kRetries), 2);
+  EXPECT_EQ(recorder.Outcome(), "retried");
+  mdio::ClearRequestPolicy();
+  mdio::ClearTelemetryHooks();
+}
+
+TEST(RequestPolicy, permanentErrors) {
+  mdio::SetRequestPolicy(TestPolicy());
+  int attempts = 0;
+  auto result = mdio::internal::RunWithPolicy<int>(
+                    "chunk", [&attempts]() -> tensorstore::Future<int> {
+                      ++attempts;
+                      return absl::NotFoundError("missing");
+                    })
+                    .result();
+  EXPECT_TRUE(absl::IsNotFound(result.status())) << result.status();
+  EXPECT_EQ(attempts, 1);
+  mdio::ClearRequestPolicy();
+}
+
+TEST(RequestPolicy, retryBudget) {
+  auto policy = TestPolicy();
+  policy.retry_burst = 1;
+  policy.retry_budget = 0;
+  mdio::SetRequestPolicy(policy);
+  std::atomic<int> attempts{0};
+  auto failing = [&attempts]() -> tensorstore::Future<int> {
+    ++attempts;
+    return absl::UnavailableError("throttled");
+  };
+  auto first = mdio::internal::RunWithPolicy<int>("a", failing).result();
+  EXPECT_TRUE(absl::IsUnavailable(first.status())) << first.status();
+  // The only token went to the first request's retry.
+  EXPECT_EQ(attempts, 2);
+  auto second = mdio::internal::RunWithPolicy<int>("b", failing).result();
+  EXPECT_TRUE(absl::IsUnavailable(second.status())) << second.status();
+  EXPECT_EQ(attempts, 3);
+  mdio::ClearRequestPolicy();
+}
+
+TEST(RequestPolicy, hedgesSlowRequests) {
+  static Recorder recorder;
+  mdio::SetTelemetryHooks(recorder.Hooks());
+  auto policy = TestPolicy();
+  policy.hedge_percentile = 0.5;
+  policy.hedge_warmup = 1;
+  policy.min_hedge_delay = absl::Milliseconds(1);
+  mdio::SetRequestPolicy(policy);
+  mdio::internal::GetRequestState()->RecordLatency(absl::Milliseconds(1));
+
+  // The first attempt never answers.
+  auto stuck = tensorstore::PromiseFuturePair<int>::Make();
+  std::atomic<int> attempts{0};
+  auto result =
+      mdio::internal::RunWithPolicy<int>(
+          "chunk",
+          [&attempts, &stuck]() -> tensorstore::Future<int> {
+            if (attempts++ == 0) {
+              return stuck.future;
+            }
+            return tensorstore::MakeReadyFuture<int>(7);
+          })
+          .result();
+  ASSERT_TRUE(result.ok()) << result.status();
+  EXPECT_EQ(result.value(), 7);
+  EXPECT_EQ(attempts, 2);
+  EXPECT_EQ(recorder.Counter(mdio::TelemetryCounter::kHedgedRequests), 1);
+  EXPECT_EQ(recorder.Outcome(), "hedged");
+  mdio::ClearRequestPolicy();
+  mdio::ClearTelemetryHooks();
+}
+
+TEST(RequestPolicy, deadline) {
+  static Recorder recorder;
+  mdio::SetTelemetryHooks(recorder.Hooks());
+  auto policy = TestPolicy();
+  policy.deadline = absl::Milliseconds(5);
+  policy.max_retries = 1;
+  mdio::SetRequestPolicy(policy);
+  auto stuck = tensorstore::PromiseFuturePair<int>::Make();
+  std::atomic<int> attempts{0};
+  auto result = mdio::internal::RunWithPolicy<int>(
+                    "chunk",
+                    [&attempts, &stuck]() -> tensorstore::Future<int> {
+                      ++attempts;
+                      return stuck.future;
+                    })
+                    .result();
+  EXPECT_TRUE(absl::IsDeadlineExceeded(result.status())) << result.status();
+  EXPECT_EQ(attempts, 2);
+  EXPECT_EQ(recorder.Outcome(), "deadline_exceeded");
+  mdio::ClearRequestPolicy();
+  mdio::ClearTelemetryHooks();
+}
+
+TEST(RequestPolicy, backoff) {
+  mdio::internal::RequestState state{mdio::RequestPolicy{}};
+  EXPECT_EQ(state.Backoff(1), absl::Milliseconds(100));
+  EXPECT_EQ(state.Backoff(2), absl::Milliseconds(200));
+  EXPECT_EQ(state.Backoff(4), absl::Milliseconds(800));
+  EXPECT_EQ(state.Backoff(20), absl::Seconds(10));
+  // Without observed latencies there is nothing to hedge after.
+  EXPECT_FALSE(state.HedgeDelay().has_value());
+}
+
+TEST(RequestPolicy, cloudSpecs) {
+  ::nlohmann::json s3 = {{"driver", "s3"}, {"bucket", "b"}, {"path", "p/"}};
+  ::nlohmann::json file = {{"driver", "file"}, {"path", "p/"}};
+  mdio::internal::ApplyRequestPolicy(s3);
+  EXPECT_FALSE(s3.contains("s3_request_retries"));
+
+  mdio::SetRequestPolicy(mdio::RequestPolicy{});
+  mdio::internal::ApplyRequestPolicy(s3);
+  mdio::internal::ApplyRequestPolicy(file);
+  EXPECT_EQ(s3["s3_request_retries"],
+            ::nlohmann::json({{"max_retries", 4},
+                              {"initial_delay", "100ms"},
+                              {"max_delay", "10s"}}));
+  EXPECT_EQ(file.size(), 2);
+  mdio::ClearRequestPolicy();
+}
+
+}  // namespace
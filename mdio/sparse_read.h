@@ -0,0 +1,485 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MDIO_SPARSE_READ_H_
+#define MDIO_SPARSE_READ_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "mdio/compute.h"
+#include "mdio/compute_stats.h"
+#include "mdio/dataset.h"
+#include "mdio/impl.h"
+#include "mdio/mapped_read.h"
+#include "mdio/variable.h"
+#include "tensorstore/kvstore/byte_range.h"
+#include "tensorstore/kvstore/kvstore.h"
+#include "tensorstore/kvstore/operations.h"
+#include "tensorstore/util/division.h"
+#include "tensorstore/util/future.h"
+
+// clang-format off
+#include <nlohmann/json.hpp>  // NOLINT
+// clang-format on
+
+namespace mdio {
+
+/**
+ * @brief How `ReadSparse` finds out which chunks were written.
+ */
+enum class ChunkProbe {
+  /// Assume every chunk with a live trace was written.
+  kNone,
+  /// List the chunk keys of the Variable once.
+  kList,
+  /// Ask for an empty range of every chunk with a live trace.
+  kHead,
+};
+
+/**
+ * @brief Options for `ReadSparse`.
+ */
+struct SparseReadOptions {
+  ChunkProbe probe = ChunkProbe::kList;
+  /// The maximum number of chunks read at once. 0 means unbounded.
+  std::size_t max_in_flight = 64;
+};
+
+/**
+ * @brief The live traces of a Variable, packed one after the other.
+ * @tparam T The element type of the Variable.
+ */
+template <typename T>
+struct SparseTraces {
+  /// The labels of the trace dimensions, those of the trace mask.
+  std::vector<std::string> trace_labels;
+  /// The index of every live trace along the trace dimensions, in C order of
+  /// the grid. Holds `trace_labels.size()` values per trace.
+  std::vector<Index> trace_indices;
+  /// The domain of one trace, the dimensions the trace mask doesn't have.
+  IndexDomain<> sample_domain;
+  /// The samples of the live traces. Traces in unwritten chunks hold the fill
+  /// value.
+  std::vector<T> data;
+  /// The chunks that were read.
+  std::size_t chunks_read = 0;
+  /// The chunks that were skipped, as dead or unwritten.
+  std::size_t chunks_skipped = 0;
+
+  std::size_t num_traces() const {
+    return trace_labels.empty() ? 0
+                                : trace_indices.size() / trace_labels.size();
+  }
+
+  Index samples_per_trace() const {
+    return sample_domain.valid() ? sample_domain.box().num_elements() : 0;
+  }
+
+  /// The samples of the i'th live trace, in C order.
+  const T* trace(std::size_t i) const {
+    return data.data() + i * samples_per_trace();
+  }
+};
+
+namespace internal {
+
+/**
+ * @brief Gets the separator of the chunk keys of a Zarr v2 Variable.
+ * @return The separator, or nothing if the chunk keys can't be derived from
+ * the indices of the Variable.
+ */
+template <typename T, DimensionIndex R, ReadWriteMode M>
+std::optional<std::string> GetChunkKeySeparator(const Variable<T, R, M>& var) {
+  auto spec = var.get_spec();
+  if (!spec.ok() || spec->value("driver", "") != "zarr" ||
+      !IndexesStoredArray(var)) {
+    return std::nullopt;
+  }
+  const auto metadata = spec->value("metadata", ::nlohmann::json::object());
+  return metadata.value("dimension_separator", ".");
+}
+
+/**
+ * @brief The key of a cell of the chunk grid, relative to the kvstore of the
+ * Variable.
+ */
+inline std::string ChunkKey(const std::vector<Index>& cell,
+                            const std::string& separator) {
+  if (cell.empty()) {
+    return "0";
+  }
+  std::string key;
+  for (std::size_t d = 0; d < cell.size(); ++d) {
+    key += (d ? separator : "") + std::to_string(cell[d]);
+  }
+  return key;
+}
+
+/**
+ * @brief Everything a sparse read carries from planning to packing.
+ */
+template <typename T>
+struct SparseReadState {
+  Variable<T> var;
+  std::vector<DimensionIdentifier> labels;
+  std::vector<Index> chunk_shape;
+  std::vector<Index> first_cell;
+  std::vector<Index> num_cells;
+  /// The output trace of each trace of the grid, -1 if it is dead.
+  std::vector<int64_t> slots;
+  /// The cells planned for reading, as indices of the chunk grid.
+  std::vector<std::vector<Index>> cells;
+  std::size_t total_cells = 0;
+  SparseTraces<T> result;
+};
+
+/**
+ * @brief Reads the planned chunks and copies their live traces into place.
+ */
+template <typename T>
+Future<SparseTraces<T>> ReadSparseCells(
+    std::shared_ptr<SparseReadState<T>> state, std::size_t max_in_flight) {
+  state->result.chunks_read = state->cells.size();
+  state->result.chunks_skipped = state->total_cells - state->cells.size();
+  auto all_read = ForEachBounded(
+      state->cells.size(), max_in_flight,
+      [state](std::size_t i) -> Future<void> {
+        const auto& cell = state->cells[i];
+        std::vector<RangeDescriptor<Index>> desc(cell.size());
+        for (std::size_t d = 0; d < cell.size(); ++d) {
+          desc[d] = {state->labels[d], cell[d] * state->chunk_shape[d],
+                     (cell[d] + 1) * state->chunk_shape[d], 1};
+        }
+        MDIO_ASSIGN_OR_RETURN(auto chunk, state->var.slice(desc))
+        return tensorstore::MapFutureValue(
+            tensorstore::InlineExecutor{},
+            [state](VariableData<T>& data) {
+              const T* src =
+                  data.get_data_accessor().data() + data.get_flattened_offset();
+              const auto box = data.dimensions().box();
+              const auto grid = state->var.dimensions().box();
+              const DimensionIndex k = state->result.trace_labels.size();
+              const DimensionIndex rank = box.rank();
+
+              // Where the samples of the chunk go in a packed trace.
+              std::vector<Index> sample_shape;
+              Index sample_base = 0;
+              const auto trace_strides =
+                  ContiguousStrides(state->result.sample_domain.shape());
+              for (DimensionIndex d = k; d < rank; ++d) {
+                sample_shape.push_back(box.shape()[d]);
+                sample_base +=
+                    (box.origin()[d] - grid.origin()[d]) * trace_strides[d - k];
+              }
+              Index block = 1;
+              for (auto extent : sample_shape) {
+                block *= extent;
+              }
+              const Index trace_size = state->result.samples_per_trace();
+              const Index last = sample_shape.empty() ? 1 : sample_shape.back();
+
+              std::vector<Index> trace_box_shape(box.shape().begin(),
+                                                 box.shape().begin() + k);
+              const auto grid_strides = ContiguousStrides(
+                  tensorstore::span<const Index>(grid.shape().data(), k));
+              Index local = 0;
+              ForEachRow(trace_box_shape, [&](const std::vector<Index>& row) {
+                Index grid_offset = 0;
+                for (DimensionIndex d = 0; d < k; ++d) {
+                  grid_offset +=
+                      (box.origin()[d] + row[d] - grid.origin()[d]) *
+                      grid_strides[d];
+                }
+                const Index row_length = k ? trace_box_shape[k - 1] : 1;
+                for (Index t = 0; t < row_length; ++t, ++local) {
+                  const int64_t slot = state->slots[grid_offset + t];
+                  if (slot < 0) {
+                    continue;
+                  }
+                  T* dst = state->result.data.data() + slot * trace_size +
+                           sample_base;
+                  const T* from = src + local * block;
+                  ForEachRow(sample_shape,
+                             [&](const std::vector<Index>& index) {
+                               Index to = 0;
+                               for (std::size_t d = 0; d + 1 < index.size();
+                                    ++d) {
+                                 to += index[d] * trace_strides[d];
+                               }
+                               std::copy(from, from + last, dst + to);
+                               from += last;
+                             });
+                }
+              });
+            },
+            chunk.Read());
+      });
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [state]() { return std::move(state->result); }, std::move(all_read));
+}
+
+}  // namespace internal
+
+/**
+ * @brief Reads only the live traces of a Variable.
+ * The trace mask decides which chunks hold live traces, and the store is
+ * probed for the chunks that were written, so dead and unwritten chunks are
+ * never fetched. The live traces are returned packed, with their indices,
+ * instead of as a dense array.
+ * @pre The dimensions of the trace mask are the leading dimensions of the
+ * Variable, e.g. a [inline, crossline] mask of an [inline, crossline, time]
+ * Variable.
+ * @details \b Usage
+ * @code
+ * MDIO_ASSIGN_OR_RETURN(auto seismic, ds.variables.get<float>("seismic"));
+ * MDIO_ASSIGN_OR_RETURN(auto mask, ds.variables.get<bool>("trace_mask"));
+ * MDIO_ASSIGN_OR_RETURN(auto live, mdio::ReadSparse(seismic, mask).result());
+ * for (std::size_t i = 0; i < live.num_traces(); ++i) {
+ *   const float* trace = live.trace(i);
+ * }
+ * @endcode
+ * @param var The Variable to read, which may be sliced.
+ * @param trace_mask The live traces, covering the trace dimensions of `var`.
+ * @param options How chunks are probed and how many are read at once.
+ * @return A future of the live traces.
+ */
+template <typename T>
+Future<SparseTraces<T>> ReadSparse(const Variable<T>& var,
+                                   const Variable<bool>& trace_mask,
+                                   const SparseReadOptions& options = {}) {
+  static_assert(std::is_arithmetic_v<T>,
+                "ReadSparse requires a real numeric Variable.");
+  const auto domain = var.dimensions();
+  const DimensionIndex rank = domain.rank();
+  const auto mask_domain = trace_mask.dimensions();
+  const DimensionIndex k = mask_domain.rank();
+  if (k == 0 || k > rank) {
+    return absl::InvalidArgumentError(
+        "The trace mask must have between 1 and " + std::to_string(rank) +
+        " dimensions.");
+  }
+  std::vector<RangeDescriptor<Index>> mask_desc;
+  for (DimensionIndex d = 0; d < k; ++d) {
+    if (mask_domain.labels()[d].empty() ||
+        mask_domain.labels()[d] != domain.labels()[d]) {
+      return absl::InvalidArgumentError(
+          "The dimensions of the trace mask '" +
+          trace_mask.get_variable_name() + "' must lead those of '" +
+          var.get_variable_name() + "'.");
+    }
+    mask_desc.push_back({DimensionIdentifier(domain.labels()[d]),
+                         domain.origin()[d],
+                         domain.origin()[d] + domain.shape()[d], 1});
+  }
+  MDIO_ASSIGN_OR_RETURN(auto mask, trace_mask.slice(mask_desc))
+  for (DimensionIndex d = 0; d < k; ++d) {
+    if (mask.dimensions().shape()[d] != domain.shape()[d]) {
+      return absl::OutOfRangeError("The trace mask '" +
+                                   trace_mask.get_variable_name() +
+                                   "' doesn't cover '" +
+                                   var.get_variable_name() + "'.");
+    }
+  }
+
+  auto state = std::make_shared<internal::SparseReadState<T>>();
+  state->var = var;
+  auto chunk_res = var.get_chunk_shape();
+  for (DimensionIndex d = 0; d < rank; ++d) {
+    const auto& label = domain.labels()[d];
+    state->labels.push_back(label.empty() ? DimensionIdentifier(d)
+                                          : DimensionIdentifier(label));
+    const bool chunked = chunk_res.ok() && chunk_res->size() == rank &&
+                         (*chunk_res)[d] > 0;
+    state->chunk_shape.push_back(
+        chunked ? (*chunk_res)[d] : std::max<Index>(domain.shape()[d], 1));
+    const auto interval = domain[d].interval();
+    state->first_cell.push_back(tensorstore::FloorOfRatio(
+        interval.inclusive_min(), state->chunk_shape[d]));
+    state->num_cells.push_back(
+        interval.empty()
+            ? 0
+            : tensorstore::FloorOfRatio(interval.inclusive_max(),
+                                        state->chunk_shape[d]) -
+                  state->first_cell[d] + 1);
+  }
+  auto& result = state->result;
+  for (DimensionIndex d = 0; d < k; ++d) {
+    result.trace_labels.push_back(domain.labels()[d]);
+  }
+  tensorstore::IndexDomainBuilder<> builder(rank - k);
+  for (DimensionIndex d = k; d < rank; ++d) {
+    builder.origin()[d - k] = domain.origin()[d];
+    builder.shape()[d - k] = domain.shape()[d];
+    builder.labels()[d - k] = domain.labels()[d];
+  }
+  MDIO_ASSIGN_OR_RETURN(result.sample_domain, builder.Finalize())
+  const T fill = internal::GetFillValue(var).value_or(T{});
+  const auto separator = internal::GetChunkKeySeparator(var);
+  auto kvs = var.get_store().kvstore();
+  const ChunkProbe probe =
+      separator.has_value() && kvs.valid() ? options.probe : ChunkProbe::kNone;
+  const std::size_t max_in_flight = options.max_in_flight;
+
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [state, k, fill, separator, kvs, probe,
+       max_in_flight](VariableData<bool>& flags) -> Future<SparseTraces<T>> {
+        const bool* live =
+            flags.get_data_accessor().data() + flags.get_flattened_offset();
+        const auto grid = state->var.dimensions().box();
+        const DimensionIndex rank = grid.rank();
+
+        // Number the live traces and mark the chunk columns holding them.
+        std::size_t trace_cells = 1;
+        for (DimensionIndex d = 0; d < k; ++d) {
+          trace_cells *= state->num_cells[d];
+        }
+        std::vector<char> live_cells(trace_cells);
+        auto& result = state->result;
+        const Index num_traces = flags.num_samples();
+        state->slots.assign(num_traces, -1);
+        std::vector<Index> index(k);
+        int64_t next = 0;
+        for (Index i = 0; i < num_traces; ++i) {
+          if (!live[i]) {
+            continue;
+          }
+          Index rest = i;
+          for (DimensionIndex d = k - 1; d >= 0; --d) {
+            index[d] = grid.origin()[d] + rest % grid.shape()[d];
+            rest /= grid.shape()[d];
+          }
+          state->slots[i] = next++;
+          result.trace_indices.insert(result.trace_indices.end(),
+                                      index.begin(), index.end());
+          std::size_t cell = 0;
+          for (DimensionIndex d = 0; d < k; ++d) {
+            cell = cell * state->num_cells[d] +
+                   tensorstore::FloorOfRatio(index[d],
+                                             state->chunk_shape[d]) -
+                   state->first_cell[d];
+          }
+          live_cells[cell] = 1;
+        }
+        result.data.assign(next * result.samples_per_trace(), fill);
+
+        // Every cell of the chunk grid under a live column.
+        state->total_cells = 1;
+        for (DimensionIndex d = 0; d < rank; ++d) {
+          state->total_cells *= state->num_cells[d];
+        }
+        const std::size_t sample_cells =
+            trace_cells ? state->total_cells / trace_cells : 0;
+        for (std::size_t c = 0; c < trace_cells; ++c) {
+          if (!live_cells[c]) {
+            continue;
+          }
+          for (std::size_t s = 0; s < sample_cells; ++s) {
+            std::vector<Index> cell(rank);
+            std::size_t rest = c * sample_cells + s;
+            for (DimensionIndex d = rank - 1; d >= 0; --d) {
+              cell[d] = state->first_cell[d] + rest % state->num_cells[d];
+              rest /= state->num_cells[d];
+            }
+            state->cells.push_back(std::move(cell));
+          }
+        }
+
+        if (probe == ChunkProbe::kNone || state->cells.empty()) {
+          return internal::ReadSparseCells(state, max_in_flight);
+        }
+        if (probe == ChunkProbe::kList) {
+          return tensorstore::MapFutureValue(
+              tensorstore::InlineExecutor{},
+              [state, separator, max_in_flight](
+                  std::vector<tensorstore::kvstore::ListEntry>& entries) {
+                std::unordered_set<std::string> written;
+                for (auto& entry : entries) {
+                  written.insert(std::move(entry.key));
+                }
+                auto& cells = state->cells;
+                cells.erase(std::remove_if(cells.begin(), cells.end(),
+                                           [&](const std::vector<Index>& c) {
+                                             return !written.count(
+                                                 internal::ChunkKey(
+                                                     c, *separator));
+                                           }),
+                            cells.end());
+                return internal::ReadSparseCells(state, max_in_flight);
+              },
+              tensorstore::kvstore::ListFuture(kvs));
+        }
+
+        // An empty range of each chunk tells if it exists.
+        auto exists = std::make_shared<std::vector<char>>(state->cells.size());
+        auto all_probed = internal::ForEachBounded(
+            state->cells.size(), max_in_flight,
+            [state, exists, separator, kvs](std::size_t i) {
+              tensorstore::kvstore::ReadOptions read_options;
+              read_options.byte_range =
+                  tensorstore::OptionalByteRangeRequest(0, 0);
+              return tensorstore::MapFutureValue(
+                  tensorstore::InlineExecutor{},
+                  [exists, i](const tensorstore::kvstore::ReadResult& read) {
+                    (*exists)[i] = read.has_value();
+                  },
+                  tensorstore::kvstore::Read(
+                      kvs, internal::ChunkKey(state->cells[i], *separator),
+                      std::move(read_options)));
+            });
+        return tensorstore::MapFutureValue(
+            tensorstore::InlineExecutor{},
+            [state, exists, max_in_flight]() {
+              std::vector<std::vector<Index>> written;
+              for (std::size_t i = 0; i < state->cells.size(); ++i) {
+                if ((*exists)[i]) {
+                  written.push_back(std::move(state->cells[i]));
+                }
+              }
+              state->cells = std::move(written);
+              return internal::ReadSparseCells(state, max_in_flight);
+            },
+            std::move(all_probed));
+      },
+      mask.Read());
+}
+
+/**
+ * @brief Reads only the live traces of a Variable of a Dataset.
+ * @param dataset The Dataset holding the Variable and its trace mask.
+ * @param name The name of the Variable.
+ * @param mask The name of the trace mask coordinate.
+ */
+template <typename T>
+Future<SparseTraces<T>> ReadSparse(Dataset& dataset,  // NOLINT (non-const)
+                                   const std::string& name,
+                                   const std::string& mask = "trace_mask",
+                                   const SparseReadOptions& options = {}) {
+  MDIO_ASSIGN_OR_RETURN(auto var, dataset.variables.get<T>(name))
+  MDIO_ASSIGN_OR_RETURN(auto trace_mask, dataset.variables.get<bool>(mask))
+  return ReadSparse(var, trace_mask, options);
+}
+
+}  // namespace mdio
+
+#endif  // MDIO_SPARSE_READ_H_
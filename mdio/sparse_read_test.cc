@@ -0,0 +1,162 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mdio/sparse_read.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <vector>
+
+#include "mdio/utils/test_fixtures.h"
+
+namespace {
+
+// Live traces fill the first chunk column and one trace of another column,
+// which was never written.
+struct SparseFixture {
+  mdio::Variable<float> var;
+  mdio::Variable<bool> mask;
+};
+
+mdio::Result<SparseFixture> MakeSparse() {
+  MDIO_ASSIGN_OR_RETURN(
+      auto var, mdio::Variable<float>::Open(
+                    mdio::testing::VariableSpec(
+                        "sparse_variable", {"inline", "crossline", "time"},
+                        {16, 16, 8}, {4, 4, 8}, "<f4", -1.0),
+                    mdio::constants::kCreateClean)
+                    .result());
+
+  // Sample (il, xl, t) of the first column is il * 1000 + xl * 10 + t.
+  MDIO_ASSIGN_OR_RETURN(
+      auto column,
+      var.slice(mdio::RangeDescriptor<mdio::Index>{"inline", 0, 4, 1},
+                mdio::RangeDescriptor<mdio::Index>{"crossline", 0, 4, 1}));
+  MDIO_ASSIGN_OR_RETURN(auto data, mdio::from_variable<float>(column));
+  float* samples =
+      data.get_data_accessor().data() + data.get_flattened_offset();
+  for (int il = 0; il < 4; ++il) {
+    for (int xl = 0; xl < 4; ++xl) {
+      for (int t = 0; t < 8; ++t) {
+        samples[(il * 4 + xl) * 8 + t] = il * 1000 + xl * 10 + t;
+      }
+    }
+  }
+  if (!column.Write(data).commit_future.result().ok()) {
+    return absl::InternalError("Could not write the live column.");
+  }
+
+  MDIO_ASSIGN_OR_RETURN(
+      auto mask,
+      mdio::testing::MakeVariable<bool>(
+          mdio::testing::VariableSpec("sparse_mask", {"inline", "crossline"},
+                                      {16, 16}, {8, 8}, "|b1", false),
+          [](const std::vector<mdio::Index>& p) {
+            return (p[0] < 4 && p[1] < 4) || (p[0] == 9 && p[1] == 2);
+          }));
+  return SparseFixture{var, mask};
+}
+
+void RemoveSparse() {
+  std::filesystem::remove_all("sparse_variable");
+  std::filesystem::remove_all("sparse_mask");
+}
+
+TEST(ReadSparse, listProbe) {
+  auto fixture = MakeSparse();
+  ASSERT_TRUE(fixture.ok()) << fixture.status();
+
+  auto live = mdio::ReadSparse(fixture->var, fixture->mask).result();
+  ASSERT_TRUE(live.ok()) << live.status();
+  EXPECT_EQ(live->trace_labels,
+            (std::vector<std::string>{"inline", "crossline"}));
+  ASSERT_EQ(live->num_traces(), 17);
+  EXPECT_EQ(live->samples_per_trace(), 8);
+  EXPECT_EQ(live->data.size(), 17 * 8);
+  // Only the written column is fetched.
+  EXPECT_EQ(live->chunks_read, 1);
+  EXPECT_EQ(live->chunks_skipped, 15);
+
+  for (std::size_t i = 0; i < 16; ++i) {
+    const auto il = live->trace_indices[2 * i];
+    const auto xl = live->trace_indices[2 * i + 1];
+    EXPECT_EQ(il, i / 4);
+    EXPECT_EQ(xl, i % 4);
+    for (int t = 0; t < 8; ++t) {
+      EXPECT_EQ(live->trace(i)[t], il * 1000 + xl * 10 + t);
+    }
+  }
+  // The live trace of the unwritten chunk holds the fill value.
+  EXPECT_EQ(live->trace_indices[32], 9);
+  EXPECT_EQ(live->trace_indices[33], 2);
+  for (int t = 0; t < 8; ++t) {
+    EXPECT_EQ(live->trace(16)[t], -1.0f);
+  }
+  RemoveSparse();
+}
+
+TEST(ReadSparse, probes) {
+  auto fixture = MakeSparse();
+  ASSERT_TRUE(fixture.ok()) << fixture.status();
+
+  mdio::SparseReadOptions options;
+  options.probe = mdio::ChunkProbe::kHead;
+  auto head = mdio::ReadSparse(fixture->var, fixture->mask, options).result();
+  ASSERT_TRUE(head.ok()) << head.status();
+  EXPECT_EQ(head->chunks_read, 1);
+
+  // Without a probe every live column is read.
+  options.probe = mdio::ChunkProbe::kNone;
+  auto all = mdio::ReadSparse(fixture->var, fixture->mask, options).result();
+  ASSERT_TRUE(all.ok()) << all.status();
+  EXPECT_EQ(all->chunks_read, 2);
+  EXPECT_EQ(all->data, head->data);
+  RemoveSparse();
+}
+
+TEST(ReadSparse, sliced) {
+  auto fixture = MakeSparse();
+  ASSERT_TRUE(fixture.ok()) << fixture.status();
+
+  // A window across two chunk rows and part of the samples.
+  auto window = fixture->var.slice(
+      mdio::RangeDescriptor<mdio::Index>{"inline", 2, 10, 1},
+      mdio::RangeDescriptor<mdio::Index>{"time", 3, 6, 1});
+  ASSERT_TRUE(window.ok()) << window.status();
+  auto live = mdio::ReadSparse(window.value(), fixture->mask).result();
+  ASSERT_TRUE(live.ok()) << live.status();
+  ASSERT_EQ(live->num_traces(), 9);
+  EXPECT_EQ(live->samples_per_trace(), 3);
+  EXPECT_EQ(live->trace_indices[0], 2);
+  EXPECT_EQ(live->trace_indices[1], 0);
+  for (int t = 0; t < 3; ++t) {
+    EXPECT_EQ(live->trace(0)[t], 2000 + 3 + t);
+  }
+  RemoveSparse();
+}
+
+TEST(ReadSparse, mismatchedMask) {
+  auto fixture = MakeSparse();
+  ASSERT_TRUE(fixture.ok()) << fixture.status();
+  auto wrong = fixture->mask.slice(
+      mdio::RangeDescriptor<mdio::Index>{"inline", 0, 8, 1});
+  ASSERT_TRUE(wrong.ok()) << wrong.status();
+  EXPECT_FALSE(
+      mdio::ReadSparse(fixture->var, wrong.value()).status().ok());
+  RemoveSparse();
+}
+
+}  // namespace
@@ -0,0 +1,658 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MDIO_SPATIAL_INDEX_H_
+#define MDIO_SPATIAL_INDEX_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/cord.h"
+#include "absl/strings/match.h"
+#include "mdio/arbitrary_line.h"
+#include "mdio/coordinate_index.h"
+#include "mdio/dataset.h"
+#include "mdio/impl.h"
+#include "tensorstore/kvstore/kvstore.h"
+#include "tensorstore/kvstore/operations.h"
+#include "tensorstore/util/future.h"
+
+namespace mdio {
+
+/// A surface position, as an (x, y) pair of CDP coordinates.
+using SurfacePoint = std::array<double, 2>;
+
+/**
+ * @brief The trace found by `SpatialIndex::Nearest`.
+ */
+struct SpatialMatch {
+  Index inline_index;
+  Index crossline_index;
+  /// The distance from the query to the trace, in CDP units.
+  double distance;
+};
+
+/**
+ * @brief Options for building and opening a `SpatialIndex`.
+ */
+struct SpatialIndexOptions {
+  /// The CDP coordinates, 2-D over inline and crossline.
+  std::string cdp_x = "cdp_x";
+  std::string cdp_y = "cdp_y";
+  /// How far a trace may be from the affine grid, as a fraction of the trace
+  /// spacing, for the survey to be treated as regular.
+  double tolerance = 1e-3;
+};
+
+namespace internal {
+
+// The index is stored under `kSpatialIndexKey` in the directory of `cdp_x`,
+// and its magic under the same key of `cdp_y`. Writing either coordinate
+// deletes its sidecar, so the index is only used while both are present.
+
+/// Leading bytes of a serialized index, also acts as the format version.
+constexpr std::string_view kSpatialIndexMagic = "MDIOSPX1";
+
+/// A trace of an irregular survey, a node of the k-d tree.
+struct SpatialPoint {
+  double x;
+  double y;
+  /// The C-order offset of the trace within the grid.
+  Index flat;
+};
+
+// The fields of a point are serialized as 8 byte words.
+static_assert(sizeof(Index) == sizeof(double) &&
+              sizeof(SpatialPoint) == 3 * sizeof(double));
+
+/**
+ * @brief Checks if a point is inside a polygon, by the even-odd rule.
+ */
+inline bool InPolygon(const std::vector<SurfacePoint>& polygon, double x,
+                      double y) {
+  bool inside = false;
+  for (std::size_t i = 0, j = polygon.size() - 1; i < polygon.size();
+       j = i++) {
+    const auto& a = polygon[i];
+    const auto& b = polygon[j];
+    if ((a[1] > y) != (b[1] > y) &&
+        x < (b[0] - a[0]) * (y - a[1]) / (b[1] - a[1]) + a[0]) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+}  // namespace internal
+
+/**
+ * @brief A 2-D index from CDP positions to the traces of a survey.
+ * A regular survey, whose traces lie on an affine grid, is described by six
+ * numbers and queries are solved in the index space of the grid. Any other
+ * survey is kept in a k-d tree of its live traces; traces with a NaN position
+ * are never found. Queries return the runs of traces to pass to `isel`.
+ *
+ * The index is persisted as a sidecar key in the directory of `cdp_x`. It
+ * describes the coordinates as they are when built, and must be rebuilt after
+ * they are written.
+ */
+class SpatialIndex {
+ public:
+  /**
+   * @brief Builds the index from contiguous C-order coordinates.
+   * @param x The x positions of the traces.
+   * @param y The y positions of the traces.
+   * @param domain The inline and crossline domain of the coordinates.
+   * @param tolerance The largest distance from the affine grid, as a fraction
+   * of the trace spacing, for the survey to be treated as regular.
+   */
+  static Result<SpatialIndex> Build(const double* x, const double* y,
+                                    IndexDomainView<> domain,
+                                    double tolerance = 1e-3) {
+    if (domain.rank() != 2) {
+      return absl::InvalidArgumentError(
+          "A spatial index needs coordinates over inline and crossline.");
+    }
+    SpatialIndex index;
+    index.labels_ = std::make_shared<const std::array<std::string, 2>>(
+        std::array<std::string, 2>{std::string(domain.labels()[0]),
+                                   std::string(domain.labels()[1])});
+    index.origin_ = {domain.origin()[0], domain.origin()[1]};
+    index.shape_ = {domain.shape()[0], domain.shape()[1]};
+    if (index._fitAffine(x, y, tolerance)) {
+      return index;
+    }
+    const Index n = index.shape_[0] * index.shape_[1];
+    for (Index i = 0; i < n; ++i) {
+      if (x[i] == x[i] && y[i] == y[i]) {  // Skip NaN
+        index.points_.push_back({x[i], y[i], i});
+      }
+    }
+    index._buildTree(0, index.points_.size(), 0);
+    return index;
+  }
+
+  /**
+   * @brief Checks if the survey was found to be an affine grid.
+   */
+  bool regular() const { return regular_; }
+
+  /**
+   * @brief Finds the trace closest to a position.
+   * @return The trace, or `std::nullopt` if the index holds no traces.
+   */
+  std::optional<SpatialMatch> Nearest(double x, double y) const {
+    if (regular_) {
+      return _nearestAffine(x, y);
+    }
+    if (points_.empty()) {
+      return std::nullopt;
+    }
+    std::size_t best = 0;
+    double best_d2 = std::numeric_limits<double>::infinity();
+    _nearestTree(0, points_.size(), 0, x, y, best, best_d2);
+    const auto& p = points_[best];
+    return SpatialMatch{origin_[0] + p.flat / shape_[1],
+                        origin_[1] + p.flat % shape_[1], std::sqrt(best_d2)};
+  }
+
+  /**
+   * @brief Finds every trace inside a polygon.
+   * @param polygon The vertices of the polygon, in CDP coordinates.
+   * @return One pair of inline and crossline descriptors per run of traces,
+   * in C order, as `CoordinateSelector` groups them. The descriptors refer to
+   * the labels of the index, so it must outlive them.
+   */
+  std::vector<std::vector<RangeDescriptor<Index>>> Within(
+      const std::vector<SurfacePoint>& polygon) const {
+    std::vector<std::vector<RangeDescriptor<Index>>> runs;
+    if (polygon.size() < 3) {
+      return runs;
+    }
+    if (regular_) {
+      _withinAffine(polygon, runs);
+      return runs;
+    }
+    std::array<double, 4> box = {std::numeric_limits<double>::infinity(),
+                                 -std::numeric_limits<double>::infinity(),
+                                 std::numeric_limits<double>::infinity(),
+                                 -std::numeric_limits<double>::infinity()};
+    for (const auto& p : polygon) {
+      box = {std::min(box[0], p[0]), std::max(box[1], p[0]),
+             std::min(box[2], p[1]), std::max(box[3], p[1])};
+    }
+    std::vector<Index> found;
+    _rangeTree(0, points_.size(), 0, box, polygon, found);
+    std::sort(found.begin(), found.end());
+    for (std::size_t i = 0; i < found.size();) {
+      std::size_t stop = i + 1;
+      while (stop < found.size() && found[stop] == found[stop - 1] + 1 &&
+             found[stop] % shape_[1] != 0) {
+        ++stop;
+      }
+      const Index row = found[i] / shape_[1];
+      const Index column = found[i] % shape_[1];
+      _appendRun(row, column, column + (stop - i), runs);
+      i = stop;
+    }
+    return runs;
+  }
+
+  /**
+   * @brief Gets the descriptors that select a single trace.
+   */
+  std::vector<RangeDescriptor<Index>> descriptors(
+      const SpatialMatch& match) const {
+    return {{(*labels_)[0], match.inline_index, match.inline_index + 1, 1},
+            {(*labels_)[1], match.crossline_index, match.crossline_index + 1,
+             1}};
+  }
+
+  /**
+   * @brief Serializes the index for storage.
+   * The layout is the magic, the counts and extents, the affine grid, the
+   * labels and the nodes of the k-d tree, little endian.
+   */
+  absl::Cord Serialize() const {
+    std::string out(internal::kSpatialIndexMagic);
+    const uint64_t header[] = {regular_,
+                               (*labels_)[0].size(),
+                               (*labels_)[1].size(),
+                               static_cast<uint64_t>(origin_[0]),
+                               static_cast<uint64_t>(origin_[1]),
+                               static_cast<uint64_t>(shape_[0]),
+                               static_cast<uint64_t>(shape_[1]),
+                               points_.size()};
+    internal::AppendBytes(out, header, 8);
+    internal::AppendBytes(out, affine_.data(), affine_.size());
+    out.append((*labels_)[0]);
+    out.append((*labels_)[1]);
+    internal::AppendBytes(out, points_.data(), points_.size(),
+                          sizeof(double));
+    return absl::Cord(std::move(out));
+  }
+
+  /**
+   * @brief Reconstructs an index written by `Serialize`.
+   * @return The index, or a DataLossError if the bytes are malformed.
+   */
+  static Result<SpatialIndex> Deserialize(const absl::Cord& bytes) {
+    const std::string flat(bytes);
+    std::string_view in(flat);
+    const auto corrupt = [] {
+      return absl::DataLossError("Corrupt spatial index.");
+    };
+    if (!absl::StartsWith(in, internal::kSpatialIndexMagic)) {
+      return corrupt();
+    }
+    in.remove_prefix(internal::kSpatialIndexMagic.size());
+
+    uint64_t header[8];
+    SpatialIndex index;
+    if (!internal::ConsumeBytes(in, header, 8) || header[0] > 1 ||
+        !internal::ConsumeBytes(in, index.affine_.data(),
+                                index.affine_.size()) ||
+        header[1] > in.size() || header[2] > in.size() - header[1]) {
+      return corrupt();
+    }
+    index.regular_ = header[0] == 1;
+    index.labels_ = std::make_shared<const std::array<std::string, 2>>(
+        std::array<std::string, 2>{std::string(in.substr(0, header[1])),
+                                   std::string(in.substr(header[1],
+                                                         header[2]))});
+    in.remove_prefix(header[1] + header[2]);
+    index.origin_ = {static_cast<Index>(header[3]),
+                     static_cast<Index>(header[4])};
+    index.shape_ = {static_cast<Index>(header[5]),
+                    static_cast<Index>(header[6])};
+    // Guard the allocation against sizes the payload can't hold.
+    if (header[7] > in.size()) {
+      return corrupt();
+    }
+    index.points_.resize(header[7]);
+    if (!internal::ConsumeBytes(in, index.points_.data(), header[7],
+                                sizeof(double)) ||
+        !in.empty() || index.shape_[0] < 0 || index.shape_[1] < 0) {
+      return corrupt();
+    }
+    const Index n = index.shape_[0] * index.shape_[1];
+    for (const auto& p : index.points_) {
+      if (p.flat < 0 || p.flat >= n) {
+        return corrupt();
+      }
+    }
+    return index;
+  }
+
+  /// The origin and shape of the inline and crossline grid.
+  const std::array<Index, 2>& origin() const { return origin_; }
+  const std::array<Index, 2>& shape() const { return shape_; }
+
+ private:
+  SpatialIndex() = default;
+
+  /**
+   * @brief Fits the grid through its corners and checks every trace.
+   * @return True if every trace lies on the grid.
+   */
+  bool _fitAffine(const double* x, const double* y, double tolerance) {
+    const Index nx = shape_[0];
+    const Index ny = shape_[1];
+    if (nx < 2 || ny < 2) {
+      return false;
+    }
+    const Index last_row = (nx - 1) * ny;
+    const double ax = (x[last_row] - x[0]) / (nx - 1);
+    const double ay = (y[last_row] - y[0]) / (nx - 1);
+    const double bx = (x[ny - 1] - x[0]) / (ny - 1);
+    const double by = (y[ny - 1] - y[0]) / (ny - 1);
+    const double spacing = std::min(std::hypot(ax, ay), std::hypot(bx, by));
+    if (!(spacing > 0) || ax * by - ay * bx == 0) {
+      return false;
+    }
+    const double limit = tolerance * spacing;
+    for (Index i = 0; i < nx; ++i) {
+      for (Index j = 0; j < ny; ++j) {
+        const Index at = i * ny + j;
+        const double dx = x[at] - (x[0] + i * ax + j * bx);
+        const double dy = y[at] - (y[0] + i * ay + j * by);
+        // Also rejects NaN positions.
+        if (!(std::hypot(dx, dy) <= limit)) {
+          return false;
+        }
+      }
+    }
+    affine_ = {x[0], y[0], ax, ay, bx, by};
+    regular_ = true;
+    return true;
+  }
+
+  /// Maps a position to fractional grid indices, relative to the origin.
+  std::array<double, 2> _toGrid(double x, double y) const {
+    const auto& [x0, y0, ax, ay, bx, by] = affine_;
+    const double det = ax * by - ay * bx;
+    const double dx = x - x0;
+    const double dy = y - y0;
+    return {(dx * by - dy * bx) / det, (ax * dy - ay * dx) / det};
+  }
+
+  std::optional<SpatialMatch> _nearestAffine(double x, double y) const {
+    const auto [u, v] = _toGrid(x, y);
+    const auto& [x0, y0, ax, ay, bx, by] = affine_;
+    const Index ci = std::round(std::clamp<double>(u, 0, shape_[0] - 1));
+    const Index cj = std::round(std::clamp<double>(v, 0, shape_[1] - 1));
+    // The rounded index is the closest unless the grid is skewed or the
+    // position is off the grid, so its neighbours are checked too.
+    SpatialMatch best{0, 0, std::numeric_limits<double>::infinity()};
+    for (Index i = std::max<Index>(ci - 1, 0);
+         i <= std::min(ci + 1, shape_[0] - 1); ++i) {
+      for (Index j = std::max<Index>(cj - 1, 0);
+           j <= std::min(cj + 1, shape_[1] - 1); ++j) {
+        const double d = std::hypot(x - (x0 + i * ax + j * bx),
+                                    y - (y0 + i * ay + j * by));
+        if (d < best.distance) {
+          best = {origin_[0] + i, origin_[1] + j, d};
+        }
+      }
+    }
+    return best;
+  }
+
+  /**
+   * @brief Intersects every row of the grid with the polygon.
+   * Affine maps keep the inside of a polygon, so the polygon is mapped to
+   * index space once and each row is cut at its edges.
+   */
+  void _withinAffine(
+      const std::vector<SurfacePoint>& polygon,
+      std::vector<std::vector<RangeDescriptor<Index>>>& runs)  // NOLINT
+      const {
+    std::vector<std::array<double, 2>> grid;
+    double lo = std::numeric_limits<double>::infinity();
+    double hi = -lo;
+    for (const auto& p : polygon) {
+      grid.push_back(_toGrid(p[0], p[1]));
+      lo = std::min(lo, grid.back()[0]);
+      hi = std::max(hi, grid.back()[0]);
+    }
+    // Clamped as doubles, a polygon far off the grid would overflow.
+    const double top = shape_[0] - 1;
+    if (!(std::ceil(lo) <= top) || !(std::floor(hi) >= 0)) {
+      return;
+    }
+    const Index first = std::max(0.0, std::ceil(lo));
+    const Index last = std::min(top, std::floor(hi));
+    const double right = shape_[1] - 1;
+    std::vector<double> cuts;
+    for (Index row = first; row <= last; ++row) {
+      cuts.clear();
+      for (std::size_t i = 0, j = grid.size() - 1; i < grid.size(); j = i++) {
+        const auto& a = grid[i];
+        const auto& b = grid[j];
+        if ((a[0] > row) != (b[0] > row)) {
+          cuts.push_back(a[1] + (row - a[0]) * (b[1] - a[1]) / (b[0] - a[0]));
+        }
+      }
+      std::sort(cuts.begin(), cuts.end());
+      for (std::size_t k = 0; k + 1 < cuts.size(); k += 2) {
+        const double start = std::max(0.0, std::ceil(cuts[k]));
+        const double stop = std::min(right, std::floor(cuts[k + 1])) + 1;
+        if (start < stop) {
+          _appendRun(row, start, stop, runs);
+        }
+      }
+    }
+  }
+
+  /// Appends a run of one row, merging it with the previous run if they meet.
+  void _appendRun(
+      Index row, Index start, Index stop,
+      std::vector<std::vector<RangeDescriptor<Index>>>& runs)  // NOLINT
+      const {
+    row += origin_[0];
+    start += origin_[1];
+    stop += origin_[1];
+    if (!runs.empty() && runs.back()[0].start == row &&
+        runs.back()[1].stop == start) {
+      runs.back()[1].stop = stop;
+      return;
+    }
+    runs.push_back({{(*labels_)[0], row, row + 1, 1},
+                    {(*labels_)[1], start, stop, 1}});
+  }
+
+  /// Arranges points_[lo, hi) as an implicit k-d tree, split at the middle.
+  void _buildTree(std::size_t lo, std::size_t hi, int axis) {
+    if (hi - lo < 2) {
+      return;
+    }
+    const std::size_t mid = lo + (hi - lo) / 2;
+    std::nth_element(points_.begin() + lo, points_.begin() + mid,
+                     points_.begin() + hi,
+                     [axis](const internal::SpatialPoint& a,
+                            const internal::SpatialPoint& b) {
+                       return axis == 0 ? a.x < b.x : a.y < b.y;
+                     });
+    _buildTree(lo, mid, 1 - axis);
+    _buildTree(mid + 1, hi, 1 - axis);
+  }
+
+  void _nearestTree(std::size_t lo, std::size_t hi, int axis, double x,
+                    double y, std::size_t& best,  // NOLINT (non-const)
+                    double& best_d2) const {      // NOLINT (non-const)
+    if (lo >= hi) {
+      return;
+    }
+    const std::size_t mid = lo + (hi - lo) / 2;
+    const auto& p = points_[mid];
+    const double d2 = (p.x - x) * (p.x - x) + (p.y - y) * (p.y - y);
+    if (d2 < best_d2 || (d2 == best_d2 && p.flat < points_[best].flat)) {
+      best = mid;
+      best_d2 = d2;
+    }
+    const double diff = axis == 0 ? x - p.x : y - p.y;
+    if (diff < 0) {
+      _nearestTree(lo, mid, 1 - axis, x, y, best, best_d2);
+      if (diff * diff <= best_d2) {
+        _nearestTree(mid + 1, hi, 1 - axis, x, y, best, best_d2);
+      }
+    } else {
+      _nearestTree(mid + 1, hi, 1 - axis, x, y, best, best_d2);
+      if (diff * diff <= best_d2) {
+        _nearestTree(lo, mid, 1 - axis, x, y, best, best_d2);
+      }
+    }
+  }
+
+  void _rangeTree(std::size_t lo, std::size_t hi, int axis,
+                  const std::array<double, 4>& box,
+                  const std::vector<SurfacePoint>& polygon,
+                  std::vector<Index>& found) const {  // NOLINT (non-const)
+    if (lo >= hi) {
+      return;
+    }
+    const std::size_t mid = lo + (hi - lo) / 2;
+    const auto& p = points_[mid];
+    if (p.x >= box[0] && p.x <= box[1] && p.y >= box[2] && p.y <= box[3] &&
+        internal::InPolygon(polygon, p.x, p.y)) {
+      found.push_back(p.flat);
+    }
+    const double value = axis == 0 ? p.x : p.y;
+    if (box[2 * axis] <= value) {
+      _rangeTree(lo, mid, 1 - axis, box, polygon, found);
+    }
+    if (box[2 * axis + 1] >= value) {
+      _rangeTree(mid + 1, hi, 1 - axis, box, polygon, found);
+    }
+  }
+
+  bool regular_ = false;
+  /// x0, y0 and the steps along inline and crossline of a regular survey.
+  std::array<double, 6> affine_ = {};
+  /// Shared, so the descriptors keep pointing at them when the index moves.
+  std::shared_ptr<const std::array<std::string, 2>> labels_;
+  std::array<Index, 2> origin_ = {};
+  std::array<Index, 2> shape_ = {};
+  std::vector<internal::SpatialPoint> points_;
+};
+
+namespace internal {
+
+/**
+ * @brief Reads the CDP coordinates and builds their index in memory.
+ */
+inline Future<SpatialIndex> ComputeSpatialIndex(
+    Dataset& dataset,  // NOLINT (non-const)
+    const SpatialIndexOptions& options) {
+  MDIO_ASSIGN_OR_RETURN(auto x_var, dataset.variables.at(options.cdp_x))
+  MDIO_ASSIGN_OR_RETURN(auto y_var, dataset.variables.at(options.cdp_y))
+  IndexDomain<> domain(x_var.dimensions());
+  if (domain != IndexDomain<>(y_var.dimensions())) {
+    return absl::InvalidArgumentError("'" + options.cdp_x + "' and '" +
+                                      options.cdp_y +
+                                      "' must share their dimensions.");
+  }
+  auto xs = ReadAsDouble(dataset, options.cdp_x);
+  auto ys = ReadAsDouble(dataset, options.cdp_y);
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [domain, tolerance = options.tolerance](std::vector<double>& x,
+                                              std::vector<double>& y) {
+        return SpatialIndex::Build(x.data(), y.data(), domain, tolerance);
+      },
+      std::move(xs), std::move(ys));
+}
+
+}  // namespace internal
+
+/**
+ * @brief Builds the spatial index of a Dataset and stores it with `cdp_x`.
+ * Writing either coordinate deletes the stored index, `OpenSpatialIndex`
+ * builds it in memory until it is built again.
+ * @details \b Usage
+ * @code
+ * MDIO_ASSIGN_OR_RETURN(auto index, mdio::BuildSpatialIndex(ds).result());
+ * auto well = index.Nearest(452311.5, 6782220.0);
+ * MDIO_ASSIGN_OR_RETURN(auto trace, ds.isel(index.descriptors(*well)));
+ * @endcode
+ * @param dataset The Dataset, whose CDP coordinates are unsliced.
+ * @param options The names of the coordinates and the regularity tolerance.
+ * @return A future of the index, ready once it has been written.
+ */
+inline Future<SpatialIndex> BuildSpatialIndex(
+    Dataset& dataset,  // NOLINT (non-const)
+    const SpatialIndexOptions& options = {}) {
+  for (const auto& name : {options.cdp_x, options.cdp_y}) {
+    if (!internal::IsCoordinate(name, dataset.coordinates, dataset.domain)) {
+      return absl::InvalidArgumentError(
+          "A spatial index can only be built from coordinates, '" + name +
+          "' is not one.");
+    }
+  }
+  MDIO_ASSIGN_OR_RETURN(auto x_var, dataset.variables.at(options.cdp_x))
+  MDIO_ASSIGN_OR_RETURN(auto y_var, dataset.variables.at(options.cdp_y))
+  auto x_kvs = x_var.get_store().kvstore();
+  auto y_kvs = y_var.get_store().kvstore();
+  if (!x_kvs.valid() || !y_kvs.valid()) {
+    return absl::UnimplementedError(
+        "The Variable's store does not support a spatial index.");
+  }
+  MDIO_ASSIGN_OR_RETURN(auto store_shape, x_var.get_store_shape())
+  auto domain = x_var.dimensions();
+  for (DimensionIndex i = 0; i < domain.rank(); ++i) {
+    if (domain.origin()[i] != 0 || domain.shape()[i] != store_shape[i]) {
+      return absl::InvalidArgumentError(
+          "A spatial index must be built from unsliced coordinates.");
+    }
+  }
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [x_var, y_var, x_kvs, y_kvs](SpatialIndex& index) {
+        // The next writes of the coordinates have to delete it again.
+        x_var.TrackCoordinateIndex();
+        y_var.TrackCoordinateIndex();
+        return tensorstore::MapFutureValue(
+            tensorstore::InlineExecutor{},
+            [index](const tensorstore::TimestampedStorageGeneration&,
+                    const tensorstore::TimestampedStorageGeneration&) {
+              return index;
+            },
+            tensorstore::kvstore::Write(x_kvs, internal::kSpatialIndexKey,
+                                        index.Serialize()),
+            tensorstore::kvstore::Write(
+                y_kvs, internal::kSpatialIndexKey,
+                absl::Cord(internal::kSpatialIndexMagic)));
+      },
+      internal::ComputeSpatialIndex(dataset, options));
+}
+
+/**
+ * @brief Gets the spatial index of a Dataset.
+ * The index stored by `BuildSpatialIndex` is used if neither coordinate was
+ * written since and it still matches their grid, otherwise the index is built
+ * in memory.
+ * @param dataset The Dataset, whose CDP coordinates are unsliced.
+ * @param options The names of the coordinates and the regularity tolerance.
+ */
+inline Future<SpatialIndex> OpenSpatialIndex(
+    Dataset& dataset,  // NOLINT (non-const)
+    const SpatialIndexOptions& options = {}) {
+  MDIO_ASSIGN_OR_RETURN(auto x_var, dataset.variables.at(options.cdp_x))
+  MDIO_ASSIGN_OR_RETURN(auto y_var, dataset.variables.at(options.cdp_y))
+  auto x_kvs = x_var.get_store().kvstore();
+  auto y_kvs = y_var.get_store().kvstore();
+  if (!x_kvs.valid() || !y_kvs.valid()) {
+    return internal::ComputeSpatialIndex(dataset, options);
+  }
+  auto domain = x_var.dimensions();
+  if (domain.rank() != 2) {
+    return absl::InvalidArgumentError(
+        "A spatial index needs coordinates over inline and crossline.");
+  }
+  const std::array<Index, 2> origin = {domain.origin()[0],
+                                       domain.origin()[1]};
+  const std::array<Index, 2> shape = {domain.shape()[0], domain.shape()[1]};
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [dataset, options, origin, shape](
+          const tensorstore::kvstore::ReadResult& read,
+          const tensorstore::kvstore::ReadResult& stamp) mutable
+      -> Future<SpatialIndex> {
+        if (read.has_value() && stamp.has_value() &&
+            stamp.value == internal::kSpatialIndexMagic) {
+          auto index = SpatialIndex::Deserialize(read.value);
+          // An index that can't be decoded is treated as absent.
+          if (index.ok() && index->origin() == origin &&
+              index->shape() == shape) {
+            return std::move(index).value();
+          }
+        }
+        return internal::ComputeSpatialIndex(dataset, options);
+      },
+      tensorstore::kvstore::Read(x_kvs, internal::kSpatialIndexKey),
+      tensorstore::kvstore::Read(y_kvs, internal::kSpatialIndexKey));
+}
+
+}  // namespace mdio
+
+#endif  // MDIO_SPATIAL_INDEX_H_
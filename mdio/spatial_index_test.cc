@@ -0,0 +1,268 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mdio/spatial_index.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr mdio::Index kInlines = 6;
+constexpr mdio::Index kCrosslines = 8;
+const double kAngle = std::acos(-1.0) / 6;
+
+mdio::IndexDomain<> GridDomain() {
+  return tensorstore::IndexDomainBuilder<>(2)
+      .labels({"inline", "crossline"})
+      .shape({kInlines, kCrosslines})
+      .Finalize()
+      .value();
+}
+
+// A grid rotated by 30 degrees, 25 m between inlines and 12.5 m between
+// crosslines.
+void RotatedGrid(std::vector<double>& x, std::vector<double>& y) {
+  const double c = std::cos(kAngle);
+  const double s = std::sin(kAngle);
+  x.resize(kInlines * kCrosslines);
+  y.resize(kInlines * kCrosslines);
+  for (mdio::Index i = 0; i < kInlines; ++i) {
+    for (mdio::Index j = 0; j < kCrosslines; ++j) {
+      x[i * kCrosslines + j] = 1000 + 25 * i * c - 12.5 * j * s;
+      y[i * kCrosslines + j] = 5000 + 25 * i * s + 12.5 * j * c;
+    }
+  }
+}
+
+// Counts the traces of a set of runs.
+mdio::Index CountTraces(
+    const std::vector<std::vector<mdio::RangeDescriptor<mdio::Index>>>& runs) {
+  mdio::Index total = 0;
+  for (const auto& run : runs) {
+    total += (run[0].stop - run[0].start) * (run[1].stop - run[1].start);
+  }
+  return total;
+}
+
+TEST(SpatialIndex, regularGrid) {
+  std::vector<double> x, y;
+  RotatedGrid(x, y);
+  auto index = mdio::SpatialIndex::Build(x.data(), y.data(), GridDomain());
+  ASSERT_TRUE(index.ok()) << index.status();
+  EXPECT_TRUE(index->regular());
+
+  const mdio::Index at = 3 * kCrosslines + 5;
+  auto match = index->Nearest(x[at] + 2, y[at] - 1);
+  ASSERT_TRUE(match.has_value());
+  EXPECT_EQ(match->inline_index, 3);
+  EXPECT_EQ(match->crossline_index, 5);
+  EXPECT_NEAR(match->distance, std::sqrt(5.0), 1e-9);
+
+  auto desc = index->descriptors(*match);
+  ASSERT_EQ(desc.size(), 2);
+  EXPECT_EQ(desc[0].label.label(), "inline");
+  EXPECT_EQ(desc[1].start, 5);
+  EXPECT_EQ(desc[1].stop, 6);
+
+  // Far off the grid the closest corner is found.
+  auto corner = index->Nearest(-1e9, -1e9);
+  ASSERT_TRUE(corner.has_value());
+  EXPECT_EQ(corner->inline_index, 0);
+}
+
+TEST(SpatialIndex, irregularMatchesRegular) {
+  std::vector<double> x, y;
+  RotatedGrid(x, y);
+  auto regular = mdio::SpatialIndex::Build(x.data(), y.data(), GridDomain());
+  ASSERT_TRUE(regular.ok()) << regular.status();
+
+  // A jittered trace and a dead one make the survey irregular.
+  x[10] += 3;
+  x[20] = std::nan("");
+  y[20] = std::nan("");
+  auto irregular = mdio::SpatialIndex::Build(x.data(), y.data(), GridDomain());
+  ASSERT_TRUE(irregular.ok()) << irregular.status();
+  EXPECT_FALSE(irregular->regular());
+
+  // A polygon around inlines 1 to 3, in the rotated frame.
+  const double c = std::cos(kAngle);
+  const double s = std::sin(kAngle);
+  const auto at = [&](double i, double j) -> mdio::SurfacePoint {
+    return {1000 + 25 * i * c - 12.5 * j * s, 5000 + 25 * i * s + 12.5 * j * c};
+  };
+  std::vector<mdio::SurfacePoint> polygon = {at(0.5, 1.5), at(3.5, 1.5),
+                                             at(3.5, 6.5), at(0.5, 6.5)};
+  auto expected = regular->Within(polygon);
+  ASSERT_EQ(expected.size(), 3);
+  EXPECT_EQ(CountTraces(expected), 3 * 5);
+  EXPECT_EQ(expected[0][0].start, 1);
+  EXPECT_EQ(expected[0][1].start, 2);
+  EXPECT_EQ(expected[0][1].stop, 7);
+
+  // Trace 20 is (2, 4) and is dead, so inline 2 splits in two runs.
+  auto actual = irregular->Within(polygon);
+  EXPECT_EQ(CountTraces(actual), 3 * 5 - 1);
+  EXPECT_EQ(actual.size(), 4);
+
+  for (mdio::Index i = 0; i < kInlines * kCrosslines; ++i) {
+    if (i == 20) {
+      continue;
+    }
+    auto match = irregular->Nearest(x[i], y[i]);
+    ASSERT_TRUE(match.has_value());
+    EXPECT_EQ(match->inline_index * kCrosslines + match->crossline_index, i);
+    EXPECT_EQ(match->distance, 0);
+  }
+}
+
+TEST(SpatialIndex, serialize) {
+  std::vector<double> x, y;
+  RotatedGrid(x, y);
+  x[7] += 4;
+  auto index = mdio::SpatialIndex::Build(x.data(), y.data(), GridDomain());
+  ASSERT_TRUE(index.ok()) << index.status();
+  auto bytes = index->Serialize();
+  auto restored = mdio::SpatialIndex::Deserialize(bytes);
+  ASSERT_TRUE(restored.ok()) << restored.status();
+  EXPECT_FALSE(restored->regular());
+  EXPECT_EQ(restored->shape(), index->shape());
+  auto match = restored->Nearest(x[7], y[7]);
+  ASSERT_TRUE(match.has_value());
+  EXPECT_EQ(match->crossline_index, 7);
+
+  // The words are little endian, the header's second is the length of
+  // "inline" and the last is the offset of a trace in the grid.
+  std::string truncated(bytes);
+  const std::size_t at = mdio::internal::kSpatialIndexMagic.size() + 8;
+  EXPECT_EQ(truncated[at], static_cast<char>(6));
+  EXPECT_EQ(truncated.substr(at + 1, 7), std::string(7, '\0'));
+  EXPECT_LT(static_cast<unsigned char>(truncated[truncated.size() - 8]),
+            kInlines * kCrosslines);
+  EXPECT_EQ(truncated.substr(truncated.size() - 7), std::string(7, '\0'));
+  truncated.pop_back();
+  EXPECT_FALSE(mdio::SpatialIndex::Deserialize(absl::Cord(truncated)).ok());
+}
+
+TEST(SpatialIndex, dataset) {
+  const std::string schema = R"(
+{
+  "metadata": {
+    "name": "spatial",
+    "apiVersion": "1.0.0",
+    "createdOn": "2023-12-12T15:02:06.413469-06:00"
+  },
+  "variables": [
+    {
+      "name": "image",
+      "dataType": "float32",
+      "dimensions": [
+        {"name": "inline", "size": 6},
+        {"name": "crossline", "size": 8}
+      ],
+      "coordinates": ["cdp_x", "cdp_y"]
+    },
+    {
+      "name": "cdp_x",
+      "dataType": "float64",
+      "dimensions": ["inline", "crossline"]
+    },
+    {
+      "name": "cdp_y",
+      "dataType": "float64",
+      "dimensions": ["inline", "crossline"]
+    },
+    {
+      "name": "inline",
+      "dataType": "uint32",
+      "dimensions": [{"name": "inline", "size": 6}]
+    },
+    {
+      "name": "crossline",
+      "dataType": "uint32",
+      "dimensions": [{"name": "crossline", "size": 8}]
+    }
+  ]
+}
+  )";
+  auto dataset =
+      mdio::Dataset::from_json(::nlohmann::json::parse(schema),
+                               "zarrs/spatial", mdio::constants::kCreateClean)
+          .result();
+  ASSERT_TRUE(dataset.ok()) << dataset.status();
+  std::vector<double> x, y;
+  RotatedGrid(x, y);
+  for (const auto& [name, values] :
+       {std::pair{"cdp_x", &x}, std::pair{"cdp_y", &y}}) {
+    auto var = dataset->variables.get<double>(name);
+    ASSERT_TRUE(var.ok()) << var.status();
+    auto data = mdio::from_variable<double>(var.value());
+    ASSERT_TRUE(data.ok()) << data.status();
+    std::copy(values->begin(), values->end(),
+              data->get_data_accessor().data() + data->get_flattened_offset());
+    ASSERT_TRUE(var->Write(data.value()).commit_future.result().ok());
+  }
+
+  auto built = mdio::BuildSpatialIndex(dataset.value()).result();
+  ASSERT_TRUE(built.ok()) << built.status();
+  auto opened = mdio::OpenSpatialIndex(dataset.value()).result();
+  ASSERT_TRUE(opened.ok()) << opened.status();
+  EXPECT_TRUE(opened->regular());
+  EXPECT_TRUE(std::filesystem::exists("zarrs/spatial/cdp_x/.zspatial"));
+
+  auto match = opened->Nearest(x[13], y[13]);
+  ASSERT_TRUE(match.has_value());
+  auto trace = dataset->isel(opened->descriptors(*match));
+  ASSERT_TRUE(trace.ok()) << trace.status();
+  auto cdp = trace->variables.get<double>("cdp_x");
+  ASSERT_TRUE(cdp.ok()) << cdp.status();
+  auto value = cdp->Read().result();
+  ASSERT_TRUE(value.ok()) << value.status();
+  EXPECT_DOUBLE_EQ(
+      value->get_data_accessor().data()[value->get_flattened_offset()], x[13]);
+
+  // Writing either coordinate deletes the stored index.
+  for (const std::string name : {"cdp_y", "cdp_x"}) {
+    auto rebuilt = mdio::BuildSpatialIndex(dataset.value()).result();
+    ASSERT_TRUE(rebuilt.ok()) << rebuilt.status();
+    ASSERT_TRUE(std::filesystem::exists("zarrs/spatial/cdp_y/.zspatial"));
+    auto var = dataset->variables.get<double>(name);
+    ASSERT_TRUE(var.ok()) << var.status();
+    auto data = var->Read().result();
+    ASSERT_TRUE(data.ok()) << data.status();
+    ASSERT_TRUE(var->Write(data.value()).commit_future.result().ok());
+    EXPECT_FALSE(
+        std::filesystem::exists("zarrs/spatial/" + name + "/.zspatial"));
+    auto reopened = mdio::OpenSpatialIndex(dataset.value()).result();
+    ASSERT_TRUE(reopened.ok()) << reopened.status();
+    EXPECT_TRUE(reopened->regular());
+  }
+
+  // Only coordinates can be indexed.
+  mdio::SpatialIndexOptions options;
+  options.cdp_x = "image";
+  EXPECT_FALSE(
+      mdio::BuildSpatialIndex(dataset.value(), options).status().ok());
+
+  std::filesystem::remove_all("zarrs/spatial");
+}
+
+}  // namespace
@@ -16,9 +16,13 @@
 #define MDIO_STATS_H_
 
 #include <algorithm>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -75,6 +79,323 @@
 namespace mdio {
 namespace internal {
 
+/**
+ * @brief Mergeable partial moments of a set of samples.
+ */
+struct StatsMoments {
+  int64_t count = 0;
+  double sum = 0;
+  double sum_squares = 0;
+  double min = std::numeric_limits<double>::infinity();
+  double max = -std::numeric_limits<double>::infinity();
+
+  void Merge(const StatsMoments& other) {
+    count += other.count;
+    sum += other.sum;
+    sum_squares += other.sum_squares;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+  }
+};
+
+/**
+ * @brief Accumulates the moments of a contiguous buffer.
+ * The samples are processed in independent lanes with branch-free selects so
+ * the compiler can turn the loop into SIMD code. NaNs and, if given, the fill
+ * value are skipped.
+ * @param data Pointer to the first sample.
+ * @param n_samples The number of samples.
+ * @param fill The fill value to skip, if any.
+ * @param out The moments to accumulate into.
+ */
+template <typename T>
+void AccumulateMoments(const T* data, Index n_samples,
+                       const std::optional<T>& fill,
+                       StatsMoments& out) {  // NOLINT (non-const)
+  constexpr Index kLanes = 8;
+  const bool skip_fill = fill.has_value();
+  const T fill_value = skip_fill ? *fill : T{};
+  constexpr double kInf = std::numeric_limits<double>::infinity();
+
+  int64_t count[kLanes] = {};
+  double sum[kLanes] = {};
+  double sum_squares[kLanes] = {};
+  double min[kLanes];
+  double max[kLanes];
+  std::fill(min, min + kLanes, kInf);
+  std::fill(max, max + kLanes, -kInf);
+
+  const auto lane = [&](Index l, const T& raw) {
+    const double v = static_cast<double>(raw);
+    const bool keep = (v == v) & !(skip_fill & (raw == fill_value));
+    count[l] += keep;
+    sum[l] += keep ? v : 0.0;
+    sum_squares[l] += keep ? v * v : 0.0;
+    min[l] = keep && v < min[l] ? v : min[l];
+    max[l] = keep && v > max[l] ? v : max[l];
+  };
+
+  Index i = 0;
+  for (; i + kLanes <= n_samples; i += kLanes) {
+    for (Index l = 0; l < kLanes; ++l) {
+      lane(l, data[i + l]);
+    }
+  }
+  for (; i < n_samples; ++i) {
+    lane(0, data[i]);
+  }
+
+  for (Index l = 0; l < kLanes; ++l) {
+    out.count += count[l];
+    out.sum += sum[l];
+    out.sum_squares += sum_squares[l];
+    out.min = std::min(out.min, min[l]);
+    out.max = std::max(out.max, max[l]);
+  }
+}
+
+/**
+ * @brief Accumulates an equal width histogram over [lo, hi] of a contiguous
+ * buffer.
+ * Samples outside of the range, NaNs and the fill value are not counted.
+ * @param counts One counter per bin, must not be empty.
+ */
+template <typename T>
+void AccumulateHistogram(const T* data, Index n_samples,
+                         const std::optional<T>& fill, double lo, double hi,
+                         std::vector<int64_t>& counts) {  // NOLINT (non-const)
+  const Index num_bins = static_cast<Index>(counts.size());
+  const double scale = hi > lo ? num_bins / (hi - lo) : 0.0;
+  const bool skip_fill = fill.has_value();
+  const T fill_value = skip_fill ? *fill : T{};
+  for (Index i = 0; i < n_samples; ++i) {
+    const double v = static_cast<double>(data[i]);
+    if (!(v >= lo && v <= hi) || (skip_fill && data[i] == fill_value)) {
+      continue;
+    }
+    const Index bin = static_cast<Index>((v - lo) * scale);
+    ++counts[std::min(bin, num_bins - 1)];
+  }
+}
+
+/**
+ * @brief Gets the numeric fill value from a Variable's spec.
+ * @return The fill value, or `std::nullopt` if there is none or it is not
+ * representable as a number (e.g. "NaN", which is always skipped).
+ */
+inline std::optional<double> FillValueFromSpec(const nlohmann::json& spec) {
+  if (!spec.contains("metadata") || !spec["metadata"].contains("fill_value") ||
+      !spec["metadata"]["fill_value"].is_number()) {
+    return std::nullopt;
+  }
+  return spec["metadata"]["fill_value"].get<double>();
+}
+
+/**
+ * @brief Calls `fn` with a value of the C++ element type of a Variable that
+ * statistics can be computed for.
+ * `T` is the static element type of the Variable. If it is `void` the type is
+ * resolved from `dtype`.
+ * @return False if the element type is not a real numeric type.
+ */
+template <typename T, typename Fn>
+bool DispatchNumericType(DataType dtype, Fn&& fn) {
+  if constexpr (!std::is_void_v<T>) {
+    if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>) {
+      fn(T{});
+      return true;
+    } else {
+      return false;
+    }
+  } else {
+    if (dtype == constants::kFloat32) {
+      fn(dtypes::float32_t{});
+    } else if (dtype == constants::kFloat64) {
+      fn(dtypes::float64_t{});
+    } else if (dtype == constants::kInt8) {
+      fn(dtypes::int8_t{});
+    } else if (dtype == constants::kInt16) {
+      fn(dtypes::int16_t{});
+    } else if (dtype == constants::kInt32) {
+      fn(dtypes::int32_t{});
+    } else if (dtype == constants::kInt64) {
+      fn(dtypes::int64_t{});
+    } else if (dtype == constants::kUint8) {
+      fn(dtypes::uint8_t{});
+    } else if (dtype == constants::kUint16) {
+      fn(dtypes::uint16_t{});
+    } else if (dtype == constants::kUint32) {
+      fn(dtypes::uint32_t{});
+    } else if (dtype == constants::kUint64) {
+      fn(dtypes::uint64_t{});
+    } else {
+      return false;
+    }
+    return true;
+  }
+}
+
+/**
+ * @brief Running statistics of a Variable that are maintained as it is
+ * written.
+ * Written blocks are summarized into mergeable partials which are added to, or
+ * for overwritten data subtracted from, the totals. Count, sums and histogram
+ * stay exact under subtraction. The min and max can't be retracted, after a
+ * subtraction they are only bounds and the statistics are flagged as
+ * approximate.
+ */
+class RunningStats {
+ public:
+  /// The contribution of one block of samples.
+  struct Partial {
+    StatsMoments moments;
+    std::vector<int64_t> counts;
+  };
+
+  RunningStats(double lo, double hi, std::size_t num_bins,
+               std::optional<double> fill, bool subtract_overwritten = true)
+      : lo_(lo),
+        hi_(hi),
+        fill_(fill),
+        subtract_overwritten_(subtract_overwritten),
+        counts_(num_bins, 0) {}
+
+  /**
+   * @brief Resumes from a statsV1 object with an equal width, edge defined
+   * histogram.
+   */
+  static Result<std::shared_ptr<RunningStats>> FromJson(
+      const nlohmann::json& stats, std::optional<double> fill,
+      bool subtract_overwritten = true) {
+    try {
+      const auto& hist = stats.at("histogram");
+      std::vector<double> edges = hist.at("binEdges");
+      std::vector<double> widths = hist.at("binWidths");
+      std::vector<int64_t> counts = hist.at("counts");
+      if (edges.empty() || edges.size() != widths.size() ||
+          widths.size() != counts.size()) {
+        return absl::InvalidArgumentError(
+            "Running statistics require an edge defined histogram with one "
+            "edge and width per bin.");
+      }
+      auto running = std::make_shared<RunningStats>(
+          edges.front(), edges.back() + widths.back(), counts.size(), fill,
+          subtract_overwritten);
+      running->moments_.count = stats.at("count").get<int64_t>();
+      running->moments_.sum = stats.at("sum").get<double>();
+      running->moments_.sum_squares = stats.at("sumSquares").get<double>();
+      if (running->moments_.count > 0) {
+        running->moments_.min = stats.at("min").get<double>();
+        running->moments_.max = stats.at("max").get<double>();
+      }
+      running->counts_ = std::move(counts);
+      return running;
+    } catch (const nlohmann::json::exception& e) {
+      return absl::InvalidArgumentError(
+          "Could not resume running statistics from statsV1: " +
+          std::string(e.what()));
+    }
+  }
+
+  /**
+   * @brief Summarizes a contiguous block of samples.
+   * Thread safe, the totals are not touched.
+   */
+  template <typename T>
+  Partial Summarize(const T* data, Index n_samples) const {
+    std::optional<T> fill;
+    if (fill_.has_value()) {
+      fill = static_cast<T>(*fill_);
+    }
+    Partial partial;
+    partial.counts.assign(counts_.size(), 0);
+    AccumulateMoments(data, n_samples, fill, partial.moments);
+    AccumulateHistogram(data, n_samples, fill, lo_, hi_, partial.counts);
+    return partial;
+  }
+
+  /// Adds a summarized block to the totals.
+  void Add(const Partial& partial) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    moments_.Merge(partial.moments);
+    for (std::size_t b = 0; b < counts_.size(); ++b) {
+      counts_[b] += partial.counts[b];
+    }
+    dirty_ = true;
+  }
+
+  /// Removes a summarized block from the totals.
+  void Subtract(const Partial& partial) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (partial.moments.count == 0) {
+      return;
+    }
+    moments_.count -= partial.moments.count;
+    moments_.sum -= partial.moments.sum;
+    moments_.sum_squares -= partial.moments.sum_squares;
+    for (std::size_t b = 0; b < counts_.size(); ++b) {
+      counts_[b] -= partial.counts[b];
+    }
+    approximate_ = true;
+    dirty_ = true;
+  }
+
+  /// Whether writes read the region they overwrite to subtract it.
+  bool subtract_overwritten() const { return subtract_overwritten_; }
+
+  /// True once removed samples may have left the min and max loose.
+  bool approximate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return approximate_;
+  }
+
+  /**
+   * @brief Clears and returns whether the totals changed since the last call.
+   */
+  bool TakeDirty() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::exchange(dirty_, false);
+  }
+
+  /// Marks the totals as changed.
+  void MarkDirty() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    dirty_ = true;
+  }
+
+  /// Gets the statsV1 representation of the totals.
+  nlohmann::json ToJson() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const double width = (hi_ - lo_) / counts_.size();
+    std::vector<double> edges;
+    std::vector<double> widths(counts_.size(), width);
+    for (std::size_t b = 0; b < counts_.size(); ++b) {
+      edges.push_back(lo_ + b * width);
+    }
+    nlohmann::json stats;
+    stats["count"] = moments_.count;
+    stats["sum"] = moments_.sum;
+    stats["sumSquares"] = moments_.sum_squares;
+    stats["min"] = moments_.count ? moments_.min : 0.0;
+    stats["max"] = moments_.count ? moments_.max : 0.0;
+    stats["histogram"]["binEdges"] = edges;
+    stats["histogram"]["binWidths"] = widths;
+    stats["histogram"]["counts"] = counts_;
+    return stats;
+  }
+
+ private:
+  const double lo_;
+  const double hi_;
+  const std::optional<double> fill_;
+  const bool subtract_overwritten_;
+  mutable std::mutex mutex_;
+  StatsMoments moments_;
+  std::vector<int64_t> counts_;
+  bool approximate_ = false;
+  bool dirty_ = false;
+};
+
 /**
  * @brief A Histogram can be either CenteredBinHistogram or EdgeDefinedHistogram
  * as defined by the MDIO spec
@@ -270,14 +591,14 @@ class SummaryStats {
       }
     }
     auto stats =
-        SummaryStats(j["count"].get<int32_t>(), j["max"].get<float>(),
+        SummaryStats(j["count"].get<int64_t>(), j["max"].get<float>(),
                      j["min"].get<float>(), j["sum"].get<float>(),
                      j["sumSquares"].get<float>(), std::move(histogram));
     return mdio::Result<SummaryStats>(stats);
   }
 
  private:
-  SummaryStats(const int32_t count, const float max, const float min,
+  SummaryStats(const int64_t count, const float max, const float min,
                const float sum, const float sumSquares,
                std::unique_ptr<const Histogram> histogram)
       : count(count),
@@ -326,7 +647,7 @@ class SummaryStats {
     return histogram;
   }
 
-  const int32_t count;
+  const int64_t count;
   const float max;
   const float min;
   const float sum;
@@ -632,5 +953,22 @@ class UserAttributes {
   const nlohmann::json attrs;
 };
 
+/**
+ * @brief Options for `Variable::TrackStats`.
+ */
+struct StatsTrackingOptions {
+  /// The number of equal width histogram bins of new statistics.
+  std::size_t num_bins = 256;
+  /// The range covered by the histogram of new statistics. Required unless
+  /// the Variable already has statsV1 with an edge defined histogram, which
+  /// tracking then resumes from.
+  std::optional<std::pair<double, double>> histogram_range;
+  /// Whether a write reads the region it overwrites and subtracts it from the
+  /// statistics. This costs a read per write and requires unwritten samples to
+  /// equal the fill value. If false the new block is only added, which is
+  /// exact for write once (e.g. append only) workloads.
+  bool subtract_overwritten = true;
+};
+
 }  // namespace mdio
 #endif  // MDIO_STATS_H_
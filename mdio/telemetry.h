@@ -0,0 +1,261 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MDIO_TELEMETRY_H_
+#define MDIO_TELEMETRY_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "tensorstore/util/future.h"
+#include "tensorstore/util/result.h"
+
+namespace mdio {
+
+/**
+ * @brief A timed operation of MDIO, such as a read or an open.
+ * The fields follow the OpenTelemetry span model, so a hook can forward them
+ * to a tracer as they are.
+ */
+struct TelemetrySpan {
+  /// The operation, e.g. "mdio.Variable.Read".
+  std::string name;
+  /// What the operation was applied to, e.g. {"mdio.variable", "seismic"}.
+  std::vector<std::pair<std::string, std::string>> attributes;
+  absl::Time start;
+  absl::Duration duration;
+  /// The outcome of the operation.
+  absl::Status status;
+};
+
+/**
+ * @brief The counters MDIO reports.
+ */
+enum class TelemetryCounter {
+  /// Bytes of samples returned by reads.
+  kBytesRead,
+  /// Bytes of samples committed by writes.
+  kBytesWritten,
+  /// Chunks covered by reads.
+  kChunksFetched,
+  /// Metadata and chunks served from the in-process memo or the disk cache.
+  kCacheHits,
+  /// Metadata and chunks that had to be downloaded.
+  kCacheMisses,
+  /// Requests to a store that were retried.
+  kRetries,
+  /// Requests to a store that were sent again because they were slow.
+  kHedgedRequests,
+  /// Explicit chunk shapes that are tiny or oversized.
+  kChunkShapeWarnings,
+};
+
+/**
+ * @brief Gets the OpenTelemetry style name of a counter.
+ */
+inline const char* TelemetryCounterName(TelemetryCounter counter) {
+  switch (counter) {
+    case TelemetryCounter::kBytesRead:
+      return "mdio.bytes_read";
+    case TelemetryCounter::kBytesWritten:
+      return "mdio.bytes_written";
+    case TelemetryCounter::kChunksFetched:
+      return "mdio.chunks_fetched";
+    case TelemetryCounter::kCacheHits:
+      return "mdio.cache_hits";
+    case TelemetryCounter::kCacheMisses:
+      return "mdio.cache_misses";
+    case TelemetryCounter::kHedgedRequests:
+      return "mdio.hedged_requests";
+    case TelemetryCounter::kChunkShapeWarnings:
+      return "mdio.chunk_shape_warnings";
+    default:
+      return "mdio.retries";
+  }
+}
+
+/**
+ * @brief The callbacks that receive the spans and counters of the process.
+ * Either may be empty. They are called from whichever thread completes the
+ * operation, so they must be thread safe and should return quickly.
+ */
+struct TelemetryHooks {
+  std::function<void(const TelemetrySpan&)> on_span;
+  std::function<void(TelemetryCounter, std::int64_t)> on_counter;
+};
+
+namespace internal {
+
+/// Checked before anything else, so disabled telemetry costs one load.
+inline std::atomic<bool>& TelemetryEnabled() {
+  static std::atomic<bool> enabled{false};
+  return enabled;
+}
+
+inline std::shared_ptr<const TelemetryHooks>& ProcessTelemetryHooks() {
+  static std::shared_ptr<const TelemetryHooks> hooks;
+  return hooks;
+}
+
+inline std::mutex& ProcessTelemetryMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+/**
+ * @brief The hooks of the process, null if telemetry is disabled.
+ */
+inline std::shared_ptr<const TelemetryHooks> GetTelemetryHooks() {
+  if (!TelemetryEnabled().load(std::memory_order_relaxed)) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(ProcessTelemetryMutex());
+  return ProcessTelemetryHooks();
+}
+
+/**
+ * @brief Adds to a counter, if telemetry is enabled.
+ */
+inline void Count(TelemetryCounter counter, std::int64_t value) {
+  auto hooks = GetTelemetryHooks();
+  if (hooks && hooks->on_counter) {
+    hooks->on_counter(counter, value);
+  }
+}
+
+/**
+ * @brief Times an operation and reports it to the `on_span` hook.
+ * Nothing is recorded if telemetry was disabled when the span started. A span
+ * that is never ended is not reported.
+ */
+class Span {
+ public:
+  explicit Span(const char* name) {
+    auto hooks_ptr = GetTelemetryHooks();
+    if (hooks_ptr && hooks_ptr->on_span) {
+      hooks = std::move(hooks_ptr);
+      span.name = name;
+      span.start = absl::Now();
+    }
+  }
+
+  /**
+   * @brief Checks if the span will be reported, so callers can skip work
+   * that only feeds it.
+   */
+  bool active() const { return hooks != nullptr; }
+
+  /**
+   * @brief Describes what the operation is applied to.
+   */
+  Span& Attribute(const char* key, const std::string& value) {
+    if (active()) {
+      span.attributes.emplace_back(key, value);
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Reports the span with the outcome of the operation.
+   */
+  void End(const absl::Status& status) {
+    if (!active()) {
+      return;
+    }
+    span.duration = absl::Now() - span.start;
+    span.status = status;
+    hooks->on_span(span);
+    hooks = nullptr;
+  }
+
+  /**
+   * @brief Reports the span with the outcome of a synchronous operation.
+   * @return The result, unchanged.
+   */
+  template <typename T>
+  tensorstore::Result<T> End(tensorstore::Result<T> result) {
+    End(result.status());
+    return result;
+  }
+
+  /**
+   * @brief Reports the span once an asynchronous operation is ready.
+   * @return A future of the same result, ready once the span is reported.
+   */
+  template <typename T>
+  tensorstore::Future<T> End(tensorstore::Future<T> future) {
+    if (!active()) {
+      return future;
+    }
+    return tensorstore::MapFuture(
+        tensorstore::InlineExecutor{},
+        [span = std::move(*this)](
+            tensorstore::Result<T>& result) mutable -> tensorstore::Result<T> {
+          span.End(result.status());
+          return std::move(result);
+        },
+        std::move(future));
+  }
+
+ private:
+  std::shared_ptr<const TelemetryHooks> hooks;
+  TelemetrySpan span;
+};
+
+}  // namespace internal
+
+/**
+ * @brief Reports the spans and counters of MDIO to the given hooks.
+ * Spans are reported for `Dataset::Open`, `Dataset::OpenLazy`, `isel`, `sel`,
+ * `CommitMetadata`, `Variable::Read`, `Variable::Write`, the stages of a
+ * `CoordinateSelector` and the requests run under a `RequestPolicy`.
+ * Operations already in flight keep the hooks they started with.
+ * @details \b Usage
+ * @code
+ * mdio::TelemetryHooks hooks;
+ * hooks.on_span = [](const mdio::TelemetrySpan& span) {
+ *   LOG(INFO) << span.name << " took " << span.duration;
+ * };
+ * mdio::SetTelemetryHooks(std::move(hooks));
+ * @endcode
+ * @param hooks The callbacks, replacing any set before.
+ */
+inline void SetTelemetryHooks(TelemetryHooks hooks) {
+  std::lock_guard<std::mutex> lock(internal::ProcessTelemetryMutex());
+  internal::ProcessTelemetryHooks() =
+      std::make_shared<const TelemetryHooks>(std::move(hooks));
+  internal::TelemetryEnabled().store(true, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Stops reporting spans and counters.
+ */
+inline void ClearTelemetryHooks() {
+  std::lock_guard<std::mutex> lock(internal::ProcessTelemetryMutex());
+  internal::TelemetryEnabled().store(false, std::memory_order_relaxed);
+  internal::ProcessTelemetryHooks() = nullptr;
+}
+
+}  // namespace mdio
+
+#endif  // MDIO_TELEMETRY_H_
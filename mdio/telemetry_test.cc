@@ -0,0 +1,163 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mdio/telemetry.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "mdio/dataset.h"
+#include "mdio/variable.h"
+
+namespace {
+
+// clang-format off
+::nlohmann::json json_traced = ::nlohmann::json::object({
+    {"driver", "zarr"},
+    {"kvstore",
+        {
+            {"driver", "file"},
+            {"path", "traced_variable"}
+        }
+    },
+    {"attributes",
+        {
+            {"long_name", "telemetry test"},
+            {"dimension_names", {"x", "y"} },
+        }
+    },
+    {"metadata",
+        {
+            {"dtype", "<f4"},
+            {"shape", {20, 30}},
+            {"chunks", {8, 16}},
+            {"fill_value", 0.0},
+            {"dimension_separator", "/"},
+        }
+    }
+});
+// clang-format on
+
+// Collects what the hooks report.
+struct Recorder {
+  std::mutex mutex;
+  std::vector<mdio::TelemetrySpan> spans;
+  std::map<mdio::TelemetryCounter, std::int64_t> counters;
+
+  mdio::TelemetryHooks Hooks() {
+    mdio::TelemetryHooks hooks;
+    hooks.on_span = [this](const mdio::TelemetrySpan& span) {
+      std::lock_guard<std::mutex> lock(mutex);
+      spans.push_back(span);
+    };
+    hooks.on_counter = [this](mdio::TelemetryCounter counter,
+                              std::int64_t value) {
+      std::lock_guard<std::mutex> lock(mutex);
+      counters[counter] += value;
+    };
+    return hooks;
+  }
+
+  std::vector<mdio::TelemetrySpan> Named(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<mdio::TelemetrySpan> named;
+    for (const auto& span : spans) {
+      if (span.name == name) {
+        named.push_back(span);
+      }
+    }
+    return named;
+  }
+};
+
+TEST(Telemetry, variableSpans) {
+  auto var = mdio::Variable<float>::Open(json_traced,
+                                         mdio::constants::kCreateClean)
+                 .result();
+  ASSERT_TRUE(var.ok()) << var.status();
+  auto data = mdio::from_variable<float>(var.value());
+  ASSERT_TRUE(data.ok()) << data.status();
+
+  Recorder recorder;
+  mdio::SetTelemetryHooks(recorder.Hooks());
+  ASSERT_TRUE(var->Write(data.value()).commit_future.result().ok());
+  mdio::RangeDescriptor<mdio::Index> desc = {"x", 0, 10, 1};
+  auto half = var->slice(desc);
+  ASSERT_TRUE(half.ok()) << half.status();
+  ASSERT_TRUE(half->Read().result().ok());
+  mdio::ClearTelemetryHooks();
+
+  auto writes = recorder.Named("mdio.Variable.Write");
+  ASSERT_EQ(writes.size(), 1);
+  EXPECT_TRUE(writes[0].status.ok()) << writes[0].status;
+  EXPECT_THAT(writes[0].attributes,
+              ::testing::Contains(::testing::Pair("mdio.variable",
+                                                  "traced_variable")));
+  auto reads = recorder.Named("mdio.Variable.Read");
+  ASSERT_EQ(reads.size(), 1);
+  EXPECT_GE(reads[0].duration, absl::ZeroDuration());
+
+  std::lock_guard<std::mutex> lock(recorder.mutex);
+  EXPECT_EQ(recorder.counters[mdio::TelemetryCounter::kBytesWritten],
+            20 * 30 * sizeof(float));
+  EXPECT_EQ(recorder.counters[mdio::TelemetryCounter::kBytesRead],
+            10 * 30 * sizeof(float));
+  // Rows 0 to 9 cover two rows of chunks, each two chunks wide.
+  EXPECT_EQ(recorder.counters[mdio::TelemetryCounter::kChunksFetched], 4);
+
+  std::filesystem::remove_all("traced_variable");
+}
+
+TEST(Telemetry, disabled) {
+  auto var = mdio::Variable<float>::Open(json_traced,
+                                         mdio::constants::kCreateClean)
+                 .result();
+  ASSERT_TRUE(var.ok()) << var.status();
+
+  Recorder recorder;
+  mdio::SetTelemetryHooks(recorder.Hooks());
+  mdio::ClearTelemetryHooks();
+  ASSERT_TRUE(var->Read().result().ok());
+  EXPECT_TRUE(recorder.Named("mdio.Variable.Read").empty());
+  EXPECT_TRUE(recorder.counters.empty());
+
+  std::filesystem::remove_all("traced_variable");
+}
+
+TEST(Telemetry, failedSpan) {
+  Recorder recorder;
+  mdio::SetTelemetryHooks(recorder.Hooks());
+  auto dataset =
+      mdio::Dataset::Open(std::string("zarrs/no_such_dataset.mdio"),
+                          mdio::constants::kOpen)
+          .result();
+  mdio::ClearTelemetryHooks();
+  EXPECT_FALSE(dataset.ok());
+
+  auto opens = recorder.Named("mdio.Dataset.Open");
+  ASSERT_EQ(opens.size(), 1);
+  EXPECT_FALSE(opens[0].status.ok());
+  EXPECT_THAT(opens[0].attributes,
+              ::testing::Contains(::testing::Pair(
+                  "mdio.path", "zarrs/no_such_dataset.mdio")));
+}
+
+}  // namespace
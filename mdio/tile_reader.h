@@ -0,0 +1,166 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MDIO_TILE_READER_H_
+#define MDIO_TILE_READER_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <utility>
+
+#include "mdio/impl.h"
+#include "mdio/variable.h"
+#include "tensorstore/util/division.h"
+#include "tensorstore/util/future.h"
+
+namespace mdio {
+
+/**
+ * @brief Options for a `TileReader`.
+ */
+struct TileReaderOptions {
+  /// The number of tiles read ahead of the one being processed.
+  std::size_t read_ahead = 2;
+  /// The extent of a tile along the traversal dimension. The default of 0
+  /// uses the chunk extent, so every tile reads whole chunks.
+  Index tile_size = 0;
+};
+
+/**
+ * @brief Reads a Variable tile by tile along one dimension, keeping the next
+ * tiles in flight while the current one is processed.
+ * Tiles are aligned to the chunk grid, so each chunk is fetched once. The
+ * first and last tiles are cut short by the bounds of the Variable.
+ * @note A TileReader is not thread safe, it is driven by one consumer.
+ * @details \b Usage
+ * @code
+ * MDIO_ASSIGN_OR_RETURN(auto seismic, ds.variables.get<float>("seismic"));
+ * MDIO_ASSIGN_OR_RETURN(auto tiles,
+ *                       mdio::TileReader<float>::Make(seismic, "inline"));
+ * while (!tiles.done()) {
+ *   MDIO_ASSIGN_OR_RETURN(auto tile, tiles.Next().result());
+ *   // process the tile while the next ones are read
+ * }
+ * @endcode
+ */
+template <typename T = void>
+class TileReader {
+ public:
+  /**
+   * @brief Makes a reader over a Variable.
+   * @param var The Variable, or region of one, to read.
+   * @param dimension The label of the dimension to traverse.
+   * @param options The tile size and read ahead depth.
+   * @return The reader, or an error if the Variable has no such dimension.
+   */
+  static Result<TileReader> Make(const Variable<T>& var,
+                                 const std::string& dimension,
+                                 const TileReaderOptions& options = {}) {
+    const auto domain = var.dimensions();
+    DimensionIndex dim = -1;
+    for (DimensionIndex d = 0; d < domain.rank(); ++d) {
+      if (domain.labels()[d] == dimension) {
+        dim = d;
+      }
+    }
+    if (dim < 0) {
+      return absl::NotFoundError("Dimension '" + dimension +
+                                 "' not found in Variable '" +
+                                 var.get_variable_name() + "'.");
+    }
+    Index tile_size = options.tile_size;
+    if (tile_size <= 0) {
+      auto chunk_res = var.get_chunk_shape();
+      const bool chunked =
+          chunk_res.ok() &&
+          dim < static_cast<DimensionIndex>(chunk_res->size()) &&
+          (*chunk_res)[dim] > 0;
+      tile_size = chunked ? (*chunk_res)[dim]
+                          : std::max<Index>(domain[dim].exclusive_max(), 1);
+    }
+    return TileReader(var, dimension, domain[dim].inclusive_min(),
+                      domain[dim].exclusive_max(), tile_size,
+                      options.read_ahead);
+  }
+
+  /**
+   * @brief Checks if every tile has been handed out by `Next`.
+   */
+  bool done() const { return next_tile >= end_tile && ahead.empty(); }
+
+  /**
+   * @brief Gets the number of tiles of the traversal.
+   */
+  Index num_tiles() const { return end_tile - first_tile; }
+
+  /**
+   * @brief Gets the next tile, and starts reading the tiles after it.
+   * @return A future of the tile, in the index space of the Variable, or an
+   * out of range error once every tile has been handed out.
+   */
+  Future<VariableData<T>> Next() {
+    if (done()) {
+      return absl::OutOfRangeError("Every tile has been read.");
+    }
+    // The tile being handed out and `read_ahead` more are kept in flight.
+    while (next_tile < end_tile && ahead.size() <= read_ahead) {
+      const Index start = std::max(origin, next_tile * tile_size);
+      const Index stop = std::min(exclusive_max, (next_tile + 1) * tile_size);
+      ++next_tile;
+      RangeDescriptor<Index> desc = {dimension, start, stop, 1};
+      auto tile = var.slice(desc);
+      ahead.push_back(tile.ok() ? tile->Read()
+                                : Future<VariableData<T>>(tile.status()));
+    }
+    auto tile = std::move(ahead.front());
+    ahead.pop_front();
+    return tile;
+  }
+
+ private:
+  TileReader(const Variable<T>& var, std::string dimension, Index origin,
+             Index exclusive_max, Index tile_size, std::size_t read_ahead)
+      : var(var),
+        dimension(std::move(dimension)),
+        origin(origin),
+        exclusive_max(exclusive_max),
+        tile_size(tile_size),
+        read_ahead(read_ahead),
+        first_tile(tensorstore::FloorOfRatio(origin, tile_size)),
+        end_tile(exclusive_max > origin
+                     ? tensorstore::FloorOfRatio(exclusive_max - 1, tile_size) +
+                           1
+                     : first_tile),
+        next_tile(first_tile) {}
+
+  Variable<T> var;
+  std::string dimension;
+  Index origin;
+  Index exclusive_max;
+  Index tile_size;
+  std::size_t read_ahead;
+  /// The tiles of the chunk aligned grid the Variable covers.
+  Index first_tile;
+  Index end_tile;
+  /// The next tile to start reading.
+  Index next_tile;
+  /// The tiles read, or being read, and not yet handed out.
+  std::deque<Future<VariableData<T>>> ahead;
+};
+
+}  // namespace mdio
+
+#endif  // MDIO_TILE_READER_H_
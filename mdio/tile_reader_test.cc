@@ -0,0 +1,94 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mdio/tile_reader.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <vector>
+
+#include "mdio/utils/test_fixtures.h"
+
+namespace {
+
+// Opens the Variable with the value x * 100 + y.
+mdio::Result<mdio::Variable<float>> MakeTiled() {
+  return mdio::testing::MakeVariable<float>(
+      mdio::testing::VariableSpec("tiled_variable", {"x", "y"}, {20, 30},
+                                  {8, 16}, "<f4", -1.0),
+      [](const std::vector<mdio::Index>& p) { return p[0] * 100 + p[1]; });
+}
+
+TEST(TileReader, chunkAligned) {
+  auto var = MakeTiled();
+  ASSERT_TRUE(var.ok()) << var.status();
+
+  mdio::RangeDescriptor<mdio::Index> desc = {"x", 5, 20, 1};
+  auto region = var->slice(desc);
+  ASSERT_TRUE(region.ok()) << region.status();
+  auto tiles = mdio::TileReader<float>::Make(region.value(), "x");
+  ASSERT_TRUE(tiles.ok()) << tiles.status();
+  EXPECT_EQ(tiles->num_tiles(), 3);
+
+  // The tiles are cut at the chunk boundaries.
+  std::vector<mdio::Index> origins, sizes;
+  while (!tiles->done()) {
+    auto tile = tiles->Next().result();
+    ASSERT_TRUE(tile.ok()) << tile.status();
+    auto domain = tile->dimensions();
+    origins.push_back(domain.origin()[0]);
+    sizes.push_back(domain.shape()[0]);
+    auto ptr = tile->get_data_accessor().data() + tile->get_flattened_offset();
+    EXPECT_EQ(ptr[0], domain.origin()[0] * 100);
+    EXPECT_EQ(ptr[domain.shape()[0] * 30 - 1],
+              (domain.origin()[0] + domain.shape()[0] - 1) * 100 + 29);
+  }
+  EXPECT_EQ(origins, (std::vector<mdio::Index>{5, 8, 16}));
+  EXPECT_EQ(sizes, (std::vector<mdio::Index>{3, 8, 4}));
+  EXPECT_FALSE(tiles->Next().result().ok());
+
+  std::filesystem::remove_all("tiled_variable");
+}
+
+TEST(TileReader, options) {
+  auto var = MakeTiled();
+  ASSERT_TRUE(var.ok()) << var.status();
+
+  EXPECT_FALSE(mdio::TileReader<float>::Make(var.value(), "z").ok());
+
+  mdio::TileReaderOptions options;
+  options.tile_size = 1;
+  options.read_ahead = 4;
+  auto tiles = mdio::TileReader<float>::Make(var.value(), "y", options);
+  ASSERT_TRUE(tiles.ok()) << tiles.status();
+  EXPECT_EQ(tiles->num_tiles(), 30);
+  mdio::Index count = 0;
+  for (; !tiles->done(); ++count) {
+    auto tile = tiles->Next().result();
+    ASSERT_TRUE(tile.ok()) << tile.status();
+    EXPECT_EQ(tile->num_samples(), 20);
+  }
+  EXPECT_EQ(count, 30);
+
+  // A prefetch is a read that is only kept by the cache.
+  mdio::RangeDescriptor<mdio::Index> desc = {"x", 0, 8, 1};
+  EXPECT_TRUE(var->Prefetch(desc).result().ok());
+  EXPECT_TRUE(var->Prefetch().result().ok());
+
+  std::filesystem::remove_all("tiled_variable");
+}
+
+}  // namespace
@@ -0,0 +1,333 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MDIO_TYPED_DATASET_H_
+#define MDIO_TYPED_DATASET_H_
+
+#include <cctype>
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "mdio/dataset.h"
+#include "mdio/impl.h"
+#include "mdio/variable.h"
+#include "tensorstore/util/future.h"
+
+// clang-format off
+#include <nlohmann/json.hpp>  // NOLINT
+// clang-format on
+
+namespace mdio {
+
+/**
+ * @brief Declares the element type and rank of one Variable of a typed
+ * layout. The declaration derives from it and names the Variable.
+ * @details \b Usage
+ * @code
+ * struct Seismic : mdio::TypedVariable<mdio::dtypes::float32_t, 3> {
+ *   static constexpr const char* name = "seismic";
+ * };
+ * @endcode
+ */
+template <typename T, DimensionIndex R>
+struct TypedVariable {
+  static_assert(R >= 0, "A typed Variable has a static rank.");
+  using element_type = T;
+  static constexpr DimensionIndex rank = R;
+};
+
+namespace internal {
+
+/**
+ * @brief Gets the position of `V` in `Vars`, `sizeof...(Vars)` if it isn't
+ * one of them.
+ */
+template <typename V, typename... Vars>
+constexpr std::size_t TypedIndex() {
+  constexpr bool matches[] = {std::is_same_v<V, Vars>...};
+  for (std::size_t i = 0; i < sizeof...(Vars); ++i) {
+    if (matches[i]) {
+      return i;
+    }
+  }
+  return sizeof...(Vars);
+}
+
+/**
+ * @brief Gets the Variable declared by `V` from a Dataset.
+ * @return The Variable, or an error if it is missing or has another type or
+ * rank.
+ */
+template <typename V>
+Result<Variable<typename V::element_type, V::rank>> BindTypedVariable(
+    const Dataset& dataset) {
+  auto bound =
+      dataset.variables.get<typename V::element_type, V::rank>(V::name);
+  if (!bound.ok() && !absl::IsNotFound(bound.status())) {
+    return absl::Status(bound.status().code(),
+                        std::string("Variable '") + V::name +
+                            "' doesn't match its declaration: " +
+                            std::string(bound.status().message()));
+  }
+  return bound;
+}
+
+/**
+ * @brief Gets the C++ element type of an MDIO data type.
+ * Structured types have no static element type and are `void`.
+ */
+inline Result<std::string> TypedElementName(const ::nlohmann::json& dtype) {
+  if (dtype.is_object()) {
+    return std::string("void");
+  }
+  static const std::unordered_map<std::string, std::string> kElements = {
+      {"int8", "int8_t"},
+      {"int16", "int16_t"},
+      {"int32", "int32_t"},
+      {"int64", "int64_t"},
+      {"uint8", "uint8_t"},
+      {"uint16", "uint16_t"},
+      {"uint32", "uint32_t"},
+      {"uint64", "uint64_t"},
+      {"float16", "float_16_t"},
+      {"float32", "float32_t"},
+      {"float64", "float64_t"},
+      {"complex64", "complex64_t"},
+      {"complex128", "complex128_t"},
+      {"bool", "bool_t"},
+  };
+  auto found = dtype.is_string() ? kElements.find(dtype.get<std::string>())
+                                 : kElements.end();
+  if (found == kElements.end()) {
+    return absl::InvalidArgumentError("Unsupported dataType " + dtype.dump());
+  }
+  return "mdio::dtypes::" + found->second;
+}
+
+/**
+ * @brief Gets the declaration name of a Variable, e.g. "CdpX" for "cdp_x".
+ */
+inline std::string TypedDeclarationName(const std::string& name) {
+  std::string declaration;
+  bool upper = true;
+  for (char c : name) {
+    if (!std::isalnum(static_cast<unsigned char>(c))) {
+      upper = true;
+      continue;
+    }
+    declaration += upper ? static_cast<char>(std::toupper(c)) : c;
+    upper = false;
+  }
+  if (declaration.empty() ||
+      std::isdigit(static_cast<unsigned char>(declaration[0]))) {
+    declaration = "V" + declaration;
+  }
+  return declaration;
+}
+
+}  // namespace internal
+
+/**
+ * @brief A Dataset whose Variables have their element type and rank fixed at
+ * compile time.
+ * The Variables are looked up and checked once, when the view is made. After
+ * that `get`, `Read`, `Write` and `isel` work on `Variable<T, R>` directly,
+ * without type checks or lookups by name.
+ * @details \b Usage
+ * @code
+ * struct Seismic : mdio::TypedVariable<mdio::dtypes::float32_t, 3> {
+ *   static constexpr const char* name = "seismic";
+ * };
+ * struct Inline : mdio::TypedVariable<mdio::dtypes::uint32_t, 1> {
+ *   static constexpr const char* name = "inline";
+ * };
+ * using Survey = mdio::TypedDataset<Seismic, Inline>;
+ *
+ * MDIO_ASSIGN_OR_RETURN(auto survey,
+ *     Survey::Open(path, mdio::constants::kOpen).result());
+ * mdio::RangeDescriptor<mdio::Index> desc = {"inline", 0, 10, 1};
+ * MDIO_ASSIGN_OR_RETURN(auto part, survey.isel(desc));
+ * // A VariableData<float, 3>
+ * MDIO_ASSIGN_OR_RETURN(auto traces, part.Read<Seismic>().result());
+ * @endcode
+ * The declarations can be generated from a schema with `TypedLayoutSource`.
+ * @tparam Vars The declared Variables, see `TypedVariable`.
+ */
+template <typename... Vars>
+class TypedDataset {
+  static_assert(sizeof...(Vars) > 0, "A typed Dataset declares a Variable.");
+
+ public:
+  template <typename V>
+  using variable_type = Variable<typename V::element_type, V::rank>;
+
+  template <typename V>
+  using data_type = VariableData<typename V::element_type, V::rank>;
+
+  /**
+   * @brief Makes the typed view of a Dataset.
+   * @return The view, or an error if a declared Variable is missing or has
+   * another type or rank.
+   */
+  static Result<TypedDataset> FromDataset(const Dataset& dataset) {
+    return Bind(dataset, std::index_sequence_for<Vars...>{});
+  }
+
+  /**
+   * @brief Opens a Dataset, see `Dataset::Open`, and makes its typed view.
+   */
+  template <typename... Option>
+  static Future<TypedDataset> Open(const std::string& dataset_path,
+                                   Option&&... options) {
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [](const Dataset& dataset) { return FromDataset(dataset); },
+        Dataset::Open(dataset_path, std::forward<Option>(options)...));
+  }
+
+  /**
+   * @brief Gets a declared Variable.
+   */
+  template <typename V>
+  const variable_type<V>& get() const {
+    constexpr std::size_t index = internal::TypedIndex<V, Vars...>();
+    static_assert(index < sizeof...(Vars),
+                  "The Variable is not declared by this TypedDataset.");
+    return std::get<index>(variables);
+  }
+
+  /**
+   * @brief Reads a declared Variable, see `Variable::Read`.
+   */
+  template <typename V>
+  Future<data_type<V>> Read() const {
+    auto variable = get<V>();
+    return variable.Read();
+  }
+
+  /**
+   * @brief Writes a declared Variable, see `Variable::Write`.
+   */
+  template <typename V>
+  WriteFutures Write(const data_type<V>& data) const {
+    return get<V>().Write(data);
+  }
+
+  /**
+   * @brief Slices every Variable along the described dimensions, see
+   * `Dataset::isel`. Variables without a described dimension are unchanged.
+   * @return The typed view of the slice.
+   */
+  template <typename... Descriptors>
+  Result<TypedDataset> isel(const Descriptors&... descriptors) const {
+    static_assert(sizeof...(Descriptors) > 0, "No slices provided.");
+    const std::vector<RangeDescriptor<Index>> slices{
+        RangeDescriptor<Index>(descriptors)...};
+    return Slice(slices, std::index_sequence_for<Vars...>{});
+  }
+
+ private:
+  explicit TypedDataset(std::tuple<variable_type<Vars>...> variables)
+      : variables(std::move(variables)) {}
+
+  template <typename Results, std::size_t... I>
+  static Result<TypedDataset> Collect(Results results,
+                                      std::index_sequence<I...>) {
+    absl::Status status;
+    (status.Update(std::get<I>(results).status()), ...);
+    if (!status.ok()) {
+      return status;
+    }
+    return TypedDataset(
+        std::make_tuple(std::move(std::get<I>(results)).value()...));
+  }
+
+  template <std::size_t... I>
+  static Result<TypedDataset> Bind(const Dataset& dataset,
+                                   std::index_sequence<I...> indices) {
+    return Collect(
+        std::make_tuple(internal::BindTypedVariable<Vars>(dataset)...),
+        indices);
+  }
+
+  template <std::size_t... I>
+  Result<TypedDataset> Slice(const std::vector<RangeDescriptor<Index>>& slices,
+                             std::index_sequence<I...> indices) const {
+    return Collect(std::make_tuple(std::get<I>(variables).slice(slices)...),
+                   indices);
+  }
+
+  std::tuple<variable_type<Vars>...> variables;
+};
+
+/**
+ * @brief Generates the `TypedDataset` declarations of a schema, the JSON
+ * given to `Dataset::from_json`, as C++ source.
+ * Each Variable becomes a `TypedVariable` named after it in CamelCase, e.g.
+ * "cdp_x" is `CdpX`, and `layout` is the `TypedDataset` of all of them.
+ * Structured Variables are declared with a `void` element type.
+ * @param schema The Dataset schema.
+ * @param layout The name of the `TypedDataset` alias.
+ * @return The source, or an error if a Variable has an unsupported dataType
+ * or two Variables would get the same declaration name.
+ */
+inline Result<std::string> TypedLayoutSource(const ::nlohmann::json& schema,
+                                             const std::string& layout) {
+  if (!schema.contains("variables") || !schema["variables"].is_array()) {
+    return absl::InvalidArgumentError("The schema has no variables.");
+  }
+  const std::string dataset_name =
+      schema.contains("metadata") ? schema["metadata"].value("name", "") : "";
+  std::ostringstream source;
+  source << "// Generated from the " << dataset_name
+         << " schema by mdio::TypedLayoutSource.\n"
+         << "#include \"mdio/typed_dataset.h\"\n";
+  std::vector<std::string> declarations;
+  std::unordered_set<std::string> seen;
+  for (const auto& variable : schema["variables"]) {
+    const auto name = variable.value("name", "");
+    MDIO_ASSIGN_OR_RETURN(auto element,
+                          internal::TypedElementName(variable["dataType"]))
+    auto declaration = internal::TypedDeclarationName(name);
+    if (!seen.insert(declaration).second) {
+      return absl::InvalidArgumentError(
+          "Variables of the schema share the declaration name " +
+          declaration);
+    }
+    declarations.push_back(declaration);
+    const ::nlohmann::json quoted = name;
+    source << "\nstruct " << declaration << " : mdio::TypedVariable<"
+           << element << ", " << variable["dimensions"].size() << "> {\n"
+           << "  static constexpr const char* name = " << quoted.dump()
+           << ";\n"
+           << "};\n";
+  }
+  source << "\nusing " << layout << " = mdio::TypedDataset<";
+  for (std::size_t i = 0; i < declarations.size(); ++i) {
+    source << (i ? ", " : "") << declarations[i];
+  }
+  source << ">;\n";
+  return source.str();
+}
+
+}  // namespace mdio
+
+#endif  // MDIO_TYPED_DATASET_H_
@@ -0,0 +1,177 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mdio/typed_dataset.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string>
+#include <type_traits>
+
+// clang-format off
+#include <nlohmann/json.hpp>  // NOLINT
+// clang-format on
+
+namespace {
+
+/*NOLINT*/ const std::string kPath = "zarrs/typed.mdio";
+
+const char kSchema[] = R"(
+{
+  "metadata": {
+    "name": "typed",
+    "apiVersion": "1.0.0",
+    "createdOn": "2023-12-12T15:02:06.413469-06:00"
+  },
+  "variables": [
+    {
+      "name": "seismic",
+      "dataType": "float32",
+      "dimensions": [
+        {"name": "inline", "size": 4},
+        {"name": "crossline", "size": 3},
+        {"name": "depth", "size": 2}
+      ],
+      "coordinates": ["cdp_x"]
+    },
+    {
+      "name": "cdp_x",
+      "dataType": "float64",
+      "dimensions": ["inline", "crossline"]
+    },
+    {
+      "name": "inline",
+      "dataType": "uint32",
+      "dimensions": [{"name": "inline", "size": 4}]
+    },
+    {
+      "name": "crossline",
+      "dataType": "uint32",
+      "dimensions": [{"name": "crossline", "size": 3}]
+    },
+    {
+      "name": "depth",
+      "dataType": "uint32",
+      "dimensions": [{"name": "depth", "size": 2}]
+    }
+  ]
+}
+)";
+
+struct Seismic : mdio::TypedVariable<mdio::dtypes::float32_t, 3> {
+  static constexpr const char* name = "seismic";
+};
+struct CdpX : mdio::TypedVariable<mdio::dtypes::float64_t, 2> {
+  static constexpr const char* name = "cdp_x";
+};
+struct Inline : mdio::TypedVariable<mdio::dtypes::uint32_t, 1> {
+  static constexpr const char* name = "inline";
+};
+
+using Survey = mdio::TypedDataset<Seismic, CdpX, Inline>;
+
+static_assert(std::is_same_v<decltype(std::declval<Survey>().get<Seismic>()),
+                             const mdio::Variable<float, 3>&>);
+static_assert(std::is_same_v<decltype(std::declval<Survey>().Read<CdpX>()),
+                             mdio::Future<mdio::VariableData<double, 2>>>);
+
+TEST(TypedDataset, readWrite) {
+  auto schema = ::nlohmann::json::parse(kSchema);
+  ASSERT_TRUE(
+      mdio::Dataset::from_json(schema, kPath, mdio::constants::kCreateClean)
+          .result()
+          .ok());
+  auto survey = Survey::Open(kPath, mdio::constants::kOpen).result();
+  ASSERT_TRUE(survey.ok()) << survey.status();
+
+  auto data = mdio::from_variable<float, 3>(survey->get<Seismic>());
+  ASSERT_TRUE(data.ok()) << data.status();
+  auto samples = data->get_data_accessor();
+  for (mdio::Index il = 0; il < 4; ++il) {
+    for (mdio::Index xl = 0; xl < 3; ++xl) {
+      for (mdio::Index z = 0; z < 2; ++z) {
+        samples(il, xl, z) = static_cast<float>(il * 100 + xl * 10 + z);
+      }
+    }
+  }
+  ASSERT_TRUE(
+      survey->Write<Seismic>(data.value()).commit_future.result().ok());
+
+  mdio::RangeDescriptor<mdio::Index> inlines = {"inline", 1, 3, 1};
+  auto part = survey->isel(inlines);
+  ASSERT_TRUE(part.ok()) << part.status();
+  EXPECT_THAT(part->get<Seismic>().dimensions().shape(),
+              ::testing::ElementsAre(2, 3, 2));
+  EXPECT_THAT(part->get<CdpX>().dimensions().shape(),
+              ::testing::ElementsAre(2, 3));
+  EXPECT_THAT(part->get<Inline>().dimensions().shape(),
+              ::testing::ElementsAre(2));
+
+  auto read = part->Read<Seismic>().result();
+  ASSERT_TRUE(read.ok()) << read.status();
+  auto traces = read->get_data_accessor();
+  // The slice keeps the origin of the Dataset.
+  EXPECT_EQ(traces(1, 2, 1), 121.0f);
+  EXPECT_EQ(traces(2, 0, 0), 200.0f);
+  std::filesystem::remove_all(kPath);
+}
+
+TEST(TypedDataset, mismatch) {
+  auto schema = ::nlohmann::json::parse(kSchema);
+  auto dataset =
+      mdio::Dataset::from_json(schema, kPath, mdio::constants::kCreateClean)
+          .result();
+  ASSERT_TRUE(dataset.ok()) << dataset.status();
+
+  struct WrongType : mdio::TypedVariable<mdio::dtypes::int16_t, 3> {
+    static constexpr const char* name = "seismic";
+  };
+  struct WrongRank : mdio::TypedVariable<mdio::dtypes::float32_t, 2> {
+    static constexpr const char* name = "seismic";
+  };
+  struct Missing : mdio::TypedVariable<mdio::dtypes::float32_t, 3> {
+    static constexpr const char* name = "velocity";
+  };
+  auto type = mdio::TypedDataset<WrongType>::FromDataset(dataset.value());
+  EXPECT_FALSE(type.ok());
+  EXPECT_THAT(std::string(type.status().message()),
+              ::testing::HasSubstr("seismic"));
+  EXPECT_FALSE(
+      mdio::TypedDataset<WrongRank>::FromDataset(dataset.value()).ok());
+  EXPECT_EQ(mdio::TypedDataset<Seismic, Missing>::FromDataset(dataset.value())
+                .status()
+                .code(),
+            absl::StatusCode::kNotFound);
+  std::filesystem::remove_all(kPath);
+}
+
+TEST(TypedDataset, layoutSource) {
+  auto schema = ::nlohmann::json::parse(kSchema);
+  auto source = mdio::TypedLayoutSource(schema, "Survey");
+  ASSERT_TRUE(source.ok()) << source.status();
+  EXPECT_THAT(source.value(),
+              ::testing::HasSubstr(
+                  "struct CdpX : mdio::TypedVariable<mdio::dtypes::float64_t, "
+                  "2> {\n  static constexpr const char* name = \"cdp_x\";\n"));
+  EXPECT_THAT(source.value(),
+              ::testing::HasSubstr("using Survey = mdio::TypedDataset<Seismic, "
+                                   "CdpX, Inline, Crossline, Depth>;\n"));
+
+  schema["variables"][0]["dataType"] = "string";
+  EXPECT_FALSE(mdio::TypedLayoutSource(schema, "Survey").ok());
+}
+
+}  // namespace
@@ -0,0 +1,351 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MDIO_UTILS_COPY_H_
+#define MDIO_UTILS_COPY_H_
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mdio/dataset.h"
+#include "mdio/mapped_read.h"
+#include "mdio/request_policy.h"
+#include "mdio/utils/rechunk.h"
+#include "tensorstore/index_space/dim_expression.h"
+#include "tensorstore/kvstore/kvstore.h"
+#include "tensorstore/kvstore/operations.h"
+
+namespace mdio {
+namespace utils {
+
+/**
+ * @brief Options for `CopyDataset`.
+ */
+struct CopyOptions {
+  /// The maximum number of chunks copied at once. 0 means unbounded.
+  std::size_t max_in_flight = 64;
+  /// Invoked as `progress(done, total)` each time a chunk is copied. The
+  /// calls are serialized but may come from any thread.
+  std::function<void(std::size_t, std::size_t)> progress;
+};
+
+/**
+ * @brief How the chunks of a `CopyDataset` were copied.
+ */
+struct CopyStats {
+  /// Chunks whose stored bytes were copied as they are.
+  std::size_t raw_chunks = 0;
+  /// Chunks that were decoded and encoded again.
+  std::size_t decoded_chunks = 0;
+};
+
+namespace internal {
+
+/**
+ * @brief How the chunk keys of a Variable are formed from their grid cell.
+ */
+struct ChunkKeyFormat {
+  std::string prefix;
+  std::string separator;
+
+  std::string Key(const std::vector<Index>& cell) const {
+    std::string key = prefix;
+    for (std::size_t d = 0; d < cell.size(); ++d) {
+      key += (d ? separator : "") + std::to_string(cell[d]);
+    }
+    return key;
+  }
+};
+
+/**
+ * @brief Gets the chunk key format of a Variable.
+ * @return The format, or nothing if the chunks of the Variable can't be
+ * copied by key: its domain doesn't index the stored array, or it has no
+ * chunked dimensions.
+ */
+template <typename T, DimensionIndex R, ReadWriteMode M>
+std::optional<ChunkKeyFormat> GetChunkKeyFormat(const Variable<T, R, M>& var) {
+  auto spec = var.get_spec();
+  if (!spec.ok() || !mdio::internal::IndexesStoredArray(var)) {
+    return std::nullopt;
+  }
+  const auto metadata = spec->value("metadata", ::nlohmann::json::object());
+  const std::string driver = spec->value("driver", "");
+  if (driver == "zarr") {
+    if (metadata.value("chunks", ::nlohmann::json::array()).empty()) {
+      return std::nullopt;
+    }
+    return ChunkKeyFormat{"", metadata.value("dimension_separator", ".")};
+  }
+  if (driver != "zarr3" ||
+      metadata.value("shape", ::nlohmann::json::array()).empty()) {
+    return std::nullopt;
+  }
+  const auto encoding =
+      metadata.value("chunk_key_encoding", ::nlohmann::json::object());
+  const auto configuration =
+      encoding.value("configuration", ::nlohmann::json::object());
+  if (encoding.value("name", "default") == "v2") {
+    return ChunkKeyFormat{"", configuration.value("separator", ".")};
+  }
+  const std::string separator = configuration.value("separator", "/");
+  return ChunkKeyFormat{"c" + separator, separator};
+}
+
+/**
+ * @brief What the copy of one Variable needs.
+ */
+struct CopyVariable {
+  std::string name;
+  tensorstore::TensorStore<> source;
+  tensorstore::TensorStore<> dest;
+  /// The chunk shape, over the leading dimensions of the domain.
+  std::vector<Index> chunks;
+  /// The shape of the stored array the source is a part of.
+  std::vector<Index> stored_shape;
+  /// Set if the chunks can be copied by key.
+  std::optional<ChunkKeyFormat> keys;
+  /// The grid cells of the destination, in C order.
+  std::vector<Index> cells;
+  /// The first copy task of this Variable.
+  std::size_t first_task = 0;
+};
+
+/// The state shared by the chunk copies of one `CopyDataset`.
+struct CopyState {
+  std::vector<CopyVariable> variables;
+  std::size_t total = 0;
+  std::function<void(std::size_t, std::size_t)> progress;
+  std::mutex mutex;
+  std::size_t done = 0;
+  CopyStats stats;
+};
+
+/**
+ * @brief Tells if a chunk of the destination can be copied from the stored
+ * bytes of the source.
+ * That takes a selection that starts on a chunk boundary, and a chunk that
+ * the selection either holds whole or cuts only where the stored array ends.
+ * A chunk the selection cuts short would otherwise carry samples past the end
+ * of the destination.
+ */
+inline bool IsRawChunk(const CopyVariable& var,
+                       tensorstore::IndexDomainView<> domain,
+                       const std::vector<Index>& cell) {
+  if (!var.keys.has_value()) {
+    return false;
+  }
+  for (std::size_t d = 0; d < var.chunks.size(); ++d) {
+    const Index origin = domain.origin()[d];
+    if (origin % var.chunks[d] != 0) {
+      return false;
+    }
+    const Index end = std::min((cell[d] + 1) * var.chunks[d],
+                               domain.shape()[d]);
+    const bool cut = end < (cell[d] + 1) * var.chunks[d];
+    if (cut && origin + domain.shape()[d] != var.stored_shape[d]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Copies one chunk of the destination, by key when it can, and
+ * counts how it was copied.
+ */
+inline Future<void> CopyChunk(std::shared_ptr<CopyState> state,
+                              std::size_t task) {
+  std::size_t v = 0;
+  while (v + 1 < state->variables.size() &&
+         state->variables[v + 1].first_task <= task) {
+    ++v;
+  }
+  const CopyVariable& var = state->variables[v];
+  const auto domain = var.source.domain();
+  const std::size_t k = var.chunks.size();
+  std::vector<Index> cell(k);
+  Index rest = task - var.first_task;
+  for (std::size_t d = k; d-- > 0;) {
+    cell[d] = rest % var.cells[d];
+    rest /= var.cells[d];
+  }
+
+  const auto count = [state](bool raw) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    ++(raw ? state->stats.raw_chunks : state->stats.decoded_chunks);
+    ++state->done;
+    if (state->progress) {
+      state->progress(state->done, state->total);
+    }
+  };
+
+  if (IsRawChunk(var, domain, cell)) {
+    std::vector<Index> source_cell(k);
+    for (std::size_t d = 0; d < k; ++d) {
+      source_cell[d] = domain.origin()[d] / var.chunks[d] + cell[d];
+    }
+    auto dest_kvs = var.dest.kvstore();
+    auto dest_key = var.keys->Key(cell);
+    auto read = mdio::internal::PolicyRead(var.source.kvstore(),
+                                           var.keys->Key(source_cell));
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [dest_kvs, dest_key, count](
+            const tensorstore::kvstore::ReadResult& stored) -> Future<void> {
+          // A chunk that was never written stays unwritten.
+          if (!stored.has_value()) {
+            count(true);
+            return absl::OkStatus();
+          }
+          return tensorstore::MapFutureValue(
+              tensorstore::InlineExecutor{},
+              [count](const tensorstore::TimestampedStorageGeneration&) {
+                count(true);
+              },
+              tensorstore::kvstore::Write(dest_kvs, dest_key, stored.value));
+        },
+        std::move(read));
+  }
+
+  // The region of the chunk, in the coordinates of the source. Trailing
+  // dimensions, such as the bytes of a structured type, are copied whole.
+  tensorstore::Box<> box(domain.rank());
+  std::vector<Index> dest_origin(domain.rank(), 0);
+  for (DimensionIndex d = 0; d < domain.rank(); ++d) {
+    box.origin()[d] = domain.origin()[d];
+    box.shape()[d] = domain.shape()[d];
+    if (static_cast<std::size_t>(d) < k) {
+      const Index start = cell[d] * var.chunks[d];
+      box.origin()[d] += start;
+      box.shape()[d] = std::min(var.chunks[d], domain.shape()[d] - start);
+      dest_origin[d] = start;
+    }
+  }
+  MDIO_ASSIGN_OR_RETURN(auto source_chunk,
+                        var.source | tensorstore::AllDims().BoxSlice(box))
+  MDIO_ASSIGN_OR_RETURN(
+      auto dest_chunk,
+      var.dest |
+          tensorstore::AllDims().SizedInterval(dest_origin, box.shape()) |
+          tensorstore::AllDims().TranslateTo(box.origin()))
+  auto written = tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [dest_chunk](const tensorstore::SharedOffsetArray<void>& samples) {
+        return tensorstore::Write(samples, dest_chunk).commit_future;
+      },
+      tensorstore::Read(source_chunk));
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{}, [count]() { count(false); },
+      std::move(written));
+}
+
+}  // namespace internal
+
+/**
+ * @brief Copies a Dataset, or a selection of one, to a new place.
+ * The copy keeps the codecs and chunk grid of every Variable. Where a
+ * selection starts on chunk boundaries, the stored chunks are copied as they
+ * are, without decoding and encoding them again, and only the metadata is
+ * written anew. Chunks the selection cuts short, and Variables whose
+ * selection doesn't start on a chunk boundary or is strided, are decoded and
+ * written again.
+ * @details \b Usage
+ * @code
+ * MDIO_ASSIGN_OR_RETURN(
+ *     auto survey,
+ *     mdio::Dataset::Open("gs://a/survey.mdio", mdio::constants::kOpen)
+ *         .result())
+ * mdio::RangeDescriptor<mdio::Index> inlines = {"inline", 256, 512, 1};
+ * MDIO_ASSIGN_OR_RETURN(auto part, survey.isel(inlines))
+ * auto copied = mdio::utils::CopyDataset(part, "s3://b/part.mdio");
+ * @endcode
+ * @param source The Dataset to copy.
+ * @param dest_path The path to copy it to. A Dataset already there is
+ * replaced.
+ * @param options How many chunks to copy at once.
+ * @return A future of how the chunks were copied.
+ */
+inline Future<CopyStats> CopyDataset(const Dataset& source,
+                                     const std::string& dest_path,
+                                     const CopyOptions& options = {}) {
+  auto state = std::make_shared<internal::CopyState>();
+  state->progress = options.progress;
+  std::vector<nlohmann::json> specs;
+  for (const auto& name : source.variables.get_keys()) {
+    MDIO_ASSIGN_OR_RETURN(auto var, source.variables.at(name))
+    MDIO_ASSIGN_OR_RETURN(auto spec, internal::CopySpec(var, dest_path))
+    MDIO_ASSIGN_OR_RETURN(auto chunks, var.get_chunk_shape())
+    internal::CopyVariable copy;
+    copy.name = name;
+    copy.source = var.get_store();
+    copy.chunks.assign(chunks.begin(), chunks.end());
+    copy.keys = internal::GetChunkKeyFormat(var);
+    const auto domain = copy.source.domain();
+    if (copy.chunks.size() > static_cast<std::size_t>(domain.rank())) {
+      return absl::InvalidArgumentError("The chunks of '" + name +
+                                        "' don't match its dimensions.");
+    }
+    // The stored array keeps its shape, the copy takes the selection's.
+    auto& metadata = spec["metadata"];
+    copy.stored_shape = metadata["shape"].get<std::vector<Index>>();
+    std::vector<Index> shape(domain.shape().begin(),
+                             domain.shape().begin() + copy.chunks.size());
+    metadata["shape"] = shape;
+    copy.first_task = state->total;
+    std::size_t cells = 1;
+    for (std::size_t d = 0; d < copy.chunks.size(); ++d) {
+      copy.cells.push_back((shape[d] + copy.chunks[d] - 1) / copy.chunks[d]);
+      cells *= copy.cells.back();
+    }
+    state->total += cells;
+    state->variables.push_back(std::move(copy));
+    specs.push_back(std::move(spec));
+  }
+
+  auto created = mdio::Dataset::Open(source.getMetadata(), specs,
+                                     mdio::constants::kCreateClean);
+  const std::size_t max_in_flight = options.max_in_flight;
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [state, max_in_flight](const Dataset& dest) -> Future<CopyStats> {
+        for (auto& var : state->variables) {
+          MDIO_ASSIGN_OR_RETURN(auto dest_var, dest.variables.at(var.name))
+          var.dest = dest_var.get_store();
+        }
+        auto copied = mdio::internal::ForEachBounded(
+            state->total, max_in_flight, [state](std::size_t task) {
+              return internal::CopyChunk(state, task);
+            });
+        return tensorstore::MapFutureValue(
+            tensorstore::InlineExecutor{},
+            [state]() {
+              std::lock_guard<std::mutex> lock(state->mutex);
+              return state->stats;
+            },
+            std::move(copied));
+      },
+      std::move(created));
+}
+
+}  // namespace utils
+}  // namespace mdio
+
+#endif  // MDIO_UTILS_COPY_H_
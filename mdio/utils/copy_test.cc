@@ -0,0 +1,124 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mdio/utils/copy.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "mdio/utils/test_fixtures.h"
+
+namespace {
+
+/*NOLINT*/ const std::string kSourcePath = "zarrs/testing/original.mdio";
+/*NOLINT*/ const std::string kDestPath = "zarrs/testing/copied.mdio";
+
+// Creates the source, seismic holds the position of each sample.
+mdio::Result<mdio::Dataset> MakeSource() {
+  return mdio::testing::MakeSeismicDataset(
+      kSourcePath,
+      mdio::testing::SeismicSchema({8, 6, 10}, {4, 3, 10}, {4, 3, 10}));
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+std::vector<float> ReadSeismic(const std::string& path) {
+  return mdio::testing::ReadSeismic(path).value();
+}
+
+TEST(CopyDataset, wholeDatasetByKey) {
+  auto source = MakeSource();
+  ASSERT_TRUE(source.ok()) << source.status();
+  std::size_t last = 0;
+  mdio::utils::CopyOptions options;
+  options.progress = [&last](std::size_t done, std::size_t) { last = done; };
+  auto stats =
+      mdio::utils::CopyDataset(source.value(), kDestPath, options).result();
+  ASSERT_TRUE(stats.ok()) << stats.status();
+  // 4 chunks of seismic, 2 + 2 + 1 of the coordinates.
+  EXPECT_EQ(stats->raw_chunks, 9);
+  EXPECT_EQ(stats->decoded_chunks, 0);
+  EXPECT_EQ(last, 9);
+  // The compressed chunk is copied byte for byte.
+  const std::string chunk = "/seismic/1/1/0";
+  EXPECT_EQ(ReadFile(kDestPath + chunk), ReadFile(kSourcePath + chunk));
+  EXPECT_EQ(ReadSeismic(kDestPath), ReadSeismic(kSourcePath));
+  std::filesystem::remove_all(kSourcePath);
+  std::filesystem::remove_all(kDestPath);
+}
+
+TEST(CopyDataset, alignedSelection) {
+  auto source = MakeSource();
+  ASSERT_TRUE(source.ok()) << source.status();
+  mdio::RangeDescriptor<mdio::Index> inlines = {"inline", 4, 8, 1};
+  mdio::RangeDescriptor<mdio::Index> crosslines = {"crossline", 0, 5, 1};
+  auto part = source->isel(inlines, crosslines);
+  ASSERT_TRUE(part.ok()) << part.status();
+  auto stats = mdio::utils::CopyDataset(part.value(), kDestPath).result();
+  ASSERT_TRUE(stats.ok()) << stats.status();
+  // The selection cuts the second crossline chunk of seismic and of the
+  // crossline coordinate short, those are decoded.
+  EXPECT_EQ(stats->raw_chunks, 4);
+  EXPECT_EQ(stats->decoded_chunks, 2);
+
+  auto dest = mdio::Dataset::Open(kDestPath, mdio::constants::kOpen).result();
+  ASSERT_TRUE(dest.ok()) << dest.status();
+  auto seismic = dest->variables.at("seismic");
+  ASSERT_TRUE(seismic.ok()) << seismic.status();
+  EXPECT_THAT(seismic->dimensions().shape(), ::testing::ElementsAre(4, 5, 10));
+  auto copied = ReadSeismic(kDestPath);
+  ASSERT_EQ(copied.size(), 4 * 5 * 10);
+  for (int il = 0; il < 4; ++il) {
+    for (int xl = 0; xl < 5; ++xl) {
+      for (int z = 0; z < 10; ++z) {
+        EXPECT_EQ(copied[(il * 5 + xl) * 10 + z],
+                  static_cast<float>(((il + 4) * 6 + xl) * 10 + z));
+      }
+    }
+  }
+  std::filesystem::remove_all(kSourcePath);
+  std::filesystem::remove_all(kDestPath);
+}
+
+TEST(CopyDataset, unalignedSelection) {
+  auto source = MakeSource();
+  ASSERT_TRUE(source.ok()) << source.status();
+  mdio::RangeDescriptor<mdio::Index> inlines = {"inline", 1, 5, 1};
+  auto part = source->isel(inlines);
+  ASSERT_TRUE(part.ok()) << part.status();
+  auto stats = mdio::utils::CopyDataset(part.value(), kDestPath).result();
+  ASSERT_TRUE(stats.ok()) << stats.status();
+  // Seismic and inline are decoded, crossline and depth are copied by key.
+  EXPECT_EQ(stats->decoded_chunks, 2 + 1);
+  EXPECT_EQ(stats->raw_chunks, 2 + 1);
+  auto copied = ReadSeismic(kDestPath);
+  ASSERT_EQ(copied.size(), 4 * 6 * 10);
+  EXPECT_EQ(copied.front(), 60.0f);
+  EXPECT_EQ(copied.back(), 299.0f);
+  std::filesystem::remove_all(kSourcePath);
+  std::filesystem::remove_all(kDestPath);
+}
+
+}  // namespace
@@ -15,65 +15,201 @@
 #ifndef MDIO_UTILS_DELETE_H_
 #define MDIO_UTILS_DELETE_H_
 
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "mdio/dataset.h"
+#include "tensorstore/kvstore/key_range.h"
 #include "tensorstore/kvstore/kvstore.h"
+#include "tensorstore/kvstore/operations.h"
 
 namespace mdio {
 namespace utils {
 
 /**
- * @brief A utility to delete an MDIO dataset
- * It will first be checked that the dataset is a valid MDIO dataset before
- * deletion. This is intended to provide a safe interface to delete MDIO
- * datasets.
- * @param dataset_path The path to the dataset
- * @return OK result if the dataset was valid and deleted successfully,
- * otherwise an error result
+ * @brief Options for `DeleteDataset`.
  */
-Result<void> DeleteDataset(const std::string dataset_path) {
-  // Open the dataset
-  // This is to ensure that what is getting deleted by MDIO is a valid MDIO
-  // dataset itself.
-  auto dsRes = mdio::Dataset::Open(dataset_path, mdio::constants::kOpen);
-  if (!dsRes.status().ok()) {
-    return dsRes.status();
-  }
-  auto ds = dsRes.value();
-
-  // Pick the arbitrarially first Variable in the dataset as the base KVStore
-  // template
-  MDIO_ASSIGN_OR_RETURN(auto var,
-                        ds.variables.at(ds.variables.get_keys().front()))
-  MDIO_ASSIGN_OR_RETURN(auto spec, var.get_spec())
-  nlohmann::json kvs = spec["kvstore"];
-
-  // Drop the Variable path from the KVStore path. This is will leave us with
-  // the full Dataset
-  std::size_t pos =
-      kvs["path"].get<std::string>().rfind(var.get_variable_name());
-  std::string path = kvs["path"].get<std::string>().substr(0, pos - 1);
-  if (path.back() == '/') {
-    // Handle case where the variable is double slashed
-    path.pop_back();
+struct DeleteOptions {
+  /// The maximum number of key ranges deleted at once. 0 means unbounded.
+  std::size_t max_in_flight = 64;
+  /// Invoked as `progress(done, total)` each time a key range is deleted. The
+  /// calls are serialized but may come from any thread.
+  std::function<void(std::size_t, std::size_t)> progress;
+};
+
+namespace internal {
+
+/**
+ * @brief Partitions the chunk keys of the arrays in a consolidated metadata.
+ * Each array with more than one dimension is split into one key prefix per
+ * chunk index along its first dimension, so the deletions can run in
+ * parallel without listing the whole Dataset up front.
+ * @param zmetadata The contents of .zmetadata, if any.
+ * @param zarr_json The contents of the root zarr.json, if any.
+ * @return The key ranges, or an error if neither describes an MDIO Dataset.
+ */
+inline Result<std::vector<tensorstore::KeyRange>> DatasetChunkRanges(
+    const tensorstore::kvstore::ReadResult& zmetadata,
+    const tensorstore::kvstore::ReadResult& zarr_json) {
+  struct Array {
+    std::string chunk_prefix;
+    std::string separator;
+    std::vector<uint64_t> shape;
+    std::vector<uint64_t> chunks;
+  };
+  std::vector<Array> arrays;
+  try {
+    if (zmetadata.has_value()) {
+      auto json = nlohmann::json::parse(std::string(zmetadata.value));
+      if (!json.contains("metadata") ||
+          !json["metadata"].contains(".zattrs")) {
+        return absl::InvalidArgumentError(
+            "zmetadata does not contain dataset metadata.");
+      }
+      const std::string suffix = "/.zarray";
+      for (auto& item : json["metadata"].items()) {
+        const auto& key = item.key();
+        if (key.size() <= suffix.size() ||
+            key.compare(key.size() - suffix.size(), suffix.size(), suffix)) {
+          continue;
+        }
+        arrays.push_back(
+            {key.substr(0, key.size() - suffix.size()) + "/",
+             item.value().value("dimension_separator", "."),
+             item.value()["shape"].get<std::vector<uint64_t>>(),
+             item.value()["chunks"].get<std::vector<uint64_t>>()});
+      }
+    } else if (zarr_json.has_value()) {
+      auto json = nlohmann::json::parse(std::string(zarr_json.value));
+      if (!json.contains("consolidated_metadata") ||
+          !json["consolidated_metadata"].contains("metadata")) {
+        return absl::InvalidArgumentError(
+            "zarr.json does not contain consolidated metadata.");
+      }
+      for (auto& item : json["consolidated_metadata"]["metadata"].items()) {
+        const auto& array = item.value();
+        if (array.value("node_type", "") != "array") {
+          continue;
+        }
+        // The default chunk key encoding is "c/0/0/0".
+        arrays.push_back(
+            {item.key() + "/c/", "/",
+             array["shape"].get<std::vector<uint64_t>>(),
+             array["chunk_grid"]["configuration"]["chunk_shape"]
+                 .get<std::vector<uint64_t>>()});
+      }
+    } else {
+      return absl::NotFoundError(
+          "No .zmetadata or zarr.json found, the path is not an MDIO "
+          "Dataset.");
+    }
+  } catch (const nlohmann::json::exception& e) {
+    return absl::InvalidArgumentError(e.what());
   }
-  kvs["path"] = path;
 
-  auto kvsFuture = tensorstore::kvstore::Open(kvs);
-  if (!kvsFuture.status().ok()) {
-    return kvsFuture.status();
+  std::vector<tensorstore::KeyRange> ranges;
+  for (const auto& array : arrays) {
+    if (array.shape.size() < 2 || array.chunks.size() != array.shape.size() ||
+        array.chunks[0] == 0) {
+      ranges.push_back(tensorstore::KeyRange::Prefix(array.chunk_prefix));
+      continue;
+    }
+    const uint64_t num_chunks =
+        (array.shape[0] + array.chunks[0] - 1) / array.chunks[0];
+    for (uint64_t i = 0; i < num_chunks; ++i) {
+      ranges.push_back(tensorstore::KeyRange::Prefix(
+          array.chunk_prefix + std::to_string(i) + array.separator));
+    }
   }
-  auto kvstore = kvsFuture.value();
+  return ranges;
+}
+
+}  // namespace internal
 
-  auto deleteRes = tensorstore::kvstore::DeleteRange(kvstore, {});
-  if (!deleteRes.status().ok()) {
-    return deleteRes.status();
+/**
+ * @brief A utility to delete an MDIO dataset
+ * It will first be checked that the dataset is a valid MDIO dataset before
+ * deletion, which only requires its consolidated metadata. This is intended to
+ * provide a safe interface to delete MDIO datasets.
+ * The chunks are deleted concurrently, partitioned by their first chunk index,
+ * and the metadata is removed last so an interrupted deletion can be retried.
+ * @param dataset_path The path to the dataset
+ * @param options The concurrency and progress reporting of the deletion.
+ * @details \b Usage
+ * @code
+ * mdio::utils::DeleteOptions options;
+ * options.progress = [](std::size_t done, std::size_t total) {
+ *   std::cout << done << " / " << total << std::endl;
+ * };
+ * auto deleted =
+ *     mdio::utils::DeleteDataset("s3://bucket/survey.mdio", options);
+ * @endcode
+ * @return A future that is OK if the dataset was valid and deleted
+ * successfully, otherwise an error
+ */
+Future<void> DeleteDataset(const std::string dataset_path,
+                           const DeleteOptions& options = {}) {
+  // The kvstore is a prefix, keys only land inside the Dataset with a slash.
+  std::string path = dataset_path;
+  if (path.empty() || path.back() != '/') {
+    path += '/';
   }
 
-  return absl::OkStatus();
+  struct Progress {
+    std::mutex mutex;
+    std::size_t done = 0;
+  };
+
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [options](const tensorstore::KvStore& kvs) -> Future<void> {
+        auto zmetadata = tensorstore::kvstore::Read(kvs, ".zmetadata");
+        auto zarr_json = tensorstore::kvstore::Read(kvs, "zarr.json");
+        return tensorstore::MapFutureValue(
+            tensorstore::InlineExecutor{},
+            [kvs, options](const tensorstore::kvstore::ReadResult& v2,
+                           const tensorstore::kvstore::ReadResult& v3)
+                -> Future<void> {
+              MDIO_ASSIGN_OR_RETURN(auto ranges,
+                                    internal::DatasetChunkRanges(v2, v3))
+              auto shared_ranges =
+                  std::make_shared<std::vector<tensorstore::KeyRange>>(
+                      std::move(ranges));
+              auto progress = std::make_shared<Progress>();
+              const std::size_t total = shared_ranges->size();
+              auto chunks_deleted = mdio::internal::ForEachBounded(
+                  total, options.max_in_flight,
+                  [kvs, options, shared_ranges, progress,
+                   total](std::size_t i) -> Future<void> {
+                    auto deleted = tensorstore::kvstore::DeleteRange(
+                        kvs, (*shared_ranges)[i]);
+                    if (!options.progress) {
+                      return deleted;
+                    }
+                    return tensorstore::MapFutureValue(
+                        tensorstore::InlineExecutor{},
+                        [options, progress, total]() {
+                          std::lock_guard<std::mutex> lock(progress->mutex);
+                          options.progress(++progress->done, total);
+                        },
+                        std::move(deleted));
+                  });
+              // Sweep up the metadata and anything the partitions missed.
+              return tensorstore::MapFutureValue(
+                  tensorstore::InlineExecutor{},
+                  [kvs]() {
+                    return tensorstore::kvstore::DeleteRange(kvs, {});
+                  },
+                  std::move(chunks_deleted));
+            },
+            std::move(zmetadata), std::move(zarr_json));
+      },
+      mdio::internal::dataset_kvs_store(path));
 }
 
 }  // namespace utils
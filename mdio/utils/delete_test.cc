@@ -17,6 +17,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <filesystem>
+#include <fstream>
 #include <string>
 
 // clang-format off
@@ -181,6 +183,35 @@ TEST(DeleteDataset, delLocal) {
   EXPECT_FALSE(dsRes.status().ok()) << dsRes.status();
 }
 
+TEST(DeleteDataset, progress) {
+  ASSERT_TRUE(SETUP(kTestPath).status().ok());
+  std::size_t last_done = 0;
+  std::size_t last_total = 0;
+  mdio::utils::DeleteOptions options;
+  options.max_in_flight = 2;
+  options.progress = [&](std::size_t done, std::size_t total) {
+    EXPECT_EQ(done, last_done + 1);
+    last_done = done;
+    last_total = total;
+  };
+  auto res = mdio::utils::DeleteDataset(kTestPath, options);
+  ASSERT_TRUE(res.status().ok()) << res.status();
+  EXPECT_GT(last_total, 1);
+  EXPECT_EQ(last_done, last_total);
+  EXPECT_FALSE(std::filesystem::exists(kTestPath + "/.zmetadata"));
+}
+
+TEST(DeleteDataset, notMdio) {
+  const std::string path = "zarrs/testing/not_mdio";
+  std::filesystem::create_directories(path);
+  std::ofstream(path + "/keep.txt") << "not an MDIO dataset";
+  auto res = mdio::utils::DeleteDataset(path);
+  EXPECT_FALSE(res.status().ok());
+  // Nothing was deleted.
+  EXPECT_TRUE(std::filesystem::exists(path + "/keep.txt"));
+  std::filesystem::remove_all(path);
+}
+
 TEST(DeleteDataset, delGCS) {
   if (GCS_PATH == "gs://USER_BUCKET") {
     GTEST_SKIP() << "Skipping GCS deletion test.\nTo enable, please update the "
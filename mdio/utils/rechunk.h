@@ -0,0 +1,506 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MDIO_UTILS_RECHUNK_H_
+#define MDIO_UTILS_RECHUNK_H_
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "mdio/dataset.h"
+#include "tensorstore/index_space/dim_expression.h"
+#include "tensorstore/kvstore/key_range.h"
+#include "tensorstore/kvstore/kvstore.h"
+#include "tensorstore/kvstore/operations.h"
+
+namespace mdio {
+namespace utils {
+
+/**
+ * @brief Options for `Rechunk`.
+ */
+struct RechunkOptions {
+  /// The new chunk shape of each Variable, by name. Variables that aren't
+  /// named keep their chunk shape.
+  std::unordered_map<std::string, std::vector<Index>> chunks;
+  /// The most bytes staged at once, over all of the blocks in flight.
+  std::size_t memory_budget = std::size_t{1} << 30;
+  /// The maximum number of blocks copied at once. 0 means one per hardware
+  /// thread.
+  std::size_t max_in_flight = 0;
+  /// Continues a copy into the destination that an earlier call with the same
+  /// source and chunks left unfinished, rather than starting over.
+  bool resume = true;
+  /// Invoked as `progress(done, total)` each time a block is copied. The
+  /// calls are serialized but may come from any thread.
+  std::function<void(std::size_t, std::size_t)> progress;
+};
+
+namespace internal {
+
+/// Where an unfinished copy keeps its plan and the blocks it has copied.
+constexpr char kRechunkPrefix[] = ".zrechunk/";
+
+/**
+ * @brief Picks the shape of the blocks one Variable is copied in.
+ * A block spans the least common multiple of the source and destination
+ * chunks, so every chunk is read and written once, whole. Blocks over the
+ * budget are halved along the dimension with the most destination chunks,
+ * which reads some source chunks more than once but still writes whole
+ * chunks. A block is never smaller than one destination chunk.
+ * @param shape The shape of the Variable, dimensions past the chunk rank are
+ * kept whole.
+ * @param source_chunks The chunk shape of the source.
+ * @param dest_chunks The chunk shape of the destination.
+ * @param item_bytes The size of one element.
+ * @param budget The most bytes one block may hold.
+ * @return The block shape.
+ */
+inline std::vector<Index> RechunkBlockShape(
+    const std::vector<Index>& shape, const std::vector<Index>& source_chunks,
+    const std::vector<Index>& dest_chunks, Index item_bytes,
+    std::size_t budget) {
+  const std::size_t rank = dest_chunks.size();
+  std::vector<Index> block = shape;
+  for (std::size_t d = 0; d < rank; ++d) {
+    block[d] = std::min(std::lcm(source_chunks[d], dest_chunks[d]), shape[d]);
+  }
+  // Empty dimensions still have one (empty) block.
+  for (Index& extent : block) {
+    extent = std::max<Index>(extent, 1);
+  }
+  const auto bytes = [&block, item_bytes]() {
+    Index total = item_bytes;
+    for (Index extent : block) {
+      total *= extent;
+    }
+    return total;
+  };
+  while (bytes() > static_cast<Index>(budget)) {
+    std::size_t widest = rank;
+    Index most = 1;
+    for (std::size_t d = 0; d < rank; ++d) {
+      const Index count = (block[d] + dest_chunks[d] - 1) / dest_chunks[d];
+      if (count > most) {
+        widest = d;
+        most = count;
+      }
+    }
+    if (widest == rank) {
+      break;
+    }
+    block[widest] = (most / 2) * dest_chunks[widest];
+  }
+  return block;
+}
+
+/**
+ * @brief Gets the region of a Variable that one block covers.
+ * Blocks are numbered in C order.
+ */
+inline tensorstore::Box<> RechunkBlock(tensorstore::IndexDomainView<> domain,
+                                       const std::vector<Index>& block,
+                                       Index index) {
+  const DimensionIndex rank = domain.rank();
+  tensorstore::Box<> box(rank);
+  for (DimensionIndex d = rank - 1; d >= 0; --d) {
+    const Index count = (domain.shape()[d] + block[d] - 1) / block[d];
+    const Index start = (index % count) * block[d];
+    index /= count;
+    box.origin()[d] = domain.origin()[d] + start;
+    box.shape()[d] = std::min(block[d], domain.shape()[d] - start);
+  }
+  return box;
+}
+
+/// The number of blocks of a Variable.
+inline Index RechunkBlockCount(tensorstore::IndexDomainView<> domain,
+                               const std::vector<Index>& block) {
+  Index count = 1;
+  for (DimensionIndex d = 0; d < domain.rank(); ++d) {
+    count *= (domain.shape()[d] + block[d] - 1) / block[d];
+  }
+  return count;
+}
+
+/**
+ * @brief Plans the copy of a Dataset into new chunks.
+ * The plan is stored with an unfinished copy. A later call only resumes it if
+ * its own plan has the same source and chunks.
+ * @return A JSON object with the "source" path and the "chunks" and "blocks"
+ * of every Variable.
+ */
+inline Result<nlohmann::json> PlanRechunk(const Dataset& source,
+                                          const std::string& source_path,
+                                          const RechunkOptions& options) {
+  std::size_t max_in_flight = options.max_in_flight;
+  if (max_in_flight == 0) {
+    max_in_flight = std::max(1u, std::thread::hardware_concurrency());
+  }
+  const std::size_t budget = options.memory_budget / max_in_flight;
+  for (const auto& [name, unused] : options.chunks) {
+    if (!source.variables.at(name).ok()) {
+      return absl::NotFoundError("There is no Variable '" + name +
+                                 "' to rechunk.");
+    }
+  }
+
+  nlohmann::json plan = {{"source", source_path},
+                         {"chunks", nlohmann::json::object()},
+                         {"blocks", nlohmann::json::object()}};
+  for (const auto& name : source.variables.get_keys()) {
+    MDIO_ASSIGN_OR_RETURN(auto var, source.variables.at(name))
+    MDIO_ASSIGN_OR_RETURN(auto source_chunks, var.get_chunk_shape())
+    std::vector<Index> dest_chunks(source_chunks.begin(), source_chunks.end());
+    auto requested = options.chunks.find(name);
+    if (requested != options.chunks.end()) {
+      dest_chunks = requested->second;
+      if (dest_chunks.size() != source_chunks.size()) {
+        return absl::InvalidArgumentError(
+            "The chunks of '" + name + "' need " +
+            std::to_string(source_chunks.size()) + " dimensions.");
+      }
+      for (Index extent : dest_chunks) {
+        if (extent <= 0) {
+          return absl::InvalidArgumentError(
+              "The chunks of '" + name + "' must be positive.");
+        }
+      }
+    }
+    const auto domain = var.get_store().domain();
+    std::vector<Index> shape(domain.shape().begin(), domain.shape().end());
+    std::vector<Index> chunks(source_chunks.begin(), source_chunks.end());
+    plan["chunks"][name] = dest_chunks;
+    plan["blocks"][name] = RechunkBlockShape(
+        shape, chunks, dest_chunks, var.get_store().dtype().size(), budget);
+  }
+  return plan;
+}
+
+/**
+ * @brief Gets the kvstore of one Variable of the Dataset at `dataset_path`.
+ * Paths are handled as by `Dataset::Open`.
+ */
+inline nlohmann::json VariableKvstore(std::string dataset_path,
+                                      const std::string& name) {
+  while (!dataset_path.empty() && dataset_path.back() == '/') {
+    dataset_path.pop_back();
+  }
+  std::string driver = "file";
+  if (absl::StartsWith(dataset_path, "gs://")) {
+    driver = "gcs";
+  } else if (absl::StartsWith(dataset_path, "s3://")) {
+    driver = "s3";
+  }
+  if (driver == "file") {
+    return {{"driver", driver}, {"path", dataset_path + "/" + name}};
+  }
+  std::string bucket_and_path = dataset_path.substr(5);
+  const std::size_t slash = bucket_and_path.find('/');
+  std::string path = slash == std::string::npos
+                         ? name
+                         : bucket_and_path.substr(slash + 1) + "/" + name;
+  return {{"driver", driver},
+          {"bucket", bucket_and_path.substr(0, slash)},
+          {"path", path}};
+}
+
+/**
+ * @brief Gets the spec that creates a copy of a Variable, with its
+ * attributes, in the Dataset at `dest_path`.
+ */
+inline Result<nlohmann::json> CopySpec(const Variable<>& var,
+                                       const std::string& dest_path) {
+  MDIO_ASSIGN_OR_RETURN(auto spec, mdio::internal::variable_zmetadata_json(var))
+  spec["kvstore"] = VariableKvstore(dest_path, var.get_variable_name());
+  return spec;
+}
+
+/**
+ * @brief Gets the specs that create the Variables of the destination.
+ * Each is the spec of the source Variable, with its attributes, in the new
+ * place and chunks.
+ */
+inline Result<std::vector<nlohmann::json>> RechunkSpecs(
+    const Dataset& source, const nlohmann::json& plan,
+    const std::string& dest_path) {
+  std::vector<nlohmann::json> specs;
+  for (const auto& name : source.variables.get_keys()) {
+    MDIO_ASSIGN_OR_RETURN(auto var, source.variables.at(name))
+    MDIO_ASSIGN_OR_RETURN(auto spec, CopySpec(var, dest_path))
+    auto& metadata = spec["metadata"];
+    if (mdio::internal::IsZarr3(spec)) {
+      for (const auto& codec : metadata.value("codecs", nlohmann::json())) {
+        if (codec.value("name", "") == "sharding_indexed") {
+          return absl::UnimplementedError("Rechunking the sharded Variable '" +
+                                          name + "' is not supported.");
+        }
+      }
+      metadata["chunk_grid"]["configuration"]["chunk_shape"] =
+          plan["chunks"][name];
+    } else {
+      metadata["chunks"] = plan["chunks"][name];
+    }
+    specs.push_back(std::move(spec));
+  }
+  return specs;
+}
+
+/// The state shared by the block copies of one `Rechunk`.
+struct RechunkState {
+  RechunkState(Dataset source, Dataset dest, tensorstore::KvStore kvs)
+      : source(std::move(source)),
+        dest(std::move(dest)),
+        kvs(std::move(kvs)) {}
+
+  Dataset source;
+  Dataset dest;
+  tensorstore::KvStore kvs;
+  /// The Variable and the block index of every block that is left to copy.
+  std::vector<std::pair<std::string, Index>> blocks;
+  std::unordered_map<std::string, std::vector<Index>> block_shapes;
+  std::function<void(std::size_t, std::size_t)> progress;
+  std::mutex mutex;
+  std::size_t done = 0;
+  std::size_t total = 0;
+};
+
+inline std::string RechunkMarker(const std::string& name, Index block) {
+  return std::string(kRechunkPrefix) + name + "/" + std::to_string(block);
+}
+
+/**
+ * @brief Copies one block and records it as done.
+ */
+inline Future<void> CopyRechunkBlock(std::shared_ptr<RechunkState> state,
+                                     std::size_t i) {
+  const auto& [name, index] = state->blocks[i];
+  MDIO_ASSIGN_OR_RETURN(auto source_var, state->source.variables.at(name))
+  MDIO_ASSIGN_OR_RETURN(auto dest_var, state->dest.variables.at(name))
+  const auto box = RechunkBlock(source_var.get_store().domain(),
+                                state->block_shapes.at(name), index);
+  MDIO_ASSIGN_OR_RETURN(
+      auto source_block,
+      source_var.get_store() | tensorstore::AllDims().BoxSlice(box))
+  MDIO_ASSIGN_OR_RETURN(
+      auto dest_block,
+      dest_var.get_store() | tensorstore::AllDims().BoxSlice(box))
+  auto written = tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [dest_block](const tensorstore::SharedOffsetArray<void>& samples) {
+        return tensorstore::Write(samples, dest_block).commit_future;
+      },
+      tensorstore::Read(source_block));
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [state, marker = RechunkMarker(name, index)]() -> Future<void> {
+        auto recorded =
+            tensorstore::kvstore::Write(state->kvs, marker, absl::Cord());
+        return tensorstore::MapFutureValue(
+            tensorstore::InlineExecutor{},
+            [state](const tensorstore::TimestampedStorageGeneration&) {
+              std::lock_guard<std::mutex> lock(state->mutex);
+              ++state->done;
+              if (state->progress) {
+                state->progress(state->done, state->total);
+              }
+            },
+            std::move(recorded));
+      },
+      std::move(written));
+}
+
+/**
+ * @brief Copies the blocks of the plan that aren't in `copied` and then
+ * drops the record of the copy.
+ */
+inline Future<void> RunRechunk(const Dataset& source, const Dataset& dest,
+                               const tensorstore::KvStore& kvs,
+                               const nlohmann::json& plan,
+                               const std::unordered_set<std::string>& copied,
+                               const RechunkOptions& options) {
+  auto state = std::make_shared<RechunkState>(source, dest, kvs);
+  state->progress = options.progress;
+  for (const auto& name : source.variables.get_keys()) {
+    MDIO_ASSIGN_OR_RETURN(auto var, source.variables.at(name))
+    auto block = plan["blocks"][name].get<std::vector<Index>>();
+    const Index count = RechunkBlockCount(var.get_store().domain(), block);
+    for (Index index = 0; index < count; ++index) {
+      if (!copied.count(RechunkMarker(name, index))) {
+        state->blocks.emplace_back(name, index);
+      }
+    }
+    state->block_shapes[name] = std::move(block);
+  }
+  state->total = state->blocks.size();
+  std::size_t max_in_flight = options.max_in_flight;
+  if (max_in_flight == 0) {
+    max_in_flight = std::max(1u, std::thread::hardware_concurrency());
+  }
+  auto all_copied = mdio::internal::ForEachBounded(
+      state->blocks.size(), max_in_flight,
+      [state](std::size_t i) { return CopyRechunkBlock(state, i); });
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [kvs]() {
+        return tensorstore::kvstore::DeleteRange(
+            kvs, tensorstore::KeyRange::Prefix(kRechunkPrefix));
+      },
+      std::move(all_copied));
+}
+
+/**
+ * @brief Continues the copy described by `plan` into an existing
+ * destination.
+ */
+inline Future<void> ResumeRechunk(const Dataset& source,
+                                  const std::string& dest_path,
+                                  const tensorstore::KvStore& kvs,
+                                  const nlohmann::json& plan,
+                                  const RechunkOptions& options) {
+  auto dest = mdio::Dataset::Open(dest_path, mdio::constants::kOpen);
+  tensorstore::kvstore::ListOptions list_options;
+  list_options.range = tensorstore::KeyRange::Prefix(kRechunkPrefix);
+  auto listed = tensorstore::kvstore::ListFuture(kvs, list_options);
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [source, kvs, plan, options](
+          const Dataset& dest,
+          std::vector<tensorstore::kvstore::ListEntry>& entries) {
+        std::unordered_set<std::string> copied;
+        for (auto& entry : entries) {
+          copied.insert(std::move(entry.key));
+        }
+        return RunRechunk(source, dest, kvs, plan, copied, options);
+      },
+      std::move(dest), std::move(listed));
+}
+
+/**
+ * @brief Creates the destination, records the plan and copies every block.
+ */
+inline Future<void> StartRechunk(const Dataset& source,
+                                 const std::string& dest_path,
+                                 const tensorstore::KvStore& kvs,
+                                 const nlohmann::json& plan,
+                                 const RechunkOptions& options) {
+  MDIO_ASSIGN_OR_RETURN(auto specs, RechunkSpecs(source, plan, dest_path))
+  // A stale record must not mark blocks of the new copy as done.
+  auto cleared = tensorstore::kvstore::DeleteRange(
+      kvs, tensorstore::KeyRange::Prefix(kRechunkPrefix));
+  auto created = tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [metadata = source.getMetadata(), specs]() {
+        return mdio::Dataset::Open(metadata, specs,
+                                   mdio::constants::kCreateClean);
+      },
+      std::move(cleared));
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [source, kvs, plan, options](const Dataset& dest) -> Future<void> {
+        auto recorded = tensorstore::kvstore::Write(
+            kvs, std::string(kRechunkPrefix) + "plan",
+            absl::Cord(plan.dump()));
+        return tensorstore::MapFutureValue(
+            tensorstore::InlineExecutor{},
+            [source, dest, kvs, plan,
+             options](const tensorstore::TimestampedStorageGeneration&) {
+              return RunRechunk(source, dest, kvs, plan, {}, options);
+            },
+            std::move(recorded));
+      },
+      std::move(created));
+}
+
+}  // namespace internal
+
+/**
+ * @brief Copies a Dataset into a new one with a different chunk layout.
+ * A cube ingested trace by trace reads slowly across time slices, a copy in
+ * bricks or time major chunks reads them quickly. The Variables are copied in
+ * blocks that are aligned to the destination chunks, in parallel, and at most
+ * `memory_budget` bytes are staged at once. Every copied block is recorded in
+ * the destination, so a copy that is interrupted resumes where it stopped
+ * when it is started again. The record is removed once the copy is done.
+ * @details \b Usage
+ * @code
+ * mdio::utils::RechunkOptions options;
+ * options.chunks["seismic"] = {64, 64, 64};
+ * auto copied = mdio::utils::Rechunk("s3://bucket/survey_traces.mdio",
+ *                                    "s3://bucket/survey_bricks.mdio",
+ *                                    options);
+ * @endcode
+ * @param source_path The path to the Dataset to copy.
+ * @param dest_path The path to write the copy to. Anything there that isn't
+ * an unfinished copy of the same Dataset into the same chunks is replaced.
+ * @param options The new chunks and how to copy them.
+ * @return A future that is OK once every Variable has been copied.
+ */
+inline Future<void> Rechunk(const std::string& source_path,
+                            const std::string& dest_path,
+                            const RechunkOptions& options = {}) {
+  std::string kvs_path = dest_path;
+  if (kvs_path.empty() || kvs_path.back() != '/') {
+    kvs_path += '/';
+  }
+  auto source_future = mdio::Dataset::Open(source_path, mdio::constants::kOpen);
+  auto kvs_future = mdio::internal::dataset_kvs_store(kvs_path);
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [source_path, dest_path, options](
+          const Dataset& source,
+          const tensorstore::KvStore& kvs) -> Future<void> {
+        MDIO_ASSIGN_OR_RETURN(
+            auto plan, internal::PlanRechunk(source, source_path, options))
+        auto stored = tensorstore::kvstore::Read(
+            kvs, std::string(internal::kRechunkPrefix) + "plan");
+        return tensorstore::MapFutureValue(
+            tensorstore::InlineExecutor{},
+            [source, dest_path, kvs, plan, options](
+                const tensorstore::kvstore::ReadResult& read) {
+              if (options.resume && read.has_value()) {
+                auto resumed = nlohmann::json::parse(std::string(read.value),
+                                                     nullptr, false);
+                // The blocks come from the stored plan, the budget may have
+                // changed since.
+                if (!resumed.is_discarded() &&
+                    resumed.value("source", "") == plan["source"] &&
+                    resumed.value("chunks", nlohmann::json()) ==
+                        plan["chunks"]) {
+                  return internal::ResumeRechunk(source, dest_path, kvs,
+                                                 resumed, options);
+                }
+              }
+              return internal::StartRechunk(source, dest_path, kvs, plan,
+                                            options);
+            },
+            std::move(stored));
+      },
+      std::move(source_future), std::move(kvs_future));
+}
+
+}  // namespace utils
+}  // namespace mdio
+
+#endif  // MDIO_UTILS_RECHUNK_H_
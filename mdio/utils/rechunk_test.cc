@@ -0,0 +1,199 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mdio/utils/rechunk.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "mdio/utils/test_fixtures.h"
+
+// clang-format off
+#include <nlohmann/json.hpp>  // NOLINT
+// clang-format on
+
+namespace {
+
+/*NOLINT*/ const std::string kSourcePath = "zarrs/testing/traces.mdio";
+/*NOLINT*/ const std::string kDestPath = "zarrs/testing/bricks.mdio";
+
+// Creates the trace chunked source, seismic holds the position of each
+// sample.
+mdio::Result<mdio::Dataset> MakeSource() {
+  return mdio::testing::MakeSeismicDataset(
+      kSourcePath, mdio::testing::SeismicSchema({8, 6, 10}, {1, 1, 10}));
+}
+
+std::vector<float> ReadSeismic(const std::string& path) {
+  return mdio::testing::ReadSeismic(path).value();
+}
+
+// The file kvstore may leave empty directories behind.
+bool HasRecord(const std::string& path) {
+  const std::string record = path + "/.zrechunk";
+  if (!std::filesystem::exists(record)) {
+    return false;
+  }
+  for (const auto& entry :
+       std::filesystem::recursive_directory_iterator(record)) {
+    if (entry.is_regular_file()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+TEST(Rechunk, newChunks) {
+  auto source = MakeSource();
+  ASSERT_TRUE(source.ok()) << source.status();
+  mdio::utils::RechunkOptions options;
+  options.chunks["seismic"] = {4, 3, 5};
+  options.max_in_flight = 2;
+  std::size_t last = 0;
+  options.progress = [&last](std::size_t done, std::size_t total) {
+    EXPECT_LE(done, total);
+    last = done;
+  };
+  auto copied =
+      mdio::utils::Rechunk(kSourcePath, kDestPath, options).result();
+  ASSERT_TRUE(copied.ok()) << copied.status();
+  // 4 blocks of seismic, one of each coordinate.
+  EXPECT_EQ(last, 7);
+  EXPECT_FALSE(HasRecord(kDestPath));
+
+  auto dest = mdio::Dataset::Open(kDestPath, mdio::constants::kOpen).result();
+  ASSERT_TRUE(dest.ok()) << dest.status();
+  auto seismic = dest->variables.at("seismic");
+  ASSERT_TRUE(seismic.ok()) << seismic.status();
+  EXPECT_THAT(seismic->get_chunk_shape().value(),
+              ::testing::ElementsAre(4, 3, 5));
+  EXPECT_EQ(seismic->GetAttributes()["attributes"]["fizz"], "buzz");
+  EXPECT_EQ(dest->getMetadata(), source->getMetadata());
+  EXPECT_EQ(ReadSeismic(kDestPath), ReadSeismic(kSourcePath));
+  std::filesystem::remove_all(kSourcePath);
+  std::filesystem::remove_all(kDestPath);
+}
+
+TEST(Rechunk, resumes) {
+  auto source = MakeSource();
+  ASSERT_TRUE(source.ok()) << source.status();
+  mdio::utils::RechunkOptions options;
+  options.chunks["seismic"] = {4, 3, 5};
+  ASSERT_TRUE(mdio::utils::Rechunk(kSourcePath, kDestPath, options)
+                  .result()
+                  .ok());
+
+  // Blank the first two blocks of seismic, then record that only the first
+  // one is left to copy.
+  {
+    auto dest =
+        mdio::Dataset::Open(kDestPath, mdio::constants::kOpen).result();
+    ASSERT_TRUE(dest.ok()) << dest.status();
+    auto seismic = dest->variables.get<float>("seismic");
+    ASSERT_TRUE(seismic.ok()) << seismic.status();
+    mdio::RangeDescriptor<mdio::Index> inlines = {"inline", 0, 4, 1};
+    auto blank = seismic->slice(inlines);
+    ASSERT_TRUE(blank.ok()) << blank.status();
+    auto zeros = mdio::from_variable<float>(blank.value());
+    ASSERT_TRUE(zeros.ok()) << zeros.status();
+    float* samples =
+        zeros->get_data_accessor().data() + zeros->get_flattened_offset();
+    std::fill(samples, samples + 4 * 6 * 10, 0.0f);
+    ASSERT_TRUE(blank->Write(zeros.value()).commit_future.result().ok());
+  }
+  auto plan = mdio::utils::internal::PlanRechunk(source.value(), kSourcePath,
+                                                 options);
+  ASSERT_TRUE(plan.ok()) << plan.status();
+  const std::string record = kDestPath + "/.zrechunk";
+  std::filesystem::create_directories(record);
+  std::ofstream(record + "/plan") << plan->dump();
+  for (const auto& name : source->variables.get_keys()) {
+    auto var = source->variables.at(name);
+    ASSERT_TRUE(var.ok()) << var.status();
+    const auto count = mdio::utils::internal::RechunkBlockCount(
+        var->get_store().domain(),
+        (*plan)["blocks"][name].get<std::vector<mdio::Index>>());
+    std::filesystem::create_directories(record + "/" + name);
+    for (mdio::Index i = name == "seismic" ? 1 : 0; i < count; ++i) {
+      std::ofstream(record + "/" + name + "/" + std::to_string(i));
+    }
+  }
+
+  std::size_t total = 0;
+  options.progress = [&total](std::size_t, std::size_t all) { total = all; };
+  auto resumed =
+      mdio::utils::Rechunk(kSourcePath, kDestPath, options).result();
+  ASSERT_TRUE(resumed.ok()) << resumed.status();
+  EXPECT_EQ(total, 1);
+  EXPECT_FALSE(HasRecord(kDestPath));
+
+  // The first block is copied again, the second one was recorded as done.
+  auto expected = ReadSeismic(kSourcePath);
+  auto actual = ReadSeismic(kDestPath);
+  for (int il = 0; il < 8; ++il) {
+    for (int xl = 0; xl < 6; ++xl) {
+      const bool blanked = il < 4 && xl >= 3;
+      for (int z = 0; z < 10; ++z) {
+        const int i = (il * 6 + xl) * 10 + z;
+        EXPECT_EQ(actual[i], blanked ? 0.0f : expected[i]) << i;
+      }
+    }
+  }
+  std::filesystem::remove_all(kSourcePath);
+  std::filesystem::remove_all(kDestPath);
+}
+
+TEST(Rechunk, invalidChunks) {
+  ASSERT_TRUE(MakeSource().ok());
+  mdio::utils::RechunkOptions options;
+  options.chunks["velocity"] = {4, 4, 4};
+  EXPECT_EQ(
+      mdio::utils::Rechunk(kSourcePath, kDestPath, options).status().code(),
+      absl::StatusCode::kNotFound);
+  options.chunks.clear();
+  options.chunks["seismic"] = {4, 4};
+  EXPECT_EQ(
+      mdio::utils::Rechunk(kSourcePath, kDestPath, options).status().code(),
+      absl::StatusCode::kInvalidArgument);
+  std::filesystem::remove_all(kSourcePath);
+  std::filesystem::remove_all(kDestPath);
+}
+
+TEST(Rechunk, blockShape) {
+  using mdio::utils::internal::RechunkBlockShape;
+  // Traces into bricks stage whole traces of whole bricks.
+  EXPECT_THAT(RechunkBlockShape({100, 100, 1000}, {1, 1, 1000}, {64, 64, 64},
+                                4, std::size_t{1} << 30),
+              ::testing::ElementsAre(64, 64, 1000));
+  // Over budget, the dimension with the most bricks is halved.
+  EXPECT_THAT(RechunkBlockShape({100, 100, 1000}, {1, 1, 1000}, {64, 64, 64},
+                                4, 64 * 64 * 1000 * 2),
+              ::testing::ElementsAre(64, 64, 512));
+  // A block is never smaller than one destination chunk.
+  EXPECT_THAT(RechunkBlockShape({100, 100, 1000}, {1, 1, 1000}, {64, 64, 64},
+                                4, 0),
+              ::testing::ElementsAre(64, 64, 64));
+  // Nor larger than the Variable.
+  EXPECT_THAT(RechunkBlockShape({10, 10, 10}, {3, 3, 10}, {4, 4, 4}, 4,
+                                std::size_t{1} << 30),
+              ::testing::ElementsAre(10, 10, 10));
+}
+
+}  // namespace
@@ -0,0 +1,186 @@
+// Copyright 2025 TGS
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//    http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MDIO_UTILS_TEST_FIXTURES_H_
+#define MDIO_UTILS_TEST_FIXTURES_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "mdio/dataset.h"
+#include "mdio/variable.h"
+
+// clang-format off
+#include <nlohmann/json.hpp>  // NOLINT
+// clang-format on
+
+namespace mdio {
+namespace testing {
+
+/**
+ * @brief Gets the spec of a zarr Variable in a local directory.
+ * @param path The directory of the Variable, also its long name.
+ * @param dimension_names The names of the dimensions.
+ * @param shape The size of each dimension.
+ * @param chunk_shape The chunk shape.
+ * @param dtype The zarr dtype, e.g. "<f4" or "|b1".
+ * @param fill_value The value of unwritten samples.
+ */
+inline ::nlohmann::json VariableSpec(
+    const std::string& path, const std::vector<std::string>& dimension_names,
+    const std::vector<Index>& shape, const std::vector<Index>& chunk_shape,
+    const std::string& dtype = "<f4",
+    const ::nlohmann::json& fill_value = 0.0) {
+  return ::nlohmann::json::object(
+      {{"driver", "zarr"},
+       {"kvstore", {{"driver", "file"}, {"path", path}}},
+       {"attributes",
+        {{"long_name", path}, {"dimension_names", dimension_names}}},
+       {"metadata",
+        {{"dtype", dtype},
+         {"shape", shape},
+         {"chunks", chunk_shape},
+         {"fill_value", fill_value},
+         {"dimension_separator", "/"}}}});
+}
+
+/**
+ * @brief Creates a Variable and writes every sample of it.
+ * @param spec The spec of the Variable, see `VariableSpec`.
+ * @param value Gives the value of a sample from its position.
+ * @return The Variable once it is written.
+ */
+template <typename T, typename Value>
+Result<Variable<T>> MakeVariable(const ::nlohmann::json& spec, Value value) {
+  MDIO_ASSIGN_OR_RETURN(
+      auto var,
+      Variable<T>::Open(spec, constants::kCreateClean).result())
+  MDIO_ASSIGN_OR_RETURN(auto data, from_variable<T>(var))
+  T* samples = data.get_data_accessor().data() + data.get_flattened_offset();
+  const auto domain = var.dimensions();
+  const auto shape = domain.shape();
+  std::vector<Index> position(shape.size(), 0);
+  for (Index i = 0; i < data.num_samples(); ++i) {
+    samples[i] = static_cast<T>(value(position));
+    // The next position in C order.
+    for (std::size_t d = position.size(); d-- > 0;) {
+      if (++position[d] < shape[d]) {
+        break;
+      }
+      position[d] = 0;
+    }
+  }
+  auto written = var.Write(data).commit_future.result();
+  if (!written.ok()) {
+    return written.status();
+  }
+  return var;
+}
+
+/**
+ * @brief Gets the schema of a Dataset with a float32 "seismic" Variable over
+ * inline, crossline and depth, and a uint32 coordinate for each dimension.
+ * @param shape The sizes of inline, crossline and depth.
+ * @param chunk_shape The chunk shape of seismic.
+ * @param coordinate_chunks The chunks of the inline, crossline and depth
+ * coordinates, each coordinate is one chunk if empty.
+ */
+inline ::nlohmann::json SeismicSchema(
+    const std::vector<Index>& shape, const std::vector<Index>& chunk_shape,
+    const std::vector<Index>& coordinate_chunks = {}) {
+  static const char* const kDimensions[] = {"inline", "crossline", "depth"};
+  auto dimensions = ::nlohmann::json::array();
+  auto coordinates = ::nlohmann::json::array();
+  ::nlohmann::json seismic = {
+      {"name", "seismic"},
+      {"dataType", "float32"},
+      {"longName", "Amplitude"},
+      {"metadata",
+       {{"chunkGrid",
+         {{"name", "regular"},
+          {"configuration", {{"chunkShape", chunk_shape}}}}},
+        {"attributes", {{"fizz", "buzz"}}}}},
+      {"coordinates", ::nlohmann::json::array({"inline", "crossline"})},
+      {"compressor", {{"name", "blosc"}, {"algorithm", "zstd"}}}};
+  for (std::size_t d = 0; d < 3; ++d) {
+    ::nlohmann::json dimension = {{"name", kDimensions[d]},
+                                  {"size", shape[d]}};
+    dimensions.push_back(dimension);
+    ::nlohmann::json coordinate = {
+        {"name", kDimensions[d]},
+        {"dataType", "uint32"},
+        {"dimensions", ::nlohmann::json::array({dimension})}};
+    if (!coordinate_chunks.empty()) {
+      coordinate["metadata"]["chunkGrid"] = {
+          {"name", "regular"},
+          {"configuration",
+           {{"chunkShape", ::nlohmann::json::array({coordinate_chunks[d]})}}}};
+    }
+    coordinates.push_back(coordinate);
+  }
+  seismic["dimensions"] = dimensions;
+  auto variables = ::nlohmann::json::array({seismic});
+  variables.insert(variables.end(), coordinates.begin(), coordinates.end());
+  return ::nlohmann::json::object(
+      {{"metadata",
+        {{"name", "testing"},
+         {"apiVersion", "1.0.0"},
+         {"createdOn", "2023-12-12T15:02:06.413469-06:00"},
+         {"attributes", {{"foo", "bar"}}}}},
+       {"variables", variables}});
+}
+
+/**
+ * @brief Creates a Dataset and writes seismic, whose samples hold their
+ * position in C order.
+ * @param path The path of the Dataset.
+ * @param schema The schema of the Dataset, see `SeismicSchema`.
+ */
+inline Result<Dataset> MakeSeismicDataset(const std::string& path,
+                                          const ::nlohmann::json& schema) {
+  MDIO_ASSIGN_OR_RETURN(
+      auto dataset,
+      Dataset::from_json(schema, path, constants::kCreateClean).result())
+  MDIO_ASSIGN_OR_RETURN(auto seismic, dataset.variables.get<float>("seismic"))
+  MDIO_ASSIGN_OR_RETURN(auto data, from_variable<float>(seismic))
+  float* samples =
+      data.get_data_accessor().data() + data.get_flattened_offset();
+  for (Index i = 0; i < data.num_samples(); ++i) {
+    samples[i] = static_cast<float>(i);
+  }
+  auto written = seismic.Write(data).commit_future.result();
+  if (!written.ok()) {
+    return written.status();
+  }
+  return dataset;
+}
+
+/**
+ * @brief Reads every sample of seismic from the Dataset at `path`.
+ */
+inline Result<std::vector<float>> ReadSeismic(const std::string& path) {
+  MDIO_ASSIGN_OR_RETURN(auto dataset,
+                        Dataset::Open(path, constants::kOpen).result())
+  MDIO_ASSIGN_OR_RETURN(auto seismic, dataset.variables.get<float>("seismic"))
+  MDIO_ASSIGN_OR_RETURN(auto data, seismic.Read().result())
+  const float* samples =
+      data.get_data_accessor().data() + data.get_flattened_offset();
+  return std::vector<float>(samples, samples + data.num_samples());
+}
+
+}  // namespace testing
+}  // namespace mdio
+
+#endif  // MDIO_UTILS_TEST_FIXTURES_H_
@@ -39,7 +39,8 @@ namespace utils {
  * outside the slice descriptors will remain untouched but inaccessable.
  * @param descriptors The descriptors to use for the slice. Only considers the
  * label and stop value.
- * @return A future of the trim operation.
+ * @return A future of the trim operation. The Variables are resized
+ * concurrently and the metadata is committed once they all succeed.
  */
 template <typename... Descriptors>
 Future<void> TrimDataset(std::string dataset_path,
@@ -63,6 +64,9 @@ Future<void> TrimDataset(std::string dataset_path,
     shapeDescriptors[descriptor.label.label()] = descriptor.stop;
   }
 
+  // Every Variable is resized concurrently, the metadata is committed once
+  // they have all finished.
+  std::vector<tensorstore::AnyFuture> resizes;
   for (auto& varIdentifier : ds.variables.get_iterable_accessor()) {
     MDIO_ASSIGN_OR_RETURN(auto var, ds.variables.at(varIdentifier))
     var.set_metadata_publish_flag(true);
@@ -101,16 +105,15 @@ Future<void> TrimDataset(std::string dataset_path,
       resizeOptions.mode = tensorstore::ResizeMode::resize_metadata_only;
     }
 
-    auto resizedStatus = tensorstore::Resize(
+    resizes.push_back(tensorstore::Resize(
         varStore, tensorstore::span<const tensorstore::Index>(implicitDims),
-        tensorstore::span<const tensorstore::Index>(newShape), resizeOptions);
-
-    if (!resizedStatus.status().ok()) {
-      return resizedStatus.status();
-    }
+        tensorstore::span<const tensorstore::Index>(newShape), resizeOptions));
   }
 
-  return ds.CommitMetadata();
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [ds]() mutable { return ds.CommitMetadata(); },
+      tensorstore::WaitAllFuture(resizes));
 }
 
 }  // namespace utils
@@ -15,6 +15,9 @@
 #ifndef MDIO_VARIABLE_H_
 #define MDIO_VARIABLE_H_
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <filesystem>
 #include <limits>
 #include <map>
@@ -22,13 +25,20 @@
 #include <queue>
 #include <set>
 #include <string>
+#include <string_view>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "absl/strings/str_split.h"
+#include "mdio/coordinate_index.h"
+#include "mdio/dataset_options.h"
+#include "mdio/disk_cache.h"
 #include "mdio/impl.h"
+#include "mdio/request_policy.h"
 #include "mdio/stats.h"
+#include "mdio/telemetry.h"
 #include "tensorstore/array.h"
 #include "tensorstore/driver/driver.h"
 #include "tensorstore/driver/registry.h"
@@ -40,6 +50,8 @@
 #include "tensorstore/open.h"
 #include "tensorstore/stack.h"
 #include "tensorstore/tensorstore.h"
+#include "tensorstore/transaction.h"
+#include "tensorstore/util/division.h"
 #include "tensorstore/util/future.h"
 
 // clang-format off
@@ -241,6 +253,72 @@ absl::Status CheckMissingDriverStatus(const absl::Status& status) {
   return status;
 }
 
+/**
+ * @brief Checks if a Variable spec uses the Zarr v3 driver.
+ */
+inline bool IsZarr3(const nlohmann::json& spec) {
+  return spec.contains("driver") && spec["driver"] == "zarr3";
+}
+
+/**
+ * @brief Writes the MDIO attributes of a Variable to durable media.
+ * Zarr v2 keeps them in ".zattrs". Zarr v3 keeps them as the "attributes" of
+ * the array's "zarr.json", which is read, updated and written back.
+ * @param kvstore The kvstore of the Variable's store.
+ * @param attributes The attributes to write.
+ * @param isCloudStore Whether the kvstore is a cloud store, whose keys don't
+ * take a leading slash.
+ * @param zarr3 Whether the Variable is Zarr v3.
+ * @param transaction The transaction to stage the write in, if any.
+ */
+inline Future<tensorstore::TimestampedStorageGeneration>
+WriteVariableAttributes(
+    const tensorstore::KvStore& store, const nlohmann::json& attributes,
+    bool isCloudStore, bool zarr3,
+    const tensorstore::Transaction& transaction = tensorstore::no_transaction) {
+  tensorstore::KvStore kvstore = store;
+  if (transaction != tensorstore::no_transaction) {
+    MDIO_ASSIGN_OR_RETURN(kvstore, store | transaction)
+  }
+  const std::string prefix = isCloudStore ? "" : "/";
+  if (!zarr3) {
+    return tensorstore::kvstore::Write(kvstore, prefix + ".zattrs",
+                                       absl::Cord(attributes.dump()));
+  }
+  const std::string key = prefix + "zarr.json";
+  return tensorstore::MapFutureValue(
+      tensorstore::InlineExecutor{},
+      [kvstore, key, attributes](const tensorstore::kvstore::ReadResult& read)
+          -> Future<tensorstore::TimestampedStorageGeneration> {
+        if (!read.has_value()) {
+          return absl::NotFoundError("Could not find the array's " + key);
+        }
+        auto array = nlohmann::json::parse(std::string(read.value), nullptr,
+                                           false);
+        if (array.is_discarded() || !array.is_object()) {
+          return absl::InvalidArgumentError("Could not parse the array's " +
+                                            key);
+        }
+        array["attributes"] = attributes;
+        // Don't write over a zarr.json that changed since it was read.
+        tensorstore::kvstore::WriteOptions options;
+        options.generation_conditions.if_equal = read.stamp.generation;
+        return tensorstore::MapFutureValue(
+            tensorstore::InlineExecutor{},
+            [key](const tensorstore::TimestampedStorageGeneration& stamp)
+                -> Result<tensorstore::TimestampedStorageGeneration> {
+              if (tensorstore::StorageGeneration::IsUnknown(stamp.generation)) {
+                return absl::FailedPreconditionError(
+                    "The array's " + key + " was changed by another writer.");
+              }
+              return stamp;
+            },
+            tensorstore::kvstore::Write(kvstore, key, absl::Cord(array.dump()),
+                                        options));
+      },
+      tensorstore::kvstore::Read(kvstore, key));
+}
+
 /**
  * @brief Validates and processes a JSON specification for a tensorstore
  * variable.
@@ -410,22 +488,26 @@ Future<Variable<T, R, M>> CreateVariable(const nlohmann::json& json_spec,
                         "Variable spec requires metadata");
   }
 
-  if (!json_spec["metadata"].contains("dtype")) {
+  const bool zarr3 = IsZarr3(json_spec);
+  if (!json_spec["metadata"].contains(zarr3 ? "data_type" : "dtype")) {
     return absl::Status(absl::StatusCode::kInvalidArgument,
                         "Variable metadata requires dtype");
   }
 
-  MDIO_ASSIGN_OR_RETURN(auto zarr_dtype, tensorstore::internal_zarr::ParseDType(
-                                             json_spec["metadata"]["dtype"]))
-
   // Handles the use case of creating a struct array, but intending to open as
-  // void.
-  auto do_handle_structarray =
-      zarr_dtype.has_fields && !json_spec.contains("field");
+  // void. Zarr v3 has no struct arrays.
+  bool do_handle_structarray = false;
   auto json_spec_with_field = json_spec;
-  if (do_handle_structarray) {
-    // pick the first name, it won't effect the .zarray json:
-    json_spec_with_field["field"] = zarr_dtype.fields[0].name;
+  if (!zarr3) {
+    MDIO_ASSIGN_OR_RETURN(auto zarr_dtype,
+                          tensorstore::internal_zarr::ParseDType(
+                              json_spec["metadata"]["dtype"]))
+    do_handle_structarray =
+        zarr_dtype.has_fields && !json_spec.contains("field");
+    if (do_handle_structarray) {
+      // pick the first name, it won't effect the .zarray json:
+      json_spec_with_field["field"] = zarr_dtype.fields[0].name;
+    }
   }
 
   auto json_spec_without_metadata = json_spec;
@@ -433,8 +515,8 @@ Future<Variable<T, R, M>> CreateVariable(const nlohmann::json& json_spec,
   auto future_json_store = tensorstore::MakeReadyFuture<::nlohmann::json>(
       json_spec_without_metadata);
 
-  auto publish = [](const ::nlohmann::json& json_var, bool isCloudStore,
-                    const tensorstore::TensorStore<T, R, M>& store)
+  auto publish = [zarr3](const ::nlohmann::json& json_var, bool isCloudStore,
+                         const tensorstore::TensorStore<T, R, M>& store)
       -> Future<tensorstore::TimestampedStorageGeneration> {
     auto output_json = json_var;
     output_json["_ARRAY_DIMENSIONS"] = output_json["dimension_names"];
@@ -460,22 +542,23 @@ Future<Variable<T, R, M>> CreateVariable(const nlohmann::json& json_spec,
         output_json.erase("coordinates");
       }
     }
-    std::string outpath = "/.zattrs";
-    if (isCloudStore) {
-      outpath = ".zattrs";
-    }
     // It's important to use the store's kvstore or else we get a race condition
     // on "mkdir".
-    return tensorstore::kvstore::Write(store.kvstore(), outpath,
-                                       absl::Cord(output_json.dump(4)));
+    return WriteVariableAttributes(store.kvstore(), output_json, isCloudStore,
+                                   zarr3);
   };
 
   // this is intended to handle the struct array where we "reopen" the store
   // but this time as struct ... but we loose the capactity for forward options.
   // FIXME - strip "create/delete existing" and foward other options.
-  auto apply_reopen = [](const tensorstore::TensorStore<T, R, M>& store,
-                         const ::nlohmann::json& attributes,
-                         const ::nlohmann::json& json_spec) {
+  // The Context is kept so the reopened store shares the same resources.
+  auto apply_reopen = [context = ContextFromOptions(options...)](
+                          const tensorstore::TensorStore<T, R, M>& store,
+                          const ::nlohmann::json& attributes,
+                          const ::nlohmann::json& json_spec) {
+    if (context) {
+      return tensorstore::Open<T, R, M>(json_spec, context);
+    }
     return tensorstore::Open<T, R, M>(json_spec);
   };
 
@@ -582,24 +665,62 @@ Future<Variable<T, R, M>> OpenVariable(const nlohmann::json& json_store,
 
   auto spec = tensorstore::MakeReadyFuture<::nlohmann::json>(store_spec);
 
-  // open a store:
-  auto future_store =
-      tensorstore::Open<T, R, M>(store_spec, std::forward<Option>(options)...);
+  // The attributes are read in the same Context as the store.
+  auto kvs_future =
+      OpenKvStore(store_spec["kvstore"], ContextFromOptions(options...));
+
+  // Remote stores are read through the disk cache, if enabled.
+  auto cache_prefix = DiskCachePrefix(store_spec["kvstore"]);
+  auto cache = cache_prefix.has_value() ? GetDiskCache() : nullptr;
 
-  // start by creating a kvstore future ...
-  auto kvs_future = tensorstore::kvstore::Open(store_spec["kvstore"]);
+  // open a store:
+  Future<tensorstore::TensorStore<T, R, M>> future_store;
+  if (cache) {
+    MDIO_ASSIGN_OR_RETURN(auto open_options, OpenOptionsFromOptions(options...))
+    kvs_future = tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [prefix = *cache_prefix, cache](const tensorstore::KvStore& kvstore) {
+          return CacheKvStore(kvstore, prefix, cache);
+        },
+        kvs_future);
+    // The cached kvstore is given as an option instead.
+    auto spec_without_kvstore = store_spec;
+    spec_without_kvstore.erase("kvstore");
+    future_store = tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [spec_without_kvstore, open_options](
+            const tensorstore::KvStore& kvstore)
+            -> Future<tensorstore::TensorStore<T, R, M>> {
+          auto cached_options = open_options;
+          auto status = cached_options.Set(kvstore);
+          if (!status.ok()) {
+            return status;
+          }
+          return tensorstore::Open<T, R, M>(spec_without_kvstore,
+                                            std::move(cached_options));
+        },
+        kvs_future);
+  } else {
+    future_store = tensorstore::Open<T, R, M>(store_spec,
+                                              std::forward<Option>(options)...);
+  }
 
   // go read the metadata return json ...
-  auto read = [](const tensorstore::KvStore& kvstore)
+  const bool zarr3 = IsZarr3(json_store);
+  auto read = [zarr3](const tensorstore::KvStore& kvstore)
       -> Future<tensorstore::kvstore::ReadResult> {
-    return tensorstore::kvstore::Read(kvstore, "/.zattrs");
+    return PolicyRead(kvstore, zarr3 ? "/zarr.json" : "/.zattrs");
   };
 
   // go read the attributes return json ...
-  auto parse = [](const tensorstore::kvstore::ReadResult& kvs_read,
-                  const ::nlohmann::json& spec) {
+  auto parse = [zarr3](const tensorstore::kvstore::ReadResult& kvs_read,
+                       const ::nlohmann::json& spec) {
     auto attributes =
         nlohmann::json::parse(std::string(kvs_read.value), nullptr, false);
+    if (zarr3 && attributes.is_object()) {
+      // Zarr v3 keeps the attributes in the array metadata.
+      return attributes.value("attributes", ::nlohmann::json::object());
+    }
     return attributes;
   };
 
@@ -738,6 +859,200 @@ Future<Variable<T, R, M>> Open(const nlohmann::json& json_spec,
     return OpenVariable<T, R, M>(json_spec, std::move(options));
   }
 }
+
+/**
+ * @brief Checks if a domain contains a specified label.
+ * An index identifier is valid if it is within the rank of the domain.
+ */
+inline bool DomainHasLabel(tensorstore::IndexDomainView<> domain,
+                           const DimensionIdentifier& labelToCheck) {
+  if (!labelToCheck.label().data()) {
+    return labelToCheck.index() < domain.rank() && labelToCheck.index() >= 0;
+  }
+  for (const auto& label : domain.labels()) {
+    if (label == labelToCheck) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Clamps a slice descriptor to a domain.
+ * A descriptor for a dimension the domain doesn't have is returned unchanged.
+ */
+inline RangeDescriptor<Index> ClampToDomain(
+    tensorstore::IndexDomainView<> domain, const RangeDescriptor<Index>& desc) {
+  const auto labels = domain.labels();
+  for (size_t idx = 0; idx < labels.size(); ++idx) {
+    if (labels[idx] == desc.label) {
+      const auto interval = domain[idx].interval();
+      return {desc.label,  // label
+              std::max(desc.start, interval.inclusive_min()),  // start
+              std::min(desc.stop, interval.exclusive_max()),   // stop
+              desc.step};                                      // step
+    }
+  }
+  return desc;
+}
+
+/**
+ * @brief Clamps, validates and groups slice descriptors by dimension.
+ * Descriptors for dimensions the domain doesn't have are dropped. Groups keep
+ * the order in which their dimension was first described, and abutting
+ * unit-stride ranges within a group, such as the runs from `sel`, are merged.
+ * @return The ranges of each described dimension, or an InvalidArgumentError
+ * if a descriptor has start > stop.
+ */
+inline Result<std::vector<std::vector<RangeDescriptor<Index>>>>
+GroupSliceDescriptors(tensorstore::IndexDomainView<> domain,
+                      const std::vector<RangeDescriptor<Index>>& slices) {
+  using DimensionKey = std::pair<std::string_view, DimensionIndex>;
+  std::map<DimensionKey, std::size_t> group_of;
+  std::vector<std::vector<RangeDescriptor<Index>>> groups;
+  for (const auto& desc : slices) {
+    auto d = ClampToDomain(domain, desc);
+    if (d.start > d.stop) {
+      return absl::InvalidArgumentError(
+          std::string("Slice descriptor for ") +
+          std::string(desc.label.label()) + " is invalid: start=" +
+          std::to_string(desc.start) + " > stop=" + std::to_string(desc.stop));
+    }
+    if (!DomainHasLabel(domain, d.label)) {
+      continue;
+    }
+    DimensionKey key{d.label.label(), d.label.index()};
+    auto [it, inserted] = group_of.emplace(key, groups.size());
+    if (inserted) {
+      groups.emplace_back();
+    }
+    auto& group = groups[it->second];
+    if (!group.empty() && group.back().step == 1 && d.step == 1 &&
+        group.back().stop == d.start) {
+      group.back().stop = d.stop;
+    } else {
+      group.push_back(d);
+    }
+  }
+  return groups;
+}
+
+/**
+ * @brief Applies slice descriptors to a domain the way `Variable::slice`
+ * applies them to its store.
+ * A dimension with several ranges has the combined extent of the ranges and
+ * the origin of the first one, matching `tensorstore::Concat`.
+ */
+inline Result<tensorstore::IndexDomain<>> SliceDomain(
+    tensorstore::IndexDomain<> domain,
+    const std::vector<RangeDescriptor<Index>>& slices) {
+  MDIO_ASSIGN_OR_RETURN(auto groups, GroupSliceDescriptors(domain, slices))
+  for (const auto& group : groups) {
+    MDIO_ASSIGN_OR_RETURN(auto first,
+                          domain | tensorstore::Dims(group[0].label)
+                                       .HalfOpenInterval(group[0].start,
+                                                         group[0].stop,
+                                                         group[0].step))
+    if (group.size() == 1) {
+      domain = std::move(first);
+      continue;
+    }
+    tensorstore::DimensionIndexBuffer buffer;
+    auto resolved = tensorstore::Dims(group[0].label).Resolve(domain, &buffer);
+    if (!resolved.ok()) {
+      return resolved;
+    }
+    const DimensionIndex axis = buffer[0];
+    Index extent = 0;
+    for (const auto& r : group) {
+      MDIO_ASSIGN_OR_RETURN(
+          auto piece,
+          domain | tensorstore::Dims(axis).HalfOpenInterval(r.start, r.stop,
+                                                            r.step))
+      extent += piece[axis].interval().size();
+    }
+    std::vector<Index> origin(domain.origin().begin(), domain.origin().end());
+    std::vector<Index> shape(domain.shape().begin(), domain.shape().end());
+    std::vector<std::string> labels(domain.labels().begin(),
+                                    domain.labels().end());
+    origin[axis] = first[axis].interval().inclusive_min();
+    shape[axis] = extent;
+    MDIO_ASSIGN_OR_RETURN(domain, tensorstore::IndexDomainBuilder<>(
+                                      domain.rank())
+                                      .origin(origin)
+                                      .shape(shape)
+                                      .labels(labels)
+                                      .Finalize())
+  }
+  return domain;
+}
+
+/**
+ * @brief Quantizes floating point samples in place for a lossy fixed accuracy
+ * or fixed precision codec.
+ * "fixed_accuracy" rounds to the largest power of two step that keeps the
+ * absolute error within `tolerance`. "fixed_precision" keeps `precision`
+ * significant bits. Either zeroes the low mantissa bits so the lossless
+ * compressor behind it does better. NaNs and infinities are left untouched.
+ */
+template <typename U>
+void QuantizeSamples(U* data, Index n_samples,
+                     const nlohmann::json& quantization) {
+  const std::string mode = quantization.value("mode", "");
+  if (mode == "fixed_accuracy") {
+    const double tolerance = quantization["tolerance"].get<double>();
+    const double step = std::exp2(std::floor(std::log2(2 * tolerance)));
+    // Samples this large are already a multiple of the step.
+    const double exact = step * std::exp2(std::numeric_limits<U>::digits);
+    for (Index i = 0; i < n_samples; ++i) {
+      const double v = data[i];
+      if (std::isfinite(v) && std::fabs(v) < exact) {
+        data[i] = static_cast<U>(std::nearbyint(v / step) * step);
+      }
+    }
+  } else if (mode == "fixed_precision") {
+    const int precision = quantization["precision"].get<int>();
+    if (precision >= std::numeric_limits<U>::digits) {
+      return;
+    }
+    for (Index i = 0; i < n_samples; ++i) {
+      if (!std::isfinite(data[i])) {
+        continue;
+      }
+      int exponent;
+      const U mantissa = std::frexp(data[i], &exponent);
+      data[i] = std::ldexp(std::nearbyint(std::ldexp(mantissa, precision)),
+                           exponent - precision);
+    }
+  }
+}
+
+/**
+ * @brief Gets a quantized copy of the data to write to a Variable with a lossy
+ * codec, see `QuantizeSamples`.
+ * @param quantization The Variable's ["metadata"]["quantizationV1"].
+ * @return The quantized copy, or an error if the Variable is not floating
+ * point.
+ */
+template <typename T, typename Array>
+Result<Array> QuantizeCopy(const Array& source, DataType dtype,
+                           const nlohmann::json& quantization) {
+  Array copy = tensorstore::MakeCopy(source);
+  void* ptr = copy.byte_strided_origin_pointer().get();
+  bool quantized = false;
+  DispatchNumericType<T>(dtype, [&](auto tag) {
+    using U = decltype(tag);
+    if constexpr (std::is_floating_point_v<U>) {
+      QuantizeSamples(static_cast<U*>(ptr), copy.num_elements(), quantization);
+      quantized = true;
+    }
+  });
+  if (!quantized) {
+    return absl::InvalidArgumentError(
+        "Quantization requires a floating point Variable.");
+  }
+  return copy;
+}
 }  // namespace internal
 
 /**
@@ -782,6 +1097,8 @@ class Variable {
         metadata(other.getReducedMetadata()),
         store(other.get_store()),
         attributes(other.attributes),
+        runningStats(other.runningStats),
+        indexCleared(other.indexCleared),
         attributesAddress(other.get_attributes_address()) {}
 
   friend std::ostream& operator<<(std::ostream& os, const Variable& obj) {
@@ -827,6 +1144,8 @@ class Variable {
    */
   template <ArrayOriginKind OriginKind = offset_origin>
   Future<VariableData<T, R, OriginKind>> Read() {
+    internal::Span span("mdio.Variable.Read");
+    span.Attribute("mdio.variable", variableName);
     auto data = tensorstore::Read(store);
     // We need to capture this to ensure the Variable doesn't get prematurely
     // destoryed if its parent goes out of scope before the future resolves.
@@ -840,6 +1159,7 @@ class Variable {
           if (!ready_result.ok()) {
             promise.SetResult(ready_result.status());
           } else {
+            thisVar->CountRead();
             LabeledArray<T, R, OriginKind> labeledArray{thisVar->dimensions(),
                                                         ready_result.value()};
             VariableData<T, R, OriginKind> variableData{
@@ -849,7 +1169,108 @@ class Variable {
           }
         });
 
-    return pair.future;
+    return span.End(pair.future);
+  }
+
+  /**
+   * @brief Read the data from the variable into a caller-owned VariableData.
+   * No new array is allocated, the existing buffer of `target` is reused. This
+   * is intended for tight loops that repeatedly read windows of the same shape.
+   * If the origin of `target` differs from the Variable's origin, `target` is
+   * re-addressed in place so that it indexes the same way a fresh `Read()`
+   * would.
+   * @pre `target` must have the same dtype and shape as the Variable.
+   * @param target A VariableData object, typically from a previous `Read()` or
+   * `from_variable`. It must not be accessed until the future is ready.
+   * @details \b Usage
+   * @code
+   * MDIO_ASSIGN_OR_RETURN(auto window, velocity.slice(inlineDesc));
+   * MDIO_ASSIGN_OR_RETURN(auto buffer, mdio::from_variable<float>(window));
+   * for (mdio::Index il = 0; il < numInlines; ++il) {
+   *   mdio::RangeDescriptor<mdio::Index> desc = {"inline", il, il + 1, 1};
+   *   MDIO_ASSIGN_OR_RETURN(auto window, velocity.slice(desc));
+   *   auto readFuture = window.Read(buffer);
+   *   if (!readFuture.status().ok()) {
+   *     return readFuture.status();
+   *   }
+   *   // Process `buffer` here
+   * }
+   * @endcode
+   * @return A future that will be ready when the read is complete.
+   */
+  template <ArrayOriginKind OriginKind>
+  Future<void> Read(
+      VariableData<T, R, OriginKind>& target) const {  // NOLINT (non-const)
+    if (target.dtype() != this->dtype()) {
+      return absl::InvalidArgumentError(
+          "The source and target dtypes do not match.");
+    }
+    auto domain = dimensions();
+    auto& array = target.data.data;
+    if (array.rank() != domain.rank() ||
+        !std::equal(array.shape().begin(), array.shape().end(),
+                    domain.shape().begin())) {
+      return absl::InvalidArgumentError(
+          "The source and target shapes do not match.");
+    }
+
+    if constexpr (OriginKind == offset_origin) {
+      // Shift the origin without touching the buffer. The element pointer
+      // addresses index 0, so it must move by the same amount in the opposite
+      // direction to keep the first element in place.
+      Index byte_offset = 0;
+      for (DimensionIndex i = 0; i < array.rank(); ++i) {
+        byte_offset +=
+            (array.origin()[i] - domain.origin()[i]) * array.byte_strides()[i];
+      }
+      if (byte_offset != 0) {
+        array.element_pointer() = tensorstore::AddByteOffset(
+            std::move(array.element_pointer()), byte_offset);
+      }
+      std::copy(domain.origin().begin(), domain.origin().end(),
+                array.layout().origin().begin());
+    }
+    target.data.domain = domain;
+
+    if (target.variableName != variableName) {
+      target.variableName = variableName;
+      target.longName = longName;
+      target.metadata = getMetadata();
+    }
+
+    return ReadInto(array);
+  }
+
+  /**
+   * @brief Read the data from the variable into a caller-owned array.
+   * This is the lowest level read and does no MDIO bookkeeping. The shape of
+   * `target` must match the shape of the Variable, the origin is aligned.
+   * @param target An `mdio::SharedArray` or transformed array view, such as a
+   * pinned or arena allocated buffer. It must outlive the returned future.
+   * @return A future that will be ready when the read is complete.
+   */
+  template <typename TargetArray>
+  Future<void> ReadInto(TargetArray&& target) const {
+    return tensorstore::Read(store, std::forward<TargetArray>(target));
+  }
+
+  /**
+   * @brief Starts reading a region of the Variable into the chunk cache, so a
+   * later read of it doesn't wait on the kvstore.
+   * This only helps if the Variable was opened with a Context whose
+   * "cache_pool" has a "total_bytes_limit", the default pool caches nothing.
+   * To overlap reads with processing without a cache see `TileReader`.
+   * @param descriptors The region to prefetch, the whole Variable if empty.
+   * @return A future that is ready once the region is cached. Dropping it may
+   * cancel the prefetch.
+   */
+  template <typename... Descriptors>
+  Future<void> Prefetch(const Descriptors&... descriptors) const {
+    MDIO_ASSIGN_OR_RETURN(auto region, slice(descriptors...))
+    return tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{},
+        [](const SharedArray<T, R, offset_origin>&) {},
+        tensorstore::Read(region.get_store()));
   }
 
   /**
@@ -872,6 +1293,10 @@ class Variable {
    * auto velocityWriteFuture = velocity.Write(velocityData);
    * // This is a future. It will be ready when the write is complete.
    * @endcode
+   * Variables with a lossy codec (see `transform_compressor`) are written as a
+   * quantized copy of the data. If statistics are tracked (see `TrackStats`)
+   * the written block is folded into the running statistics once the write
+   * commits. Data of another type can be written with `WriteAs`.
    * @return A future that will be ready when the write is complete.
    */
   template <ArrayOriginKind OriginKind = offset_origin>
@@ -880,7 +1305,20 @@ class Variable {
       return absl::InvalidArgumentError(
           "The source and target dtypes do not match.");
     }
-    return tensorstore::Write(source.data.data, store);
+    internal::Span span("mdio.Variable.Write");
+    span.Attribute("mdio.variable", variableName);
+    if (metadata.contains("metadata") &&
+        metadata["metadata"].contains("quantizationV1")) {
+      // A lossy codec, the quantized samples are written and tracked.
+      MDIO_ASSIGN_OR_RETURN(
+          auto quantized,
+          internal::QuantizeCopy<T>(source.data.data, this->dtype(),
+                                    metadata["metadata"]["quantizationV1"]));
+      return EndWrite(std::move(span), WriteArray(quantized),
+                      quantized.num_elements() * quantized.dtype().size());
+    }
+    return EndWrite(std::move(span), WriteArray(source.data.data),
+                    source.num_samples() * source.dtype().size());
   }
 
   /**
@@ -934,21 +1372,7 @@ class Variable {
    * @return true if the Variable contains the label, false otherwise
    */
   bool hasLabel(const DimensionIdentifier& labelToCheck) const {
-    // if it's an index slice, that is always valid ...
-    if (!labelToCheck.label().data()) {
-      auto rank = store.domain().rank();
-      // and we're in bounds
-      return (labelToCheck.index() < rank && labelToCheck.index() >= 0);
-    }
-
-    // otherwise see if the label is in the domain
-    const auto labels = store.domain().labels();
-    for (const auto& label : labels) {
-      if (label == labelToCheck) {
-        return true;
-      }
-    }
-    return false;
+    return internal::DomainHasLabel(store.domain(), labelToCheck);
   }
 
   /**
@@ -960,72 +1384,77 @@ class Variable {
    */
   RangeDescriptor<Index> sliceInRange(
       const RangeDescriptor<Index>& desc) const {
-    auto domain = dimensions();
-    const auto labels = domain.labels();
-
-    for (size_t idx = 0; idx < labels.size(); ++idx) {
-      if (labels[idx] == desc.label) {
-        // Clamp the descriptor to the domain.
-        return {desc.label,  // label
-                desc.start < domain.origin()[idx] ? domain.origin()[idx]
-                                                  : desc.start,  // start
-                desc.stop > domain.shape()[idx] ? domain.shape()[idx]
-                                                : desc.stop,  // stop
-                desc.step};                                   // step
-      }
-    }
-    // We don't slice along a dimension that doesn't exist, so the descriptor is
-    // valid
-    return desc;
-  }
-
-  template <size_t... I>
-  struct index_sequence {};
-
-  template <size_t N, size_t... I>
-  struct make_index_sequence : make_index_sequence<N - 1, N - 1, I...> {};
-
-  template <size_t... I>
-  struct make_index_sequence<0, I...> : index_sequence<I...> {};
-
-  template <std::size_t... I>
-  Result<Variable> call_slice_with_vector_impl(
-      const std::vector<RangeDescriptor<Index>>& slices,
-      std::index_sequence<I...>) {
-    return slice(slices[I]...);
+    return internal::ClampToDomain(store.domain(), desc);
   }
 
   /**
-   * @brief An overload of the `slice` method that takes a vector of
-   * RangeDescriptors. This method is limited to `internal::kMaxNumSlices`
-   * slices. This overload should only ever be used when a runtime number of
-   * slices must be generated.
+   * @brief An overload of the `slice` method that takes a runtime number of
+   * RangeDescriptors.
+   * Descriptors for dimensions the Variable doesn't have are ignored. When a
+   * dimension is described more than once, each range is sliced separately
+   * and the pieces are concatenated along that dimension in the order given.
+   * All descriptors are applied in a single pass.
+   * @param slices The descriptors used to specify the slice.
+   * @return An `mdio::Result` object containing the resulting sub-Variable.
    */
-  Result<Variable> slice(const std::vector<RangeDescriptor<Index>>& slices) {
+  Result<Variable> slice(
+      const std::vector<RangeDescriptor<Index>>& slices) const {
     if (slices.empty()) {
       return absl::InvalidArgumentError("No slices provided.");
     }
 
-    if (slices.size() > internal::kMaxNumSlices) {
-      // We are expecting the only entry point for this method to be fro mthe
-      // Dataset::isel method. That method should handle the partitioning of the
-      // slices.
-      return absl::InvalidArgumentError(
-          absl::StrCat("Too many slices provided or implicitly generated. "
-                       "Maximum number of slices is ",
-                       internal::kMaxNumSlices, " but ", slices.size(),
-                       " were provided.\n\tUse -DMAX_NUM_SLICES cmake flag to "
-                       "increase the maximum number of slices."));
+    // 1) Clamp, precondition check and group by dimension.
+    MDIO_ASSIGN_OR_RETURN(
+        auto groups, internal::GroupSliceDescriptors(store.domain(), slices))
+
+    // 2) Every dimension with a single range is sliced at once.
+    std::vector<DimensionIdentifier> labels;
+    std::vector<Index> starts, stops, steps;
+    for (const auto& group : groups) {
+      if (group.size() == 1) {
+        labels.push_back(group[0].label);
+        starts.push_back(group[0].start);
+        stops.push_back(group[0].stop);
+        steps.push_back(group[0].step);
+      }
+    }
+    auto sliced_store = store;
+    if (!labels.empty()) {
+      MDIO_ASSIGN_OR_RETURN(
+          sliced_store,
+          sliced_store | tensorstore::Dims(labels).HalfOpenInterval(
+                             starts, stops, steps));
     }
 
-    std::vector<RangeDescriptor<Index>> slicesCopy = slices;
-    for (int i = slices.size(); i < internal::kMaxNumSlices; ++i) {
-      slicesCopy.emplace_back(
-          RangeDescriptor<Index>({internal::kInertSliceKey, 0, 1, 1}));
+    // 3) Dimensions with several ranges are sliced piecewise and concatenated.
+    for (const auto& group : groups) {
+      if (group.size() == 1) {
+        continue;
+      }
+      tensorstore::DimensionIndexBuffer buffer;
+      auto resolved = tensorstore::Dims(group[0].label)
+                          .Resolve(sliced_store.domain(), &buffer);
+      if (!resolved.ok()) {
+        return resolved;
+      }
+      const DimensionIndex axis = buffer[0];
+
+      std::vector<tensorstore::TensorStore<T, R, M>> pieces;
+      pieces.reserve(group.size());
+      for (const auto& r : group) {
+        MDIO_ASSIGN_OR_RETURN(
+            auto piece, sliced_store | tensorstore::Dims(axis).HalfOpenInterval(
+                                           r.start, r.stop, r.step));
+        pieces.push_back(std::move(piece));
+      }
+      MDIO_ASSIGN_OR_RETURN(sliced_store, tensorstore::Concat(pieces, axis));
     }
 
-    return call_slice_with_vector_impl(
-        slicesCopy, std::make_index_sequence<internal::kMaxNumSlices>{});
+    Variable sliced{variableName, longName, metadata, std::move(sliced_store),
+                    attributes};
+    sliced.runningStats = runningStats;
+    sliced.indexCleared = indexCleared;
+    return sliced;
   }
 
   /**
@@ -1049,102 +1478,12 @@ class Variable {
    */
   template <typename... Descriptors>
   Result<Variable> slice(const Descriptors&... descriptors) const {
-    // 1) Pack descriptors
-    constexpr size_t N = sizeof...(Descriptors);
-    std::array<RangeDescriptor<Index>, N> descs = {descriptors...};
-
-    // 2) Clamp + precondition check
-    std::vector<DimensionIdentifier> labels;
-    std::vector<Index> starts, stops, steps;
-    labels.reserve(N);
-    starts.reserve(N);
-    stops.reserve(N);
-    steps.reserve(N);
-
-    int8_t bad_idx = -1;
-    for (size_t i = 0; i < N; ++i) {
-      auto d = sliceInRange(descs[i]);
-      if (d.start > d.stop) {
-        bad_idx = static_cast<int8_t>(i);
-        break;
-      }
-      if (this->hasLabel(d.label)) {
-        labels.push_back(d.label);
-        starts.push_back(d.start);
-        stops.push_back(d.stop);
-        steps.push_back(d.step);
-      }
-    }
-    if (bad_idx >= 0) {
-      auto& err = descs[bad_idx];
-      return Result<Variable>{absl::InvalidArgumentError(
-          std::string("Slice descriptor for ") +
-          std::string(err.label.label()) + " is invalid: start=" +
-          std::to_string(err.start) + " > stop=" + std::to_string(err.stop))};
-    }
-
-    // 3) Fast path: all labels (or axis indices) are unique
-    if (!labels.empty()) {
-      std::set<std::string_view> labelSet;
-      std::set<DimensionIndex> indexSet;
-      for (auto& lab : labels) {
-        labelSet.insert(lab.label());
-        indexSet.insert(lab.index());
-      }
-      if (labelSet.size() == labels.size() ||
-          indexSet.size() == labels.size()) {
-        MDIO_ASSIGN_OR_RETURN(
-            auto slice_store,
-            store | tensorstore::Dims(labels).HalfOpenInterval(starts, stops,
-                                                               steps));
-        return Variable{variableName, longName, metadata,
-                        std::move(slice_store), attributes};
-      }
-    }
-
-    // 4) Group by label to find any duplicates
-    std::map<std::string_view, std::vector<RangeDescriptor<Index>>> by_label;
-    for (auto& d : descs) {
-      if (d.label.label() != internal::kInertSliceKey) {
-        by_label[d.label.label()].push_back(d);
-      }
-    }
-
-    // 5) Handle the first label that has >1 descriptor
-    for (auto& [label, vec] : by_label) {
-      if (vec.size() > 1) {
-        // 5a) Unwrap the Spec so we can ask for transform().input_labels()
-        MDIO_ASSIGN_OR_RETURN(auto spec, store.spec());
-        auto spec_labels = spec.transform().input_labels();
-
-        // find the numeric axis for this label
-        auto it = std::find(spec_labels.begin(), spec_labels.end(), label);
-        if (it == spec_labels.end()) {
-          // no-op if the label isn't in the spec; skip it
-          continue;
-        }
-        int axis = static_cast<int>(std::distance(spec_labels.begin(), it));
-
-        // 5b) Slice each sub‑range in isolation
-        std::vector<tensorstore::TensorStore<T, R, M>> pieces;
-        pieces.reserve(vec.size());
-        for (auto& r : vec) {
-          auto sub = slice(r);
-          if (!sub.status().ok()) return sub.status();
-          pieces.push_back(sub.value().get_store());
-        }
-
-        // 5c) Concatenate them along the correct axis
-        MDIO_ASSIGN_OR_RETURN(auto cat_store,
-                              tensorstore::Concat(pieces, axis));
-
-        return Variable{variableName, longName, metadata, std::move(cat_store),
-                        attributes};
-      }
+    if constexpr (sizeof...(Descriptors) == 0) {
+      return *this;
+    } else {
+      return slice(std::vector<RangeDescriptor<Index>>{
+          RangeDescriptor<Index>(descriptors)...});
     }
-
-    // 6) No descriptors matched → no change
-    return *this;
   }
 
   /**
@@ -1188,6 +1527,11 @@ class Variable {
     if (!json.contains("metadata")) {
       return absl::NotFoundError("Metadata did not contain key 'metadata'.");
     }
+    // Zarr v3 stores one object per chunk of the grid, a shard if sharded.
+    if (internal::IsZarr3(json) && json["metadata"].contains("chunk_grid")) {
+      return json["metadata"]["chunk_grid"]["configuration"]["chunk_shape"]
+          .get<std::vector<long int>>();  // NOLINT: Tensorstore convention
+    }
     if (!json["metadata"].contains("chunks")) {
       return absl::NotFoundError(
           "Metadata['attributes'] did not contain key 'chunks'.");
@@ -1229,12 +1573,20 @@ class Variable {
    * @brief Publishes new ".zattrs" metadata to the Variable's durable storage.
    * This method should not be called independantly as it will result in a
    * mismatch between the Variable metadata and Dataset metadata
+   * @param transaction The transaction to stage the write in, if any.
    * @return A future representing the timestamped storage generation of the
    * updated Variable.
    */
-  Future<tensorstore::TimestampedStorageGeneration> PublishMetadata() {
-    auto publish = [](const ::nlohmann::json& json_var, bool isCloudStore,
-                      const tensorstore::TensorStore<T, R, M>& store)
+  Future<tensorstore::TimestampedStorageGeneration> PublishMetadata(
+      const tensorstore::Transaction& transaction =
+          tensorstore::no_transaction) {
+    bool isCloudStore = false;
+    // TODO(BrianMichell): Make more error tolerant
+    auto json_spec = store.spec().value().ToJson(IncludeDefaults{}).value();
+    const bool zarr3 = internal::IsZarr3(json_spec);
+    auto publish = [zarr3, transaction](
+                       const ::nlohmann::json& json_var, bool isCloudStore,
+                       const tensorstore::TensorStore<T, R, M>& store)
         -> Future<tensorstore::TimestampedStorageGeneration> {
       auto output_json = json_var;
 
@@ -1249,24 +1601,16 @@ class Variable {
         output_json["attributes"]["coordinates"] = output_json["coordinates"];
         output_json.erase("coordinates");
       }
-      std::string outpath = "/.zattrs";
-      if (isCloudStore) {
-        outpath = ".zattrs";
-      }
-
       if (output_json.contains("metadata")) {
         output_json["attributes"]["metadata"] = output_json["metadata"];
         output_json.erase("metadata");
       }
 
-      return tensorstore::kvstore::Write(
-          store.kvstore(), outpath,
-          absl::Cord(output_json["attributes"].dump(4)));
+      return internal::WriteVariableAttributes(
+          store.kvstore(), output_json["attributes"], isCloudStore, zarr3,
+          transaction);
     };
 
-    bool isCloudStore = false;
-    // TODO(BrianMichell): Make more error tolerant
-    auto json_spec = store.spec().value().ToJson(IncludeDefaults{}).value();
     auto driver = json_spec["kvstore"]["driver"];
     if (driver == "gcs" || driver == "s3") {
       isCloudStore = true;
@@ -1350,6 +1694,105 @@ class Variable {
     return (*attributes)->ToJson();
   }
 
+  /**
+   * @brief Starts maintaining the statsV1 of the Variable as it is written.
+   * Every `Write` folds the written block into running accumulators (count,
+   * sum, sum of squares, min, max and histogram) at the cost of the written
+   * bytes instead of a full recompute. The accumulators are shared by every
+   * copy and slice of the Variable and are published to the attributes by
+   * `PublishTrackedStats`, which `Dataset::CommitMetadata` calls.
+   * Tracking resumes from existing statsV1 with an edge defined histogram,
+   * otherwise it starts empty over `options.histogram_range`. Starting empty
+   * is exact for a Variable that is only filled through tracked writes, use
+   * `ComputeStats` to seed the statistics of existing data.
+   * Overwritten samples are subtracted if `options.subtract_overwritten` is
+   * set. Count, sums and histogram stay exact but the min and max can only
+   * widen, so the statistics are then flagged as approximate with the
+   * "statsV1Approximate" attribute.
+   * @param options The options controlling the tracking.
+   * @details \b Usage
+   * @code
+   * MDIO_ASSIGN_OR_RETURN(auto var, dataset.variables.get<float>("seismic"));
+   * mdio::StatsTrackingOptions options;
+   * options.histogram_range = std::make_pair(-1000.0, 1000.0);
+   * auto tracking = var.TrackStats(options);
+   * if (!tracking.ok()) {
+   *   // Handle error
+   * }
+   * // Writes through any copy or slice of `var` update the statistics
+   * auto commit = dataset.CommitMetadata();
+   * @endcode
+   * @return An OK status if tracking started, otherwise an error and nothing
+   * changes.
+   */
+  Result<void> TrackStats(const StatsTrackingOptions& options = {}) {
+    if (!internal::DispatchNumericType<T>(dtype(), [](auto) {})) {
+      return absl::InvalidArgumentError(
+          "Statistics can only be tracked for real numeric Variables.");
+    }
+    std::optional<double> fill;
+    if (auto spec = get_spec(); spec.ok()) {
+      fill = internal::FillValueFromSpec(spec.value());
+    }
+    std::shared_ptr<internal::RunningStats> running;
+    auto attrs = GetAttributes();
+    if (attrs.contains("statsV1") && attrs["statsV1"].is_object()) {
+      MDIO_ASSIGN_OR_RETURN(
+          running, internal::RunningStats::FromJson(
+                       attrs["statsV1"], fill, options.subtract_overwritten));
+    } else if (options.histogram_range.has_value()) {
+      const auto [lo, hi] = *options.histogram_range;
+      if (options.num_bins == 0 || !(lo < hi)) {
+        return absl::InvalidArgumentError(
+            "Tracked statistics require at least one bin and a non-empty "
+            "histogram range.");
+      }
+      running = std::make_shared<internal::RunningStats>(
+          lo, hi, options.num_bins, fill, options.subtract_overwritten);
+    } else {
+      return absl::InvalidArgumentError(
+          "A histogram range is required to track the statistics of a "
+          "Variable without statsV1.");
+    }
+    *runningStats = std::move(running);
+    return absl::OkStatus();
+  }
+
+  /**
+   * @brief Stops maintaining the statistics of the Variable.
+   * Statistics that were not published are dropped.
+   */
+  void StopTrackingStats() { *runningStats = nullptr; }
+
+  /**
+   * @brief Replaces the statsV1 attributes with the tracked statistics if they
+   * changed since they were last published.
+   * NOTE: This does not commit changes to durable media.
+   * Please see CommitMetadata method in the Dataset to commit changes.
+   * @return An OK status if there was nothing to publish or the attributes were
+   * updated.
+   */
+  Result<void> PublishTrackedStats() {
+    if (!runningStats || !*runningStats) {
+      return absl::OkStatus();
+    }
+    auto running = *runningStats;
+    if (!running->TakeDirty()) {
+      return absl::OkStatus();
+    }
+    auto attrs = GetAttributes();
+    attrs["statsV1"] = running->ToJson();
+    if (running->approximate()) {
+      attrs["attributes"]["statsV1Approximate"] = true;
+    }
+    auto updated = UpdateAttributes<float>(attrs);
+    if (!updated.ok()) {
+      // Keep the changes so a later publish can retry.
+      running->MarkDirty();
+    }
+    return updated;
+  }
+
   Result<nlohmann::json> get_units() const {
     auto attrs = GetAttributes();
 
@@ -1522,6 +1965,16 @@ class Variable {
   // The data that should remain static, but MAY need to be updated.
   std::shared_ptr<std::shared_ptr<UserAttributes>> attributes;
 
+  // The statistics maintained by tracked writes, shared like the attributes.
+  std::shared_ptr<std::shared_ptr<internal::RunningStats>> runningStats =
+      std::make_shared<std::shared_ptr<internal::RunningStats>>();
+
+  // Whether writes can skip deleting the coordinate index, shared like the
+  // attributes. It is cleared for the coordinates of a Dataset and when an
+  // index is built or found, and set again once a write deleted the index.
+  std::shared_ptr<std::atomic<bool>> indexCleared =
+      std::make_shared<std::atomic<bool>>(true);
+
   /**
    * @brief Gets the original address of the User Attributes.
    * This method should NEVER be called by the user.
@@ -1547,6 +2000,215 @@ class Variable {
   }
 
  private:
+  /**
+   * @brief Reports the bytes and chunks of a completed read, if telemetry is
+   * enabled.
+   */
+  void CountRead() const {
+    if (!internal::TelemetryEnabled().load(std::memory_order_relaxed)) {
+      return;
+    }
+    internal::Count(TelemetryCounter::kBytesRead,
+                    num_samples() * dtype().size());
+    auto chunk_res = get_chunk_shape();
+    if (!chunk_res.ok()) {
+      return;
+    }
+    const auto domain = dimensions();
+    Index chunks = 1;
+    for (DimensionIndex d = 0; d < domain.rank(); ++d) {
+      const Index chunk = d < static_cast<DimensionIndex>(chunk_res->size())
+                              ? (*chunk_res)[d]
+                              : 0;
+      if (domain.shape()[d] == 0) {
+        return;
+      }
+      if (chunk > 0) {
+        const Index first = domain.origin()[d];
+        const Index last = first + domain.shape()[d] - 1;
+        chunks *= tensorstore::FloorOfRatio(last, chunk) -
+                  tensorstore::FloorOfRatio(first, chunk) + 1;
+      }
+    }
+    internal::Count(TelemetryCounter::kChunksFetched, chunks);
+  }
+
+  /**
+   * @brief Reports the span of a write, and its bytes once it commits.
+   */
+  WriteFutures EndWrite(internal::Span span, WriteFutures futures,
+                        Index bytes) const {
+    if (internal::TelemetryEnabled().load(std::memory_order_relaxed)) {
+      futures.commit_future = tensorstore::MapFuture(
+          tensorstore::InlineExecutor{},
+          [bytes](const Result<void>& committed) {
+            if (committed.ok()) {
+              internal::Count(TelemetryCounter::kBytesWritten, bytes);
+            }
+            return committed;
+          },
+          std::move(futures.commit_future));
+    }
+    futures.commit_future = span.End(std::move(futures.commit_future));
+    return futures;
+  }
+
+  /**
+   * @brief Writes `source` to the store, tracking statistics if enabled.
+   */
+  template <typename Array>
+  WriteFutures WriteArray(const Array& source) const {
+    auto cleared = ClearCoordinateIndex();
+    auto futures = runningStats && *runningStats
+                       ? TrackedWrite(source, *runningStats)
+                       : WriteFutures(tensorstore::Write(source, store));
+    if (cleared.ready() && cleared.status().ok()) {
+      return futures;
+    }
+    // The write only commits once the stale index is gone too.
+    futures.commit_future = tensorstore::MapFutureValue(
+        tensorstore::InlineExecutor{}, [] {}, std::move(cleared),
+        std::move(futures.commit_future));
+    return futures;
+  }
+
+  /**
+   * @brief Makes the next write of the Variable delete its coordinate index.
+   */
+  void TrackCoordinateIndex() const {
+    indexCleared->store(false, std::memory_order_release);
+  }
+
+  /**
+   * @brief Deletes the coordinate index of the Variable when its data is
+   * first written, so values are never resolved from an index that no longer
+   * describes the data. Later writes through any copy or slice skip it, as do
+   * Variables that can't have an index.
+   * The delete isn't part of a transaction, the index is only an accelerator.
+   * @return A future that is ready once the index is deleted.
+   */
+  Future<void> ClearCoordinateIndex() const {
+    if (indexCleared->exchange(true, std::memory_order_acq_rel)) {
+      return absl::OkStatus();
+    }
+    auto kvs = store.kvstore();
+    if (!kvs.valid()) {
+      return absl::OkStatus();
+    }
+    kvs.transaction = tensorstore::no_transaction;
+    auto deleted = internal::DeleteCoordinateIndex(kvs);
+    deleted.ExecuteWhenReady(
+        [cleared = indexCleared](tensorstore::ReadyFuture<void> ready) {
+          // The next write tries again.
+          if (!ready.status().ok()) {
+            cleared->store(false, std::memory_order_release);
+          }
+        });
+    return deleted;
+  }
+
+  /**
+   * @brief Writes `source` and folds it into the running statistics once the
+   * write commits. If overwritten samples are subtracted the region is read
+   * first. In a transaction that read blocks, so the write is staged before
+   * the transaction can be committed. Otherwise both futures complete
+   * together with the commit.
+   */
+  template <typename Array>
+  WriteFutures TrackedWrite(
+      const Array& source,
+      std::shared_ptr<internal::RunningStats> running) const {
+    if (source.num_elements() != num_samples()) {
+      return absl::InvalidArgumentError(
+          "Tracked writes require the source to cover the Variable.");
+    }
+    const DataType data_type = dtype();
+    const auto summarize_flat = [data_type, running](const void* ptr,
+                                                     Index n_samples) {
+      std::optional<internal::RunningStats::Partial> partial;
+      internal::DispatchNumericType<T>(data_type, [&](auto tag) {
+        using U = decltype(tag);
+        partial = running->Summarize(static_cast<const U*>(ptr), n_samples);
+      });
+      return partial;
+    };
+    const auto summarize = [summarize_flat](const auto& array) {
+      if (tensorstore::IsContiguousLayout(array.layout(),
+                                          ContiguousLayoutOrder::c,
+                                          array.dtype().size())) {
+        return summarize_flat(array.byte_strided_origin_pointer().get(),
+                              array.num_elements());
+      }
+      // The samples are summarized as one run, so like in WriteAs a strided
+      // source is copied first.
+      auto copy = tensorstore::MakeCopy(array);
+      return summarize_flat(copy.byte_strided_origin_pointer().get(),
+                            copy.num_elements());
+    };
+    // The commit is only reported once the statistics include it.
+    const auto fold = [running](Future<void> commit_future,
+                                internal::RunningStats::Partial added,
+                                std::optional<internal::RunningStats::Partial>
+                                    removed) {
+      return tensorstore::MapFuture(
+          tensorstore::InlineExecutor{},
+          [running, added = std::move(added), removed = std::move(removed)](
+              const Result<void>& committed) {
+            if (committed.ok()) {
+              if (removed.has_value()) {
+                running->Subtract(*removed);
+              }
+              running->Add(added);
+            }
+            return committed;
+          },
+          std::move(commit_future));
+    };
+
+    // The new block is summarized before it is handed off to the write.
+    auto added = summarize(source);
+    if (!added.has_value()) {
+      return absl::InvalidArgumentError(
+          "Statistics can only be tracked for real numeric Variables.");
+    }
+
+    if (!running->subtract_overwritten()) {
+      auto futures = tensorstore::Write(source, store);
+      futures.commit_future = fold(std::move(futures.commit_future),
+                                   std::move(*added), std::nullopt);
+      return futures;
+    }
+
+    if (store.transaction() != tensorstore::no_transaction) {
+      // The caller may commit as soon as this returns, so the overwritten
+      // samples are read and the write is staged before that.
+      MDIO_ASSIGN_OR_RETURN(auto old, tensorstore::Read(store).result())
+      auto futures = tensorstore::Write(source, store);
+      futures.commit_future = fold(std::move(futures.commit_future),
+                                   std::move(*added), summarize(old));
+      return futures;
+    }
+
+    auto pair = tensorstore::PromiseFuturePair<void>::Make();
+    tensorstore::Read(store).ExecuteWhenReady(
+        [promise = pair.promise, store = store, source, summarize, fold,
+         added = std::move(*added)](auto old) mutable {
+          auto old_result = old.result();
+          if (!old_result.ok()) {
+            promise.SetResult(old_result.status());
+            return;
+          }
+          auto futures = tensorstore::Write(source, store);
+          fold(std::move(futures.commit_future), std::move(added),
+               summarize(old_result.value()))
+              .ExecuteWhenReady([promise = std::move(promise)](
+                                    tensorstore::ReadyFuture<void> folded) {
+                promise.SetResult(folded.result());
+              });
+        });
+    return WriteFutures(pair.future, pair.future);
+  }
+
   /**
    * This method should NEVER be called by the user.
    * This method is intended to be called as a callback by the Dataset
@@ -16,6 +16,9 @@
 #define MDIO_VARIABLE_COLLECTION_H_
 
 #include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -24,30 +27,123 @@
 #include "mdio/variable.h"
 
 namespace mdio {
+namespace internal {
+
+/**
+ * @brief A Variable that is opened on first use.
+ * The result of the open is shared by every copy of the placeholder, so each
+ * Variable is opened at most once. A failed open is retried on the next use.
+ */
+class LazyVariable {
+ public:
+  explicit LazyVariable(std::function<Future<Variable<>>()> open)
+      : open_(std::move(open)) {}
+
+  /**
+   * @brief Starts opening the Variable if it isn't already.
+   * @return A future of the opened Variable.
+   */
+  Future<Variable<>> Open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (opened_.null() || (opened_.ready() && !opened_.status().ok())) {
+      opened_ = open_();
+    }
+    return opened_;
+  }
+
+  /**
+   * @brief Gets the Variable, opening it and waiting for it if need be.
+   */
+  Result<Variable<>> get() { return Open().result(); }
+
+  /**
+   * @brief Checks if the Variable has been opened successfully.
+   */
+  bool is_open() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !opened_.null() && opened_.ready() && opened_.status().ok();
+  }
+
+ private:
+  std::function<Future<Variable<>>()> open_;
+  mutable std::mutex mutex_;
+  Future<Variable<>> opened_;
+};
+
+}  // namespace internal
+
 /**
  * @brief A collection of variables.
  * Provides type erasure for the coordinates and variables.
  * This is intended to be an underlying data structure for the Dataset class.
+ *
+ * Copies share the underlying Variables and only detach when a copy is
+ * modified. A sliced collection records the slice and applies it to a Variable
+ * when that Variable is retrieved, so slicing costs nothing for the Variables
+ * that are never accessed.
  */
 class VariableCollection {
  public:
   // Default constructor
-  VariableCollection() = default;
+  VariableCollection() : variables(std::make_shared<entry_map>()) {}
 
   VariableCollection(
       std::initializer_list<std::pair<const std::string, Variable<>>> list)
-      : variables(list) {}
+      : variables(std::make_shared<entry_map>()) {
+    for (const auto& [label, variable] : list) {
+      (*variables)[label] = {variable, 0, nullptr};
+    }
+  }
 
   /**
    * @brief Adds a variable with the specified label to the dataset.
    *
    * If a variable with the same label already exists, it will be overwritten.
+   * The variable is taken as is, pending slices are not applied to it.
    *
    * @param label The label of the variable.
    * @param variable The variable to be added.
    */
   void add(const std::string& label, const Variable<>& variable) {
-    variables[label] = variable;
+    if (variables.use_count() > 1) {
+      variables = std::make_shared<entry_map>(*variables);
+    }
+    (*variables)[label] = {variable, pending.size(), nullptr};
+  }
+
+  /**
+   * @brief Adds a variable that is opened the first time it is retrieved.
+   *
+   * If a variable with the same label already exists, it will be overwritten.
+   * Pending slices are not applied to it. The opened Variable is shared with
+   * every copy of the collection.
+   *
+   * @param label The label of the variable.
+   * @param open Callable returning a future of the opened Variable.
+   */
+  void add_lazy(const std::string& label,
+                std::function<Future<Variable<>>()> open) {
+    if (variables.use_count() > 1) {
+      variables = std::make_shared<entry_map>(*variables);
+    }
+    (*variables)[label] = {
+        Variable<>{},
+        pending.size(),
+        std::make_shared<internal::LazyVariable>(std::move(open))};
+  }
+
+  /**
+   * @brief Checks if the variable with the specified label has been opened.
+   * Variables added with `add` are always open.
+   * @param label The name of the Variable to check.
+   * @return true if the Variable exists and is open, false otherwise.
+   */
+  bool is_open(const std::string& label) const {
+    auto it = variables->find(label);
+    if (it == variables->end()) {
+      return false;
+    }
+    return !it->second.lazy || it->second.lazy->is_open();
   }
 
   /**
@@ -66,24 +162,23 @@ class VariableCollection {
   template <typename T = void, DimensionIndex R = dynamic_rank,
             ReadWriteMode M = ReadWriteMode::dynamic>
   Result<Variable<T, R, M>> get(const std::string& label) const {
-    if (!variables.count(label)) {
-      return absl::NotFoundError("Label '" + label +
-                                 "' not found in the stores map");
-    }
+    MDIO_ASSIGN_OR_RETURN(auto variable, at(label))
 
     auto cast_store =
         tensorstore::StaticCast<tensorstore::TensorStore<T, R, M>>(
-            variables.at(label).get_store());
+            variable.get_store());
 
     if (!cast_store.ok()) {
       return cast_store.status();
     }
 
-    return Variable<T, R, M>{variables.at(label).get_variable_name(),
-                             variables.at(label).get_long_name(),
-                             variables.at(label).getReducedMetadata(),
-                             cast_store.value(),
-                             variables.at(label).attributes};
+    Variable<T, R, M> cast{variable.get_variable_name(),
+                           variable.get_long_name(),
+                           variable.getReducedMetadata(), cast_store.value(),
+                           variable.attributes};
+    cast.runningStats = variable.runningStats;
+    cast.indexCleared = variable.indexCleared;
+    return cast;
   }
 
   /**
@@ -103,12 +198,36 @@ class VariableCollection {
   template <typename T = void, DimensionIndex R = dynamic_rank,
             ReadWriteMode M = ReadWriteMode::dynamic>
   Result<Variable<T, R, M>> at(const std::string& label) const {
-    if (!variables.count(label)) {
+    auto it = variables->find(label);
+    if (it == variables->end()) {
       return absl::NotFoundError("Label '" + label +
                                  "' not found in the stores map");
     }
 
-    return variables.at(label);
+    const auto& [variable, applied, lazy] = it->second;
+    Variable<> sliced = variable;
+    if (lazy) {
+      MDIO_ASSIGN_OR_RETURN(sliced, lazy->get())
+    }
+    for (std::size_t i = applied; i < pending.size(); ++i) {
+      MDIO_ASSIGN_OR_RETURN(sliced, sliced.slice(*pending[i]))
+    }
+    return sliced;
+  }
+
+  /**
+   * @brief Creates a sliced view of the collection.
+   * The slice is recorded and applied to each Variable when it is retrieved.
+   * The returned collection shares its Variables with this one.
+   * @param slices The descriptors used to specify the slice.
+   * @return A collection of the sliced Variables.
+   */
+  VariableCollection slice(
+      const std::vector<RangeDescriptor<Index>>& slices) const {
+    VariableCollection sliced = *this;
+    sliced.pending.push_back(
+        std::make_shared<const std::vector<RangeDescriptor<Index>>>(slices));
+    return sliced;
   }
 
   /**
@@ -118,7 +237,7 @@ class VariableCollection {
    * @return true if the VariableCollection has that label, false otherwise.
    */
   bool contains_key(const std::string& label) const {
-    return variables.count(label) != 0;
+    return variables->count(label) != 0;
   }
 
   /**
@@ -131,7 +250,7 @@ class VariableCollection {
    */
   std::vector<std::string> get_keys() const {
     std::vector<std::string> keys;
-    for (auto& [key, _] : variables) {
+    for (auto& [key, _] : *variables) {
       keys.emplace_back(key);
     }
     return keys;
@@ -155,17 +274,21 @@ class VariableCollection {
   }
 
  private:
-  // Define the iterator type for the VariableCollection
-  using iterator = std::unordered_map<std::string, Variable<>>::iterator;
-  using const_iterator =
-      std::unordered_map<std::string, Variable<>>::const_iterator;
+  /// A Variable and the number of pending slices that don't apply to it.
+  struct entry {
+    Variable<> variable;
+    std::size_t applied = 0;
+    /// Set when the Variable is opened on first use, `variable` is unused.
+    std::shared_ptr<internal::LazyVariable> lazy;
+  };
+  using entry_map = std::unordered_map<std::string, entry>;
 
-  const_iterator begin() const { return variables.cbegin(); }
-  const_iterator end() const { return variables.cend(); }
-  const_iterator cbegin() const { return variables.cbegin(); }
-  const_iterator cend() const { return variables.cend(); }
+  /// The Variables, shared between copies until one of them is modified.
+  std::shared_ptr<entry_map> variables;
 
-  std::unordered_map<std::string, Variable<>> variables;
+  /// The slices to apply to the Variables on retrieval, in order.
+  std::vector<std::shared_ptr<const std::vector<RangeDescriptor<Index>>>>
+      pending;
 };
 }  // namespace mdio
 
@@ -18,6 +18,7 @@
 #include <gtest/gtest.h>
 
 #include <string>
+#include <vector>
 
 namespace {
 
@@ -119,4 +120,38 @@ TEST(VariableCollectionTest, getKeys) {
     EXPECT_EQ(keys[0], name);
 }
 
+TEST(VariableCollectionTest, slice) {
+    auto variable = mdio::Variable<>::Open(json_good,
+                                           mdio::constants::kCreateClean);
+    ASSERT_TRUE(variable.status().ok()) << variable.status();
+
+    mdio::VariableCollection vc;
+    std::string name = "collectionVariable";
+    vc.add(name, variable.value());
+
+    std::vector<mdio::RangeDescriptor<mdio::Index>> slices = {
+        {"x", 100, 200, 1}};
+    auto sliced = vc.slice(slices);
+
+    auto slicedVar = sliced.get<int16_t>(name);
+    ASSERT_TRUE(slicedVar.status().ok()) << slicedVar.status();
+    auto domain = slicedVar.value().dimensions();
+    EXPECT_EQ(domain[0].interval().inclusive_min(), 100);
+    EXPECT_EQ(domain[0].interval().size(), 100);
+
+    // The original collection is untouched.
+    auto original = vc.at(name);
+    ASSERT_TRUE(original.status().ok()) << original.status();
+    EXPECT_EQ(original.value().dimensions()[0].interval().size(), 500);
+
+    // Slices compose, and a Variable added to a slice is taken as is.
+    auto twice = sliced.slice({{"x", 150, 160, 1}});
+    twice.add("unsliced", variable.value());
+    EXPECT_EQ(twice.at(name).value().dimensions()[0].interval().size(), 10);
+    EXPECT_EQ(twice.at("unsliced").value().dimensions()[0].interval().size(),
+              500);
+    EXPECT_FALSE(sliced.contains_key("unsliced"));
+    EXPECT_FALSE(vc.contains_key("unsliced"));
+}
+
 }  // namespace
@@ -639,11 +639,32 @@ TEST(Variable, sliceEmptyVector) {
   std::filesystem::remove_all("name");
 }
 
+TEST(Variable, sliceAbuttingRuns) {
+  auto variable =
+      mdio::Variable<>::Open(json_good, mdio::constants::kCreateClean).value();
+
+  // One single sample run per index, as generated by `sel`.
+  std::vector<mdio::RangeDescriptor<mdio::Index>> descriptors;
+  for (mdio::Index i = 10; i < 50; ++i) {
+    descriptors.push_back({"x", i, i + 1, 1});
+  }
+  descriptors.push_back({"y", 2, 4, 1});
+
+  auto result = variable.slice(descriptors);
+  ASSERT_TRUE(result.ok()) << result.status();
+  auto domain = result.value().dimensions();
+  EXPECT_EQ(domain[0].interval().inclusive_min(), 10);
+  EXPECT_EQ(domain[0].interval().size(), 40);
+  EXPECT_EQ(domain[1].interval().inclusive_min(), 2);
+  EXPECT_EQ(domain[1].interval().size(), 2);
+
+  std::filesystem::remove_all("name");
+}
+
 TEST(Variable, sliceOverfullVector) {
   auto variable =
       mdio::Variable<>::Open(json_good, mdio::constants::kCreateClean).value();
 
-  // compile time example
   mdio::RangeDescriptor<mdio::Index> desc1 = {"x", 0, 5, 1};
   std::vector<mdio::RangeDescriptor<mdio::Index>> descriptors;
   for (int i = 0; i < 33; ++i) {
@@ -651,7 +672,9 @@ TEST(Variable, sliceOverfullVector) {
   }
 
   auto result = variable.slice(descriptors);
-  ASSERT_FALSE(result.ok());
+  ASSERT_TRUE(result.ok()) << result.status();
+  auto domain = result.value().dimensions();
+  EXPECT_EQ(domain[0].interval().size(), 33 * 5);
 
   std::filesystem::remove_all("name");
 }
@@ -1276,4 +1299,68 @@ TEST(VariableData, fromVariableFillTest) {
       << variableData.value().get_data_accessor().data()[0];
 }
 
+TEST(VariableData, readIntoExisting) {
+  auto json = PopulateStore(json_good).value();
+  auto variableObject =
+      mdio::Variable<mdio::dtypes::int16_t>::Open(json).result();
+  ASSERT_TRUE(variableObject.ok());
+
+  mdio::RangeDescriptor<mdio::Index> desc1 = {"x", 0, 10, 1};
+  mdio::RangeDescriptor<mdio::Index> desc2 = {"y", 100, 110, 1};
+  auto window = variableObject.value().slice(desc1, desc2);
+  ASSERT_TRUE(window.ok());
+
+  auto buffer = mdio::from_variable<mdio::dtypes::int16_t>(window.value());
+  ASSERT_TRUE(buffer.ok());
+  auto* initial_ptr = buffer->get_data_accessor().data() +
+                      buffer->get_flattened_offset();
+
+  for (mdio::Index x = 0; x < 100; x += 10) {
+    desc1 = {"x", x, x + 10, 1};
+    window = variableObject.value().slice(desc1, desc2);
+    ASSERT_TRUE(window.ok());
+    auto readFuture = window->Read(buffer.value());
+    ASSERT_TRUE(readFuture.status().ok()) << readFuture.status();
+
+    // The buffer is reused, not reallocated.
+    auto accessor = buffer->get_data_accessor();
+    EXPECT_EQ(accessor.data() + buffer->get_flattened_offset(), initial_ptr);
+    EXPECT_EQ(buffer->dimensions().origin()[0], x);
+    for (mdio::Index i = x; i < x + 10; ++i) {
+      for (mdio::Index j = 100; j < 110; ++j) {
+        EXPECT_EQ(accessor({i, j}), int16_t(j + (i * 500)));
+      }
+    }
+  }
+
+  // Shape mismatches are rejected.
+  desc1 = {"x", 0, 20, 1};
+  window = variableObject.value().slice(desc1, desc2);
+  ASSERT_TRUE(window.ok());
+  EXPECT_FALSE(window->Read(buffer.value()).status().ok());
+
+  std::filesystem::remove_all("name");
+}
+
+TEST(Variable, quantizeSamples) {
+  std::vector<float> data = {0.0f, 0.1234f, -3.14159f, 1000.26f, NAN};
+  auto quantized = data;
+  mdio::internal::QuantizeSamples(
+      quantized.data(), quantized.size(),
+      {{"mode", "fixed_accuracy"}, {"tolerance", 0.05}});
+  for (std::size_t i = 0; i < 4; ++i) {
+    EXPECT_LE(std::fabs(quantized[i] - data[i]), 0.05f) << i;
+    // A power of two step, 1 / 16 for this tolerance.
+    EXPECT_EQ(quantized[i] * 16, std::nearbyint(quantized[i] * 16)) << i;
+  }
+  EXPECT_TRUE(std::isnan(quantized[4]));
+
+  std::vector<double> wide = {3.14159265358979, -1e10};
+  mdio::internal::QuantizeSamples(wide.data(), wide.size(),
+                                  {{"mode", "fixed_precision"},
+                                   {"precision", 8}});
+  EXPECT_DOUBLE_EQ(wide[0], 3.140625);
+  EXPECT_NEAR(wide[1], -1e10, 1e10 / 256);
+}
+
 }  // namespace